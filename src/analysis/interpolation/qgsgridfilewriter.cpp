@@ -19,6 +19,42 @@
 #include "qgsinterpolator.h"
 #include <QFile>
 #include <QProgressDialog>
+#include <QThread>
+#include <QtConcurrentMap>
+
+//one row of the output grid
+struct QgsGridFileRow
+{
+  QgsInterpolator* interpolator;
+  double yValue;
+  double xMinimum;
+  double cellSizeX;
+  int nCols;
+  QString text;
+};
+
+//interpolates the cells of a row and formats the values like the output stream would
+static void interpolateRow( QgsGridFileRow& row )
+{
+  row.text.clear();
+  QTextStream rowStream( &row.text );
+  rowStream.setRealNumberPrecision( 8 );
+
+  double currentXValue = row.xMinimum + row.cellSizeX / 2.0; //calculate value in the center of the cell
+  double interpolatedValue;
+  for ( int j = 0; j < row.nCols; ++j )
+  {
+    if ( row.interpolator->interpolatePoint( currentXValue, row.yValue, interpolatedValue ) == 0 )
+    {
+      rowStream << interpolatedValue << " ";
+    }
+    else
+    {
+      rowStream << "-9999 ";
+    }
+    currentXValue += row.cellSizeX;
+  }
+}
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator* i, QString outputPath, QgsRectangle extent, int nCols, int nRows , double cellSizeX, double cellSizeY )
     : mInterpolator( i ), mOutputFilePath( outputPath ), mInterpolationExtent( extent ), mNumColumns( nCols ), mNumRows( nRows )
@@ -57,8 +93,6 @@ int QgsGridFileWriter::writeFile( bool showProgressDialog )
   writeHeader( outStream );
 
   double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
 
   QProgressDialog* progressDialog = 0;
   if ( showProgressDialog )
@@ -67,32 +101,52 @@ int QgsGridFileWriter::writeFile( bool showProgressDialog )
     progressDialog->setWindowModality( Qt::WindowModal );
   }
 
-  for ( int i = 0; i < mNumRows; ++i )
+  //rows are interpolated in parallel batches if the interpolator allows it and written in order
+  bool concurrent = mInterpolator->prepareForConcurrentUse();
+  int batchSize = concurrent ? qMax( QThread::idealThreadCount(), 1 ) * 4 : 1;
+
+  QVector<QgsGridFileRow> rows( batchSize );
+  for ( int i = 0; i < mNumRows; i += batchSize )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    int nBatchRows = qMin( batchSize, mNumRows - i );
+    rows.resize( nBatchRows );
+    for ( int k = 0; k < nBatchRows; ++k )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
-      {
-        outStream << interpolatedValue << " ";
-      }
-      else
+      QgsGridFileRow& row = rows[k];
+      row.interpolator = mInterpolator;
+      row.yValue = currentYValue;
+      row.xMinimum = mInterpolationExtent.xMinimum();
+      row.cellSizeX = mCellSizeX;
+      row.nCols = mNumColumns;
+      currentYValue -= mCellSizeY;
+    }
+
+    if ( concurrent && nBatchRows > 1 )
+    {
+      QtConcurrent::blockingMap( rows, interpolateRow );
+    }
+    else
+    {
+      for ( int k = 0; k < nBatchRows; ++k )
       {
-        outStream << "-9999 ";
+        interpolateRow( rows[k] );
       }
-      currentXValue += mCellSizeX;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
+
+    for ( int k = 0; k < nBatchRows; ++k )
+    {
+      outStream << rows[k].text << endl;
+    }
 
     if ( showProgressDialog )
     {
       if ( progressDialog->wasCanceled() )
       {
+        delete progressDialog;
         outputFile.remove();
         return 3;
       }
-      progressDialog->setValue( i );
+      progressDialog->setValue( i + nBatchRows - 1 );
     }
   }
 
@@ -16,15 +16,27 @@
  ***************************************************************************/
 
 #include "qgsidwinterpolator.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
 
-QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData>& layerData ): QgsInterpolator( layerData ), mDistanceCoefficient( 2.0 )
+QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData>& layerData )
+    : QgsInterpolator( layerData )
+    , mDistanceCoefficient( 2.0 )
+    , mMaxNeighbors( 0 )
+    , mSearchRadius( 0.0 )
+    , mIndexBuilt( false )
 {
 
 }
 
-QgsIDWInterpolator::QgsIDWInterpolator(): QgsInterpolator( QList<LayerData>() ), mDistanceCoefficient( 2.0 )
+QgsIDWInterpolator::QgsIDWInterpolator()
+    : QgsInterpolator( QList<LayerData>() )
+    , mDistanceCoefficient( 2.0 )
+    , mMaxNeighbors( 0 )
+    , mSearchRadius( 0.0 )
+    , mIndexBuilt( false )
 {
 
 }
@@ -34,6 +46,19 @@ QgsIDWInterpolator::~QgsIDWInterpolator()
 
 }
 
+bool QgsIDWInterpolator::prepareForConcurrentUse()
+{
+  if ( !mDataIsCached )
+  {
+    cacheBaseData();
+  }
+  if ( !mIndexBuilt )
+  {
+    buildIndex();
+  }
+  return true;
+}
+
 int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
 {
   if ( !mDataIsCached )
@@ -41,23 +66,46 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
     cacheBaseData();
   }
 
+  if ( mMaxNeighbors <= 0 && mSearchRadius <= 0 )
+  {
+    return interpolateFromAll( x, y, result );
+  }
+
+  if ( !mIndexBuilt )
+  {
+    buildIndex();
+  }
+  return interpolateFromNeighbors( x, y, result );
+}
+
+inline double QgsIDWInterpolator::weight( double sqrDistance ) const
+{
+  if ( mDistanceCoefficient == 2.0 )
+  {
+    return 1.0 / sqrDistance;
+  }
+  return 1.0 / pow( sqrDistance, mDistanceCoefficient / 2.0 );
+}
+
+int QgsIDWInterpolator::interpolateFromAll( double x, double y, double& result ) const
+{
   double currentWeight;
-  double distance;
+  double sqrDistance;
 
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  QVector<vertexData>::iterator vertex_it = mCachedBaseData.begin();
+  QVector<vertexData>::const_iterator vertex_it = mCachedBaseData.constBegin();
 
-  for ( ; vertex_it != mCachedBaseData.end(); ++vertex_it )
+  for ( ; vertex_it != mCachedBaseData.constEnd(); ++vertex_it )
   {
-    distance = sqrt(( vertex_it->x - x ) * ( vertex_it->x - x ) + ( vertex_it->y - y ) * ( vertex_it->y - y ) );
-    if (( distance - 0 ) < std::numeric_limits<double>::min() )
+    sqrDistance = ( vertex_it->x - x ) * ( vertex_it->x - x ) + ( vertex_it->y - y ) * ( vertex_it->y - y );
+    if (( sqrDistance - 0 ) < std::numeric_limits<double>::min() )
     {
       result = vertex_it->z;
       return 0;
     }
-    currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
+    currentWeight = weight( sqrDistance );
     sumCounter += ( currentWeight * vertex_it->z );
     sumDenominator += currentWeight;
   }
@@ -70,3 +118,169 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
   result = sumCounter / sumDenominator;
   return 0;
 }
+
+int QgsIDWInterpolator::interpolateFromNeighbors( double x, double y, double& result ) const
+{
+  if ( mIndexCols == 0 || mIndexRows == 0 )
+  {
+    return 1;
+  }
+
+  double sqrRadius = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::max();
+  size_t maxNeighbors = mMaxNeighbors > 0 ? mMaxNeighbors : mCachedBaseData.size();
+
+  //squared distance and index of the vertices found so far. Max-heap, the farthest vertex is on top
+  std::vector< std::pair<double, int> > neighbors;
+  neighbors.reserve( qMin( maxNeighbors, ( size_t ) mCachedBaseData.size() ) + 1 );
+
+  //cell of the point (may be outside of the grid)
+  int col = ( int ) floor(( x - mIndexXMin ) / mIndexCellSize );
+  int row = ( int ) floor(( y - mIndexYMin ) / mIndexCellSize );
+  int maxRing = qMax( qMax( col, mIndexCols - 1 - col ), qMax( row, mIndexRows - 1 - row ) );
+
+  //search in rings of cells around the cell of the point
+  for ( int ring = 0; ring <= maxRing; ++ring )
+  {
+    if ( ring > 0 )
+    {
+      //no vertex in this or any further ring can be closer than this
+      double minDistance = ( ring - 1 ) * mIndexCellSize;
+      double sqrMinDistance = minDistance * minDistance;
+      if ( sqrMinDistance > sqrRadius )
+      {
+        break;
+      }
+      if ( neighbors.size() == maxNeighbors && sqrMinDistance > neighbors.front().first )
+      {
+        break;
+      }
+    }
+
+    int firstRow = qMax( row - ring, 0 );
+    int lastRow = qMin( row + ring, mIndexRows - 1 );
+    for ( int r = firstRow; r <= lastRow; ++r )
+    {
+      //the inner rows of the ring have just the first and the last cell
+      bool borderRow = ( r == row - ring || r == row + ring );
+      int step = borderRow ? 1 : 2 * ring;
+      for ( int c = col - ring; c <= col + ring; c += step )
+      {
+        if ( c < 0 || c >= mIndexCols )
+        {
+          continue;
+        }
+
+        int cell = r * mIndexCols + c;
+        for ( int i = mIndexCellStart[cell]; i < mIndexCellStart[cell + 1]; ++i )
+        {
+          int vertex = mIndexVertices[i];
+          const vertexData& v = mCachedBaseData[vertex];
+          double sqrDistance = ( v.x - x ) * ( v.x - x ) + ( v.y - y ) * ( v.y - y );
+          if ( sqrDistance > sqrRadius )
+          {
+            continue;
+          }
+          if (( sqrDistance - 0 ) < std::numeric_limits<double>::min() )
+          {
+            result = v.z;
+            return 0;
+          }
+          if ( neighbors.size() < maxNeighbors )
+          {
+            neighbors.push_back( std::make_pair( sqrDistance, vertex ) );
+            std::push_heap( neighbors.begin(), neighbors.end() );
+          }
+          else if ( sqrDistance < neighbors.front().first )
+          {
+            std::pop_heap( neighbors.begin(), neighbors.end() );
+            neighbors.back() = std::make_pair( sqrDistance, vertex );
+            std::push_heap( neighbors.begin(), neighbors.end() );
+          }
+        }
+      }
+    }
+  }
+
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( size_t i = 0; i < neighbors.size(); ++i )
+  {
+    double currentWeight = weight( neighbors[i].first );
+    sumCounter += ( currentWeight * mCachedBaseData[neighbors[i].second].z );
+    sumDenominator += currentWeight;
+  }
+
+  if ( sumDenominator == 0.0 )
+  {
+    return 1;
+  }
+
+  result = sumCounter / sumDenominator;
+  return 0;
+}
+
+void QgsIDWInterpolator::buildIndex()
+{
+  mIndexBuilt = true;
+  mIndexCellStart.clear();
+  mIndexVertices.clear();
+  mIndexCols = 0;
+  mIndexRows = 0;
+
+  int nVertices = mCachedBaseData.size();
+  if ( nVertices == 0 )
+  {
+    return;
+  }
+
+  double xMin = std::numeric_limits<double>::max();
+  double yMin = std::numeric_limits<double>::max();
+  double xMax = -std::numeric_limits<double>::max();
+  double yMax = -std::numeric_limits<double>::max();
+  QVector<vertexData>::const_iterator vertex_it = mCachedBaseData.constBegin();
+  for ( ; vertex_it != mCachedBaseData.constEnd(); ++vertex_it )
+  {
+    xMin = qMin( xMin, vertex_it->x );
+    yMin = qMin( yMin, vertex_it->y );
+    xMax = qMax( xMax, vertex_it->x );
+    yMax = qMax( yMax, vertex_it->y );
+  }
+
+  //about four vertices per cell for evenly distributed data. The second term
+  //keeps the number of cells low for data along a narrow strip
+  double width = xMax - xMin;
+  double height = yMax - yMin;
+  mIndexCellSize = qMax( sqrt( width * height * 4.0 / nVertices ), qMax( width, height ) * 4.0 / nVertices );
+  if ( mIndexCellSize <= 0 )
+  {
+    mIndexCellSize = 1.0;
+  }
+
+  mIndexXMin = xMin;
+  mIndexYMin = yMin;
+  mIndexCols = ( int ) floor( width / mIndexCellSize ) + 1;
+  mIndexRows = ( int ) floor( height / mIndexCellSize ) + 1;
+
+  //counting sort of the vertices by cell
+  QVector<int> vertexCells( nVertices );
+  mIndexCellStart.fill( 0, mIndexCols * mIndexRows + 1 );
+  for ( int i = 0; i < nVertices; ++i )
+  {
+    const vertexData& v = mCachedBaseData[i];
+    int c = qMin(( int ) floor(( v.x - xMin ) / mIndexCellSize ), mIndexCols - 1 );
+    int r = qMin(( int ) floor(( v.y - yMin ) / mIndexCellSize ), mIndexRows - 1 );
+    vertexCells[i] = r * mIndexCols + c;
+    ++mIndexCellStart[vertexCells[i] + 1];
+  }
+  for ( int cell = 0; cell < mIndexCols * mIndexRows; ++cell )
+  {
+    mIndexCellStart[cell + 1] += mIndexCellStart[cell];
+  }
+
+  QVector<int> cellFill = mIndexCellStart;
+  mIndexVertices.resize( nVertices );
+  for ( int i = 0; i < nVertices; ++i )
+  {
+    mIndexVertices[cellFill[vertexCells[i]]++] = i;
+  }
+}
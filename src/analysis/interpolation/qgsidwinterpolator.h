@@ -35,14 +35,54 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
 
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /**Uses only the n nearest vertices for the interpolation. 0 (the default) means all vertices
+      @note added in 2.0*/
+    void setMaxNeighbors( int n ) {mMaxNeighbors = n;}
+    int maxNeighbors() const {return mMaxNeighbors;}
+
+    /**Uses only the vertices within the distance (in map units) for the interpolation.
+      0 (the default) means no limit. Points without any vertex in the radius get no value
+      @note added in 2.0*/
+    void setSearchRadius( double radius ) {mSearchRadius = radius;}
+    double searchRadius() const {return mSearchRadius;}
+
+    /**Caches the base data and builds the vertex index, interpolatePoint() is thread safe then*/
+    bool prepareForConcurrentUse();
+
   private:
 
     QgsIDWInterpolator(); //forbidden
 
+    /**Interpolation from all the vertices*/
+    int interpolateFromAll( double x, double y, double& result ) const;
+    /**Interpolation from the vertices found in the index (nearest neighbors and/or search radius)*/
+    int interpolateFromNeighbors( double x, double y, double& result ) const;
+
+    /**Inverse distance weight for a squared distance*/
+    double weight( double sqrDistance ) const;
+
+    /**Builds a regular grid over the cached vertices. Each cell holds about four vertices*/
+    void buildIndex();
+
     /**The parameter that sets how the values are weighted with distance.
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient;
+
+    /**Maximum number of vertices used for interpolation (0 = all)*/
+    int mMaxNeighbors;
+    /**Maximum distance of vertices used for interpolation (0 = unlimited)*/
+    double mSearchRadius;
+
+    /**Vertex index: vertices of grid cell i are mIndexVertices[mIndexCellStart[i]] ... mIndexVertices[mIndexCellStart[i+1]-1]*/
+    bool mIndexBuilt;
+    double mIndexXMin;
+    double mIndexYMin;
+    double mIndexCellSize;
+    int mIndexCols;
+    int mIndexRows;
+    QVector<int> mIndexCellStart;
+    QVector<int> mIndexVertices;
 };
 
 #endif
@@ -64,6 +64,11 @@ class ANALYSIS_EXPORT QgsInterpolator
        @return 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double& result ) = 0;
 
+    /**Prepares the interpolator such that interpolatePoint() may be called from several threads at once.
+       @return true if concurrent calls are supported (not by default)
+       @note added in 2.0*/
+    virtual bool prepareForConcurrentUse() { return false; }
+
   protected:
     /**Caches the vertex and value data from the provider. All the vertex data
      will be held in virtual memory
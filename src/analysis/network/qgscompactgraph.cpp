@@ -0,0 +1,96 @@
+/***************************************************************************
+    qgscompactgraph.cpp
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+// C++ standard includes
+#include <cmath>
+#include <limits>
+
+//QGIS-includes
+#include "qgsgraph.h"
+#include "qgscompactgraph.h"
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph* graph, int criterionNum )
+    : mGraph( graph )
+    , mCriterionNum( criterionNum )
+    , mVertexCount( graph->vertexCount() )
+    , mHeuristicFactor( 0.0 )
+{
+  int nArcs = graph->arcCount();
+  QVector<double> costs( nArcs );
+  for ( int i = 0; i < nArcs; ++i )
+  {
+    costs[i] = graph->arc( i ).property( criterionNum ).toDouble();
+  }
+
+  build( costs, true, mOutStart, mOutArc, mOutVertex, mOutCost );
+  build( costs, false, mInStart, mInArc, mInVertex, mInCost );
+
+  mPoints.resize( mVertexCount );
+  for ( int v = 0; v < mVertexCount; ++v )
+  {
+    mPoints[v] = graph->vertex( v ).point();
+  }
+
+  // the lowest cost per distance unit makes the estimate a lower bound of the real cost
+  double inf = std::numeric_limits<double>::infinity();
+  double factor = inf;
+  for ( int v = 0; v < mVertexCount && factor > 0; ++v )
+  {
+    for ( int i = mOutStart[v]; i < mOutStart[v + 1]; ++i )
+    {
+      if ( mOutCost[i] < 0 )
+      {
+        factor = 0.0;
+        break;
+      }
+      double length = sqrt( mPoints[v].sqrDist( mPoints[ mOutVertex[i] ] ) );
+      if ( length > 0 )
+      {
+        factor = qMin( factor, mOutCost[i] / length );
+      }
+    }
+  }
+  mHeuristicFactor = factor == inf ? 0.0 : factor;
+}
+
+void QgsCompactGraph::build( const QVector<double>& costs, bool outgoing,
+                             QVector<int>& start, QVector<int>& arcs, QVector<int>& vertices, QVector<double>& arcCosts )
+{
+  int nArcs = mGraph->arcCount();
+  start.fill( 0, mVertexCount + 1 );
+  for ( int i = 0; i < nArcs; ++i )
+  {
+    const QgsGraphArc& arc = mGraph->arc( i );
+    ++start[( outgoing ? arc.outVertex() : arc.inVertex() ) + 1];
+  }
+  for ( int v = 0; v < mVertexCount; ++v )
+  {
+    start[v + 1] += start[v];
+  }
+
+  arcs.resize( nArcs );
+  vertices.resize( nArcs );
+  arcCosts.resize( nArcs );
+  QVector<int> next = start;
+  for ( int i = 0; i < nArcs; ++i )
+  {
+    const QgsGraphArc& arc = mGraph->arc( i );
+    int pos = next[ outgoing ? arc.outVertex() : arc.inVertex()]++;
+    arcs[pos] = i;
+    vertices[pos] = outgoing ? arc.inVertex() : arc.outVertex();
+    arcCosts[pos] = costs[i];
+  }
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+    qgscompactgraph.h
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPHH
+#define QGSCOMPACTGRAPHH
+
+//QT-includes
+#include <QVector>
+
+//QGIS-includes
+#include <qgspoint.h>
+
+// forward-declaration
+class QgsGraph;
+
+/** \ingroup networkanalysis
+ * Arcs of a QgsGraph grouped by vertex in contiguous arrays (compressed sparse row layout),
+ * with the cost of one optimization criterion converted to double once for each arc.
+ * Build it once and pass it to QgsGraphAnalyzer to answer many queries on the same graph.
+ * The source graph must outlive the compact graph and must not change while it is used.
+ * @note added in 2.0
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+    /**
+     * prepare the graph for queries
+     * @param graph The source graph
+     * @param criterionNum index of arc property as optimization criterion
+     */
+    QgsCompactGraph( const QgsGraph* graph, int criterionNum );
+
+    //! the source graph
+    const QgsGraph* graph() const { return mGraph; }
+
+    //! index of arc property used as optimization criterion
+    int criterionNum() const { return mCriterionNum; }
+
+    //! number of vertices of the source graph
+    int vertexCount() const { return mVertexCount; }
+
+    //! outgoing arcs of vertex v are at outStart()[v] .. outStart()[v+1]-1
+    const QVector<int>& outStart() const { return mOutStart; }
+    //! source graph index of each outgoing arc
+    const QVector<int>& outArc() const { return mOutArc; }
+    //! end vertex of each outgoing arc
+    const QVector<int>& outVertex() const { return mOutVertex; }
+    //! cost of each outgoing arc
+    const QVector<double>& outCost() const { return mOutCost; }
+
+    //! incoming arcs of vertex v are at inStart()[v] .. inStart()[v+1]-1
+    const QVector<int>& inStart() const { return mInStart; }
+    //! source graph index of each incoming arc
+    const QVector<int>& inArc() const { return mInArc; }
+    //! start vertex of each incoming arc
+    const QVector<int>& inVertex() const { return mInVertex; }
+    //! cost of each incoming arc
+    const QVector<double>& inCost() const { return mInCost; }
+
+    //! coordinates of the vertices
+    const QVector<QgsPoint>& points() const { return mPoints; }
+
+    /**
+     * lowest cost per distance unit of all arcs. Multiplied by the straight line distance
+     * it gives a lower bound of the real cost, as used by A*. It is 0 if there is no
+     * such bound (negative costs or no arc with a length)
+     */
+    double heuristicFactor() const { return mHeuristicFactor; }
+
+  private:
+    void build( const QVector<double>& costs, bool outgoing,
+                QVector<int>& start, QVector<int>& arcs, QVector<int>& vertices, QVector<double>& arcCosts );
+
+    const QgsGraph* mGraph;
+    int mCriterionNum;
+    int mVertexCount;
+
+    QVector<int> mOutStart;
+    QVector<int> mOutArc;
+    QVector<int> mOutVertex;
+    QVector<double> mOutCost;
+
+    QVector<int> mInStart;
+    QVector<int> mInArc;
+    QVector<int> mInVertex;
+    QVector<double> mInCost;
+
+    QVector<QgsPoint> mPoints;
+    double mHeuristicFactor;
+};
+
+#endif //QGSCOMPACTGRAPHH
@@ -16,6 +16,15 @@
 
 #include "qgsgraph.h"
 
+#include <QByteArray>
+
+static uint qgsPointHash( const QgsPoint& pt )
+{
+  // 0.0 and -0.0 are equal points with different bits
+  double xy[2] = { pt.x() == 0.0 ? 0.0 : pt.x(), pt.y() == 0.0 ? 0.0 : pt.y() };
+  return qHash( QByteArray::fromRawData( reinterpret_cast<const char*>( xy ), sizeof( xy ) ) );
+}
+
 QgsGraph::QgsGraph()
 {
 }
@@ -29,6 +38,7 @@ QgsGraph::~QgsGraph()
 int QgsGraph::addVertex( const QgsPoint& pt )
 {
   mGraphVertexes.append( QgsGraphVertex( pt ) );
+  mVertexIndex.insert( qgsPointHash( pt ), mGraphVertexes.size() - 1 );
   return mGraphVertexes.size() - 1;
 }
 
@@ -71,15 +81,18 @@ int QgsGraph::arcCount() const
 
 int QgsGraph::findVertex( const QgsPoint& pt ) const
 {
-  int i = 0;
-  for ( i = 0; i < mGraphVertexes.size(); ++i )
+  // return the first of the vertices with the same coordinates
+  int result = -1;
+  uint key = qgsPointHash( pt );
+  QMultiHash< uint, int >::const_iterator it = mVertexIndex.find( key );
+  for ( ; it != mVertexIndex.constEnd() && it.key() == key; ++it )
   {
-    if ( mGraphVertexes[ i ].point() == pt )
+    if ( mGraphVertexes[ it.value()].point() == pt && ( result == -1 || it.value() < result ) )
     {
-      return i;
+      result = it.value();
     }
   }
-  return -1;
+  return result;
 }
 
 QgsGraphArc::QgsGraphArc()
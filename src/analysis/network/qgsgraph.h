@@ -28,6 +28,7 @@
 
 // QT4 includes
 #include <QList>
+#include <QMultiHash>
 #include <QVector>
 #include <QVariant>
 
@@ -176,6 +177,9 @@ class ANALYSIS_EXPORT QgsGraph
     QVector<QgsGraphVertex> mGraphVertexes;
 
     QVector<QgsGraphArc> mGraphArc;
+
+    //! vertex indexes by hash of their coordinates
+    QMultiHash< uint, int > mVertexIndex;
 };
 
 #endif //QGSGRAPHH
@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 // C++ standard includes
+#include <cmath>
 #include <limits>
 
 // QT includes
@@ -25,65 +26,165 @@
 //QGIS-uncludes
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
-void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int criterionNum, QVector<int>* resultTree, QVector<double>* resultCost )
+/**
+ * Binary min-heap of vertices which keeps the position of each vertex,
+ * so that the cost of a queued vertex can be decreased in place.
+ */
+class QgsVertexHeap
 {
-  QVector< double > * result = NULL;
-  if ( resultCost != NULL )
-  {
-    result = resultCost;
-  }
-  else
-  {
-    result = new QVector<double>();
-  }
+  public:
+    explicit QgsVertexHeap( int vertexCount ) : mPos( vertexCount, -1 ) {}
 
-  result->clear();
-  result->insert( result->begin(), source->vertexCount(), std::numeric_limits<double>::infinity() );
-  ( *result )[ startPointIdx ] = 0.0;
+    bool isEmpty() const { return mHeap.isEmpty(); }
 
-  if ( resultTree != NULL )
+    double topCost() const { return mHeap[0].first; }
+
+    //! remove and return the vertex with the lowest cost
+    int pop()
+    {
+      int vertex = mHeap[0].second;
+      mPos[vertex] = -1;
+      QPair<double, int> last = mHeap.last();
+      mHeap.pop_back();
+      if ( !mHeap.isEmpty() )
+      {
+        mHeap[0] = last;
+        mPos[last.second] = 0;
+        down( 0 );
+      }
+      return vertex;
+    }
+
+    //! insert the vertex or lower its cost
+    void push( int vertex, double cost )
+    {
+      int i = mPos[vertex];
+      if ( i < 0 )
+      {
+        i = mHeap.size();
+        mHeap.append( qMakePair( cost, vertex ) );
+        mPos[vertex] = i;
+      }
+      else
+      {
+        mHeap[i].first = cost;
+      }
+      up( i );
+    }
+
+  private:
+    void up( int i )
+    {
+      QPair<double, int> item = mHeap[i];
+      while ( i > 0 )
+      {
+        int parent = ( i - 1 ) / 2;
+        if ( mHeap[parent].first <= item.first )
+          break;
+        mHeap[i] = mHeap[parent];
+        mPos[mHeap[i].second] = i;
+        i = parent;
+      }
+      mHeap[i] = item;
+      mPos[item.second] = i;
+    }
+
+    void down( int i )
+    {
+      int n = mHeap.size();
+      QPair<double, int> item = mHeap[i];
+      while ( true )
+      {
+        int child = 2 * i + 1;
+        if ( child >= n )
+          break;
+        if ( child + 1 < n && mHeap[child + 1].first < mHeap[child].first )
+          ++child;
+        if ( item.first <= mHeap[child].first )
+          break;
+        mHeap[i] = mHeap[child];
+        mPos[mHeap[i].second] = i;
+        i = child;
+      }
+      mHeap[i] = item;
+      mPos[item.second] = i;
+    }
+
+    QVector< QPair<double, int> > mHeap;
+    QVector<int> mPos;
+};
+
+/**
+ * Dijkstra or A* search from startVertexIdx. The search ends when stopVertexIdx is settled
+ * (-1 to search the whole graph). The estimated cost to the stop vertex is the straight
+ * line distance multiplied by the heuristic factor of the graph (only if useHeuristic).
+ */
+static void searchForward( const QgsCompactGraph& graph, int startVertexIdx, int stopVertexIdx,
+                           bool useHeuristic, QVector<int>& tree, QVector<double>& cost )
+{
+  int vertexCount = graph.vertexCount();
+  cost.fill( std::numeric_limits<double>::infinity(), vertexCount );
+  tree.fill( -1, vertexCount );
+  cost[ startVertexIdx ] = 0.0;
+
+  const QVector<int>& outStart = graph.outStart();
+  const QVector<int>& outArc = graph.outArc();
+  const QVector<int>& outVertex = graph.outVertex();
+  const QVector<double>& outCost = graph.outCost();
+  const QVector<QgsPoint>& points = graph.points();
+  double heuristicFactor = useHeuristic ? graph.heuristicFactor() : 0.0;
+  QgsPoint stopPoint;
+  if ( heuristicFactor > 0 )
   {
-    resultTree->clear();
-    resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
+    stopPoint = points[ stopVertexIdx ];
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and not create any struct or class.
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
-
-  not_begin.insert( 0.0, startPointIdx );
+  QgsVertexHeap heap( vertexCount );
+  heap.push( startVertexIdx, 0.0 );
 
-  while ( !not_begin.empty() )
+  while ( !heap.isEmpty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
-
-    // edge index list
-    QgsGraphArcIdList l = source->vertex( curVertex ).outArc();
-    QgsGraphArcIdList::iterator arcIt;
-    for ( arcIt = l.begin(); arcIt != l.end(); ++arcIt )
-    {
-      const QgsGraphArc arc = source->arc( *arcIt );
-      double cost = arc.property( criterionNum ).toDouble() + curCost;
+    int curVertex = heap.pop();
+    if ( curVertex == stopVertexIdx )
+      break;
 
-      if ( cost < ( *result )[ arc.inVertex()] )
+    double curCost = cost[ curVertex ];
+    for ( int i = outStart[ curVertex ]; i < outStart[ curVertex + 1 ]; ++i )
+    {
+      int inVertex = outVertex[i];
+      double arcCost = curCost + outCost[i];
+      if ( arcCost < cost[ inVertex ] )
       {
-        ( *result )[ arc.inVertex()] = cost;
-        if ( resultTree != NULL )
-        {
-          ( *resultTree )[ arc.inVertex()] = *arcIt;
-        }
-        not_begin.insert( cost, arc.inVertex() );
+        cost[ inVertex ] = arcCost;
+        tree[ inVertex ] = outArc[i];
+        double estimate = heuristicFactor > 0 ? heuristicFactor * sqrt( points[ inVertex ].sqrDist( stopPoint ) ) : 0.0;
+        heap.push( inVertex, arcCost + estimate );
       }
     }
   }
-  if ( resultCost == NULL )
+}
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int criterionNum, QVector<int>* resultTree, QVector<double>* resultCost )
+{
+  QgsCompactGraph graph( source, criterionNum );
+  dijkstra( &graph, startPointIdx, resultTree, resultCost );
+}
+
+void QgsGraphAnalyzer::dijkstra( const QgsCompactGraph* graph, int startPointIdx, QVector<int>* resultTree, QVector<double>* resultCost )
+{
+  QVector<int> tree;
+  QVector<double> cost;
+  searchForward( *graph, startPointIdx, -1, false, tree, cost );
+
+  if ( resultTree != NULL )
+  {
+    *resultTree = tree;
+  }
+  if ( resultCost != NULL )
   {
-    delete result;
+    *resultCost = cost;
   }
 }
 
@@ -122,3 +223,131 @@ QgsGraph* QgsGraphAnalyzer::shortestTree( const QgsGraph* source, int startVerte
 
   return treeResult;
 }
+
+
+QList<int> QgsGraphAnalyzer::shortestPath( const QgsGraph* source, int startVertexIdx, int stopVertexIdx, int criterionNum,
+    Algorithm algorithm, double* pathCost )
+{
+  QgsCompactGraph graph( source, criterionNum );
+  return shortestPath( &graph, startVertexIdx, stopVertexIdx, algorithm, pathCost );
+}
+
+QList<int> QgsGraphAnalyzer::shortestPath( const QgsCompactGraph* graph, int startVertexIdx, int stopVertexIdx,
+    Algorithm algorithm, double* pathCost )
+{
+  QList<int> path;
+  double inf = std::numeric_limits<double>::infinity();
+  if ( pathCost != NULL )
+  {
+    *pathCost = inf;
+  }
+
+  const QgsGraph* source = graph->graph();
+  int vertexCount = graph->vertexCount();
+  if ( startVertexIdx < 0 || startVertexIdx >= vertexCount ||
+       stopVertexIdx < 0 || stopVertexIdx >= vertexCount )
+  {
+    return path;
+  }
+  if ( startVertexIdx == stopVertexIdx )
+  {
+    if ( pathCost != NULL )
+    {
+      *pathCost = 0.0;
+    }
+    return path;
+  }
+
+  if ( algorithm != Bidirectional )
+  {
+    QVector<int> tree;
+    QVector<double> cost;
+    searchForward( *graph, startVertexIdx, stopVertexIdx, algorithm == AStar, tree, cost );
+    if ( tree[ stopVertexIdx ] == -1 )
+    {
+      return path;
+    }
+
+    for ( int v = stopVertexIdx; v != startVertexIdx; v = source->arc( tree[v] ).outVertex() )
+    {
+      path.prepend( tree[v] );
+    }
+    if ( pathCost != NULL )
+    {
+      *pathCost = cost[ stopVertexIdx ];
+    }
+    return path;
+  }
+
+  // bidirectional search: forward from the start along outgoing arcs,
+  // backward from the stop vertex along incoming arcs
+  QVector<double> costForward( vertexCount, inf );
+  QVector<double> costBackward( vertexCount, inf );
+  QVector<int> treeForward( vertexCount, -1 );
+  QVector<int> treeBackward( vertexCount, -1 );
+  QgsVertexHeap heapForward( vertexCount );
+  QgsVertexHeap heapBackward( vertexCount );
+
+  costForward[ startVertexIdx ] = 0.0;
+  costBackward[ stopVertexIdx ] = 0.0;
+  heapForward.push( startVertexIdx, 0.0 );
+  heapBackward.push( stopVertexIdx, 0.0 );
+
+  double best = inf;
+  int meetVertex = -1;
+
+  while ( !heapForward.isEmpty() && !heapBackward.isEmpty() )
+  {
+    // no path through unsettled vertices can be shorter than the best one found
+    if ( heapForward.topCost() + heapBackward.topCost() >= best )
+      break;
+
+    bool forward = heapForward.topCost() <= heapBackward.topCost();
+    QgsVertexHeap& heap = forward ? heapForward : heapBackward;
+    QVector<double>& cost = forward ? costForward : costBackward;
+    const QVector<double>& otherCost = forward ? costBackward : costForward;
+    QVector<int>& tree = forward ? treeForward : treeBackward;
+    const QVector<int>& start = forward ? graph->outStart() : graph->inStart();
+    const QVector<int>& arcs = forward ? graph->outArc() : graph->inArc();
+    const QVector<int>& vertices = forward ? graph->outVertex() : graph->inVertex();
+    const QVector<double>& arcCosts = forward ? graph->outCost() : graph->inCost();
+
+    int curVertex = heap.pop();
+    double curCost = cost[ curVertex ];
+    for ( int i = start[ curVertex ]; i < start[ curVertex + 1 ]; ++i )
+    {
+      int v = vertices[i];
+      double arcCost = curCost + arcCosts[i];
+      if ( arcCost < cost[ v ] )
+      {
+        cost[ v ] = arcCost;
+        tree[ v ] = arcs[i];
+        heap.push( v, arcCost );
+      }
+      if ( arcCost + otherCost[ v ] < best )
+      {
+        best = arcCost + otherCost[ v ];
+        meetVertex = v;
+      }
+    }
+  }
+
+  if ( meetVertex == -1 )
+  {
+    return path;
+  }
+
+  for ( int v = meetVertex; v != startVertexIdx; v = source->arc( treeForward[v] ).outVertex() )
+  {
+    path.prepend( treeForward[v] );
+  }
+  for ( int v = meetVertex; v != stopVertexIdx; v = source->arc( treeBackward[v] ).inVertex() )
+  {
+    path.append( treeBackward[v] );
+  }
+  if ( pathCost != NULL )
+  {
+    *pathCost = best;
+  }
+  return path;
+}
@@ -19,10 +19,12 @@
 #define QGSGRAPHANALYZERH
 
 //QT-includes
+#include <QList>
 #include <QVector>
 
 // forward-declaration
 class QgsGraph;
+class QgsCompactGraph;
 
 /** \ingroup networkanalysis
  * The QGis class provides graph analysis functions
@@ -31,6 +33,17 @@ class QgsGraph;
 class ANALYSIS_EXPORT QgsGraphAnalyzer
 {
   public:
+    /**
+     * Algorithm used by shortestPath()
+     * @note added in 2.0
+     */
+    enum Algorithm
+    {
+      Dijkstra,      //!< Dijkstra search stopped at the stop vertex
+      AStar,         //!< A* search with the straight line distance to the stop vertex as the heuristic
+      Bidirectional  //!< Dijkstra search from both the start and the stop vertex
+    };
+
     /**
      * solve shortest path problem using dijkstra algorithm
      * @param source The source graph
@@ -41,6 +54,17 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      */
     static void dijkstra( const QgsGraph* source, int startVertexIdx, int criterionNum, QVector<int>* resultTree = NULL, QVector<double>* resultCost = NULL );
 
+    /**
+     * solve shortest path problem using dijkstra algorithm on a prepared graph.
+     * Use it instead of the QgsGraph variant to run many queries on the same graph.
+     * @param graph The prepared graph, its criterion is the optimization criterion
+     * @param startVertexIdx index of start vertex
+     * @param treeResult array represents the shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex if vertex reacheble and resultTree[ vertexIndex ] == -1 others.
+     * @param resultCost array of cost paths
+     * @note added in 2.0
+     */
+    static void dijkstra( const QgsCompactGraph* graph, int startVertexIdx, QVector<int>* resultTree = NULL, QVector<double>* resultCost = NULL );
+
     /**
      * return shortest path tree with root-node in startVertexIdx
      * @param source The source graph
@@ -48,5 +72,38 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      * @param criterionNum index of edge property as optimization criterion
      */
     static QgsGraph* shortestTree( const QgsGraph* source, int startVertexIdx, int criterionNum );
+
+    /**
+     * solve the point-to-point shortest path problem
+     * @param source The source graph
+     * @param startVertexIdx index of start vertex
+     * @param stopVertexIdx index of stop vertex
+     * @param criterionNum index of arc property as optimization criterion
+     * @param algorithm search algorithm. A* estimates the remaining cost by the straight line
+     * distance to the stop vertex scaled by the lowest cost per distance unit of all arcs,
+     * so it finds the same paths as Dijkstra
+     * @param pathCost if not NULL it receives the cost of the path (infinity if there is no path)
+     * @return indexes of the path arcs from the start to the stop vertex, empty list if
+     * there is no path or the start vertex is the stop vertex
+     * @note added in 2.0
+     */
+    static QList<int> shortestPath( const QgsGraph* source, int startVertexIdx, int stopVertexIdx, int criterionNum,
+                                    Algorithm algorithm = AStar, double* pathCost = NULL );
+
+    /**
+     * solve the point-to-point shortest path problem on a prepared graph.
+     * Use it instead of the QgsGraph variant to run many queries on the same graph,
+     * the arc costs and the A* estimate are then computed only once.
+     * @param graph The prepared graph, its criterion is the optimization criterion
+     * @param startVertexIdx index of start vertex
+     * @param stopVertexIdx index of stop vertex
+     * @param algorithm search algorithm
+     * @param pathCost if not NULL it receives the cost of the path (infinity if there is no path)
+     * @return indexes of the path arcs from the start to the stop vertex, empty list if
+     * there is no path or the start vertex is the stop vertex
+     * @note added in 2.0
+     */
+    static QList<int> shortestPath( const QgsCompactGraph* graph, int startVertexIdx, int stopVertexIdx,
+                                    Algorithm algorithm = AStar, double* pathCost = NULL );
 };
 #endif //QGSGRAPHANALYZERH
@@ -55,34 +55,188 @@ class QgsPointCompare
     double mTolerance;
 };
 
-template <typename RandIter, typename Type, typename CompareOp > RandIter my_binary_search( RandIter begin, RandIter end, Type val, CompareOp comp )
+class QgsPointEquivalent
 {
-  // result if not found
-  RandIter not_found = end;
+  public:
+    QgsPointEquivalent( const QgsPointCompare& compare ) :
+        mCompare( compare )
+    {  }
 
-  while ( true )
-  {
-    RandIter avg = begin + ( end - begin ) / 2;
-    if ( begin == avg || end == avg )
+    bool operator()( const QgsPoint& p1, const QgsPoint& p2 ) const
     {
-      if ( !comp( *begin, val ) && !comp( val, *begin ) )
-        return begin;
-      if ( !comp( *end, val ) && !comp( val, *end ) )
-        return end;
-
-      return not_found;
+      return !mCompare( p1, p2 ) && !mCompare( p2, p1 );
     }
-    if ( comp( val, *avg ) )
-      end = avg;
-    else if ( comp( *avg, val ) )
-      begin = avg;
-    else
-      return avg;
-  }
 
-  return not_found;
+  private:
+    QgsPointCompare mCompare;
+};
+
+//! index of the point equivalent to pt in sorted points, -1 if there is none
+static int findPoint( const QVector< QgsPoint >& points, const QgsPoint& pt, const QgsPointCompare& compare )
+{
+  QVector< QgsPoint >::const_iterator it = std::lower_bound( points.begin(), points.end(), pt, compare );
+  if ( it == points.end() || compare( pt, *it ) )
+    return -1;
+  return it - points.begin();
 }
 
+/**
+ * Uniform grid of line segments to find the nearest segment of a point.
+ * Each segment is listed in all the cells its bounding box overlaps.
+ */
+class QgsSegmentGrid
+{
+  public:
+    QgsSegmentGrid( const QVector< QgsPoint >& segmentStart, const QVector< QgsPoint >& segmentEnd ) :
+        mStart( segmentStart ), mEnd( segmentEnd ), mCols( 0 ), mRows( 0 )
+    {
+      int n = mStart.size();
+      if ( n == 0 )
+        return;
+
+      double xMax = -std::numeric_limits<double>::max();
+      double yMax = -std::numeric_limits<double>::max();
+      mXMin = std::numeric_limits<double>::max();
+      mYMin = std::numeric_limits<double>::max();
+      double lengthSum = 0.0;
+      for ( int i = 0; i < n; ++i )
+      {
+        mXMin = qMin( mXMin, qMin( mStart[i].x(), mEnd[i].x() ) );
+        mYMin = qMin( mYMin, qMin( mStart[i].y(), mEnd[i].y() ) );
+        xMax = qMax( xMax, qMax( mStart[i].x(), mEnd[i].x() ) );
+        yMax = qMax( yMax, qMax( mStart[i].y(), mEnd[i].y() ) );
+        lengthSum += qMax( qAbs( mEnd[i].x() - mStart[i].x() ), qAbs( mEnd[i].y() - mStart[i].y() ) );
+      }
+
+      // about one segment per cell, but cells not smaller than an average segment
+      double width = xMax - mXMin;
+      double height = yMax - mYMin;
+      mCellSize = qMax( sqrt( width * height / n ), lengthSum / n );
+      mCellSize = qMax( mCellSize, qMax( width, height ) / n );
+      if ( mCellSize <= 0 )
+        mCellSize = 1.0;
+      mCols = ( int ) floor( width / mCellSize ) + 1;
+      mRows = ( int ) floor( height / mCellSize ) + 1;
+
+      // counting sort of the segments by cell
+      mCellStart.fill( 0, mCols * mRows + 1 );
+      for ( int pass = 0; pass < 2; ++pass )
+      {
+        QVector< int > next;
+        if ( pass == 1 )
+        {
+          for ( int c = 0; c < mCols * mRows; ++c )
+            mCellStart[c + 1] += mCellStart[c];
+          next = mCellStart;
+          mCellSegments.resize( mCellStart.last() );
+        }
+
+        for ( int i = 0; i < n; ++i )
+        {
+          int x0 = column( qMin( mStart[i].x(), mEnd[i].x() ) );
+          int x1 = column( qMax( mStart[i].x(), mEnd[i].x() ) );
+          int y0 = row( qMin( mStart[i].y(), mEnd[i].y() ) );
+          int y1 = row( qMax( mStart[i].y(), mEnd[i].y() ) );
+          for ( int y = y0; y <= y1; ++y )
+          {
+            for ( int x = x0; x <= x1; ++x )
+            {
+              if ( pass == 0 )
+                ++mCellStart[ y * mCols + x + 1 ];
+              else
+                mCellSegments[ next[ y * mCols + x ]++ ] = i;
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * find the nearest segment, the first one in the segment order if there are more
+     * @return segment index, -1 if there are no segments
+     */
+    int nearestSegment( const QgsPoint& pt, double& sqrDist, QgsPoint& nearestPoint ) const
+    {
+      int result = -1;
+      sqrDist = std::numeric_limits<double>::infinity();
+      if ( mCols == 0 )
+        return result;
+
+      // the cell of the point, it may lie outside of the grid
+      int px = ( int ) floor( qBound( -1e9, ( pt.x() - mXMin ) / mCellSize, 1e9 ) );
+      int py = ( int ) floor( qBound( -1e9, ( pt.y() - mYMin ) / mCellSize, 1e9 ) );
+      int rMin = qMax( qMax( -px, px - mCols + 1 ), qMax( -py, py - mRows + 1 ) );
+      int rMax = qMax( qMax( px, mCols - 1 - px ), qMax( py, mRows - 1 - py ) );
+
+      // search rings of cells around the point until no closer segment can be found
+      for ( int r = qMax( rMin, 0 ); r <= rMax; ++r )
+      {
+        for ( int y = qMax( py - r, 0 ); y <= qMin( py + r, mRows - 1 ); ++y )
+        {
+          bool fullRow = y == py - r || y == py + r;
+          int step = fullRow || r == 0 ? 1 : 2 * r;
+          for ( int x = px - r; x <= px + r; x += step )
+          {
+            if ( x < 0 || x >= mCols )
+              continue;
+
+            for ( int c = mCellStart[ y * mCols + x ]; c < mCellStart[ y * mCols + x + 1 ]; ++c )
+            {
+              int i = mCellSegments[c];
+              QgsPoint segmentPoint;
+              double d;
+              if ( mStart[i].x() == mEnd[i].x() && mStart[i].y() == mEnd[i].y() )
+              {
+                d = pt.sqrDist( mStart[i] );
+                segmentPoint = mStart[i];
+              }
+              else
+              {
+                d = pt.sqrDistToSegment( mStart[i].x(), mStart[i].y(), mEnd[i].x(), mEnd[i].y(), segmentPoint );
+              }
+
+              if ( d < sqrDist || ( d == sqrDist && i < result ) )
+              {
+                sqrDist = d;
+                nearestPoint = segmentPoint;
+                result = i;
+              }
+            }
+          }
+        }
+
+        // cells of the next rings are at least r cells away
+        double searched = r * mCellSize;
+        if ( result != -1 && sqrDist <= searched * searched )
+          break;
+      }
+      return result;
+    }
+
+  private:
+    int column( double x ) const
+    {
+      return qBound( 0, ( int ) floor(( x - mXMin ) / mCellSize ), mCols - 1 );
+    }
+
+    int row( double y ) const
+    {
+      return qBound( 0, ( int ) floor(( y - mYMin ) / mCellSize ), mRows - 1 );
+    }
+
+    const QVector< QgsPoint >& mStart;
+    const QVector< QgsPoint >& mEnd;
+    double mXMin;
+    double mYMin;
+    double mCellSize;
+    int mCols;
+    int mRows;
+
+    //! segments of cell c are mCellSegments[ mCellStart[c] ] .. mCellSegments[ mCellStart[c+1]-1 ]
+    QVector< int > mCellStart;
+    QVector< int > mCellSegments;
+};
+
 struct TiePointInfo
 {
   QgsPoint mTiedPoint;
@@ -161,6 +315,9 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
   QgsFeatureIterator fit = vl->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
 
   // begin: tie points to the graph
+  QVector< QgsPoint > segmentStart;
+  QVector< QgsPoint > segmentEnd;
+
   QgsAttributeList la;
   QgsFeature feature;
   while ( fit.nextFeature( feature ) )
@@ -182,33 +339,10 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
         pt2 = ct.transform( *pointIt );
         points.push_back( pt2 );
 
-        if ( !isFirstPoint )
+        if ( !isFirstPoint && !additionalPoints.isEmpty() )
         {
-          int i = 0;
-          for ( i = 0; i != additionalPoints.size(); ++i )
-          {
-            TiePointInfo info;
-            if ( pt1 == pt2 )
-            {
-              info.mLength = additionalPoints[ i ].sqrDist( pt1 );
-              info.mTiedPoint = pt1;
-            }
-            else
-            {
-              info.mLength = additionalPoints[ i ].sqrDistToSegment( pt1.x(), pt1.y(),
-                             pt2.x(), pt2.y(), info.mTiedPoint );
-            }
-
-            if ( pointLengthMap[ i ].mLength > info.mLength )
-            {
-              Q_UNUSED( info.mTiedPoint );
-              info.mFirstPoint = pt1;
-              info.mLastPoint = pt2;
-
-              pointLengthMap[ i ] = info;
-              tiedPoint[ i ] = info.mTiedPoint;
-            }
-          }
+          segmentStart.push_back( pt1 );
+          segmentEnd.push_back( pt2 );
         }
         pt1 = pt2;
         isFirstPoint = false;
@@ -216,10 +350,26 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
     }
     emit buildProgress( ++step, featureCount );
   }
+
+  QgsSegmentGrid segmentGrid( segmentStart, segmentEnd );
+  int i = 0;
+  for ( i = 0; i < additionalPoints.size(); ++i )
+  {
+    TiePointInfo info;
+    int segment = segmentGrid.nearestSegment( additionalPoints[ i ], info.mLength, info.mTiedPoint );
+    if ( segment == -1 )
+      continue;
+
+    info.mFirstPoint = segmentStart[ segment ];
+    info.mLastPoint = segmentEnd[ segment ];
+    pointLengthMap[ i ] = info;
+    tiedPoint[ i ] = info.mTiedPoint;
+  }
+  segmentStart.clear();
+  segmentEnd.clear();
   // end: tie points to graph
 
   // add tied point to graph
-  int i = 0;
   for ( i = 0; i < tiedPoint.size(); ++i )
   {
     if ( tiedPoint[ i ] != QgsPoint( 0.0, 0.0 ) )
@@ -230,15 +380,20 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
 
   QgsPointCompare pointCompare( builder->topologyTolerance() );
 
+  // points closer than the topology tolerance become one vertex
   qSort( points.begin(), points.end(), pointCompare );
-  QVector< QgsPoint >::iterator tmp = std::unique( points.begin(), points.end() );
+  QVector< QgsPoint >::iterator tmp = std::unique( points.begin(), points.end(), QgsPointEquivalent( pointCompare ) );
   points.resize( tmp - points.begin() );
 
   for ( i = 0;i < points.size();++i )
     builder->addVertex( i, points[ i ] );
 
   for ( i = 0; i < tiedPoint.size() ; ++i )
-    tiedPoint[ i ] = *( my_binary_search( points.begin(), points.end(), tiedPoint[ i ], pointCompare ) );
+  {
+    int idx = findPoint( points, tiedPoint[ i ], pointCompare );
+    if ( idx != -1 )
+      tiedPoint[ i ] = points[ idx ];
+  }
 
   qSort( pointLengthMap.begin(), pointLengthMap.end(), TiePointInfoCompare );
 
@@ -325,25 +480,11 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
           TiePointInfo t;
           t.mFirstPoint = pt1;
           t.mLastPoint  = pt2;
-          pointLengthIt = my_binary_search( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
-
-          if ( pointLengthIt != pointLengthMap.end() )
+          std::pair< QVector< TiePointInfo >::iterator, QVector< TiePointInfo >::iterator > range =
+            std::equal_range( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
+          for ( pointLengthIt = range.first; pointLengthIt != range.second; ++pointLengthIt )
           {
-            QVector< TiePointInfo >::iterator it;
-            for ( it = pointLengthIt; it - pointLengthMap.begin() >= 0; --it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
-            for ( it = pointLengthIt + 1; it != pointLengthMap.end(); ++it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
+            pointsOnArc[ pt1.sqrDist( pointLengthIt->mTiedPoint )] = pointLengthIt->mTiedPoint;
           }
 
           std::map< double, QgsPoint >::iterator pointsIt;
@@ -353,10 +494,10 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
           bool isFirstPoint = true;
           for ( pointsIt = pointsOnArc.begin(); pointsIt != pointsOnArc.end(); ++pointsIt )
           {
-            pt2 = pointsIt->second;
-            tmp = my_binary_search( points.begin(), points.end(), pt2, pointCompare );
-            pt2 = *tmp;
-            pt2idx = tmp - points.begin();
+            pt2idx = findPoint( points, pointsIt->second, pointCompare );
+            if ( pt2idx == -1 )
+              continue;
+            pt2 = points[ pt2idx ];
 
             if ( !isFirstPoint && pt1 != pt2 )
             {
@@ -16,6 +16,8 @@
  ***************************************************************************/
 
 #include "qgsaspectfilter.h"
+#include <typeinfo>
+#include <QVector>
 
 QgsAspectFilter::QgsAspectFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat ) :
     QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -33,18 +35,46 @@ float QgsAspectFilter::processNineCellWindow(
   float* x12, float* x22, float* x32,
   float* x13, float* x23, float* x33 )
 {
-  float derX = calcFirstDerX( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
-  float derY = calcFirstDerY( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
+  float rowAbove[3], row[3], rowBelow[3], result;
+  windowToRows( x11, x21, x31, x12, x22, x32, x13, x23, x33, rowAbove, row, rowBelow );
+  aspectRow( rowAbove, row, rowBelow, &result, 1 );
+  return result;
+}
 
-  if ( derX == mOutputNodataValue ||
-       derY == mOutputNodataValue ||
-       ( derX == 0.0 && derY == 0.0 ) )
+void QgsAspectFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  //subclasses may reimplement processNineCellWindow
+  if ( typeid( *this ) != typeid( QgsAspectFilter ) )
   {
-    return mOutputNodataValue;
+    QgsNineCellFilter::processRow( rowAbove, row, rowBelow, result, width );
+    return;
   }
-  else
+  aspectRow( rowAbove, row, rowBelow, result, width );
+}
+
+bool QgsAspectFilter::prepareForConcurrentUse()
+{
+  //the window function of a subclass might not be safe to call from several threads
+  return typeid( *this ) == typeid( QgsAspectFilter );
+}
+
+void QgsAspectFilter::aspectRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  QVector<float> derY( width );
+  calcFirstDerRow( rowAbove, row, rowBelow, result, derY.data(), width );
+
+  for ( int j = 0; j < width; ++j )
   {
-    return 180.0 + atan2( derX, derY ) * 180.0 / M_PI;
+    float derX = result[j];
+    if ( derX == mOutputNodataValue ||
+         derY[j] == mOutputNodataValue ||
+         ( derX == 0.0 && derY[j] == 0.0 ) )
+    {
+      result[j] = mOutputNodataValue;
+    }
+    else
+    {
+      result[j] = 180.0 + atan2( derX, derY[j] ) * 180.0 / M_PI;
+    }
   }
 }
-
@@ -33,6 +33,13 @@ class ANALYSIS_EXPORT QgsAspectFilter: public QgsDerivativeFilter
                                  float* x12, float* x22, float* x32,
                                  float* x13, float* x23, float* x33 );
 
+    void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
+    bool prepareForConcurrentUse();
+
+  private:
+    //! the aspect of a row of cells, used for objects of this class and by processNineCellWindow
+    void aspectRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
 };
 
 #endif // QGSASPECTFILTER_H
@@ -28,64 +28,40 @@ QgsDerivativeFilter::~QgsDerivativeFilter()
 
 }
 
-float QgsDerivativeFilter::calcFirstDerX( float* x11, float* x21, float* x31, float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 )
+//adds the difference between the last and the first of three cells in a row of the 3x3 window. If one of them is nodata,
+//the difference to the middle cell is taken with half of the weight (probably 3x3 window is at the border)
+static inline void addDerivativeTerm( float first, float middle, float last, float nodata, int factor, double& sum, int& weight )
 {
-  //the basic formula would be simple, but we need to test for nodata values...
-  //return (( (*x31 - *x11) + 2 * (*x32 - *x12) + (*x33 - *x13) ) / (8 * mCellSizeX));
-
-  int weight = 0;
-  double sum = 0;
-
-  //first row
-  if ( *x31 != mInputNodataValue && *x11 != mInputNodataValue ) //the normal case
+  bool hasFirst = first != nodata;
+  bool hasMiddle = middle != nodata;
+  bool hasLast = last != nodata;
+  if ( hasFirst && hasLast ) //the normal case
   {
-    sum += ( *x31 - *x11 );
-    weight += 2;
+    sum += factor * ( last - first );
+    weight += 2 * factor;
   }
-  else if ( *x31 == mInputNodataValue && *x11 != mInputNodataValue && *x21 != mInputNodataValue ) //probably 3x3 window is at the border
+  else if ( hasFirst && hasMiddle )
   {
-    sum += ( *x21 - *x11 );
-    weight += 1;
+    sum += factor * ( middle - first );
+    weight += factor;
   }
-  else if ( *x11 == mInputNodataValue && *x31 != mInputNodataValue && *x21 != mInputNodataValue ) //probably 3x3 window is at the border
+  else if ( hasLast && hasMiddle )
   {
-    sum += ( *x31 - *x21 );
-    weight += 1;
+    sum += factor * ( last - middle );
+    weight += factor;
   }
+}
 
-  //second row
-  if ( *x32 != mInputNodataValue && *x12 != mInputNodataValue ) //the normal case
-  {
-    sum += 2 * ( *x32 - *x12 );
-    weight += 4;
-  }
-  else if ( *x32 == mInputNodataValue && *x12 != mInputNodataValue && *x22 != mInputNodataValue )
-  {
-    sum += 2 * ( *x22 - *x12 );
-    weight += 2;
-  }
-  else if ( *x12 == mInputNodataValue && *x32 != mInputNodataValue && *x22 != mInputNodataValue )
-  {
-    sum += 2 * ( *x32 - *x22 );
-    weight += 2;
-  }
+float QgsDerivativeFilter::calcFirstDerX( float* x11, float* x21, float* x31, float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 )
+{
+  //the basic formula would be simple, but we need to test for nodata values...
+  //return (( (*x31 - *x11) + 2 * (*x32 - *x12) + (*x33 - *x13) ) / (8 * mCellSizeX));
 
-  //third row
-  if ( *x33 != mInputNodataValue && *x13 != mInputNodataValue ) //the normal case
-  {
-    sum += ( *x33 - *x13 );
-    weight += 2;
-  }
-  else if ( *x33 == mInputNodataValue && *x13 != mInputNodataValue && *x23 != mInputNodataValue )
-  {
-    sum += ( *x23 - *x13 );
-    weight += 1;
-  }
-  else if ( *x13 == mInputNodataValue && *x33 != mInputNodataValue && *x23 != mInputNodataValue )
-  {
-    sum += ( *x33 - *x23 );
-    weight += 1;
-  }
+  int weight = 0;
+  double sum = 0;
+  addDerivativeTerm( *x11, *x21, *x31, mInputNodataValue, 1, sum, weight );
+  addDerivativeTerm( *x12, *x22, *x32, mInputNodataValue, 2, sum, weight );
+  addDerivativeTerm( *x13, *x23, *x33, mInputNodataValue, 1, sum, weight );
 
   if ( weight == 0 )
   {
@@ -100,59 +76,11 @@ float QgsDerivativeFilter::calcFirstDerY( float* x11, float* x21, float* x31, fl
   //the basic formula would be simple, but we need to test for nodata values...
   //return (((*x11 - *x13) + 2 * (*x21 - *x23) + (*x31 - *x33)) / ( 8 * mCellSizeY));
 
-  double sum = 0;
   int weight = 0;
-
-  //first row
-  if ( *x11 != mInputNodataValue && *x13 != mInputNodataValue ) //normal case
-  {
-    sum += ( *x11 - *x13 );
-    weight += 2;
-  }
-  else if ( *x11 == mInputNodataValue && *x13 != mInputNodataValue && *x12 != mInputNodataValue )
-  {
-    sum += ( *x12 - *x13 );
-    weight += 1;
-  }
-  else if ( *x31 == mInputNodataValue && *x11 != mInputNodataValue && *x12 != mInputNodataValue )
-  {
-    sum += ( *x11 - *x12 );
-    weight += 1;
-  }
-
-  //second row
-  if ( *x21 != mInputNodataValue && *x23 != mInputNodataValue )
-  {
-    sum += 2 * ( *x21 - *x23 );
-    weight += 4;
-  }
-  else if ( *x21 == mInputNodataValue && *x23 != mInputNodataValue && *x22 != mInputNodataValue )
-  {
-    sum += 2 * ( *x22 - *x23 );
-    weight += 2;
-  }
-  else if ( *x23 == mInputNodataValue && *x21 != mInputNodataValue && *x22 != mInputNodataValue )
-  {
-    sum += 2 * ( *x21 - *x22 );
-    weight += 2;
-  }
-
-  //third row
-  if ( *x31 != mInputNodataValue && *x33 != mInputNodataValue )
-  {
-    sum += ( *x31 - *x33 );
-    weight += 2;
-  }
-  else if ( *x31 == mInputNodataValue && *x33 != mInputNodataValue && *x32 != mInputNodataValue )
-  {
-    sum += ( *x32 - *x33 );
-    weight += 1;
-  }
-  else if ( *x33 == mInputNodataValue && *x31 != mInputNodataValue && *x32 != mInputNodataValue )
-  {
-    sum += ( *x31 - *x32 );
-    weight += 1;
-  }
+  double sum = 0;
+  addDerivativeTerm( *x13, *x12, *x11, mInputNodataValue, 1, sum, weight );
+  addDerivativeTerm( *x23, *x22, *x21, mInputNodataValue, 2, sum, weight );
+  addDerivativeTerm( *x33, *x32, *x31, mInputNodataValue, 1, sum, weight );
 
   if ( weight == 0 )
   {
@@ -162,7 +90,22 @@ float QgsDerivativeFilter::calcFirstDerY( float* x11, float* x21, float* x31, fl
   return sum / ( weight * mCellSizeY * mZFactor );
 }
 
-
-
-
-
+void QgsDerivativeFilter::calcFirstDerRow( const float* rowAbove, const float* row, const float* rowBelow, float* derX, float* derY, int width ) const
+{
+  for ( int j = 0; j < width; ++j )
+  {
+    int weightX = 0;
+    double sumX = 0;
+    addDerivativeTerm( rowAbove[j], rowAbove[j+1], rowAbove[j+2], mInputNodataValue, 1, sumX, weightX );
+    addDerivativeTerm( row[j], row[j+1], row[j+2], mInputNodataValue, 2, sumX, weightX );
+    addDerivativeTerm( rowBelow[j], rowBelow[j+1], rowBelow[j+2], mInputNodataValue, 1, sumX, weightX );
+    derX[j] = weightX == 0 ? mOutputNodataValue : ( float )( sumX / ( weightX * mCellSizeX * mZFactor ) );
+
+    int weightY = 0;
+    double sumY = 0;
+    addDerivativeTerm( rowBelow[j], row[j], rowAbove[j], mInputNodataValue, 1, sumY, weightY );
+    addDerivativeTerm( rowBelow[j+1], row[j+1], rowAbove[j+1], mInputNodataValue, 2, sumY, weightY );
+    addDerivativeTerm( rowBelow[j+2], row[j+2], rowAbove[j+2], mInputNodataValue, 1, sumY, weightY );
+    derY[j] = weightY == 0 ? mOutputNodataValue : ( float )( sumY / ( weightY * mCellSizeY * mZFactor ) );
+  }
+}
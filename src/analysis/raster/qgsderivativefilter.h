@@ -36,6 +36,10 @@ class ANALYSIS_EXPORT QgsDerivativeFilter : public QgsNineCellFilter
     float calcFirstDerX( float* x11, float* x21, float* x31, float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 );
     /**Calculates the first order derivative in y-direction according to Horn (1981)*/
     float calcFirstDerY( float* x11, float* x21, float* x31, float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 );
+    /**Calculates the first order derivatives in x- and y-direction for a row of cells, the input rows have width + 2 values
+      like in processRow. Cells without derivative get the output nodata value
+      @note added in 2.0*/
+    void calcFirstDerRow( const float* rowAbove, const float* row, const float* rowBelow, float* derX, float* derY, int width ) const;
 };
 
 #endif // QGSDERIVATIVEFILTER_H
@@ -16,6 +16,8 @@
  ***************************************************************************/
 
 #include "qgshillshadefilter.h"
+#include <typeinfo>
+#include <QVector>
 
 QgsHillshadeFilter::QgsHillshadeFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat, double lightAzimuth,
                                         double lightAngle )
@@ -33,25 +35,55 @@ float QgsHillshadeFilter::processNineCellWindow( float* x11, float* x21, float*
     float* x12, float* x22, float* x32,
     float* x13, float* x23, float* x33 )
 {
-  float derX = calcFirstDerX( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
-  float derY = calcFirstDerY( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
+  float rowAbove[3], row[3], rowBelow[3], result;
+  windowToRows( x11, x21, x31, x12, x22, x32, x13, x23, x33, rowAbove, row, rowBelow );
+  hillshadeRow( rowAbove, row, rowBelow, &result, 1 );
+  return result;
+}
 
-  if ( derX == mOutputNodataValue || derY == mOutputNodataValue )
+void QgsHillshadeFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  //subclasses may reimplement processNineCellWindow
+  if ( typeid( *this ) != typeid( QgsHillshadeFilter ) )
   {
-    return mOutputNodataValue;
+    QgsNineCellFilter::processRow( rowAbove, row, rowBelow, result, width );
+    return;
   }
+  hillshadeRow( rowAbove, row, rowBelow, result, width );
+}
+
+bool QgsHillshadeFilter::prepareForConcurrentUse()
+{
+  //the window function of a subclass might not be safe to call from several threads
+  return typeid( *this ) == typeid( QgsHillshadeFilter );
+}
+
+void QgsHillshadeFilter::hillshadeRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  QVector<float> derY( width );
+  calcFirstDerRow( rowAbove, row, rowBelow, result, derY.data(), width );
 
   float zenith_rad = mLightAngle * M_PI / 180.0;
-  float slope_rad = atan( sqrt( derX * derX + derY * derY ) );
   float azimuth_rad = mLightAzimuth * M_PI / 180.0;
-  float aspect_rad = 0;
-  if ( derX == 0 && derY == 0 ) //aspect undefined, take a neutral value. Better solutions?
+  for ( int j = 0; j < width; ++j )
   {
-    aspect_rad = azimuth_rad / 2.0;
-  }
-  else
-  {
-    aspect_rad = M_PI + atan2( derX, derY );
+    float derX = result[j];
+    if ( derX == mOutputNodataValue || derY[j] == mOutputNodataValue )
+    {
+      result[j] = mOutputNodataValue;
+      continue;
+    }
+
+    float slope_rad = atan( sqrt( derX * derX + derY[j] * derY[j] ) );
+    float aspect_rad = 0;
+    if ( derX == 0 && derY[j] == 0 ) //aspect undefined, take a neutral value. Better solutions?
+    {
+      aspect_rad = azimuth_rad / 2.0;
+    }
+    else
+    {
+      aspect_rad = M_PI + atan2( derX, derY[j] );
+    }
+    result[j] = qMax( 0.0, 255.0 * (( cos( zenith_rad ) * cos( slope_rad ) ) + ( sin( zenith_rad ) * sin( slope_rad ) * cos( azimuth_rad - aspect_rad ) ) ) );
   }
-  return qMax( 0.0, 255.0 * (( cos( zenith_rad ) * cos( slope_rad ) ) + ( sin( zenith_rad ) * sin( slope_rad ) * cos( azimuth_rad - aspect_rad ) ) ) );
 }
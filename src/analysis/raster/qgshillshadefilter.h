@@ -33,12 +33,19 @@ class ANALYSIS_EXPORT QgsHillshadeFilter: public QgsDerivativeFilter
                                  float* x12, float* x22, float* x32,
                                  float* x13, float* x23, float* x33 );
 
+    void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
+    bool prepareForConcurrentUse();
+
     float lightAzimuth() const { return mLightAzimuth; }
     void setLightAzimuth( float azimuth ) { mLightAzimuth = azimuth; }
     float lightAngle() const { return mLightAngle; }
     void setLightAngle( float angle ) { mLightAngle = angle; }
 
   private:
+    //! the hillshade of a row of cells, used for objects of this class and by processNineCellWindow
+    void hillshadeRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
     float mLightAzimuth;
     float mLightAngle;
 };
@@ -18,6 +18,10 @@
 #include "qgsninecellfilter.h"
 #include "cpl_string.h"
 #include <QProgressDialog>
+#include <QtAlgorithms>
+#include <QVector>
+#include <QtConcurrentMap>
+#include <cstring>
 
 #if defined(GDAL_VERSION_NUM) && GDAL_VERSION_NUM >= 1800
 #define TO8(x) (x).toUtf8().constData()
@@ -25,6 +29,26 @@
 #define TO8(x) (x).toLocal8Bit().constData()
 #endif
 
+//rows of a strip processed by one task
+struct QgsNineCellFilterRows
+{
+  QgsNineCellFilter* filter;
+  const float* input; //the row above the first row, rows have width + 2 values
+  float* output;
+  int nRows;
+  int width;
+};
+
+static void processRows( QgsNineCellFilterRows& rows )
+{
+  int paddedWidth = rows.width + 2;
+  for ( int i = 0; i < rows.nRows; ++i )
+  {
+    const float* rowAbove = rows.input + i * paddedWidth;
+    rows.filter->processRow( rowAbove, rowAbove + paddedWidth, rowAbove + 2 * paddedWidth, rows.output + i * rows.width, rows.width );
+  }
+}
+
 QgsNineCellFilter::QgsNineCellFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat )
     : mInputFile( inputFile ), mOutputFile( outputFile ), mOutputFormat( outputFormat ), mCellSizeX( -1 ), mCellSizeY( -1 ),
     mInputNodataValue( -1 ), mOutputNodataValue( -1 ), mZFactor( 1.0 )
@@ -95,24 +119,33 @@ int QgsNineCellFilter::processRaster( QProgressDialog* p )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time
-  float* scanLine1 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float* scanLine2 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float* scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  //the raster is processed in strips of whole rows aligned to the blocks of the input. The input rows get one row of
+  //halo above and below and one nodata value on the left and the right side, so that the values outside the layer
+  //extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
+  int blockXSize, blockYSize;
+  GDALGetBlockSize( rasterBand, &blockXSize, &blockYSize );
+  blockYSize = qMax( blockYSize, 1 );
+  int stripRows = qMin(( 127 / blockYSize + 1 ) * blockYSize, ySize );
+  int paddedWidth = xSize + 2;
+
+  QVector<float> input(( stripRows + 2 ) * paddedWidth, mInputNodataValue );
+  QVector<float> output( stripRows * xSize );
 
-  float* resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  //the rows of a strip are processed in parallel tasks if the filter allows it
+  bool concurrent = prepareForConcurrentUse();
+  int taskRows = concurrent ? 16 : stripRows;
+  QVector<QgsNineCellFilterRows> tasks;
 
   if ( p )
   {
     p->setMaximum( ySize );
   }
 
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int i = 0; i < ySize; ++i )
+  for ( int firstRow = 0; firstRow < ySize; firstRow += stripRows )
   {
     if ( p )
     {
-      p->setValue( i );
+      p->setValue( firstRow );
     }
 
     if ( p && p->wasCanceled() )
@@ -120,56 +153,51 @@ int QgsNineCellFilter::processRaster( QProgressDialog* p )
       break;
     }
 
-    if ( i == 0 )
+    int nRows = qMin( stripRows, ySize - firstRow );
+
+    //the last two rows of the previous strip are the halo row above and the first row of this strip
+    int firstReadRow = firstRow;
+    if ( firstRow > 0 )
     {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, scanLine2, xSize, 1, GDT_Float32, 0, 0 );
+      memmove( input.data(), input.data() + stripRows * paddedWidth, 2 * paddedWidth * sizeof( float ) );
+      firstReadRow = firstRow + 1;
     }
-    else
+
+    //read the rows of the strip and the halo row below at once
+    int lastReadRow = qMin( firstRow + nRows, ySize - 1 );
+    float* readStart = input.data() + ( firstReadRow - firstRow + 1 ) * paddedWidth + 1;
+    if ( lastReadRow >= firstReadRow )
     {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+      GDALRasterIO( rasterBand, GF_Read, 0, firstReadRow, xSize, lastReadRow - firstReadRow + 1, readStart, xSize, lastReadRow - firstReadRow + 1,
+                    GDT_Float32, sizeof( float ), ( int )( paddedWidth * sizeof( float ) ) );
     }
-
-    if ( i == ySize - 1 ) //fill the row below the bottom with nodata values
+    if ( lastReadRow < firstRow + nRows ) //fill the row below the bottom with nodata values
     {
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
+      qFill( input.begin() + ( nRows + 1 ) * paddedWidth, input.begin() + ( nRows + 2 ) * paddedWidth, mInputNodataValue );
     }
-    else
+
+    tasks.clear();
+    for ( int i = 0; i < nRows; i += taskRows )
     {
-      GDALRasterIO( rasterBand, GF_Read, 0, i + 1, xSize, 1, scanLine3, xSize, 1, GDT_Float32, 0, 0 );
+      QgsNineCellFilterRows task;
+      task.filter = this;
+      task.input = input.constData() + i * paddedWidth;
+      task.output = output.data() + i * xSize;
+      task.nRows = qMin( taskRows, nRows - i );
+      task.width = xSize;
+      tasks.append( task );
     }
 
-    for ( int j = 0; j < xSize; ++j )
+    if ( tasks.size() > 1 )
     {
-      if ( j == 0 )
-      {
-        resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j+1], &mInputNodataValue, &scanLine2[j],
-                                               &scanLine2[j+1], &mInputNodataValue, &scanLine3[j], &scanLine3[j+1] );
-      }
-      else if ( j == xSize - 1 )
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j-1], &scanLine1[j], &mInputNodataValue, &scanLine2[j-1], &scanLine2[j],
-                                               &mInputNodataValue, &scanLine3[j-1], &scanLine3[j], &mInputNodataValue );
-      }
-      else
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j-1], &scanLine1[j], &scanLine1[j+1], &scanLine2[j-1], &scanLine2[j],
-                                               &scanLine2[j+1], &scanLine3[j-1], &scanLine3[j], &scanLine3[j+1] );
-      }
+      QtConcurrent::blockingMap( tasks, processRows );
+    }
+    else
+    {
+      processRows( tasks[0] );
     }
 
-    GDALRasterIO( outputRasterBand, GF_Write, 0, i, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 );
+    GDALRasterIO( outputRasterBand, GF_Write, 0, firstRow, xSize, nRows, output.data(), xSize, nRows, GDT_Float32, 0, 0 );
   }
 
   if ( p )
@@ -177,11 +205,6 @@ int QgsNineCellFilter::processRaster( QProgressDialog* p )
     p->setValue( ySize );
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
-
   GDALClose( inputDataset );
 
   if ( p && p->wasCanceled() )
@@ -195,6 +218,27 @@ int QgsNineCellFilter::processRaster( QProgressDialog* p )
   return 0;
 }
 
+void QgsNineCellFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  float* r1 = const_cast<float*>( rowAbove );
+  float* r2 = const_cast<float*>( row );
+  float* r3 = const_cast<float*>( rowBelow );
+  for ( int j = 0; j < width; ++j )
+  {
+    result[j] = processNineCellWindow( &r1[j], &r1[j+1], &r1[j+2], &r2[j], &r2[j+1], &r2[j+2], &r3[j], &r3[j+1], &r3[j+2] );
+  }
+}
+
+void QgsNineCellFilter::windowToRows( float* x11, float* x21, float* x31,
+                                      float* x12, float* x22, float* x32,
+                                      float* x13, float* x23, float* x33,
+                                      float* rowAbove, float* row, float* rowBelow )
+{
+  rowAbove[0] = *x11; rowAbove[1] = *x21; rowAbove[2] = *x31;
+  row[0] = *x12; row[1] = *x22; row[2] = *x32;
+  rowBelow[0] = *x13; rowBelow[1] = *x23; rowBelow[2] = *x33;
+}
+
 GDALDatasetH QgsNineCellFilter::openInputFile( int& nCellsX, int& nCellsY )
 {
   GDALDatasetH inputDataset = GDALOpen( TO8( mInputFile ), GA_ReadOnly );
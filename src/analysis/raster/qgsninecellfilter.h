@@ -57,6 +57,19 @@ class ANALYSIS_EXPORT QgsNineCellFilter
                                          float* x12, float* x22, float* x32,
                                          float* x13, float* x23, float* x33 ) = 0;
 
+    /**Calculates the output values of one row. The input rows above, at and below the processed row contain width + 2 values,
+      the first and the last one being the neighbours left and right of the row (nodata values at the border of the raster).
+      The default implementation calls processNineCellWindow for each cell, subclasses may reimplement it with a faster loop.
+      The filters of QGIS do so only for objects of their own class: a subclass of them reimplementing processNineCellWindow
+      is processed cell by cell and in the calling thread
+      @note added in 2.0*/
+    virtual void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
+    /**Returns true if processRow may be called for different rows from several threads at once. The default
+      implementation returns false, so that the rows are processed in the calling thread
+      @note added in 2.0*/
+    virtual bool prepareForConcurrentUse() { return false; }
+
   private:
     //default constructor forbidden. We need input file, output file and format obligatory
     QgsNineCellFilter();
@@ -71,6 +84,12 @@ class ANALYSIS_EXPORT QgsNineCellFilter
     GDALDatasetH openOutputFile( GDALDatasetH inputDataset, GDALDriverH outputDriver );
 
   protected:
+    /**Copies a 3x3 window to three rows of three values, so that subclasses with a row kernel can use it to implement processNineCellWindow
+      @note added in 2.0*/
+    static void windowToRows( float* x11, float* x21, float* x31,
+                              float* x12, float* x22, float* x32,
+                              float* x13, float* x23, float* x33,
+                              float* rowAbove, float* row, float* rowBelow );
 
     QString mInputFile;
     QString mOutputFile;
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsruggednessfilter.h"
+#include <typeinfo>
 
 QgsRuggednessFilter::QgsRuggednessFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat ): QgsNineCellFilter( inputFile, outputFile, outputFormat )
 {
@@ -36,59 +37,51 @@ QgsRuggednessFilter::~QgsRuggednessFilter()
 float QgsRuggednessFilter::processNineCellWindow( float* x11, float* x21, float* x31,
     float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 )
 {
-  //the formula would be that easy without nodata values...
-  /*
-    //return *x22; //test: write the raster value of the middle cell
-    float diff1 = *x11 - *x22;
-    float diff2 = *x21 - *x22;
-    float diff3 = *x31 - *x22;
-    float diff4 = *x12 - *x22;
-    float diff5 = *x32 - *x22;
-    float diff6 = *x13 - *x22;
-    float diff7 = *x23 - *x22;
-    float diff8 = *x33 - *x22;
-    return sqrt(diff1 * diff1 + diff2 * diff2 + diff3 * diff3 + diff4 * diff4 + diff5 * diff5 + diff6 * diff6 + diff7 * diff7 + diff8 * diff8);
-   */
+  float rowAbove[3], row[3], rowBelow[3], result;
+  windowToRows( x11, x21, x31, x12, x22, x32, x13, x23, x33, rowAbove, row, rowBelow );
+  ruggednessRow( rowAbove, row, rowBelow, &result, 1 );
+  return result;
+}
 
-  if ( *x22 == mInputNodataValue )
+void QgsRuggednessFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  //subclasses may reimplement processNineCellWindow
+  if ( typeid( *this ) != typeid( QgsRuggednessFilter ) )
   {
-    return mOutputNodataValue;
+    QgsNineCellFilter::processRow( rowAbove, row, rowBelow, result, width );
+    return;
   }
+  ruggednessRow( rowAbove, row, rowBelow, result, width );
+}
 
-  double sum = 0;
-  if ( *x11 != mInputNodataValue )
-  {
-    sum += ( *x11 - *x22 ) * ( *x11 - *x22 );
-  }
-  if ( *x21 != mInputNodataValue )
-  {
-    sum += ( *x21 - *x22 ) * ( *x21 - *x22 );
-  }
-  if ( *x31 != mInputNodataValue )
-  {
-    sum += ( *x31 - *x22 ) * ( *x31 - *x22 );
-  }
-  if ( *x12 != mInputNodataValue )
-  {
-    sum += ( *x12 - *x22 ) * ( *x12 - *x22 );
-  }
-  if ( *x32 != mInputNodataValue )
-  {
-    sum += ( *x32 - *x22 ) * ( *x32 - *x22 );
-  }
-  if ( *x13 != mInputNodataValue )
-  {
-    sum += ( *x13 - *x22 ) * ( *x13 - *x22 );
-  }
-  if ( *x23 != mInputNodataValue )
-  {
-    sum += ( *x23 - *x22 ) * ( *x23 - *x22 );
-  }
-  if ( *x33 != mInputNodataValue )
-  {
-    sum += ( *x33 - *x22 ) * ( *x33 - *x22 );
-  }
+bool QgsRuggednessFilter::prepareForConcurrentUse()
+{
+  //the window function of a subclass might not be safe to call from several threads
+  return typeid( *this ) == typeid( QgsRuggednessFilter );
+}
 
-  return sqrt( sum );
+//squared difference of a neighbour to the center cell, 0 if the neighbour is nodata
+static inline float squaredDifference( float value, float center, float nodata )
+{
+  float diff = value - center;
+  return value != nodata ? diff * diff : 0.0f;
 }
 
+void QgsRuggednessFilter::ruggednessRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  for ( int j = 0; j < width; ++j )
+  {
+    float center = row[j+1];
+    double sum = 0;
+    sum += squaredDifference( rowAbove[j], center, mInputNodataValue );
+    sum += squaredDifference( rowAbove[j+1], center, mInputNodataValue );
+    sum += squaredDifference( rowAbove[j+2], center, mInputNodataValue );
+    sum += squaredDifference( row[j], center, mInputNodataValue );
+    sum += squaredDifference( row[j+2], center, mInputNodataValue );
+    sum += squaredDifference( rowBelow[j], center, mInputNodataValue );
+    sum += squaredDifference( rowBelow[j+1], center, mInputNodataValue );
+    sum += squaredDifference( rowBelow[j+2], center, mInputNodataValue );
+
+    result[j] = center == mInputNodataValue ? mOutputNodataValue : ( float ) sqrt( sum );
+  }
+}
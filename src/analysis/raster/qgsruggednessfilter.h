@@ -28,6 +28,8 @@ class ANALYSIS_EXPORT QgsRuggednessFilter: public QgsNineCellFilter
     QgsRuggednessFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat );
     ~QgsRuggednessFilter();
 
+    bool prepareForConcurrentUse();
+
   protected:
     /**Calculates output value from nine input values. The input values and the output value can be equal to the
       nodata value if not present or outside of the border. Must be implemented by subclasses*/
@@ -35,7 +37,12 @@ class ANALYSIS_EXPORT QgsRuggednessFilter: public QgsNineCellFilter
                                  float* x12, float* x22, float* x32,
                                  float* x13, float* x23, float* x33 );
 
+    void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
   private:
+    //! the ruggedness index of a row of cells, used for objects of this class and by processNineCellWindow
+    void ruggednessRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
     QgsRuggednessFilter();
 };
 
@@ -16,6 +16,8 @@
  ***************************************************************************/
 
 #include "qgsslopefilter.h"
+#include <typeinfo>
+#include <QVector>
 
 QgsSlopeFilter::QgsSlopeFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat )
     : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -31,14 +33,44 @@ QgsSlopeFilter::~QgsSlopeFilter()
 float QgsSlopeFilter::processNineCellWindow( float* x11, float* x21, float* x31,
     float* x12, float* x22, float* x32, float* x13, float* x23, float* x33 )
 {
-  float derX = calcFirstDerX( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
-  float derY = calcFirstDerY( x11, x21, x31, x12, x22, x32, x13, x23, x33 );
+  float rowAbove[3], row[3], rowBelow[3], result;
+  windowToRows( x11, x21, x31, x12, x22, x32, x13, x23, x33, rowAbove, row, rowBelow );
+  slopeRow( rowAbove, row, rowBelow, &result, 1 );
+  return result;
+}
 
-  if ( derX == mOutputNodataValue || derY == mOutputNodataValue )
+void QgsSlopeFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  //subclasses may reimplement processNineCellWindow
+  if ( typeid( *this ) != typeid( QgsSlopeFilter ) )
   {
-    return mOutputNodataValue;
+    QgsNineCellFilter::processRow( rowAbove, row, rowBelow, result, width );
+    return;
   }
+  slopeRow( rowAbove, row, rowBelow, result, width );
+}
 
-  return atan( sqrt( derX * derX + derY * derY ) ) * 180.0 / M_PI;
+bool QgsSlopeFilter::prepareForConcurrentUse()
+{
+  //the window function of a subclass might not be safe to call from several threads
+  return typeid( *this ) == typeid( QgsSlopeFilter );
 }
 
+void QgsSlopeFilter::slopeRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  QVector<float> derY( width );
+  calcFirstDerRow( rowAbove, row, rowBelow, result, derY.data(), width );
+
+  for ( int j = 0; j < width; ++j )
+  {
+    float derX = result[j];
+    if ( derX == mOutputNodataValue || derY[j] == mOutputNodataValue )
+    {
+      result[j] = mOutputNodataValue;
+    }
+    else
+    {
+      result[j] = atan( sqrt( derX * derX + derY[j] * derY[j] ) ) * 180.0 / M_PI;
+    }
+  }
+}
@@ -32,6 +32,14 @@ class ANALYSIS_EXPORT QgsSlopeFilter: public QgsDerivativeFilter
     float processNineCellWindow( float* x11, float* x21, float* x31,
                                  float* x12, float* x22, float* x32,
                                  float* x13, float* x23, float* x33 );
+
+    void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
+    bool prepareForConcurrentUse();
+
+  private:
+    //! the slope of a row of cells, used for objects of this class and by processNineCellWindow
+    void slopeRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
 };
 
 #endif // QGSSLOPEFILTER_H
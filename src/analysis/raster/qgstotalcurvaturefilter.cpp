@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgstotalcurvaturefilter.h"
+#include <typeinfo>
 
 QgsTotalCurvatureFilter::QgsTotalCurvatureFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat )
     : QgsNineCellFilter( inputFile, outputFile, outputFormat )
@@ -31,18 +32,51 @@ QgsTotalCurvatureFilter::~QgsTotalCurvatureFilter()
 float QgsTotalCurvatureFilter::processNineCellWindow( float* x11, float* x21, float* x31, float* x12,
     float* x22, float* x32, float* x13, float* x23, float* x33 )
 {
-  //return nodata if one value is the nodata value
-  if ( *x11 == mInputNodataValue || *x21 == mInputNodataValue || *x31 == mInputNodataValue || *x12 == mInputNodataValue
-       || *x22 == mInputNodataValue || *x32 == mInputNodataValue || *x13 == mInputNodataValue || *x23 == mInputNodataValue
-       || *x33 == mInputNodataValue )
+  float rowAbove[3], row[3], rowBelow[3], result;
+  windowToRows( x11, x21, x31, x12, x22, x32, x13, x23, x33, rowAbove, row, rowBelow );
+  totalCurvatureRow( rowAbove, row, rowBelow, &result, 1 );
+  return result;
+}
+
+void QgsTotalCurvatureFilter::processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
+  //subclasses may reimplement processNineCellWindow
+  if ( typeid( *this ) != typeid( QgsTotalCurvatureFilter ) )
   {
-    return mOutputNodataValue;
+    QgsNineCellFilter::processRow( rowAbove, row, rowBelow, result, width );
+    return;
   }
+  totalCurvatureRow( rowAbove, row, rowBelow, result, width );
+}
+
+bool QgsTotalCurvatureFilter::prepareForConcurrentUse()
+{
+  //the window function of a subclass might not be safe to call from several threads
+  return typeid( *this ) == typeid( QgsTotalCurvatureFilter );
+}
 
+void QgsTotalCurvatureFilter::totalCurvatureRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width )
+{
   double cellSizeAvg = ( mCellSizeX + mCellSizeY ) / 2.0;
-  double dxx = ( *x32 - 2 * *x22 + *x12 ) / ( mCellSizeX * mCellSizeX );
-  double dyy = ( -*x11 + *x31 + *x13 - *x33 ) / ( 4 * cellSizeAvg * cellSizeAvg );
-  double dxy = ( *x21 - 2 * *x22 + *x23 ) / ( mCellSizeY * mCellSizeY );
+  for ( int j = 0; j < width; ++j )
+  {
+    float x11 = rowAbove[j], x21 = rowAbove[j+1], x31 = rowAbove[j+2];
+    float x12 = row[j], x22 = row[j+1], x32 = row[j+2];
+    float x13 = rowBelow[j], x23 = rowBelow[j+1], x33 = rowBelow[j+2];
 
-  return dxx*dxx + 2*dxy*dxy + dyy*dyy;
+    //return nodata if one value is the nodata value
+    if ( x11 == mInputNodataValue || x21 == mInputNodataValue || x31 == mInputNodataValue || x12 == mInputNodataValue
+         || x22 == mInputNodataValue || x32 == mInputNodataValue || x13 == mInputNodataValue || x23 == mInputNodataValue
+         || x33 == mInputNodataValue )
+    {
+      result[j] = mOutputNodataValue;
+      continue;
+    }
+
+    double dxx = ( x32 - 2 * x22 + x12 ) / ( mCellSizeX * mCellSizeX );
+    double dyy = ( -x11 + x31 + x13 - x33 ) / ( 4 * cellSizeAvg * cellSizeAvg );
+    double dxy = ( x21 - 2 * x22 + x23 ) / ( mCellSizeY * mCellSizeY );
+
+    result[j] = dxx * dxx + 2 * dxy * dxy + dyy * dyy;
+  }
 }
@@ -27,12 +27,20 @@ class ANALYSIS_EXPORT QgsTotalCurvatureFilter: public QgsNineCellFilter
     QgsTotalCurvatureFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat );
     ~QgsTotalCurvatureFilter();
 
+    bool prepareForConcurrentUse();
+
   protected:
     /**Calculates total curvature from nine input values. The input values and the output value can be equal to the
       nodata value if not present or outside of the border. Must be implemented by subclasses*/
     float processNineCellWindow( float* x11, float* x21, float* x31,
                                  float* x12, float* x22, float* x32,
                                  float* x13, float* x23, float* x33 );
+
+    void processRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
+
+  private:
+    //! the total curvature of a row of cells, used for objects of this class and by processNineCellWindow
+    void totalCurvatureRow( const float* rowAbove, const float* row, const float* rowBelow, float* result, int width );
 };
 
 #endif // QGSTOTALCURVATUREFILTER_H
@@ -50,22 +50,15 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
   combineFieldLists( fieldsA, fieldsB );
 
   QgsVectorFileWriter vWriter( shapefileName, dpA->encoding(), fieldsA, outputType, &crs );
-  QgsFeature currentFeature;
-  QgsSpatialIndex index;
+  // bulk load the index with the geometries of the overlay layer
+  QgsFeatureRequest indexRequest = QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() );
+  if ( onlySelectedFeatures )
+    indexRequest.setFilterFids( layerB->selectedFeaturesIds() );
+  QgsSpatialIndex index( layerB->getFeatures( indexRequest ) );
 
   //take only selection
   if ( onlySelectedFeatures )
   {
-    const QgsFeatureIds selectionB = layerB->selectedFeaturesIds();
-    QgsFeatureIds::const_iterator it = selectionB.constBegin();
-    for ( ; it != selectionB.constEnd(); ++it )
-    {
-      if ( !layerB->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( currentFeature ) )
-      {
-        continue;
-      }
-      index.insertFeature( currentFeature );
-    }
     //use QgsVectorLayer::featureAtId
     const QgsFeatureIds selectionA = layerA->selectedFeaturesIds();
     if ( p )
@@ -74,7 +67,7 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
     }
     QgsFeature currentFeature;
     int processedFeatures = 0;
-    it = selectionA.constBegin();
+    QgsFeatureIds::const_iterator it = selectionA.constBegin();
     for ( ; it != selectionA.constEnd(); ++it )
     {
       if ( p )
@@ -102,12 +95,6 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
   //take all features
   else
   {
-    QgsFeatureIterator fit = layerB->getFeatures();
-    while ( fit.nextFeature( currentFeature ) )
-    {
-      index.insertFeature( currentFeature );
-    }
-
     int featureCount = layerA->featureCount();
     if ( p )
     {
@@ -115,7 +102,7 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
     }
     int processedFeatures = 0;
 
-    fit = layerA->getFeatures();
+    QgsFeatureIterator fit = layerA->getFeatures();
 
     QgsFeature currentFeature;
     while ( fit.nextFeature( currentFeature ) )
@@ -22,6 +22,10 @@
 #include "gdal.h"
 #include "cpl_string.h"
 #include <QProgressDialog>
+#include <QtConcurrentMap>
+
+#include <cmath>
+#include <limits>
 
 #if defined(GDAL_VERSION_NUM) && GDAL_VERSION_NUM >= 1800
 #define TO8(x) (x).toUtf8().constData()
@@ -29,12 +33,21 @@
 #define TO8(x) (x).toLocal8Bit().constData()
 #endif
 
-QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer* polygonLayer, const QString& rasterFile, const QString& attributePrefix, int rasterBand )
+//number of zones read from the raster and calculated in parallel at once
+static const int ZONE_BATCH_SIZE = 256;
+//maximum number of cells read from the raster at once for one zone
+static const qint64 ZONE_CHUNK_CELLS = 1 << 20;
+//maximum number of cells buffered for the parallel calculation
+static const qint64 ZONE_BATCH_CELLS = 1 << 24;
+
+QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer* polygonLayer, const QString& rasterFile, const QString& attributePrefix, int rasterBand,
+                                        Statistics stats )
     : mRasterFilePath( rasterFile )
     , mRasterBand( rasterBand )
     , mPolygonLayer( polygonLayer )
     , mAttributePrefix( attributePrefix )
     , mInputNodataValue( -1 )
+    , mStatistics( stats )
 {
 
 }
@@ -108,24 +121,41 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog* p )
   QgsRectangle rasterBBox( geoTransform[0], geoTransform[3] - ( nCellsYGDAL * cellsizeY ),
                            geoTransform[0] + ( nCellsXGDAL * cellsizeX ), geoTransform[3] );
 
-  //add the new count, sum, mean fields to the provider
+  //add the new statistics fields to the provider
+  QList< QPair<Statistic, QString> > statFieldNames;
+  statFieldNames << qMakePair( Count, QString( "count" ) )
+  << qMakePair( Sum, QString( "sum" ) )
+  << qMakePair( Mean, QString( "mean" ) )
+  << qMakePair( Min, QString( "min" ) )
+  << qMakePair( Max, QString( "max" ) )
+  << qMakePair( StDev, QString( "stdev" ) )
+  << qMakePair( Majority, QString( "majority" ) );
+
   QList<QgsField> newFieldList;
-  QgsField countField( mAttributePrefix + "count", QVariant::Double, "double precision" );
-  QgsField sumField( mAttributePrefix + "sum", QVariant::Double, "double precision" );
-  QgsField meanField( mAttributePrefix + "mean", QVariant::Double, "double precision" );
-  newFieldList.push_back( countField );
-  newFieldList.push_back( sumField );
-  newFieldList.push_back( meanField );
+  for ( int i = 0; i < statFieldNames.size(); ++i )
+  {
+    if ( mStatistics & statFieldNames[i].first )
+    {
+      newFieldList.push_back( QgsField( mAttributePrefix + statFieldNames[i].second, QVariant::Double, "double precision" ) );
+    }
+  }
   vectorProvider->addAttributes( newFieldList );
 
   //index of the new fields
-  int countIndex = vectorProvider->fieldNameIndex( mAttributePrefix + "count" );
-  int sumIndex = vectorProvider->fieldNameIndex( mAttributePrefix + "sum" );
-  int meanIndex = vectorProvider->fieldNameIndex( mAttributePrefix + "mean" );
-
-  if ( countIndex == -1 || sumIndex == -1 || meanIndex == -1 )
+  mStatFieldIndexes.clear();
+  for ( int i = 0; i < statFieldNames.size(); ++i )
   {
-    return 8;
+    if ( !( mStatistics & statFieldNames[i].first ) )
+    {
+      continue;
+    }
+    int index = vectorProvider->fieldNameIndex( mAttributePrefix + statFieldNames[i].second );
+    if ( index == -1 )
+    {
+      GDALClose( inputDataset );
+      return 8;
+    }
+    mStatFieldIndexes.insert( statFieldNames[i].first, index );
   }
 
   //progress dialog
@@ -141,84 +171,155 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog* p )
   request.setSubsetOfAttributes( QgsAttributeList() );
   QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature f;
-  double count = 0;
-  double sum = 0;
-  double mean = 0;
   int featureCounter = 0;
+  bool finished = false;
 
-  while ( fi.nextFeature( f ) )
+  while ( !finished )
   {
-    if ( p )
+    //read the raster windows of a batch of features in blocks of rows
+    QList<Zone> zones;
+    QList<ZoneChunk> chunks;
+    qint64 bufferedCells = 0;
+    while ( zones.size() < ZONE_BATCH_SIZE )
     {
-      p->setValue( featureCounter );
-    }
+      if ( !fi.nextFeature( f ) )
+      {
+        finished = true;
+        break;
+      }
+      ++featureCounter;
 
-    if ( p && p->wasCanceled() )
-    {
-      break;
-    }
+      QgsGeometry* featureGeometry = f.geometry();
+      if ( !featureGeometry )
+      {
+        continue;
+      }
 
-    QgsGeometry* featureGeometry = f.geometry();
-    if ( !featureGeometry )
-    {
-      ++featureCounter;
-      continue;
-    }
+      QgsRectangle featureRect = featureGeometry->boundingBox().intersect( &rasterBBox );
+      if ( featureRect.isEmpty() )
+      {
+        continue;
+      }
 
-    QgsRectangle featureRect = featureGeometry->boundingBox().intersect( &rasterBBox );
-    if ( featureRect.isEmpty() )
-    {
-      ++featureCounter;
-      continue;
-    }
+      int offsetX, offsetY, nCellsX, nCellsY;
+      if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
+      {
+        continue;
+      }
 
-    int offsetX, offsetY, nCellsX, nCellsY;
-    if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
-    {
-      ++featureCounter;
-      continue;
-    }
+      //avoid access to cells outside of the raster (may occur because of rounding)
+      if (( offsetX + nCellsX ) > nCellsXGDAL )
+      {
+        nCellsX = nCellsXGDAL - offsetX;
+      }
+      if (( offsetY + nCellsY ) > nCellsYGDAL )
+      {
+        nCellsY = nCellsYGDAL - offsetY;
+      }
+      if ( nCellsX <= 0 || nCellsY <= 0 )
+      {
+        continue;
+      }
 
-    //avoid access to cells outside of the raster (may occur because of rounding)
-    if (( offsetX + nCellsX ) > nCellsXGDAL )
-    {
-      nCellsX = nCellsXGDAL - offsetX;
-    }
-    if (( offsetY + nCellsY ) > nCellsYGDAL )
-    {
-      nCellsY = nCellsYGDAL - offsetY;
-    }
+      Zone zone;
+      zone.fid = f.id();
+      zone.window = QgsRectangle( rasterBBox.xMinimum() + offsetX * cellsizeX, rasterBBox.yMaximum() - ( offsetY + nCellsY ) * cellsizeY,
+                                  rasterBBox.xMinimum() + ( offsetX + nCellsX ) * cellsizeX, rasterBBox.yMaximum() - offsetY * cellsizeY );
+      zone.offsetX = offsetX;
+      zone.offsetY = offsetY;
+      zone.nCellsX = nCellsX;
+      zone.nCellsY = nCellsY;
+      zone.cellSizeX = cellsizeX;
+      zone.cellSizeY = cellsizeY;
+      zone.nodataValue = mInputNodataValue;
+      zone.valid = true;
+      zone.stats = FeatureStats( mStatistics.testFlag( Majority ) );
+
+      if ( featureGeometry->isMultipart() )
+      {
+        QgsMultiPolygon multiPolygon = featureGeometry->asMultiPolygon();
+        for ( int i = 0; i < multiPolygon.size(); ++i )
+        {
+          zone.rings += multiPolygon[i].toList();
+        }
+      }
+      else
+      {
+        zone.rings = featureGeometry->asPolygon().toList();
+      }
+      zone.geometry = new QgsGeometry( *featureGeometry );
+      zones.append( zone );
 
-    statisticsFromMiddlePointTest( rasterBand, featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                   rasterBBox, sum, count );
+      int rowsPerChunk = qMax( 1, ( int )( ZONE_CHUNK_CELLS / nCellsX ) );
+      for ( int firstRow = 0; firstRow < nCellsY; firstRow += rowsPerChunk )
+      {
+        ZoneChunk chunk;
+        chunk.zoneIndex = zones.size() - 1;
+        chunk.zone = 0;
+        chunk.firstRow = firstRow;
+        chunk.nRows = qMin( rowsPerChunk, nCellsY - firstRow );
+        chunk.stats = FeatureStats( zone.stats.storeValueCounts );
+        chunk.cells.resize(( qint64 ) nCellsX * chunk.nRows );
+        if ( GDALRasterIO( rasterBand, GF_Read, offsetX, offsetY + firstRow, nCellsX, chunk.nRows, chunk.cells.data(),
+                           nCellsX, chunk.nRows, GDT_Float32, 0, 0 ) != CE_None )
+        {
+          zones.last().valid = false;
+          break;
+        }
+        bufferedCells += chunk.cells.size();
+        chunks.append( chunk );
 
-    if ( count <= 1 )
+        if ( bufferedCells >= ZONE_BATCH_CELLS )
+        {
+          processChunks( zones, chunks );
+          bufferedCells = 0;
+        }
+      }
+    }
+    processChunks( zones, chunks );
+
+    QVector<float> cells;
+    for ( int i = 0; i < zones.size(); ++i )
     {
+      Zone& zone = zones[i];
+      if ( !zone.valid || zone.stats.count > 1 )
+      {
+        continue;
+      }
+
       //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      statisticsFromPreciseIntersection( rasterBand, featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                         rasterBBox, sum, count );
+      zone.stats.reset();
+      int rowsPerChunk = qMax( 1, ( int )( ZONE_CHUNK_CELLS / zone.nCellsX ) );
+      for ( int firstRow = 0; firstRow < zone.nCellsY; firstRow += rowsPerChunk )
+      {
+        int nRows = qMin( rowsPerChunk, zone.nCellsY - firstRow );
+        cells.resize(( qint64 ) zone.nCellsX * nRows );
+        if ( GDALRasterIO( rasterBand, GF_Read, zone.offsetX, zone.offsetY + firstRow, zone.nCellsX, nRows, cells.data(),
+                           zone.nCellsX, nRows, GDT_Float32, 0, 0 ) != CE_None )
+        {
+          zone.valid = false;
+          break;
+        }
+        statisticsFromPreciseIntersection( zone, firstRow, nRows, cells.constData(), zone.stats );
+      }
     }
 
+    writeStatistics( zones );
 
-    if ( count == 0 )
+    for ( int i = 0; i < zones.size(); ++i )
     {
-      mean = 0;
+      delete zones[i].geometry;
     }
-    else
+
+    if ( p )
     {
-      mean = sum / count;
+      p->setValue( featureCounter );
     }
 
-    //write the statistics value to the vector data provider
-    QgsChangedAttributesMap changeMap;
-    QgsAttributeMap changeAttributeMap;
-    changeAttributeMap.insert( countIndex, QVariant( count ) );
-    changeAttributeMap.insert( sumIndex, QVariant( sum ) );
-    changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-    changeMap.insert( f.id(), changeAttributeMap );
-    vectorProvider->changeAttributeValues( changeMap );
-
-    ++featureCounter;
+    if ( p && p->wasCanceled() )
+    {
+      break;
+    }
   }
 
   if ( p )
@@ -260,105 +361,257 @@ int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle& rasterBBox, const Q
   return 0;
 }
 
-void QgsZonalStatistics::statisticsFromMiddlePointTest( void* band, QgsGeometry* poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle& rasterBBox, double& sum, double& count )
+void QgsZonalStatistics::statisticsFromMiddlePointTest( ZoneChunk& chunk )
 {
-  double cellCenterX, cellCenterY;
-
-  float* scanLine = ( float * ) CPLMalloc( sizeof( float ) * nCellsX );
-  cellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  count = 0;
-  sum = 0;
+  const Zone& zone = *chunk.zone;
+  chunk.stats.reset();
 
-  GEOSGeometry* polyGeos = poly->asGeos();
-  if ( !polyGeos )
+  QVector<double> crossings;
+  double cellCenterY = zone.window.yMaximum() - ( chunk.firstRow + 0.5 ) * zone.cellSizeY;
+  for ( int row = 0; row < chunk.nRows; ++row, cellCenterY -= zone.cellSizeY )
   {
-    return;
-  }
-
-  const GEOSPreparedGeometry* polyGeosPrepared = GEOSPrepare( poly->asGeos() );
-  if ( !polyGeosPrepared )
-  {
-    return;
-  }
-
-  GEOSCoordSequence* cellCenterCoords = 0;
-  GEOSGeometry* currentCellCenter = 0;
-
-  for ( int i = 0; i < nCellsY; ++i )
-  {
-    if ( GDALRasterIO( band, GF_Read, pixelOffsetX, pixelOffsetY + i, nCellsX, 1, scanLine, nCellsX, 1, GDT_Float32, 0, 0 )
-         != CPLE_None )
+    //x coordinates where the polygon boundary crosses the row of cell centers
+    crossings.resize( 0 );
+    for ( int r = 0; r < zone.rings.size(); ++r )
     {
-      continue;
+      const QgsPolyline& ring = zone.rings[r];
+      for ( int i = 1; i < ring.size(); ++i )
+      {
+        const QgsPoint& p1 = ring[i - 1];
+        const QgsPoint& p2 = ring[i];
+        if (( p1.y() <= cellCenterY && p2.y() > cellCenterY ) || ( p2.y() <= cellCenterY && p1.y() > cellCenterY ) )
+        {
+          crossings.append( p1.x() + ( cellCenterY - p1.y() ) * ( p2.x() - p1.x() ) / ( p2.y() - p1.y() ) );
+        }
+      }
     }
-    cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
-    for ( int j = 0; j < nCellsX; ++j )
+    if ( crossings.size() < 2 )
     {
-      GEOSGeom_destroy( currentCellCenter );
-      cellCenterCoords = GEOSCoordSeq_create( 1, 2 );
-      GEOSCoordSeq_setX( cellCenterCoords, 0, cellCenterX );
-      GEOSCoordSeq_setY( cellCenterCoords, 0, cellCenterY );
-      currentCellCenter = GEOSGeom_createPoint( cellCenterCoords );
+      continue;
+    }
+    qSort( crossings );
 
-      if ( GEOSPreparedContains( polyGeosPrepared, currentCellCenter ) )
+    //the cells with the center between two successive crossings are inside (even-odd rule)
+    const float* rowCells = chunk.cells.constData() + ( qint64 ) row * zone.nCellsX;
+    for ( int i = 0; i + 1 < crossings.size(); i += 2 )
+    {
+      int firstCol = qMax( 0, ( int ) ceil(( crossings[i] - zone.window.xMinimum() ) / zone.cellSizeX - 0.5 ) );
+      int lastCol = qMin( zone.nCellsX, ( int ) ceil(( crossings[i + 1] - zone.window.xMinimum() ) / zone.cellSizeX - 0.5 ) );
+      for ( int col = firstCol; col < lastCol; ++col )
       {
-        if ( scanLine[j] != mInputNodataValue ) //don't consider nodata values
+        if ( rowCells[col] != zone.nodataValue ) //don't consider nodata values
         {
-          sum += scanLine[j];
-          ++count;
+          chunk.stats.addValue( rowCells[col] );
         }
       }
-      cellCenterX += cellSizeX;
     }
-    cellCenterY -= cellSizeY;
   }
-  CPLFree( scanLine );
-  GEOSPreparedGeom_destroy( polyGeosPrepared );
 }
 
-void QgsZonalStatistics::statisticsFromPreciseIntersection( void* band, QgsGeometry* poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle& rasterBBox, double& sum, double& count )
+void QgsZonalStatistics::statisticsFromPreciseIntersection( const Zone& zone, int firstRow, int nRows, const float* cells, FeatureStats& stats )
 {
-  sum = 0;
-  count = 0;
-  double currentY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  float* pixelData = ( float * ) CPLMalloc( sizeof( float ) );
-  QgsGeometry* pixelRectGeometry = 0;
+  double hCellSizeX = zone.cellSizeX / 2.0;
+  double hCellSizeY = zone.cellSizeY / 2.0;
+  double pixelArea = zone.cellSizeX * zone.cellSizeY;
+  double currentY = zone.window.yMaximum() - firstRow * zone.cellSizeY - hCellSizeY;
 
-  double hCellSizeX = cellSizeX / 2.0;
-  double hCellSizeY = cellSizeY / 2.0;
-  double pixelArea = cellSizeX * cellSizeY;
-  double weight = 0;
-
-  for ( int row = 0; row < nCellsY; ++row )
+  for ( int row = 0; row < nRows; ++row )
   {
-    double currentX = rasterBBox.xMinimum() + cellSizeX / 2.0 + pixelOffsetX * cellSizeX;
-    for ( int col = 0; col < nCellsX; ++col )
+    double currentX = zone.window.xMinimum() + hCellSizeX;
+    for ( int col = 0; col < zone.nCellsX; ++col )
     {
-      GDALRasterIO( band, GF_Read, pixelOffsetX + col, pixelOffsetY + row, nCellsX, 1, pixelData, 1, 1, GDT_Float32, 0, 0 );
-      pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
+      float value = cells[( qint64 ) row * zone.nCellsX + col ];
+      QgsGeometry* pixelRectGeometry = 0;
+      if ( value != zone.nodataValue )
+      {
+        pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
+      }
       if ( pixelRectGeometry )
       {
         //intersection
-        QgsGeometry *intersectGeometry = pixelRectGeometry->intersection( poly );
+        QgsGeometry *intersectGeometry = pixelRectGeometry->intersection( zone.geometry );
         if ( intersectGeometry )
         {
           double intersectionArea = intersectGeometry->area();
-          if ( intersectionArea >= 0.0 )
+          if ( intersectionArea > 0.0 )
           {
-            weight = intersectionArea / pixelArea;
-            count += weight;
-            sum += *pixelData * weight;
+            stats.addValue( value, intersectionArea / pixelArea );
           }
           delete intersectGeometry;
         }
+        delete pixelRectGeometry;
+      }
+      currentX += zone.cellSizeX;
+    }
+    currentY -= zone.cellSizeY;
+  }
+}
+
+void QgsZonalStatistics::processChunks( QList<Zone>& zones, QList<ZoneChunk>& chunks )
+{
+  for ( int i = 0; i < chunks.size(); ++i )
+  {
+    chunks[i].zone = &zones.at( chunks[i].zoneIndex );
+  }
+
+  //the statistics of the chunks are independent of each other
+  QtConcurrent::blockingMap( chunks, statisticsFromMiddlePointTest );
+
+  for ( int i = 0; i < chunks.size(); ++i )
+  {
+    zones[ chunks[i].zoneIndex ].stats.merge( chunks[i].stats );
+  }
+  chunks.clear();
+}
+
+void QgsZonalStatistics::writeStatistics( const QList<Zone>& zones )
+{
+  if ( zones.isEmpty() )
+  {
+    return;
+  }
+
+  QgsChangedAttributesMap changeMap;
+  for ( int i = 0; i < zones.size(); ++i )
+  {
+    if ( !zones[i].valid )
+    {
+      continue;
+    }
+    const FeatureStats& stats = zones[i].stats;
+    bool hasValues = stats.count > 0;
+
+    QgsAttributeMap changeAttributeMap;
+    QMap<Statistic, int>::const_iterator it = mStatFieldIndexes.constBegin();
+    for ( ; it != mStatFieldIndexes.constEnd(); ++it )
+    {
+      QVariant value;
+      switch ( it.key() )
+      {
+        case Count:
+          value = stats.count;
+          break;
+        case Sum:
+          value = stats.sum;
+          break;
+        case Mean:
+          value = hasValues ? stats.sum / stats.count : 0.0;
+          break;
+        case Min:
+          value = hasValues ? QVariant( stats.min ) : QVariant( QVariant::Double );
+          break;
+        case Max:
+          value = hasValues ? QVariant( stats.max ) : QVariant( QVariant::Double );
+          break;
+        case StDev:
+          value = stats.stDev();
+          break;
+        case Majority:
+          value = hasValues ? QVariant(( double ) stats.majority() ) : QVariant( QVariant::Double );
+          break;
+        case All:
+          break;
       }
-      currentX += cellSizeX;
+      changeAttributeMap.insert( it.value(), value );
+    }
+    changeMap.insert( zones[i].fid, changeAttributeMap );
+  }
+
+  //write the statistics values to the vector data provider
+  mPolygonLayer->dataProvider()->changeAttributeValues( changeMap );
+}
+
+QgsZonalStatistics::FeatureStats::FeatureStats( bool storeCounts )
+    : storeValueCounts( storeCounts )
+{
+  reset();
+}
+
+void QgsZonalStatistics::FeatureStats::reset()
+{
+  count = 0;
+  sum = 0;
+  mean = 0;
+  m2 = 0;
+  min = std::numeric_limits<double>::max();
+  max = -std::numeric_limits<double>::max();
+  valueCounts.clear();
+}
+
+void QgsZonalStatistics::FeatureStats::addValue( float value, double weight )
+{
+  count += weight;
+  sum += value * weight;
+
+  //weighted incremental variance (West 1979)
+  double delta = value - mean;
+  mean += delta * weight / count;
+  m2 += weight * delta * ( value - mean );
+
+  if ( value < min )
+  {
+    min = value;
+  }
+  if ( value > max )
+  {
+    max = value;
+  }
+  if ( storeValueCounts )
+  {
+    valueCounts[value] += weight;
+  }
+}
+
+void QgsZonalStatistics::FeatureStats::merge( const FeatureStats& other )
+{
+  if ( other.count <= 0 )
+  {
+    return;
+  }
+
+  //combined mean and variance of two parts (Chan et al. 1979)
+  double total = count + other.count;
+  double delta = other.mean - mean;
+  mean += delta * other.count / total;
+  m2 += other.m2 + delta * delta * count * other.count / total;
+  count = total;
+  sum += other.sum;
+
+  if ( other.min < min )
+  {
+    min = other.min;
+  }
+  if ( other.max > max )
+  {
+    max = other.max;
+  }
+  if ( storeValueCounts )
+  {
+    QMap<float, double>::const_iterator it = other.valueCounts.constBegin();
+    for ( ; it != other.valueCounts.constEnd(); ++it )
+    {
+      valueCounts[it.key()] += it.value();
     }
-    currentY -= cellSizeY;
   }
-  CPLFree( pixelData );
 }
 
+double QgsZonalStatistics::FeatureStats::stDev() const
+{
+  return count > 0 ? sqrt( m2 / count ) : 0.0;
+}
 
+float QgsZonalStatistics::FeatureStats::majority() const
+{
+  float majorityValue = 0;
+  double majorityCount = 0;
+  QMap<float, double>::const_iterator it = valueCounts.constBegin();
+  for ( ; it != valueCounts.constEnd(); ++it )
+  {
+    if ( it.value() > majorityCount )
+    {
+      majorityValue = it.key();
+      majorityCount = it.value();
+    }
+  }
+  return majorityValue;
+}
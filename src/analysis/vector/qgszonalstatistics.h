@@ -18,18 +18,37 @@
 #ifndef QGSZONALSTATISTICS_H
 #define QGSZONALSTATISTICS_H
 
+#include "qgsfeature.h"
+#include "qgspoint.h"
 #include "qgsrectangle.h"
+#include <QMap>
 #include <QString>
+#include <QVector>
 
 class QgsGeometry;
 class QgsVectorLayer;
 class QProgressDialog;
 
-/**A class that calculates raster statistics (count, sum, mean) for a polygon or multipolygon layer and appends the results as attributes*/
+/**A class that calculates raster statistics (count, sum, mean, min, max, standard deviation, majority) for a polygon or multipolygon layer and appends the results as attributes*/
 class ANALYSIS_EXPORT QgsZonalStatistics
 {
   public:
-    QgsZonalStatistics( QgsVectorLayer* polygonLayer, const QString& rasterFile, const QString& attributePrefix = "", int rasterBand = 1 );
+    /**Statistics to calculate (added in 2.0)*/
+    enum Statistic
+    {
+      Count = 1,
+      Sum = 2,
+      Mean = 4,
+      Min = 8,
+      Max = 16,
+      StDev = 32,
+      Majority = 64,
+      All = Count | Sum | Mean | Min | Max | StDev | Majority
+    };
+    Q_DECLARE_FLAGS( Statistics, Statistic )
+
+    QgsZonalStatistics( QgsVectorLayer* polygonLayer, const QString& rasterFile, const QString& attributePrefix = "", int rasterBand = 1,
+                        Statistics stats = Statistics( Count | Sum | Mean ) );
     ~QgsZonalStatistics();
 
     /**Starts the calculation
@@ -37,23 +56,80 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     int calculateStatistics( QProgressDialog* p );
 
   private:
+    /**Accumulates the (weighted) cell values of one zone*/
+    class FeatureStats
+    {
+      public:
+        FeatureStats( bool storeValueCounts = false );
+        void reset();
+        void addValue( float value, double weight = 1.0 );
+        /**Adds the values accumulated by other (e.g. of another part of the same zone)*/
+        void merge( const FeatureStats& other );
+        double stDev() const;
+        /**Most frequent value, the lowest one if there are more of them*/
+        float majority() const;
+
+        double count;
+        double sum;
+        double mean;
+        double min;
+        double max;
+        /**Sum of squared differences from the mean*/
+        double m2;
+        bool storeValueCounts;
+        QMap<float, double> valueCounts;
+    };
+
+    /**Raster window and polygon of one feature*/
+    struct Zone
+    {
+      QgsFeatureId fid;
+      QgsGeometry* geometry;
+      QList<QgsPolyline> rings;
+      QgsRectangle window;
+      int offsetX;
+      int offsetY;
+      int nCellsX;
+      int nCellsY;
+      double cellSizeX;
+      double cellSizeY;
+      float nodataValue;
+      /**False if the raster cells could not be read*/
+      bool valid;
+      FeatureStats stats;
+    };
+
+    /**A block of rows of a zone window. The raster cells are read in the main thread,
+      the statistics of the block are calculated in a worker thread*/
+    struct ZoneChunk
+    {
+      int zoneIndex;
+      const Zone* zone;
+      int firstRow;
+      int nRows;
+      QVector<float> cells;
+      FeatureStats stats;
+    };
+
     QgsZonalStatistics();
     /**Analysis what cells need to be considered to cover the bounding box of a feature
       @return 0 in case of success*/
     int cellInfoForBBox( const QgsRectangle& rasterBBox, const QgsRectangle& featureBBox, double cellSizeX, double cellSizeY,
                          int& offsetX, int& offsetY, int& nCellsX, int& nCellsY ) const;
 
-    /**Returns statistics by considering the pixels where the center point is within the polygon (fast)*/
-    void statisticsFromMiddlePointTest( void* band, QgsGeometry* poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                        double cellSizeX, double cellSizeY, const QgsRectangle& rasterBBox, double& sum, double& count );
+    /**Returns statistics by considering the pixels where the center point is within the polygon (fast).
+      The polygon is rasterized along the rows of cell centers with the even-odd rule, so holes and
+      multipolygons are handled without any geometry tests. Runs in worker threads*/
+    static void statisticsFromMiddlePointTest( ZoneChunk& chunk );
 
-    void statisticsFromMiddlePointTest_improved( void* band, QgsGeometry* poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-        double cellSizeX, double cellSizeY, const QgsRectangle& rasterBBox, double& sum, double& count );
+    /**Returns statistics with precise pixel - polygon intersection test (slow, uses GEOS and must run in the main thread) */
+    static void statisticsFromPreciseIntersection( const Zone& zone, int firstRow, int nRows, const float* cells, FeatureStats& stats );
 
-    /**Returns statistics with precise pixel - polygon intersection test (slow) */
-    void statisticsFromPreciseIntersection( void* band, QgsGeometry* poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                            double cellSizeX, double cellSizeY, const QgsRectangle& rasterBBox, double& sum, double& count );
+    /**Calculates the statistics of the chunks in parallel, adds them to their zones and clears the chunks*/
+    static void processChunks( QList<Zone>& zones, QList<ZoneChunk>& chunks );
 
+    /**Writes the statistics of the zones to the vector layer*/
+    void writeStatistics( const QList<Zone>& zones );
 
     QString mRasterFilePath;
     /**Raster band to calculate statistics from (defaults to 1)*/
@@ -62,6 +138,11 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     QString mAttributePrefix;
     /**The nodata value of the input layer*/
     float mInputNodataValue;
+    Statistics mStatistics;
+    /**Indexes of the new attributes, -1 if the statistic is not calculated*/
+    QMap<Statistic, int> mStatFieldIndexes;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS( QgsZonalStatistics::Statistics )
+
 #endif // QGSZONALSTATISTICS_H
@@ -37,6 +37,9 @@
 #include "qgsfeatureaction.h"
 #include "qgsattributeaction.h"
 
+// number of features evaluated at once by the search
+static const int FEATURE_BLOCK_SIZE = 1000;
+
 class QgsAttributeTableDock : public QDockWidget
 {
   public:
@@ -564,15 +567,11 @@ void QgsAttributeTableDialog::doSearch( QString searchString )
   if ( cbxSearchSelectedOnly->isChecked() )
   {
     QgsFeatureList selectedFeatures = mLayer->selectedFeatures();
-    for ( QgsFeatureList::Iterator it = selectedFeatures.begin(); it != selectedFeatures.end(); ++it )
+    QBitArray matches = search.filterBlock( selectedFeatures );
+    for ( int i = 0; i < matches.size(); ++i )
     {
-      QgsFeature& feat = *it;
-      if ( search.evaluate( &feat ).toInt() != 0 )
-        mSelectedFeatures << feat.id();
-
-      // check if there were errors during evaluating
-      if ( search.hasEvalError() )
-        break;
+      if ( matches.testBit( i ) )
+        mSelectedFeatures << selectedFeatures[i].id();
     }
   }
   else
@@ -582,15 +581,29 @@ void QgsAttributeTableDialog::doSearch( QString searchString )
       r.setFlags( QgsFeatureRequest::NoGeometry );
     QgsFeatureIterator fit = mLayer->getFeatures( r );
 
+    // evaluate blocks of features at once
+    QgsFeatureList features;
     QgsFeature f;
-    while ( fit.nextFeature( f ) )
+    bool atEnd = false;
+    while ( !atEnd && !search.hasEvalError() )
     {
-      if ( search.evaluate( &f ).toInt() != 0 )
-        mSelectedFeatures << f.id();
+      features.clear();
+      while ( features.count() < FEATURE_BLOCK_SIZE )
+      {
+        if ( !fit.nextFeature( f ) )
+        {
+          atEnd = true;
+          break;
+        }
+        features << f;
+      }
 
-      // check if there were errors during evaluating
-      if ( search.hasEvalError() )
-        break;
+      QBitArray matches = search.filterBlock( features );
+      for ( int i = 0; i < matches.size(); ++i )
+      {
+        if ( matches.testBit( i ) )
+          mSelectedFeatures << features[i].id();
+      }
     }
   }
 
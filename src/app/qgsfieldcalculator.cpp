@@ -25,6 +25,9 @@
 #include <QMessageBox>
 #include <QSettings>
 
+// number of features evaluated at once
+static const int FEATURE_BLOCK_SIZE = 1000;
+
 QgsFieldCalculator::QgsFieldCalculator( QgsVectorLayer* vl )
     : QDialog()
     , mVectorLayer( vl )
@@ -161,36 +164,54 @@ void QgsFieldCalculator::accept()
   bool useGeometry = exp.needsGeometry();
   int rownum = 1;
 
+  exp.setGeomCalculator( myDa );
+
+  // the expression is evaluated for blocks of features at once
+  QgsFeatureList features;
+  bool atEnd = false;
+
   QgsFeatureIterator fit = mVectorLayer->getFeatures( QgsFeatureRequest().setFlags( useGeometry ? QgsFeatureRequest::NoFlags : QgsFeatureRequest::NoGeometry ) );
-  while ( fit.nextFeature( feature ) )
+  while ( !atEnd )
   {
-    if ( onlySelected )
+    features.clear();
+    while ( features.count() < FEATURE_BLOCK_SIZE )
     {
-      if ( !selectedIds.contains( feature.id() ) )
+      if ( !fit.nextFeature( feature ) )
       {
-        continue;
+        atEnd = true;
+        break;
       }
+
+      if ( onlySelected )
+      {
+        if ( !selectedIds.contains( feature.id() ) )
+        {
+          continue;
+        }
+      }
+
+      features << feature;
     }
 
     exp.setCurrentRowNumber( rownum );
-    exp.setGeomCalculator( myDa );
 
-    QVariant value = exp.evaluate( &feature );
+    QVector<QVariant> values = exp.evaluateBlock( features );
     if ( exp.hasEvalError() )
     {
       calculationSuccess = false;
       error = exp.evalErrorString();
       break;
     }
-    else
+
+    // FIXME workaround while QgsVectorLayer::changeAttributeValue's emitSignal is ignored (see #7071)
+    mVectorLayer->blockSignals( true );
+    for ( int i = 0; i < features.count(); ++i )
     {
-      // FIXME workaround while QgsVectorLayer::changeAttributeValue's emitSignal is ignored (see #7071)
-      mVectorLayer->blockSignals( true );
-      mVectorLayer->changeAttributeValue( feature.id(), mAttributeId, value, false );
-      mVectorLayer->blockSignals( false );
+      mVectorLayer->changeAttributeValue( features[i].id(), mAttributeId, values[i], false );
     }
+    mVectorLayer->blockSignals( false );
 
-    rownum++;
+    rownum += features.count();
   }
 
 
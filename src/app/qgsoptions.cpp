@@ -494,6 +494,7 @@ QgsOptions::QgsOptions( QWidget *parent, Qt::WFlags fl ) :
   //Changed to default to true as of QGIS 1.7
   chkAntiAliasing->setChecked( settings.value( "/qgis/enable_anti_aliasing", true ).toBool() );
   chkUseRenderCaching->setChecked( settings.value( "/qgis/enable_render_caching", false ).toBool() );
+  chkParallelRendering->setChecked( settings.value( "/qgis/parallel_rendering", false ).toBool() );
 
   //Changed to default to true as of QGIS 1.7
   //TODO: remove hack when http://hub.qgis.org/issues/5170 is fixed
@@ -1065,6 +1066,7 @@ void QgsOptions::saveOptions()
   settings.setValue( "/qgis/new_layers_visible", chkAddedVisibility->isChecked() );
   settings.setValue( "/qgis/enable_anti_aliasing", chkAntiAliasing->isChecked() );
   settings.setValue( "/qgis/enable_render_caching", chkUseRenderCaching->isChecked() );
+  settings.setValue( "/qgis/parallel_rendering", chkParallelRendering->isChecked() );
   settings.setValue( "/qgis/use_qimage_to_render", !( chkUseQPixmap->isChecked() ) );
   settings.setValue( "/qgis/use_symbology_ng", chkUseSymbologyNG->isChecked() );
   settings.setValue( "/qgis/legendDoubleClickAction", cmbLegendDoubleClickAction->currentIndex() );
@@ -1366,7 +1366,7 @@ namespace pal
         rnbp--;
         ( *lPos )[i]->setCost( DBL_MAX ); // infinite cost => do not use
       }
-      else   // this one is OK
+      else if ( candidates )  // this one is OK
       {
         ( *lPos )[i]->insertIntoIndex( candidates );
       }
@@ -34,6 +34,9 @@
 //#define _VERBOSE_
 //#define _EXPORT_MAP_
 #include <QTime>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -196,11 +199,25 @@ namespace pal
   }
 
 
+  struct _featCbackCtx;
+
+  /**
+   * \brief feature part waiting for its label candidates
+   */
+  typedef struct _candidatesJob
+  {
+    FeaturePart *feature;
+    struct _featCbackCtx *context;
+    LabelPosition **lPos;
+    int nblp;
+  } CandidatesJob;
+
   typedef struct _featCbackCtx
   {
     Layer *layer;
     double scale;
     LinkedList<Feats*> *fFeats;
+    QList<CandidatesJob> *jobs;
     RTree<PointSet*, double, 2, double> *obstacles;
     RTree<LabelPosition*, double, 2, double> *candidates;
     double priority;
@@ -269,32 +286,78 @@ namespace pal
       }
     }
 
-    // generate candidates for the feature part
-    LabelPosition** lPos = NULL;
-    int nblp = ft_ptr->setPosition( context->scale, &lPos, context->bbox_min, context->bbox_max, ft_ptr, context->candidates
+    // candidates for the feature part are generated once the whole layer is extracted
+    CandidatesJob job;
+    job.feature = ft_ptr;
+    job.context = context;
+    job.lPos = NULL;
+    job.nblp = 0;
+    context->jobs->append( job );
+
+    return true;
+  }
+
+
+  void generateCandidates( CandidatesJob &job )
+  {
+    FeatCallBackCtx *context = job.context;
+    // candidates are inserted into the index by the caller, the index is not thread safe
+    job.nblp = job.feature->setPosition( context->scale, &job.lPos, context->bbox_min, context->bbox_max, job.feature, NULL
 #ifdef _EXPORT_MAP_
-                                    , *context->svgmap
+                                         , *context->svgmap
 #endif
-                                  );
+                                       );
+  }
+
+
+  /*
+   * Generate the candidates of the feature parts extracted from a layer
+   *
+   * The candidates of a feature part only depend on the part itself, so the parts
+   * are processed concurrently. Valid candidates are then indexed and their
+   * features added to fFeats in the order of extraction.
+   */
+  void generateLayerCandidates( FeatCallBackCtx *context )
+  {
+    QList<CandidatesJob> &jobs = *context->jobs;
 
-    if ( nblp > 0 )
+#ifndef _EXPORT_MAP_
+    if ( jobs.size() > 1 )
     {
-      // valid features are added to fFeats
-      Feats *ft = new Feats();
-      ft->feature = ft_ptr;
-      ft->shape = NULL;
-      ft->nblp = nblp;
-      ft->lPos = lPos;
-      ft->priority = context->priority;
-      context->fFeats->push_back( ft );
+      QtConcurrent::blockingMap( jobs, generateCandidates );
     }
     else
+#endif
     {
-      // Others are deleted
-      delete[] lPos;
+      for ( int i = 0; i < jobs.size(); i++ )
+        generateCandidates( jobs[i] );
     }
 
-    return true;
+    for ( int i = 0; i < jobs.size(); i++ )
+    {
+      CandidatesJob &job = jobs[i];
+      if ( job.nblp > 0 )
+      {
+        for ( int j = 0; j < job.nblp; j++ )
+          job.lPos[j]->insertIntoIndex( context->candidates );
+
+        // valid features are added to fFeats
+        Feats *ft = new Feats();
+        ft->feature = job.feature;
+        ft->shape = NULL;
+        ft->nblp = job.nblp;
+        ft->lPos = job.lPos;
+        ft->priority = context->priority;
+        context->fFeats->push_back( ft );
+      }
+      else
+      {
+        // Others are deleted
+        delete[] job.lPos;
+      }
+    }
+
+    jobs.clear();
   }
 
 
@@ -372,8 +435,11 @@ namespace pal
 
     LinkedList<Feats*> *fFeats = new LinkedList<Feats*> ( ptrFeatsCompare );
 
+    QList<CandidatesJob> jobs;
+
     FeatCallBackCtx *context = new FeatCallBackCtx();
     context->fFeats = fFeats;
+    context->jobs = &jobs;
     context->scale = scale;
     context->obstacles = obstacles;
     context->candidates = prob->candidates;
@@ -433,6 +499,7 @@ namespace pal
 
             context->layer->modMutex->lock();
             context->layer->rtree->Search( amin, amax, extractFeatCallback, ( void* ) context );
+            generateLayerCandidates( context );
             context->layer->modMutex->unlock();
 
 #ifdef _EXPORT_MAP_
@@ -823,6 +890,11 @@ namespace pal
     return prob;
   }
 
+  void solveProblemPart( Problem *part )
+  {
+    part->solve();
+  }
+
   std::list<LabelPosition*>* Pal::solveProblem( Problem* prob, bool displayAll )
   {
     if ( prob == NULL )
@@ -830,12 +902,17 @@ namespace pal
 
     prob->reduce();
 
-    if ( searchMethod == FALP )
-      prob->init_sol_falp();
-    else if ( searchMethod == CHAIN )
-      prob->chain_search();
+    // parts of the map where labels do not compete are solved in their own threads
+    std::vector<Problem*> parts = prob->split( QThread::idealThreadCount() * 4 );
+    if ( parts.empty() )
+    {
+      prob->solve();
+    }
     else
-      prob->popmusic();
+    {
+      QtConcurrent::blockingMap( parts, solveProblemPart );
+      prob->mergeParts( parts );
+    }
 
     return prob->getSolution( displayAll );
   }
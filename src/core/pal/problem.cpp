@@ -80,6 +80,7 @@ namespace pal
     bbox[2] = 0;
     bbox[3] = 0;
     featWrap = NULL;
+    parentFeatId = NULL;
     candidates = new RTree<LabelPosition*, double, 2, double>();
     candidates_sol = new RTree<LabelPosition*, double, 2, double>();
     candidates_subsol = NULL;
@@ -99,6 +100,8 @@ namespace pal
 
     if ( featWrap )
       delete[] featWrap;
+    if ( parentFeatId )
+      delete[] parentFeatId;
     if ( featStartId )
       delete[] featStartId;
     if ( featNbLp )
@@ -229,6 +232,215 @@ namespace pal
     delete[] ok;
   }
 
+  inline int findPart( int *root, int feat )
+  {
+    while ( root[feat] != feat )
+    {
+      root[feat] = root[root[feat]];
+      feat = root[feat];
+    }
+    return feat;
+  }
+
+  typedef struct
+  {
+    int *root;
+    int feat;
+  } SplitContext;
+
+  bool splitCallback( LabelPosition *lp, void *ctx )
+  {
+    SplitContext *context = ( SplitContext* ) ctx;
+
+    int r1 = findPart( context->root, context->feat );
+    int r2 = findPart( context->root, lp->getProblemFeatureId() );
+    if ( r1 != r2 )
+      context->root[r2] = r1;
+
+    return true;
+  }
+
+  std::vector<Problem*> Problem::split( int nbParts )
+  {
+    std::vector<Problem*> parts;
+
+    if ( nbft < 2 || nbParts < 2 )
+      return parts;
+
+    int i, j;
+    double amin[2];
+    double amax[2];
+
+    // Every search of the solver is done with the bounding box of a candidate,
+    // features are thus independent when their candidates' boxes do not overlap
+    int *root = new int[nbft];
+    for ( i = 0; i < nbft; i++ )
+      root[i] = i;
+
+    SplitContext context;
+    context.root = root;
+    for ( i = 0; i < nbft; i++ )
+    {
+      context.feat = i;
+      for ( j = 0; j < featNbLp[i]; j++ )
+      {
+        labelpositions[featStartId[i] + j]->getBoundingBox( amin, amax );
+        candidates->Search( amin, amax, splitCallback, ( void* ) &context );
+      }
+    }
+
+    int *groupSize = new int[nbft];
+    memset( groupSize, 0, sizeof( int ) * nbft );
+    int nbGroups = 0;
+    for ( i = 0; i < nbft; i++ )
+    {
+      root[i] = findPart( root, i );
+      if ( groupSize[root[i]]++ == 0 )
+        nbGroups++;
+    }
+
+    if ( nbGroups < 2 )
+    {
+      delete[] root;
+      delete[] groupSize;
+      return parts;
+    }
+
+    // pack groups in parts of about the same number of features
+    int partSize = ( nbft + nbParts - 1 ) / nbParts;
+    int *groupPart = new int[nbft];
+    memset( groupPart, -1, sizeof( int ) * nbft );
+    std::vector<int> partNbFt;
+    std::vector<int> partNbLp;
+    for ( i = 0; i < nbft; i++ )
+    {
+      int group = root[i];
+      if ( groupPart[group] == -1 )
+      {
+        if ( partNbFt.empty() || partNbFt.back() >= partSize )
+        {
+          partNbFt.push_back( 0 );
+          partNbLp.push_back( 0 );
+        }
+        groupPart[group] = partNbFt.size() - 1;
+        partNbFt.back() += groupSize[group];
+      }
+      partNbLp[groupPart[group]] += featNbLp[i];
+    }
+
+    if ( partNbFt.size() < 2 )
+    {
+      delete[] root;
+      delete[] groupSize;
+      delete[] groupPart;
+      return parts;
+    }
+
+    for ( size_t p = 0; p < partNbFt.size(); p++ )
+    {
+      Problem *part = new Problem();
+      // the candidates stay indexed in this problem
+      delete part->candidates;
+      part->candidates = candidates;
+      part->nbLabelledLayers = 0;
+      part->labelledLayersName = NULL;
+      part->pal = pal;
+      part->scale = scale;
+      part->displayAll = displayAll;
+      for ( j = 0; j < 4; j++ )
+        part->bbox[j] = bbox[j];
+
+      part->nbft = 0;
+      part->nblp = part->all_nblp = 0;
+      part->nbOverlap = 0;
+      part->parentFeatId = new int[partNbFt[p]];
+      part->featStartId = new int[partNbFt[p]];
+      part->featNbLp = new int[partNbFt[p]];
+      part->inactiveCost = new double[partNbFt[p]];
+      part->labelpositions = new LabelPosition*[partNbLp[p]];
+      parts.push_back( part );
+    }
+
+    // features keep their order, candidates get ids of their part
+    for ( i = 0; i < nbft; i++ )
+    {
+      Problem *part = parts[groupPart[root[i]]];
+      int id = part->nbft++;
+      part->parentFeatId[id] = i;
+      part->featStartId[id] = part->nblp;
+      part->featNbLp[id] = featNbLp[i];
+      part->inactiveCost[id] = inactiveCost[i];
+      for ( j = 0; j < featNbLp[i]; j++ )
+      {
+        LabelPosition *lp = labelpositions[featStartId[i] + j];
+        lp->setProblemIds( id, part->nblp );
+        part->labelpositions[part->nblp++] = lp;
+        part->nbOverlap += lp->getNumOverlaps();
+      }
+    }
+
+    for ( size_t p = 0; p < parts.size(); p++ )
+    {
+      parts[p]->all_nblp = parts[p]->nblp;
+      parts[p]->nbOverlap /= 2;
+    }
+
+    delete[] root;
+    delete[] groupSize;
+    delete[] groupPart;
+
+    return parts;
+  }
+
+  void Problem::mergeParts( std::vector<Problem*> &parts )
+  {
+    int i, j;
+
+    if ( sol )
+    {
+      if ( sol->s )
+        delete[] sol->s;
+      delete sol;
+    }
+
+    sol = new Sol();
+    sol->s = new int[nbft];
+    sol->cost = 0;
+
+    for ( size_t p = 0; p < parts.size(); p++ )
+    {
+      Problem *part = parts[p];
+      for ( i = 0; i < part->nbft; i++ )
+      {
+        int feat = part->parentFeatId[i];
+        int label = part->sol->s[i];
+        sol->s[feat] = ( label == -1 ? -1 : featStartId[feat] + label - part->featStartId[i] );
+
+        // give the candidates their ids back
+        for ( j = 0; j < featNbLp[feat]; j++ )
+          labelpositions[featStartId[feat] + j]->setProblemIds( feat, featStartId[feat] + j );
+      }
+      sol->cost += part->sol->cost;
+
+      // candidates and their index belong to this problem
+      part->all_nblp = 0;
+      part->candidates = NULL;
+      delete part;
+    }
+
+    parts.clear();
+  }
+
+  void Problem::solve()
+  {
+    if ( pal->searchMethod == FALP )
+      init_sol_falp();
+    else if ( pal->searchMethod == CHAIN )
+      chain_search();
+    else
+      popmusic();
+  }
+
   /**
    * \brief Basic initial solution : every feature to -1
    */
@@ -35,6 +35,7 @@
 #define _PROBLEM_H
 
 #include <list>
+#include <vector>
 #include <pal/pal.h>
 #include "rtree.hpp"
 
@@ -161,6 +162,11 @@ namespace pal
 
       int *featWrap;
 
+      /**
+       * ids of the features in the problem this part was split from (see split())
+       */
+      int *parentFeatId; // [nbft]
+
       Chain *chain( SubPart *part, int seed );
 
       Chain *chain( int seed );
@@ -184,11 +190,33 @@ namespace pal
       int getFeatureCandidateCount( int i ) { return featNbLp[i]; }
       // both features and candidates counted 0..n-1
       LabelPosition* getFeatureCandidate( int fi, int ci ) { return labelpositions[ featStartId[fi] + ci]; }
+      // cost of the solution found by solve() or taken back by mergeParts()
+      double getSolutionCost() { return sol ? sol->cost : 0.0; }
       /////////////////
 
 
       void reduce();
 
+      /**
+       * \brief split the problem into parts which can be solved independently
+       * Features whose candidates overlap, directly or through other features,
+       * end up in the same part. Parts share the candidates of this problem,
+       * which is not usable until mergeParts() is called. Call after reduce().
+       * \param nbParts number of parts wanted, small groups of features are packed together
+       * \return the parts, empty if all features depend on each other
+       */
+      std::vector<Problem*> split( int nbParts );
+
+      /**
+       * \brief take the solutions of the solved parts back and delete the parts
+       */
+      void mergeParts( std::vector<Problem*> &parts );
+
+      /**
+       * \brief search a solution with the search method of pal
+       */
+      void solve();
+
 
       void post_optimization();
 
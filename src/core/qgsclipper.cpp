@@ -49,8 +49,9 @@ unsigned char* QgsClipper::clippedLineWKB( unsigned char* wkb, const QgsRectangl
   double p1x_c, p1y_c; //clipped end coordinates
   double lastClipX = 0.0, lastClipY = 0.0; //last successfully clipped coords
 
+  // keep the memory of the polygon, it may be reused for many lines
+  line.resize( 0 );
   line.reserve( nPoints + 1 );
-  line.clear();
 
   for ( unsigned int i = 0; i < nPoints; ++i )
   {
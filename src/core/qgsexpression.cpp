@@ -20,6 +20,8 @@
 #include <QSettings>
 #include <QDate>
 #include <QRegExp>
+#include <QCache>
+#include <QThreadStorage>
 
 #include <math.h>
 #include <limits>
@@ -189,6 +191,17 @@ inline bool isIntervalSafe( const QVariant& v )
 
 inline bool isNull( const QVariant& v ) { return v.isNull(); }
 
+// value which can be used directly as a number, without any conversion checks
+inline bool isNumeric( const QVariant& v )
+{
+  return ( v.type() == QVariant::Int || v.type() == QVariant::Double ) && !v.isNull();
+}
+
+inline bool isNumericType( QVariant::Type type )
+{
+  return type == QVariant::Int || type == QVariant::Double;
+}
+
 ///////////////////////////////////////////////
 // evaluation error macros
 
@@ -491,13 +504,30 @@ static QVariant fcnReplace( const QVariantList& values, QgsFeature* , QgsExpress
   QString after = getStringValue( values.at( 2 ), parent );
   return QVariant( str.replace( before, after ) );
 }
+// regular expressions used by the functions, compiled once per pattern in each thread
+static const QRegExp& cachedRegExp( const QString& pattern )
+{
+  static QThreadStorage< QCache<QString, QRegExp>* > sRegExpCache;
+  if ( !sRegExpCache.hasLocalData() )
+    sRegExpCache.setLocalData( new QCache<QString, QRegExp>( 100 ) );
+
+  QCache<QString, QRegExp>* cache = sRegExpCache.localData();
+  QRegExp* re = cache->object( pattern );
+  if ( !re )
+  {
+    re = new QRegExp( pattern );
+    cache->insert( pattern, re );
+  }
+  return *re;
+}
+
 static QVariant fcnRegexpReplace( const QVariantList& values, QgsFeature* , QgsExpression* parent )
 {
   QString str = getStringValue( values.at( 0 ), parent );
   QString regexp = getStringValue( values.at( 1 ), parent );
   QString after = getStringValue( values.at( 2 ), parent );
 
-  QRegExp re( regexp );
+  const QRegExp& re = cachedRegExp( regexp );
   if ( !re.isValid() )
   {
     parent->setEvalErrorString( QObject::tr( "Invalid regular expression '%1': %2" ).arg( regexp ).arg( re.errorString() ) );
@@ -1298,6 +1328,52 @@ QVariant QgsExpression::evaluate( QgsFeature* f )
   return mRootNode->eval( this, f );
 }
 
+QVector<QVariant> QgsExpression::evaluateBlock( QgsFeatureList& features )
+{
+  mEvalErrorString = QString();
+  QVector<QVariant> values;
+  if ( !mRootNode )
+  {
+    mEvalErrorString = QObject::tr( "No root node! Parsing failed?" );
+    return values;
+  }
+
+  QBitArray rows( features.count(), true );
+  mRootNode->evalBlock( this, features, rows, values );
+  if ( !hasEvalError() )
+    return values;
+
+  // evaluate the features one by one, so that the operands are evaluated in the same order
+  // and the error is reported for the first feature as with evaluate()
+  mEvalErrorString = QString();
+  values.resize( features.count() );
+  int firstRow = mRowNumber;
+  for ( int i = 0; i < features.count(); ++i )
+  {
+    mRowNumber = firstRow + i;
+    values[i] = mRootNode->eval( this, &features[i] );
+    if ( hasEvalError() )
+    {
+      values.clear();
+      break;
+    }
+  }
+  mRowNumber = firstRow;
+  return values;
+}
+
+QBitArray QgsExpression::filterBlock( QgsFeatureList& features )
+{
+  QVector<QVariant> values = evaluateBlock( features );
+  QBitArray result( values.count() );
+  for ( int i = 0; i < values.count(); ++i )
+  {
+    if ( !values[i].isNull() && values[i].toDouble() != 0 )
+      result.setBit( i );
+  }
+  return result;
+}
+
 QVariant QgsExpression::evaluate( QgsFeature* f, const QgsFields& fields )
 {
   // first prepare
@@ -1586,6 +1662,49 @@ QgsExpression::Node* QgsExpression::Node::createFromOgcFilter( QDomElement &elem
 ///////////////////////////////////////////////
 // nodes
 
+void QgsExpression::Node::prepareStatic( QgsExpression* parent, bool operandsStatic )
+{
+  mStatic = false;
+  mStaticValue = QVariant();
+  if ( !operandsStatic || parent->hasEvalError() )
+    return;
+
+  QVariant value = eval( parent, 0 );
+  if ( parent->hasEvalError() )
+  {
+    // leave the error to be reported when the node is evaluated
+    parent->setEvalErrorString( QString() );
+    return;
+  }
+
+  mStaticValue = value;
+  mStatic = true;
+}
+
+void QgsExpression::Node::evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  if ( mStatic )
+  {
+    values.fill( mStaticValue, count );
+    return;
+  }
+
+  values.resize( count );
+  int firstRow = parent->currentRowNumber();
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( !rows.testBit( i ) )
+      continue;
+
+    parent->setCurrentRowNumber( firstRow + i );
+    values[i] = eval( parent, &features[i] );
+    if ( parent->hasEvalError() )
+      break;
+  }
+  parent->setCurrentRowNumber( firstRow );
+}
+
 QString QgsExpression::NodeList::dump() const
 {
   QString msg; bool first = true;
@@ -1609,9 +1728,41 @@ void QgsExpression::NodeList::toOgcFilter( QDomDocument &doc, QDomElement &eleme
 
 QVariant QgsExpression::NodeUnaryOperator::eval( QgsExpression* parent, QgsFeature* f )
 {
+  if ( mStatic )
+    return mStaticValue;
+
   QVariant val = mOperand->eval( parent, f );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalValue( parent, val );
+}
+
+void QgsExpression::NodeUnaryOperator::evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  if ( mStatic )
+  {
+    values.fill( mStaticValue, count );
+    return;
+  }
+
+  mOperand->evalBlock( parent, features, rows, values );
+  if ( parent->hasEvalError() )
+    return;
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( !rows.testBit( i ) )
+      continue;
+
+    values[i] = evalValue( parent, values[i] );
+    if ( parent->hasEvalError() )
+      return;
+  }
+}
+
+QVariant QgsExpression::NodeUnaryOperator::evalValue( QgsExpression* parent, const QVariant& val )
+{
   switch ( mOp )
   {
     case uoNot:
@@ -1637,7 +1788,21 @@ QVariant QgsExpression::NodeUnaryOperator::eval( QgsExpression* parent, QgsFeatu
 
 bool QgsExpression::NodeUnaryOperator::prepare( QgsExpression* parent, const QgsFields& fields )
 {
-  return mOperand->prepare( parent, fields );
+  bool res = mOperand->prepare( parent, fields );
+  prepareStatic( parent, res && mOperand->isStatic() );
+  return res;
+}
+
+QVariant::Type QgsExpression::NodeUnaryOperator::resultType() const
+{
+  if ( mStatic )
+    return mStaticValue.type();
+
+  if ( mOp == uoNot )
+    return QVariant::Int;
+
+  QVariant::Type type = mOperand->resultType();
+  return isNumericType( type ) ? type : QVariant::Invalid;
 }
 
 QString QgsExpression::NodeUnaryOperator::dump() const
@@ -1701,11 +1866,118 @@ QgsExpression::Node* QgsExpression::NodeUnaryOperator::createFromOgcFilter( QDom
 
 QVariant QgsExpression::NodeBinaryOperator::eval( QgsExpression* parent, QgsFeature* f )
 {
+  if ( mStatic )
+    return mStaticValue;
+
   QVariant vL = mOpLeft->eval( parent, f );
   ENSURE_NO_EVAL_ERROR;
+
+  if ( mOp == boAnd || mOp == boOr )
+  {
+    TVL tvlL = getTVLValue( vL, parent );
+    ENSURE_NO_EVAL_ERROR;
+
+    // the right operand cannot change the result
+    if (( mOp == boAnd && tvlL == False ) || ( mOp == boOr && tvlL == True ) )
+      return tvl2variant( tvlL );
+
+    QVariant vR = mOpRight->eval( parent, f );
+    ENSURE_NO_EVAL_ERROR;
+    TVL tvlR = getTVLValue( vR, parent );
+    ENSURE_NO_EVAL_ERROR;
+    return tvl2variant( mOp == boAnd ? AND[tvlL][tvlR] : OR[tvlL][tvlR] );
+  }
+
   QVariant vR = mOpRight->eval( parent, f );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalValues( parent, vL, vR );
+}
+
+void QgsExpression::NodeBinaryOperator::evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  if ( mStatic )
+  {
+    values.fill( mStaticValue, count );
+    return;
+  }
+
+  mOpLeft->evalBlock( parent, features, rows, values );
+  if ( parent->hasEvalError() )
+    return;
+
+  QVector<QVariant> valuesR;
+
+  if ( mOp == boAnd || mOp == boOr )
+  {
+    // the right operand is evaluated only in the rows where the left one does not decide the result
+    QBitArray rowsR( rows );
+    QVector<TVL> tvlL( count, Unknown );
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( !rows.testBit( i ) )
+        continue;
+
+      tvlL[i] = getTVLValue( values[i], parent );
+      if ( parent->hasEvalError() )
+        return;
+      if (( mOp == boAnd && tvlL[i] == False ) || ( mOp == boOr && tvlL[i] == True ) )
+        rowsR.clearBit( i );
+    }
+
+    mOpRight->evalBlock( parent, features, rowsR, valuesR );
+    if ( parent->hasEvalError() )
+      return;
+
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( !rows.testBit( i ) )
+        continue;
+
+      if ( !rowsR.testBit( i ) )
+      {
+        values[i] = tvl2variant( tvlL[i] );
+        continue;
+      }
+
+      TVL tvlR = getTVLValue( valuesR[i], parent );
+      if ( parent->hasEvalError() )
+        return;
+      values[i] = tvl2variant( mOp == boAnd ? AND[tvlL[i]][tvlR] : OR[tvlL[i]][tvlR] );
+    }
+    return;
+  }
+
+  mOpRight->evalBlock( parent, features, rows, valuesR );
+  if ( parent->hasEvalError() )
+    return;
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( !rows.testBit( i ) )
+      continue;
+
+    values[i] = evalValues( parent, values[i], valuesR[i] );
+    if ( parent->hasEvalError() )
+      return;
+  }
+}
+
+QVariant QgsExpression::NodeBinaryOperator::evalValues( QgsExpression* parent, const QVariant& vL, const QVariant& vR )
+{
+  // operand types resolved by prepare(), the checks below are not needed
+  if ( mNumeric && isNumeric( vL ) && isNumeric( vR ) )
+    return evalNumeric( vL, vR );
+
+  if ( mStringCompare && !isNull( vL ) && !isNull( vR ) )
+  {
+    int diff = QString::compare( vL.toString(), vR.toString() );
+    if ( mOp == boIs || mOp == boIsNot )
+      return ( diff == 0 ) == ( mOp == boIs ) ? TVL_True : TVL_False;
+    return compare( diff ) ? TVL_True : TVL_False;
+  }
+
   switch ( mOp )
   {
     case boPlus:
@@ -1754,20 +2026,6 @@ QVariant QgsExpression::NodeBinaryOperator::eval( QgsExpression* parent, QgsFeat
         return QVariant( pow( fL, fR ) );
       }
 
-    case boAnd:
-    {
-      TVL tvlL = getTVLValue( vL, parent ), tvlR = getTVLValue( vR, parent );
-      ENSURE_NO_EVAL_ERROR;
-      return tvl2variant( AND[tvlL][tvlR] );
-    }
-
-    case boOr:
-    {
-      TVL tvlL = getTVLValue( vL, parent ), tvlR = getTVLValue( vR, parent );
-      ENSURE_NO_EVAL_ERROR;
-      return tvl2variant( OR[tvlL][tvlR] );
-    }
-
     case boEQ:
     case boNE:
     case boLT:
@@ -1832,26 +2090,14 @@ QVariant QgsExpression::NodeBinaryOperator::eval( QgsExpression* parent, QgsFeat
       {
         QString str    = getStringValue( vL, parent ); ENSURE_NO_EVAL_ERROR;
         QString regexp = getStringValue( vR, parent ); ENSURE_NO_EVAL_ERROR;
-        // TODO: cache QRegExp in case that regexp is a literal string (i.e. it will stay constant)
-        bool matches;
-        if ( mOp == boLike || mOp == boILike || mOp == boNotLike || mOp == boNotILike ) // change from LIKE syntax to regexp
-        {
-          // XXX escape % and _  ???
-          regexp.replace( "%", ".*" );
-          regexp.replace( "_", "." );
-          matches = QRegExp( regexp, mOp == boLike || mOp == boNotLike ? Qt::CaseSensitive : Qt::CaseInsensitive ).exactMatch( str );
-        }
-        else
-        {
-          matches = QRegExp( regexp ).indexIn( str ) != -1;
-        }
+        bool matched = matches( str, regexp );
 
         if ( mOp == boNotLike || mOp == boNotILike )
         {
-          matches = !matches;
+          matched = !matched;
         }
 
-        return matches ? TVL_True : TVL_False;
+        return matched ? TVL_True : TVL_False;
       }
 
     case boConcat:
@@ -1921,13 +2167,223 @@ double QgsExpression::NodeBinaryOperator::computeDouble( double x, double y )
 }
 
 
+QVariant QgsExpression::NodeBinaryOperator::evalNumeric( const QVariant& vL, const QVariant& vR )
+{
+  switch ( mOp )
+  {
+    case boPlus:
+    case boMinus:
+    case boMul:
+    case boDiv:
+    case boMod:
+      if ( vL.type() == QVariant::Int && vR.type() == QVariant::Int )
+      {
+        int iL = vL.toInt();
+        int iR = vR.toInt();
+        if ( mOp == boDiv && iR == 0 ) return QVariant(); // silently handle division by zero and return NULL
+        return QVariant( computeInt( iL, iR ) );
+      }
+      else
+      {
+        double fL = vL.toDouble();
+        double fR = vR.toDouble();
+        if ( mOp == boDiv && fR == 0 ) return QVariant(); // silently handle division by zero and return NULL
+        return QVariant( computeDouble( fL, fR ) );
+      }
+
+    case boPow:
+      return QVariant( pow( vL.toDouble(), vR.toDouble() ) );
+
+    case boEQ:
+    case boNE:
+    case boLT:
+    case boGT:
+    case boLE:
+    case boGE:
+      return compare( vL.toDouble() - vR.toDouble() ) ? TVL_True : TVL_False;
+
+    case boIs:
+    case boIsNot:
+      return ( vL.toDouble() == vR.toDouble() ) == ( mOp == boIs ) ? TVL_True : TVL_False;
+
+    default: break;
+  }
+  Q_ASSERT( false );
+  return QVariant();
+}
+
+bool QgsExpression::NodeBinaryOperator::matches( const QString& str, const QString& pattern )
+{
+  // the pattern is usually static: the same string is compared very quickly
+  if ( mMatchMode == MatchNone || pattern != mMatchPattern )
+    prepareMatcher( pattern );
+
+  Qt::CaseSensitivity cs = mOp == boILike || mOp == boNotILike ? Qt::CaseInsensitive : Qt::CaseSensitive;
+  switch ( mMatchMode )
+  {
+    case MatchExact: return QString::compare( str, mMatchString, cs ) == 0;
+    case MatchPrefix: return str.startsWith( mMatchString, cs );
+    case MatchSuffix: return str.endsWith( mMatchString, cs );
+    case MatchContains: return str.contains( mMatchString, cs );
+    case MatchAll: return true;
+    case MatchLikeRegexp: return mMatchRegexp.exactMatch( str );
+    case MatchRegexp: return mMatchRegexp.indexIn( str ) != -1;
+    default: Q_ASSERT( false ); return false;
+  }
+}
+
+void QgsExpression::NodeBinaryOperator::prepareMatcher( const QString& pattern )
+{
+  mMatchPattern = pattern;
+  mMatchString = QString();
+  mMatchRegexp = QRegExp();
+
+  if ( mOp == boRegexp )
+  {
+    mMatchMode = MatchRegexp;
+    mMatchRegexp = QRegExp( pattern );
+    return;
+  }
+
+  // wildcards at the start and at the end of the pattern
+  int start = 0, end = pattern.length();
+  while ( start < end && pattern[start] == '%' )
+    start++;
+  while ( end > start && pattern[end - 1] == '%' )
+    end--;
+
+  // characters which make the pattern need a regular expression
+  static const QString specialChars( "%_\\.^$|?*+()[]{}" );
+  bool plain = true;
+  for ( int i = start; i < end && plain; ++i )
+  {
+    plain = !specialChars.contains( pattern[i] );
+  }
+
+  if ( plain )
+  {
+    bool anyStart = start > 0;
+    bool anyEnd = end < pattern.length();
+    mMatchString = pattern.mid( start, end - start );
+    if ( mMatchString.isEmpty() )
+      mMatchMode = anyStart ? MatchAll : MatchExact;
+    else if ( anyStart && anyEnd )
+      mMatchMode = MatchContains;
+    else if ( anyStart )
+      mMatchMode = MatchSuffix;
+    else if ( anyEnd )
+      mMatchMode = MatchPrefix;
+    else
+      mMatchMode = MatchExact;
+    return;
+  }
+
+  // change from LIKE syntax to regexp
+  // XXX escape % and _  ???
+  QString regexp = pattern;
+  regexp.replace( "%", ".*" );
+  regexp.replace( "_", "." );
+  mMatchMode = MatchLikeRegexp;
+  mMatchRegexp = QRegExp( regexp, mOp == boLike || mOp == boNotLike ? Qt::CaseSensitive : Qt::CaseInsensitive );
+}
+
+// static operand which never converts to a number, so that comparisons with it are done on strings
+static bool isStaticNonNumeric( QgsExpression::Node* node, QgsExpression* parent )
+{
+  if ( !node->isStatic() )
+    return false;
+
+  QVariant v = node->eval( parent, 0 );
+  return !isNull( v ) && !isDoubleSafe( v );
+}
+
 bool QgsExpression::NodeBinaryOperator::prepare( QgsExpression* parent, const QgsFields& fields )
 {
   bool resL = mOpLeft->prepare( parent, fields );
   bool resR = mOpRight->prepare( parent, fields );
+
+  bool comparison = false;
+  bool numericOp = false;
+  bool matchOp = false;
+  switch ( mOp )
+  {
+    case boRegexp:
+    case boLike:
+    case boNotLike:
+    case boILike:
+    case boNotILike:
+      matchOp = true;
+      break;
+
+    case boEQ:
+    case boNE:
+    case boLT:
+    case boGT:
+    case boLE:
+    case boGE:
+    case boIs:
+    case boIsNot:
+      comparison = true;
+      numericOp = true;
+      break;
+
+    case boPlus:
+    case boMinus:
+    case boMul:
+    case boDiv:
+    case boMod:
+    case boPow:
+      numericOp = true;
+      break;
+
+    default:
+      break;
+  }
+
+  mNumeric = numericOp && isNumericType( mOpLeft->resultType() ) && isNumericType( mOpRight->resultType() );
+  mStringCompare = comparison && ( isStaticNonNumeric( mOpLeft, parent ) || isStaticNonNumeric( mOpRight, parent ) );
+
+  // patterns given as literals are compiled only once
+  mMatchMode = MatchNone;
+  if ( matchOp && mOpRight->isStatic() )
+  {
+    QVariant pattern = mOpRight->eval( parent, 0 );
+    if ( !isNull( pattern ) )
+      prepareMatcher( getStringValue( pattern, parent ) );
+  }
+
+  prepareStatic( parent, resL && resR && mOpLeft->isStatic() && mOpRight->isStatic() );
   return resL && resR;
 }
 
+QVariant::Type QgsExpression::NodeBinaryOperator::resultType() const
+{
+  if ( mStatic )
+    return mStaticValue.type();
+
+  switch ( mOp )
+  {
+    case boPlus:
+    case boMinus:
+    case boMul:
+    case boDiv:
+    case boMod:
+      if ( !mNumeric )
+        return QVariant::Invalid;
+      return mOpLeft->resultType() == QVariant::Int && mOpRight->resultType() == QVariant::Int ? QVariant::Int : QVariant::Double;
+
+    case boPow:
+      return QVariant::Double;
+
+    case boConcat:
+      return QVariant::String;
+
+    default:
+      // logical operators and comparisons
+      return QVariant::Int;
+  }
+}
+
 QString QgsExpression::NodeBinaryOperator::dump() const
 {
   return QString( "%1 %2 %3" ).arg( mOpLeft->dump() ).arg( BinaryOperatorText[mOp] ).arg( mOpRight->dump() );
@@ -2100,8 +2556,28 @@ QgsExpression::Node* QgsExpression::NodeBinaryOperator::createFromOgcFilter( QDo
 }
 //
 
+// check whether the value equals to an item of the IN list, both are not NULL
+static bool inListEqual( const QVariant& v1, const QVariant& v2, QgsExpression* parent )
+{
+  if ( isDoubleSafe( v1 ) && isDoubleSafe( v2 ) )
+  {
+    double f1 = getDoubleValue( v1, parent );
+    double f2 = getDoubleValue( v2, parent );
+    return f1 == f2;
+  }
+  else
+  {
+    QString s1 = getStringValue( v1, parent );
+    QString s2 = getStringValue( v2, parent );
+    return QString::compare( s1, s2 ) == 0;
+  }
+}
+
 QVariant QgsExpression::NodeInOperator::eval( QgsExpression* parent, QgsFeature* f )
 {
+  if ( mStatic )
+    return mStaticValue;
+
   if ( mList->count() == 0 )
     return mNotIn ? TVL_True : TVL_False;
   QVariant v1 = mNode->eval( parent, f );
@@ -2119,20 +2595,8 @@ QVariant QgsExpression::NodeInOperator::eval( QgsExpression* parent, QgsFeature*
       listHasNull = true;
     else
     {
-      bool equal = false;
-      // check whether they are equal
-      if ( isDoubleSafe( v1 ) && isDoubleSafe( v2 ) )
-      {
-        double f1 = getDoubleValue( v1, parent ); ENSURE_NO_EVAL_ERROR;
-        double f2 = getDoubleValue( v2, parent ); ENSURE_NO_EVAL_ERROR;
-        equal = f1 == f2;
-      }
-      else
-      {
-        QString s1 = getStringValue( v1, parent ); ENSURE_NO_EVAL_ERROR;
-        QString s2 = getStringValue( v2, parent ); ENSURE_NO_EVAL_ERROR;
-        equal = QString::compare( s1, s2 ) == 0;
-      }
+      bool equal = inListEqual( v1, v2, parent );
+      ENSURE_NO_EVAL_ERROR;
 
       if ( equal ) // we know the result
         return mNotIn ? TVL_False : TVL_True;
@@ -2146,13 +2610,85 @@ QVariant QgsExpression::NodeInOperator::eval( QgsExpression* parent, QgsFeature*
     return mNotIn ? TVL_True : TVL_False;
 }
 
+void QgsExpression::NodeInOperator::evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  if ( mStatic )
+  {
+    values.fill( mStaticValue, count );
+    return;
+  }
+
+  if ( mList->count() == 0 )
+  {
+    values.fill( mNotIn ? TVL_True : TVL_False, count );
+    return;
+  }
+
+  mNode->evalBlock( parent, features, rows, values );
+  if ( parent->hasEvalError() )
+    return;
+
+  // rows without the result yet
+  QBitArray rowsLeft( rows );
+  QBitArray listHasNull( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( rows.testBit( i ) && isNull( values[i] ) )
+    {
+      values[i] = TVL_Unknown;
+      rowsLeft.clearBit( i );
+    }
+  }
+
+  QVector<QVariant> items;
+  foreach ( Node* n, mList->list() )
+  {
+    n->evalBlock( parent, features, rowsLeft, items );
+    if ( parent->hasEvalError() )
+      return;
+
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( !rowsLeft.testBit( i ) )
+        continue;
+
+      if ( isNull( items[i] ) )
+      {
+        listHasNull.setBit( i );
+        continue;
+      }
+
+      bool equal = inListEqual( values[i], items[i], parent );
+      if ( parent->hasEvalError() )
+        return;
+
+      if ( equal )
+      {
+        values[i] = mNotIn ? TVL_False : TVL_True;
+        rowsLeft.clearBit( i );
+      }
+    }
+  }
+
+  // items not found
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( rowsLeft.testBit( i ) )
+      values[i] = listHasNull.testBit( i ) ? TVL_Unknown : ( mNotIn ? TVL_True : TVL_False );
+  }
+}
+
 bool QgsExpression::NodeInOperator::prepare( QgsExpression* parent, const QgsFields& fields )
 {
   bool res = mNode->prepare( parent, fields );
+  bool operandsStatic = mNode->isStatic();
   foreach ( Node* n, mList->list() )
   {
     res = res && n->prepare( parent, fields );
+    operandsStatic = operandsStatic && n->isStatic();
   }
+  prepareStatic( parent, res && operandsStatic );
   return res;
 }
 
@@ -2188,42 +2724,120 @@ void QgsExpression::NodeInOperator::toOgcFilter( QDomDocument &doc, QDomElement
 
 //
 
+QgsExpression::NodeFunction::NodeFunction( int fnIndex, NodeList* args )
+    : mFnIndex( fnIndex ), mArgs( args )
+{
+  mCoalesce = Functions()[mFnIndex]->name() == "coalesce";
+}
+
 QVariant QgsExpression::NodeFunction::eval( QgsExpression* parent, QgsFeature* f )
 {
+  if ( mStatic )
+    return mStaticValue;
+
   Function* fd = Functions()[mFnIndex];
 
   // evaluate arguments
-  QVariantList argValues;
   if ( mArgs )
   {
-    foreach ( Node* n, mArgs->list() )
+    const QList<Node*>& args = mArgs->list();
+    while ( mArgValues.count() < args.count() )
+      mArgValues.append( QVariant() );
+
+    for ( int i = 0; i < args.count(); ++i )
     {
-      QVariant v = n->eval( parent, f );
+      QVariant v = args[i]->eval( parent, f );
       ENSURE_NO_EVAL_ERROR;
-      if ( isNull( v ) && fd->name() != "coalesce" )
+      if ( isNull( v ) && !mCoalesce )
         return QVariant(); // all "normal" functions return NULL, when any parameter is NULL (so coalesce is abnormal)
-      argValues.append( v );
+      mArgValues[i] = v;
     }
   }
 
   // run the function
-  QVariant res = fd->func( argValues, f, parent );
+  QVariant res = fd->func( mArgValues, f, parent );
   ENSURE_NO_EVAL_ERROR;
 
   // everything went fine
   return res;
 }
 
+void QgsExpression::NodeFunction::evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  if ( mStatic )
+  {
+    values.fill( mStaticValue, count );
+    return;
+  }
+
+  Function* fd = Functions()[mFnIndex];
+
+  // evaluate arguments, the rows with a NULL argument return NULL
+  QBitArray rowsLeft( rows );
+  QList<Node*> args;
+  if ( mArgs )
+    args = mArgs->list();
+  QVector< QVector<QVariant> > argValues( args.count() );
+  for ( int j = 0; j < args.count(); ++j )
+  {
+    args[j]->evalBlock( parent, features, rowsLeft, argValues[j] );
+    if ( parent->hasEvalError() )
+      return;
+
+    if ( mCoalesce )
+      continue;
+
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( rowsLeft.testBit( i ) && isNull( argValues[j][i] ) )
+        rowsLeft.clearBit( i );
+    }
+  }
+
+  while ( mArgValues.count() < args.count() )
+    mArgValues.append( QVariant() );
+
+  // run the function
+  values.fill( QVariant(), count );
+  int firstRow = parent->currentRowNumber();
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( !rowsLeft.testBit( i ) )
+      continue;
+
+    for ( int j = 0; j < args.count(); ++j )
+      mArgValues[j] = argValues[j][i];
+
+    parent->setCurrentRowNumber( firstRow + i );
+    values[i] = fd->func( mArgValues, &features[i], parent );
+    if ( parent->hasEvalError() )
+      break;
+  }
+  parent->setCurrentRowNumber( firstRow );
+}
+
 bool QgsExpression::NodeFunction::prepare( QgsExpression* parent, const QgsFields& fields )
 {
   bool res = true;
+  bool operandsStatic = true;
   if ( mArgs )
   {
     foreach ( Node* n, mArgs->list() )
     {
       res = res && n->prepare( parent, fields );
+      operandsStatic = operandsStatic && n->isStatic();
     }
   }
+
+  // only the built-in functions which depend on nothing but their arguments
+  // may be evaluated once for all features. Geometry functions are not, even
+  // those which do not use the geometry of the feature like geomFromWKT()
+  Function* fd = Functions()[mFnIndex];
+  bool deterministic = dynamic_cast<StaticFunction*>( fd ) && fd->params() != 0 && !fd->usesgeometry() &&
+                       fd->group() != QObject::tr( "Geometry" ) && fd->name() != "_specialcol_";
+
+  prepareStatic( parent, res && operandsStatic && deterministic );
   return res;
 }
 
@@ -2406,8 +3020,14 @@ QVariant QgsExpression::NodeLiteral::eval( QgsExpression* , QgsFeature* )
   return mValue;
 }
 
+void QgsExpression::NodeLiteral::evalBlock( QgsExpression* /*parent*/, QgsFeatureList& features, const QBitArray& /*rows*/, QVector<QVariant>& values )
+{
+  values.fill( mValue, features.count() );
+}
+
 bool QgsExpression::NodeLiteral::prepare( QgsExpression* /*parent*/, const QgsFields& /*fields*/ )
 {
+  mStatic = true;
   return true;
 }
 
@@ -2531,6 +3151,17 @@ QVariant QgsExpression::NodeColumnRef::eval( QgsExpression* /*parent*/, QgsFeatu
   return QVariant( "[" + mName + "]" );
 }
 
+void QgsExpression::NodeColumnRef::evalBlock( QgsExpression* /*parent*/, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values )
+{
+  int count = features.count();
+  values.resize( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( rows.testBit( i ) )
+      values[i] = features.at( i ).attribute( mIndex );
+  }
+}
+
 bool QgsExpression::NodeColumnRef::prepare( QgsExpression* parent, const QgsFields& fields )
 {
   for ( int i = 0; i < fields.count(); ++i )
@@ -2538,11 +3169,13 @@ bool QgsExpression::NodeColumnRef::prepare( QgsExpression* parent, const QgsFiel
     if ( QString::compare( fields[i].name(), mName, Qt::CaseInsensitive ) == 0 )
     {
       mIndex = i;
+      mType = fields[i].type();
       return true;
     }
   }
   parent->mEvalErrorString = QObject::tr( "Column '%1' not found" ).arg( mName );
   mIndex = -1;
+  mType = QVariant::Invalid;
   return false;
 }
 
@@ -2576,6 +3209,9 @@ QgsExpression::Node* QgsExpression::NodeColumnRef::createFromOgcFilter( QDomElem
 
 QVariant QgsExpression::NodeCondition::eval( QgsExpression* parent, QgsFeature* f )
 {
+  if ( mStatic )
+    return mStaticValue;
+
   foreach ( WhenThen* cond, mConditions )
   {
     QVariant vWhen = cond->mWhenExp->eval( parent, f );
@@ -2602,18 +3238,27 @@ QVariant QgsExpression::NodeCondition::eval( QgsExpression* parent, QgsFeature*
 
 bool QgsExpression::NodeCondition::prepare( QgsExpression* parent, const QgsFields& fields )
 {
+  mStatic = false;
+
   bool res;
+  bool operandsStatic = true;
   foreach ( WhenThen* cond, mConditions )
   {
     res = cond->mWhenExp->prepare( parent, fields )
           & cond->mThenExp->prepare( parent, fields );
     if ( !res ) return false;
+    operandsStatic = operandsStatic && cond->mWhenExp->isStatic() && cond->mThenExp->isStatic();
   }
 
+  res = true;
   if ( mElseExp )
-    return mElseExp->prepare( parent, fields );
+  {
+    res = mElseExp->prepare( parent, fields );
+    operandsStatic = operandsStatic && mElseExp->isStatic();
+  }
 
-  return true;
+  prepareStatic( parent, res && operandsStatic );
+  return res;
 }
 
 QString QgsExpression::NodeCondition::dump() const
@@ -20,6 +20,9 @@
 #include <QStringList>
 #include <QVariant>
 #include <QList>
+#include <QRegExp>
+#include <QBitArray>
+#include <QVector>
 #include <QDomDocument>
 
 #include "qgsfield.h"
@@ -68,6 +71,13 @@ There is no special (three-value) 'boolean' type: true/false is represented as
 
 For better performance with many evaluations you may first call prepare(fields) function
 to find out indices of columns and then repeatedly call evaluate(feature).
+Evaluation is not reentrant: it keeps state in the expression and its nodes (the
+evaluation error, the argument buffers of the functions, the matchers of LIKE and
+regular expression patterns), so an expression must not be evaluated by several
+threads at once. Create an expression from the same string for each thread.
+To process many features, evaluateBlock(features) evaluates the expression for a whole
+list of features at once: the operators work on arrays of values instead of walking
+the expression tree again for every feature.
 
 Type conversion: operators and functions that expect arguments to be of particular
 type automatically convert the arguments to that type, e.g. sin('2.1') will convert
@@ -112,6 +122,19 @@ class CORE_EXPORT QgsExpression
     //! @note this method does not expect that prepare() has been called on this instance
     QVariant evaluate( QgsFeature* f, const QgsFields& fields );
 
+    //! Evaluate a block of features and return the results in the same order.
+    //! The features get consecutive row numbers starting with the current row number.
+    //! Returns an empty vector if the evaluation failed for any of the features.
+    //! @note prepare() should be called before calling this method
+    //! @note added in 2.0
+    QVector<QVariant> evaluateBlock( QgsFeatureList& features );
+
+    //! Evaluate a block of features and return a bit for each feature
+    //! which is set where the result is true (a number other than zero)
+    //! @note prepare() should be called before calling this method
+    //! @note added in 2.0
+    QBitArray filterBlock( QgsFeatureList& features );
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const { return !mEvalErrorString.isNull(); }
     //! Returns evaluation error
@@ -135,6 +158,10 @@ class CORE_EXPORT QgsExpression
 
     int scale() {return mScale; }
 
+    //! Return the original string of the expression (or its dump if it has not been parsed from a string)
+    //! @note added in 2.0
+    QString expression() const { return mExpression.isNull() ? dump() : mExpression; }
+
     //! Return the parsed expression as a string - useful for debugging
     QString dump() const;
 
@@ -310,6 +337,7 @@ class CORE_EXPORT QgsExpression
     class CORE_EXPORT Node
     {
       public:
+        Node() : mStatic( false ) {}
         virtual ~Node() {}
         // abstract virtual eval function
         // errors are reported to the parent
@@ -319,6 +347,20 @@ class CORE_EXPORT QgsExpression
         // errors are reported to the parent
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields ) = 0;
 
+        //! Whether the node evaluates to the same value for all features (known after prepare)
+        //! @note added in 2.0
+        bool isStatic() const { return mStatic; }
+
+        //! Expected type of the non-NULL values returned by eval(), resolved by prepare
+        //! from the field types and literals, QVariant::Invalid if not known
+        //! @note added in 2.0
+        virtual QVariant::Type resultType() const { return QVariant::Invalid; }
+
+        // evaluation of a block of features, values are resized to the number of features;
+        // only the rows set in the mask need to be evaluated. The default implementation
+        // calls eval() for every row. Errors are reported to the parent
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
+
         virtual QString dump() const = 0;
 
         virtual void toOgcFilter( QDomDocument &doc, QDomElement &element ) const { Q_UNUSED( doc ); Q_UNUSED( element ); }
@@ -329,6 +371,14 @@ class CORE_EXPORT QgsExpression
 
         // support for visitor pattern
         virtual void accept( Visitor& v ) = 0;
+
+      protected:
+        // called at the end of prepare() of nodes with operands: if all the operands
+        // are static, the node is evaluated once and eval() returns the cached value
+        void prepareStatic( QgsExpression* parent, bool operandsStatic );
+
+        bool mStatic;
+        QVariant mStaticValue;
     };
 
     class CORE_EXPORT NodeList
@@ -337,8 +387,8 @@ class CORE_EXPORT QgsExpression
         NodeList() {}
         virtual ~NodeList() { foreach ( Node* n, mList ) delete n; }
         void append( Node* node ) { mList.append( node ); }
-        int count() { return mList.count(); }
-        QList<Node*> list() { return mList; }
+        int count() const { return mList.count(); }
+        QList<Node*> list() const { return mList; }
 
         virtual QString dump() const;
         virtual void toOgcFilter( QDomDocument &doc, QDomElement &element ) const;
@@ -383,8 +433,8 @@ class CORE_EXPORT QgsExpression
         NodeUnaryOperator( UnaryOperator op, Node* operand ) : mOp( op ), mOperand( operand ) {}
         ~NodeUnaryOperator() { delete mOperand; }
 
-        UnaryOperator op() { return mOp; }
-        Node* operand() { return mOperand; }
+        UnaryOperator op() const { return mOp; }
+        Node* operand() const { return mOperand; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -396,8 +446,13 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { return mOperand->referencedColumns(); }
         virtual bool needsGeometry() const { return mOperand->needsGeometry(); }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const;
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
+        // applies the operator to an evaluated operand
+        QVariant evalValue( QgsExpression* parent, const QVariant& val );
+
         UnaryOperator mOp;
         Node* mOperand;
     };
@@ -405,12 +460,12 @@ class CORE_EXPORT QgsExpression
     class CORE_EXPORT NodeBinaryOperator : public Node
     {
       public:
-        NodeBinaryOperator( BinaryOperator op, Node* opLeft, Node* opRight ) : mOp( op ), mOpLeft( opLeft ), mOpRight( opRight ) {}
+        NodeBinaryOperator( BinaryOperator op, Node* opLeft, Node* opRight ) : mOp( op ), mOpLeft( opLeft ), mOpRight( opRight ), mNumeric( false ), mStringCompare( false ), mMatchMode( MatchNone ) {}
         ~NodeBinaryOperator() { delete mOpLeft; delete mOpRight; }
 
-        BinaryOperator op() { return mOp; }
-        Node* opLeft() { return mOpLeft; }
-        Node* opRight() { return mOpRight; }
+        BinaryOperator op() const { return mOp; }
+        Node* opLeft() const { return mOpLeft; }
+        Node* opRight() const { return mOpRight; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -422,16 +477,54 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { return mOpLeft->referencedColumns() + mOpRight->referencedColumns(); }
         virtual bool needsGeometry() const { return mOpLeft->needsGeometry() || mOpRight->needsGeometry(); }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const;
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
+        // applies the operator to evaluated operands (other than AND and OR)
+        QVariant evalValues( QgsExpression* parent, const QVariant& vL, const QVariant& vR );
+
         bool compare( double diff );
         int computeInt( int x, int y );
         double computeDouble( double x, double y );
         QDateTime computeDateTimeFromInterval( QDateTime d, QgsExpression::Interval *i );
 
+        // evaluation of operands which are both Int or Double values
+        QVariant evalNumeric( const QVariant& vL, const QVariant& vR );
+
+        // LIKE and regular expression matching with the matcher prepared for the pattern
+        bool matches( const QString& str, const QString& pattern );
+        void prepareMatcher( const QString& pattern );
+
         BinaryOperator mOp;
         Node* mOpLeft;
         Node* mOpRight;
+
+        // resolved by prepare(): both operands are numeric fields or values
+        bool mNumeric;
+        // resolved by prepare(): one operand is a static string which is not a number,
+        // so the comparison is always done on strings
+        bool mStringCompare;
+
+        // LIKE patterns without wildcards inside are matched as plain strings,
+        // the other patterns are converted to a regular expression once
+        enum MatchMode
+        {
+          MatchNone,
+          MatchExact,
+          MatchPrefix,
+          MatchSuffix,
+          MatchContains,
+          MatchAll,
+          MatchLikeRegexp,
+          MatchRegexp
+        };
+        // the matcher is rebuilt during evaluation when the pattern changes,
+        // which is why the evaluation is not reentrant
+        MatchMode mMatchMode;
+        QString mMatchPattern;
+        QString mMatchString;
+        QRegExp mMatchRegexp;
     };
 
     class CORE_EXPORT NodeInOperator : public Node
@@ -440,9 +533,9 @@ class CORE_EXPORT QgsExpression
         NodeInOperator( Node* node, NodeList* list, bool notin = false ) : mNode( node ), mList( list ), mNotIn( notin ) {}
         virtual ~NodeInOperator() { delete mNode; delete mList; }
 
-        Node* node() { return mNode; }
-        bool isNotIn() { return mNotIn; }
-        NodeList* list() { return mList; }
+        Node* node() const { return mNode; }
+        bool isNotIn() const { return mNotIn; }
+        NodeList* list() const { return mList; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -453,6 +546,8 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { QStringList lst( mNode->referencedColumns() ); foreach ( Node* n, mList->list() ) lst.append( n->referencedColumns() ); return lst; }
         virtual bool needsGeometry() const { bool needs = false; foreach ( Node* n, mList->list() ) needs |= n->needsGeometry(); return needs; }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const { return mStatic ? mStaticValue.type() : QVariant::Int; }
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
         Node* mNode;
@@ -463,12 +558,12 @@ class CORE_EXPORT QgsExpression
     class CORE_EXPORT NodeFunction : public Node
     {
       public:
-        NodeFunction( int fnIndex, NodeList* args ): mFnIndex( fnIndex ), mArgs( args ) {}
+        NodeFunction( int fnIndex, NodeList* args );
         //NodeFunction( QString name, NodeList* args ) : mName(name), mArgs(args) {}
         virtual ~NodeFunction() { delete mArgs; }
 
-        int fnIndex() { return mFnIndex; }
-        NodeList* args() { return mArgs; }
+        int fnIndex() const { return mFnIndex; }
+        NodeList* args() const { return mArgs; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -480,11 +575,19 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { QStringList lst; if ( !mArgs ) return lst; foreach ( Node* n, mArgs->list() ) lst.append( n->referencedColumns() ); return lst; }
         virtual bool needsGeometry() const { bool needs = Functions()[mFnIndex]->usesgeometry(); if ( mArgs ) { foreach ( Node* n, mArgs->list() ) needs |= n->needsGeometry(); } return needs; }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const { return mStatic ? mStaticValue.type() : QVariant::Invalid; }
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
         //QString mName;
         int mFnIndex;
         NodeList* mArgs;
+
+        // coalesce() is the only function called with NULL arguments
+        bool mCoalesce;
+        // argument values, kept between the calls to avoid allocating the list for every feature.
+        // Written by eval(), so the evaluation is not reentrant
+        QVariantList mArgValues;
     };
 
     class CORE_EXPORT NodeLiteral : public Node
@@ -492,7 +595,7 @@ class CORE_EXPORT QgsExpression
       public:
         NodeLiteral( QVariant value ) : mValue( value ) {}
 
-        QVariant value() { return mValue; }
+        QVariant value() const { return mValue; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -504,6 +607,8 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { return QStringList(); }
         virtual bool needsGeometry() const { return false; }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const { return mValue.isNull() ? QVariant::Invalid : mValue.type(); }
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
         QVariant mValue;
@@ -512,9 +617,9 @@ class CORE_EXPORT QgsExpression
     class CORE_EXPORT NodeColumnRef : public Node
     {
       public:
-        NodeColumnRef( QString name ) : mName( name ), mIndex( -1 ) {}
+        NodeColumnRef( QString name ) : mName( name ), mIndex( -1 ), mType( QVariant::Invalid ) {}
 
-        QString name() { return mName; }
+        QString name() const { return mName; }
 
         virtual bool prepare( QgsExpression* parent, const QgsFields& fields );
         virtual QVariant eval( QgsExpression* parent, QgsFeature* f );
@@ -526,10 +631,13 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const { return QStringList( mName ); }
         virtual bool needsGeometry() const { return false; }
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const { return mType; }
+        virtual void evalBlock( QgsExpression* parent, QgsFeatureList& features, const QBitArray& rows, QVector<QVariant>& values );
 
       protected:
         QString mName;
         int mIndex;
+        QVariant::Type mType;
     };
 
     class CORE_EXPORT WhenThen
@@ -559,6 +667,7 @@ class CORE_EXPORT QgsExpression
         virtual QStringList referencedColumns() const;
         virtual bool needsGeometry() const;
         virtual void accept( Visitor& v ) { v.visit( this ); }
+        virtual QVariant::Type resultType() const { return mStatic ? mStaticValue.type() : QVariant::Invalid; }
 
       protected:
         WhenThenList mConditions;
@@ -585,6 +694,10 @@ class CORE_EXPORT QgsExpression
     /** entry function for the visitor pattern */
     void acceptVisitor( Visitor& v );
 
+    //! Return the root node of the parsed expression (null if there was a parser error)
+    //! @note added in 2.0
+    const Node* rootNode() const { return mRootNode; }
+
     // convert from/to OGC Filter
     void toOgcFilter( QDomDocument &doc, QDomElement &element ) const;
     static QgsExpression* createFromOgcFilter( QDomElement &element );
@@ -18,6 +18,7 @@
 QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest& request )
     : mRequest( request ),
     mClosed( false ),
+    mFilterApplied( false ),
     refs( 0 )
 {
 }
@@ -26,6 +27,21 @@ QgsAbstractFeatureIterator::~QgsAbstractFeatureIterator()
 {
 }
 
+bool QgsAbstractFeatureIterator::nextFilteredFeature( QgsFeature& f )
+{
+  if ( mFilterApplied ||
+       ( mRequest.filterType() != QgsFeatureRequest::FilterExpression &&
+         mRequest.filterType() != QgsFeatureRequest::FilterFids ) )
+    return nextFeature( f );
+
+  while ( nextFeature( f ) )
+  {
+    if ( mRequest.acceptFeature( f ) )
+      return true;
+  }
+  return false;
+}
+
 void QgsAbstractFeatureIterator::ref()
 {
   refs++;
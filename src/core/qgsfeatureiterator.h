@@ -32,6 +32,10 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
     //! fetch next feature, return true on success
     virtual bool nextFeature( QgsFeature& f ) = 0;
+    //! fetch next feature which passes the feature ids / expression filter of the request.
+    //! The filter is tested on the fetched features unless the iterator applies it natively.
+    //! @note added in 2.0
+    bool nextFilteredFeature( QgsFeature& f );
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -42,6 +46,11 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
     bool mClosed;
 
+    //! set by iterators that evaluate the feature ids / expression filter natively
+    //! (e.g. compiled to SQL), so that fetched features need not to be tested again
+    //! @note added in 2.0
+    bool mFilterApplied;
+
     // reference counting (to allow seamless copying of QgsFeatureIterator instances)
     int refs;
     void ref(); // add reference
@@ -111,7 +120,7 @@ inline QgsFeatureIterator::~QgsFeatureIterator()
 
 inline bool QgsFeatureIterator::nextFeature( QgsFeature& f )
 {
-  return mIter ? mIter->nextFeature( f ) : false;
+  return mIter ? mIter->nextFilteredFeature( f ) : false;
 }
 
 inline bool QgsFeatureIterator::rewind()
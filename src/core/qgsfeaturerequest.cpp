@@ -15,15 +15,85 @@
 #include "qgsfeaturerequest.h"
 
 #include "qgsfield.h"
+#include "qgsexpression.h"
 
 #include <QStringList>
 
 QgsFeatureRequest::QgsFeatureRequest()
     : mFilter( FilterNone )
+    , mFilterExpression( 0 )
+    , mFilterExpressionPrepared( false )
     , mFlags( 0 )
 {
 }
 
+QgsFeatureRequest::QgsFeatureRequest( const QgsFeatureRequest& rh )
+    : mFilterExpression( 0 )
+{
+  operator=( rh );
+}
+
+QgsFeatureRequest& QgsFeatureRequest::operator=( const QgsFeatureRequest & rh )
+{
+  if ( this == &rh )
+    return *this;
+
+  mFilter = rh.mFilter;
+  mFilterRect = rh.mFilterRect;
+  mFilterFid = rh.mFilterFid;
+  mFilterFids = rh.mFilterFids;
+  mFlags = rh.mFlags;
+  mAttrs = rh.mAttrs;
+
+  // expressions are not copyable: parse the text again
+  delete mFilterExpression;
+  mFilterExpression = rh.mFilterExpression ? new QgsExpression( rh.mFilterExpression->expression() ) : 0;
+  mFilterExpressionPrepared = false;
+
+  return *this;
+}
+
+QgsFeatureRequest::~QgsFeatureRequest()
+{
+  delete mFilterExpression;
+}
+
+QgsFeatureRequest& QgsFeatureRequest::setFilterExpression( const QString& expression )
+{
+  mFilter = FilterExpression;
+  delete mFilterExpression;
+  mFilterExpression = new QgsExpression( expression );
+  mFilterExpressionPrepared = false;
+  return *this;
+}
+
+bool QgsFeatureRequest::acceptFeature( QgsFeature& feature )
+{
+  switch ( mFilter )
+  {
+    case FilterFids:
+      return mFilterFids.contains( feature.id() );
+
+    case FilterExpression:
+    {
+      if ( !mFilterExpression || mFilterExpression->hasParserError() )
+        return false;
+
+      if ( !mFilterExpressionPrepared && feature.fields() )
+      {
+        mFilterExpression->prepare( *feature.fields() );
+        mFilterExpressionPrepared = true;
+      }
+
+      QVariant res = mFilterExpression->evaluate( &feature );
+      return res.toInt() != 0;
+    }
+
+    default:
+      return true;
+  }
+}
+
 
 QgsFeatureRequest& QgsFeatureRequest::setSubsetOfAttributes( const QStringList& attrNames, const QgsFields& fields )
 {
@@ -23,6 +23,8 @@
 #include <QList>
 typedef QList<int> QgsAttributeList;
 
+class QgsExpression;
+
 /**
  * This class wraps a request for features to a vector layer (or directly its vector data provider).
  * The request may apply a filter to fetch only a particular subset of features. Currently supported filters:
@@ -31,6 +33,10 @@ typedef QList<int> QgsAttributeList;
  * - rectangle - only features that intersect given rectangle should be fetched. For the sake of speed,
  *               the intersection is often done only using feature's bounding box. There is a flag
  *               ExactIntersect that makes sure that only intersecting features will be returned.
+ * - feature ids - only features whose id is in the given set are returned
+ * - expression - only features for which the expression evaluates to true are returned.
+ *               Providers translate the expression to their native query language where possible,
+ *               otherwise the features are tested by the iterator.
  *
  * For efficiency, it is also possible to tell provider that some data is not required:
  * - NoGeometry flag
@@ -50,6 +56,8 @@ typedef QList<int> QgsAttributeList;
  *     QgsFeatureRequest().setFilterRect(QgsRectangle(0,0,1,1))
  * - fetch only one feature
  *     QgsFeatureRequest().setFilterFid(45)
+ * - fetch features matching an expression
+ *     QgsFeatureRequest().setFilterExpression("\"type\" = 'road' AND \"lanes\" > 2")
  *
  */
 class CORE_EXPORT QgsFeatureRequest
@@ -68,11 +76,19 @@ class CORE_EXPORT QgsFeatureRequest
     {
       FilterNone,   //!< No filter is applied
       FilterRect,   //!< Filter using a rectangle
-      FilterFid     //!< Filter using feature ID
+      FilterFid,    //!< Filter using feature ID
+      FilterExpression, //!< Filter using an expression (added in 2.0)
+      FilterFids    //!< Filter using a set of feature IDs (added in 2.0)
     };
 
     //! construct a default request: for all features get attributes and geometries
     QgsFeatureRequest();
+    //! copy constructor - the filter expression is duplicated
+    QgsFeatureRequest( const QgsFeatureRequest& rh );
+
+    QgsFeatureRequest& operator=( const QgsFeatureRequest& rh );
+
+    ~QgsFeatureRequest();
 
     FilterType filterType() const { return mFilter; }
 
@@ -85,6 +101,29 @@ class CORE_EXPORT QgsFeatureRequest
     QgsFeatureRequest& setFilterFid( QgsFeatureId fid ) { mFilter = FilterFid; mFilterFid = fid; return *this; }
     const QgsFeatureId& filterFid() const { return mFilterFid; }
 
+    //! Set feature IDs that should be fetched.
+    //! @note added in 2.0
+    QgsFeatureRequest& setFilterFids( const QgsFeatureIds& fids ) { mFilter = FilterFids; mFilterFids = fids; return *this; }
+    const QgsFeatureIds& filterFids() const { return mFilterFids; }
+
+    //! Set filter expression. Only features for which the expression evaluates to true are fetched.
+    //! If a subset of attributes is requested from a data provider, it must include the
+    //! attributes referenced by the expression.
+    //! @note added in 2.0
+    QgsFeatureRequest& setFilterExpression( const QString& expression );
+    //! Returns the filter expression (or null if there is none)
+    //! @note added in 2.0
+    QgsExpression* filterExpression() const { return mFilterExpression; }
+
+    //! Remove the filter: all features will be fetched
+    //! @note added in 2.0
+    QgsFeatureRequest& disableFilter() { mFilter = FilterNone; return *this; }
+
+    //! Check whether the feature passes the feature ids or expression filter of the request.
+    //! Used by feature iterators that cannot apply the filter natively.
+    //! @note added in 2.0
+    bool acceptFeature( QgsFeature& feature );
+
     //! Set flags that affect how features will be fetched
     QgsFeatureRequest& setFlags( Flags flags ) { mFlags = flags; return *this; }
     const Flags& flags() const { return mFlags; }
@@ -98,7 +137,6 @@ class CORE_EXPORT QgsFeatureRequest
     QgsFeatureRequest& setSubsetOfAttributes( const QStringList& attrNames, const QgsFields& fields );
 
     // TODO: in future
-    // void setFilterExpression(const QString& expression); // using QgsExpression
     // void setFilterNativeExpression(con QString& expr);   // using provider's SQL (if supported)
     // void setLimit(int limit);
 
@@ -106,6 +144,10 @@ class CORE_EXPORT QgsFeatureRequest
     FilterType mFilter;
     QgsRectangle mFilterRect;
     QgsFeatureId mFilterFid;
+    QgsFeatureIds mFilterFids;
+    QgsExpression* mFilterExpression;
+    //! whether the filter expression has been prepared with feature's fields
+    bool mFilterExpressionPrepared;
     Flags mFlags;
     QgsAttributeList mAttrs;
 };
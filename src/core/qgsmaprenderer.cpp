@@ -26,6 +26,8 @@
 #include "qgsmaplayer.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsdistancearea.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterlayer.h"
 #include "qgscentralpointpositionmanager.h"
 #include "qgsoverlayobjectpositionmanager.h"
 #include "qgspalobjectpositionmanager.h"
@@ -41,6 +43,149 @@
 #include <QSettings>
 #include <QTime>
 #include <QCoreApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrentMap>
+
+/** Labeling engine used by the layers rendered in a worker thread.
+ * Layer preparation is forwarded to the real engine (serialized with a mutex),
+ * feature registrations are collected and replayed in the main thread once
+ * all layers have been drawn, so the labeling engine is never used concurrently.
+ */
+class QgsLayerLabelingCollector : public QgsLabelingEngineInterface
+{
+  public:
+    QgsLayerLabelingCollector( QgsLabelingEngineInterface* engine, QMutex* engineMutex )
+        : mEngine( engine ), mEngineMutex( engineMutex ) {}
+
+    void init( QgsMapRenderer* mp ) { Q_UNUSED( mp ); }
+    bool willUseLayer( QgsVectorLayer* layer )
+    {
+      QMutexLocker locker( mEngineMutex );
+      return mEngine->willUseLayer( layer );
+    }
+    int prepareLayer( QgsVectorLayer* layer, QSet<int>& attrIndices, QgsRenderContext& ctx )
+    {
+      QMutexLocker locker( mEngineMutex );
+      return mEngine->prepareLayer( layer, attrIndices, ctx );
+    }
+    QgsPalLayerSettings& layer( const QString& layerName )
+    {
+      QMutexLocker locker( mEngineMutex );
+      return mEngine->layer( layerName );
+    }
+    int addDiagramLayer( QgsVectorLayer* layer, QgsDiagramLayerSettings* s )
+    {
+      QMutexLocker locker( mEngineMutex );
+      return mEngine->addDiagramLayer( layer, s );
+    }
+    void registerFeature( QgsVectorLayer* layer, QgsFeature& feat, const QgsRenderContext& context = QgsRenderContext() )
+    {
+      mRegistrations.append( Registration( layer, feat, context, false ) );
+    }
+    void registerDiagramFeature( QgsVectorLayer* layer, QgsFeature& feat, const QgsRenderContext& context = QgsRenderContext() )
+    {
+      mRegistrations.append( Registration( layer, feat, context, true ) );
+    }
+    void drawLabeling( QgsRenderContext& context ) { Q_UNUSED( context ); }
+    void exit() {}
+    QList<QgsLabelPosition> labelsAtPosition( const QgsPoint& p ) { Q_UNUSED( p ); return QList<QgsLabelPosition>(); }
+    QList<QgsLabelPosition> labelsWithinRect( const QgsRectangle& r ) { Q_UNUSED( r ); return QList<QgsLabelPosition>(); }
+    QgsLabelingEngineInterface* clone() { return new QgsLayerLabelingCollector( mEngine, mEngineMutex ); }
+
+    //! passes the collected features to the real engine. Must be called from the main thread
+    void replay( QPainter* painter )
+    {
+      for ( int i = 0; i < mRegistrations.size(); ++i )
+      {
+        Registration& r = mRegistrations[i];
+        r.context.setPainter( painter );
+        r.context.setLabelingEngine( mEngine );
+        if ( r.diagram )
+          mEngine->registerDiagramFeature( r.layer, r.feature, r.context );
+        else
+          mEngine->registerFeature( r.layer, r.feature, r.context );
+      }
+      mRegistrations.clear();
+    }
+
+  private:
+    struct Registration
+    {
+      Registration( QgsVectorLayer* l, const QgsFeature& f, const QgsRenderContext& c, bool d )
+          : layer( l ), feature( f ), context( c ), diagram( d ) {}
+      QgsVectorLayer* layer;
+      QgsFeature feature;
+      QgsRenderContext context;
+      bool diagram;
+    };
+
+    QgsLabelingEngineInterface* mEngine;
+    QMutex* mEngineMutex;
+    QList<Registration> mRegistrations;
+};
+
+/** Everything needed to render one layer of the layer set off-screen */
+struct QgsLayerRenderJob
+{
+  QgsMapLayer* layer;
+  QgsRenderContext context;
+  QPainter::RenderHints renderHints;
+  QImage* image;
+  QgsCoordinateTransform* ct;
+  QgsRectangle extent1;
+  QgsRectangle extent2;
+  bool split;
+  bool scaleRaster;
+  double rasterScaleFactor;
+  bool mainThread; // drawn in the main thread, the provider cannot be used by other threads
+  QgsLayerLabelingCollector* labeling;
+  bool cached;
+  bool drawOk;
+};
+
+static void renderLayerJob( QgsLayerRenderJob& job )
+{
+  // the context only reads the main context to find out whether rendering has been canceled
+  if ( job.cached || job.context.renderingStopped() )
+    return;
+
+  QPainter painter( job.image );
+  painter.setRenderHints( job.renderHints );
+  // keep the logical coordinates of the target painter
+  painter.scale( job.rasterScaleFactor, job.rasterScaleFactor );
+  job.context.setPainter( &painter );
+  job.context.setCoordinateTransform( job.ct );
+  job.context.setLabelingEngine( job.labeling );
+  job.context.setExtent( job.extent1 );
+
+  if ( job.scaleRaster )
+  {
+    QgsMapToPixel rasterMapToPixel = job.context.mapToPixel();
+    rasterMapToPixel.setMapUnitsPerPixel( job.context.mapToPixel().mapUnitsPerPixel() / job.rasterScaleFactor );
+    rasterMapToPixel.setYMaximum( job.image->height() );
+    job.context.setMapToPixel( rasterMapToPixel );
+    painter.scale( 1.0 / job.rasterScaleFactor, 1.0 / job.rasterScaleFactor );
+  }
+
+  job.drawOk = job.layer->draw( job.context );
+  if ( job.split )
+  {
+    job.context.setExtent( job.extent2 );
+    job.drawOk = job.layer->draw( job.context ) && job.drawOk;
+  }
+
+  painter.end();
+  job.context.setPainter( 0 );
+}
+
+static void renderParallelLayerJob( QgsLayerRenderJob& job )
+{
+  // the other jobs are drawn in the main thread meanwhile
+  if ( !job.mainThread )
+    renderLayerJob( job );
+}
 
 QgsMapRenderer::QgsMapRenderer()
 {
@@ -62,6 +207,8 @@ QgsMapRenderer::QgsMapRenderer()
   mOutputUnits = QgsMapRenderer::Millimeters;
 
   mLabelingEngine = NULL;
+
+  mParallelRendering = false;
 }
 
 QgsMapRenderer::~QgsMapRenderer()
@@ -324,6 +471,11 @@ void QgsMapRenderer::render( QPainter* painter, double* forceWidthScale )
   if ( mLabelingEngine )
     mLabelingEngine->init( this );
 
+  // drop sub-pixel vertices, except for vector output where the pixels are much smaller
+  QSettings simplifySettings;
+  mRenderContext.setSimplifyThreshold( mRenderContext.forceVectorOutput() ? 0.0 :
+                                       simplifySettings.value( "/qgis/simplify_drawing_threshold", 1.0 ).toDouble() );
+
   // know we know if this render is just a repeat of the last time, we
   // can clear caches if it has changed
   if ( !mySameAsLastFlag )
@@ -345,7 +497,13 @@ void QgsMapRenderer::render( QPainter* painter, double* forceWidthScale )
 
   QgsRectangle r1, r2;
 
-  while ( li.hasPrevious() )
+  if ( mParallelRendering )
+  {
+    renderLayersParallel( overlayManager, allOverlayList, mySameAsLastFlag, rasterScaleFactor );
+  }
+
+  // serial rendering of the layers (skipped if they have been rendered in parallel)
+  while ( !mParallelRendering && li.hasPrevious() )
   {
     if ( mRenderContext.renderingStopped() )
     {
@@ -635,6 +793,179 @@ void QgsMapRenderer::render( QPainter* painter, double* forceWidthScale )
   mDrawing = false;
 }
 
+void QgsMapRenderer::renderLayersParallel( QgsOverlayObjectPositionManager* overlayManager, QList<QgsVectorOverlay*>& allOverlayList,
+    bool sameAsLastFlag, double rasterScaleFactor )
+{
+  QSettings mySettings;
+  bool renderCaching = mySettings.value( "/qgis/enable_render_caching", false ).toBool();
+
+  QPainter* painter = mRenderContext.painter();
+  QSize imageSize(( int ) ceil( mSize.width() * rasterScaleFactor ), ( int ) ceil( mSize.height() * rasterScaleFactor ) );
+
+  QMutex labelingMutex;
+  QList<QgsLayerRenderJob> jobs;
+
+  // prepare the jobs in the main thread, starting at the base of the stack
+  QListIterator<QString> li( mLayerSet );
+  li.toBack();
+  while ( li.hasPrevious() )
+  {
+    QString layerId = li.previous();
+    QgsMapLayer *ml = QgsMapLayerRegistry::instance()->mapLayer( layerId );
+    if ( !ml )
+    {
+      QgsDebugMsg( "Layer not found in registry!" );
+      continue;
+    }
+
+    if ( ml->hasScaleBasedVisibility() && !( ml->minimumScale() <= mScale && mScale < ml->maximumScale() ) && !mOverview )
+    {
+      QgsDebugMsg( "Layer not rendered because it is not within the defined visibility scale range" );
+      continue;
+    }
+
+    QgsLayerRenderJob job;
+    job.layer = ml;
+    job.context = mRenderContext;
+    job.renderHints = painter->renderHints();
+    job.image = 0;
+    job.ct = 0;
+    job.split = false;
+    job.extent1 = mExtent;
+    job.rasterScaleFactor = rasterScaleFactor;
+    job.scaleRaster = ml->type() == QgsMapLayer::RasterLayer && qAbs( rasterScaleFactor - 1.0 ) > 0.000001;
+    job.labeling = 0;
+    job.cached = false;
+    job.drawOk = true;
+
+    if ( hasCrsTransformEnabled() )
+    {
+      job.split = splitLayersExtent( ml, job.extent1, job.extent2 );
+      if ( !job.extent1.isFinite() || !job.extent2.isFinite() ) //there was a problem transforming the extent. Skip the layer
+      {
+        continue;
+      }
+      // every job gets its own transform, the cached ones must not be shared between threads
+      job.ct = new QgsCoordinateTransform( ml->crs(), *mDestCRS );
+    }
+
+    // raster providers without threaded reading, e.g. network ones, are used in the main thread
+    QgsRasterLayer* rl = qobject_cast<QgsRasterLayer *>( ml );
+    job.mainThread = rl && rl->dataProvider() && !( rl->dataProvider()->capabilities() & QgsRasterInterface::ThreadedRead );
+
+    // rendering stops when it is canceled in the main context
+    job.context.setMainContext( &mRenderContext );
+    job.context.setParallelJob( !job.mainThread );
+
+    QgsVectorLayer* vl = qobject_cast<QgsVectorLayer *>( ml );
+    if ( vl )
+    {
+      //create overlay objects for features within the view extent
+      if ( overlayManager )
+      {
+        QList<QgsVectorOverlay*> thisLayerOverlayList;
+        vl->vectorOverlays( thisLayerOverlayList );
+
+        QList<QgsVectorOverlay*>::iterator overlayIt = thisLayerOverlayList.begin();
+        for ( ; overlayIt != thisLayerOverlayList.end(); ++overlayIt )
+        {
+          if (( *overlayIt )->displayFlag() )
+          {
+            ( *overlayIt )->createOverlayObjects( mRenderContext );
+            allOverlayList.push_back( *overlayIt );
+          }
+        }
+
+        overlayManager->addLayer( vl, thisLayerOverlayList );
+      }
+
+      // Force render of layers that are being edited
+      // or if there's a labeling engine that needs the layer to register features
+      if ( vl->isEditable() || ( mLabelingEngine && mLabelingEngine->willUseLayer( vl ) ) )
+      {
+        ml->setCacheImage( 0 );
+      }
+
+      if ( mLabelingEngine )
+      {
+        job.labeling = new QgsLayerLabelingCollector( mLabelingEngine, &labelingMutex );
+      }
+    }
+
+    if ( renderCaching && !job.split && sameAsLastFlag && ml->cacheImage() && ml->cacheImage()->size() == imageSize )
+    {
+      QgsDebugMsg( "Caching enabled --- drawing layer from cached image" );
+      job.image = ml->cacheImage();
+      job.cached = true;
+    }
+    else
+    {
+      job.image = new QImage( imageSize, QImage::Format_ARGB32_Premultiplied );
+      job.image->fill( 0 );
+    }
+
+    jobs.append( job );
+  }
+
+  QgsDebugMsg( QString( "Rendering %1 layers in parallel" ).arg( jobs.size() ) );
+  QFuture<void> future = QtConcurrent::map( jobs, renderParallelLayerJob );
+
+  for ( int i = 0; i < jobs.size(); ++i )
+  {
+    if ( jobs[i].mainThread )
+      renderLayerJob( jobs[i] );
+  }
+
+  // process events while waiting, so that the rendering can be canceled
+  if ( QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread() )
+  {
+    QFutureWatcher<void> watcher;
+    QEventLoop loop;
+    connect( &watcher, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+    watcher.setFuture( future );
+    if ( !future.isFinished() )
+      loop.exec();
+  }
+  future.waitForFinished();
+
+  // composite the layer images and pass the labels to the engine, in stacking order
+  QRectF targetRect( 0, 0, mSize.width(), mSize.height() );
+  for ( int i = 0; i < jobs.size(); ++i )
+  {
+    QgsLayerRenderJob& job = jobs[i];
+
+    if ( !job.drawOk )
+    {
+      emit drawError( job.layer );
+    }
+
+    if ( !mRenderContext.renderingStopped() )
+    {
+      painter->drawImage( targetRect, *job.image );
+    }
+
+    if ( job.labeling )
+    {
+      job.labeling->replay( painter );
+      delete job.labeling;
+    }
+
+    if ( !job.cached )
+    {
+      if ( renderCaching && !job.split && !mRenderContext.renderingStopped() )
+      {
+        job.layer->setCacheImage( job.image ); //layer takes ownership of the image
+      }
+      else
+      {
+        delete job.image;
+      }
+    }
+
+    delete job.ct;
+  }
+}
+
 void QgsMapRenderer::setMapUnits( QGis::UnitType u )
 {
   mScaleCalculator->setMapUnits( u );
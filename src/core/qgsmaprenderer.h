@@ -38,6 +38,7 @@ class QgsCoordinateReferenceSystem;
 class QgsDistanceArea;
 class QgsOverlayObjectPositionManager;
 class QgsVectorLayer;
+class QgsVectorOverlay;
 
 class QgsPalLayerSettings;
 class QgsDiagramLayerSettings;
@@ -230,6 +231,18 @@ class CORE_EXPORT QgsMapRenderer : public QObject
     //! Added in QGIS v1.4
     void setLabelingEngine( QgsLabelingEngineInterface* iface );
 
+    //! Enable rendering of the layers in parallel. Each layer is drawn into its own
+    //! image by a worker thread and the images are composited in stacking order.
+    //! Labels registered by the layers are passed to the labeling engine afterwards.
+    //! Raster layers whose provider does not support threaded reading are drawn in the
+    //! calling thread meanwhile. Off by default.
+    //! \note Added in QGIS v2.0
+    void setParallelRenderingEnabled( bool enabled ) { mParallelRendering = enabled; }
+
+    //! Returns whether layers are rendered in parallel
+    //! \note Added in QGIS v2.0
+    bool isParallelRenderingEnabled() const { return mParallelRendering; }
+
   signals:
 
     void drawingProgress( int current, int total );
@@ -267,6 +280,12 @@ class CORE_EXPORT QgsMapRenderer : public QObject
     @note this method was added in version 1.1*/
     QgsOverlayObjectPositionManager* overlayManagerFromSettings();
 
+    /**Renders all layers of the layer set with a pool of worker threads, each layer
+    into its own image, and composites the images onto the context painter.
+    @note this method was added in version 2.0*/
+    void renderLayersParallel( QgsOverlayObjectPositionManager* overlayManager, QList<QgsVectorOverlay*>& allOverlayList,
+                               bool sameAsLastFlag, double rasterScaleFactor );
+
     //! indicates drawing in progress
     static bool mDrawing;
 
@@ -321,6 +340,9 @@ class CORE_EXPORT QgsMapRenderer : public QObject
     //! Locks rendering loop for concurrent draws
     QMutex mRenderMutex;
 
+    //! Render layers in parallel into off-screen images
+    bool mParallelRendering;
+
   private:
     const QgsCoordinateTransform* tr( QgsMapLayer *layer );
 };
@@ -27,7 +27,11 @@ QgsRenderContext::QgsRenderContext()
     mScaleFactor( 1.0 ),
     mRasterScaleFactor( 1.0 ),
     mRendererScale( 1.0 ),
-    mLabelingEngine( NULL )
+    mLabelingEngine( NULL ),
+    mSimplifyThreshold( 0.0 ),
+    mScreenGeometryCache( NULL ),
+    mMainContext( NULL ),
+    mParallelJob( false )
 {
 
 }
@@ -25,6 +25,7 @@
 class QPainter;
 
 class QgsLabelingEngineInterface;
+class QgsScreenGeometryCache;
 
 /** \ingroup core
  * Contains information about the context of a rendering operation.
@@ -53,7 +54,8 @@ class CORE_EXPORT QgsRenderContext
 
     double rasterScaleFactor() const {return mRasterScaleFactor;}
 
-    bool renderingStopped() const {return mRenderingStopped;}
+    //! True if the rendering has been canceled in this context or in its main context
+    bool renderingStopped() const { return mRenderingStopped || ( mMainContext && mMainContext->renderingStopped() ); }
 
     bool forceVectorOutput() const {return mForceVectorOutput;}
 
@@ -64,6 +66,22 @@ class CORE_EXPORT QgsRenderContext
     //! Added in QGIS v1.4
     QgsLabelingEngineInterface* labelingEngine() const { return mLabelingEngine; }
 
+    //! Distance in pixels under which consecutive vertices are merged when drawing (0 = no simplification)
+    //! @note added in 2.0
+    double simplifyThreshold() const { return mSimplifyThreshold; }
+
+    //! Cache of screen geometries of the layer being drawn (can be NULL)
+    //! @note added in 2.0
+    QgsScreenGeometryCache* screenGeometryCache() const { return mScreenGeometryCache; }
+
+    //! Context of the whole map for a layer drawn with a copy of it (can be NULL)
+    //! @note added in 2.0
+    const QgsRenderContext* mainContext() const { return mMainContext; }
+
+    //! True if the layer is drawn in a worker thread, it must not process events then
+    //! @note added in 2.0
+    bool isParallelJob() const { return mParallelJob; }
+
     //setters
 
     /**Sets coordinate transformation. QgsRenderContext does not take ownership*/
@@ -80,6 +98,15 @@ class CORE_EXPORT QgsRenderContext
     void setForceVectorOutput( bool force ) {mForceVectorOutput = force;}
     //! Added in QGIS v1.4
     void setLabelingEngine( QgsLabelingEngineInterface* iface ) { mLabelingEngine = iface; }
+    //! @note added in 2.0
+    void setSimplifyThreshold( double threshold ) { mSimplifyThreshold = threshold; }
+    //! Does not take ownership. @note added in 2.0
+    void setScreenGeometryCache( QgsScreenGeometryCache* cache ) { mScreenGeometryCache = cache; }
+    //! Rendering with this context stops when it is stopped in the main context. Does not take ownership.
+    //! @note added in 2.0
+    void setMainContext( const QgsRenderContext* context ) { mMainContext = context; }
+    //! @note added in 2.0
+    void setParallelJob( bool parallel ) { mParallelJob = parallel; }
 
   private:
 
@@ -113,6 +140,18 @@ class CORE_EXPORT QgsRenderContext
 
     /**Labeling engine (can be NULL)*/
     QgsLabelingEngineInterface* mLabelingEngine;
+
+    /**Vertices closer than this number of pixels are merged when drawing*/
+    double mSimplifyThreshold;
+
+    /**Screen geometries of the current layer (can be NULL)*/
+    QgsScreenGeometryCache* mScreenGeometryCache;
+
+    /**Context whose cancellation also stops this one (can be NULL)*/
+    const QgsRenderContext* mMainContext;
+
+    /**True if drawn in a worker thread*/
+    bool mParallelJob;
 };
 
 #endif
@@ -17,6 +17,7 @@
 
 #include "qgsgeometry.h"
 #include "qgsfeature.h"
+#include "qgsfeatureiterator.h"
 #include "qgsrectangle.h"
 #include "qgslogger.h"
 
@@ -48,7 +49,74 @@ class QgisVisitor : public SpatialIndex::IVisitor
 };
 
 
+
+// data stream for bulk loading of the R-tree: reads the features from the iterator
+class QgsFeatureIteratorDataStream : public IDataStream
+{
+  public:
+    QgsFeatureIteratorDataStream( const QgsFeatureIterator& fi )
+        : mFi( fi ), mNextData( 0 )
+    {
+      readNextEntry();
+    }
+
+    ~QgsFeatureIteratorDataStream()
+    {
+      delete mNextData;
+    }
+
+    //! returns a pointer to the next entry in the stream or 0 at the end of the stream
+    virtual IData* getNext()
+    {
+      RTree::Data* d = mNextData;
+      mNextData = 0;
+      readNextEntry();
+      return d;
+    }
+
+    //! returns true if there are more items in the stream
+    virtual bool hasNext() { return mNextData != 0; }
+
+    //! the number of items is not known in advance
+    virtual uint32_t size() { Q_ASSERT( 0 && "not available" ); return 0; }
+
+    //! the iterator can be traversed only once
+    virtual void rewind() { Q_ASSERT( 0 && "not available" ); }
+
+  protected:
+    void readNextEntry()
+    {
+      QgsFeature f;
+      Region r;
+      QgsFeatureId id;
+      while ( mFi.nextFeature( f ) )
+      {
+        if ( QgsSpatialIndex::featureInfo( f, r, id ) )
+        {
+          mNextData = new RTree::Data( 0, 0, r, FID_TO_NUMBER( id ) );
+          return;
+        }
+      }
+    }
+
+  private:
+    QgsFeatureIterator mFi;
+    RTree::Data* mNextData;
+};
+
+
 QgsSpatialIndex::QgsSpatialIndex()
+{
+  initTree();
+}
+
+QgsSpatialIndex::QgsSpatialIndex( const QgsFeatureIterator& fi )
+{
+  QgsFeatureIteratorDataStream stream( fi );
+  initTree( &stream );
+}
+
+void QgsSpatialIndex::initTree( IDataStream* inputStream )
 {
   // for now only memory manager
   mStorageManager = StorageManager::createNewMemoryStorageManager();
@@ -68,6 +136,15 @@ QgsSpatialIndex::QgsSpatialIndex()
 
   // create R-tree
   SpatialIndex::id_type indexId;
+
+  // the bulk loader refuses an empty stream
+  if ( inputStream && inputStream->hasNext() )
+  {
+    mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, *inputStream, *mStorage, fillFactor, indexCapacity,
+             leafCapacity, dimension, variant, indexId );
+    return;
+  }
+
   mRTree = RTree::createNewRTree( *mStorage, fillFactor, indexCapacity,
                                   leafCapacity, dimension, variant, indexId );
 }
@@ -0,0 +1,374 @@
+/***************************************************************************
+    qgssqlexpressioncompiler.cpp
+    ---------------------
+    begin                : February 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgssqlexpressioncompiler.h"
+
+#include "qgslogger.h"
+
+QgsSqlExpressionCompiler::QgsSqlExpressionCompiler( const QgsFields& fields, Flags flags )
+    : mFields( fields )
+    , mFlags( flags )
+{
+}
+
+QgsSqlExpressionCompiler::~QgsSqlExpressionCompiler()
+{
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compile( const QgsExpression* exp )
+{
+  mResult.clear();
+
+  if ( !exp || !exp->rootNode() )
+    return Fail;
+
+  Result res = compile( exp->rootNode(), mResult );
+  QgsDebugMsgLevel( QString( "compiled '%1' to '%2' (result %3)" ).arg( exp->expression(), mResult, QString::number( res ) ), 3 );
+  return res;
+}
+
+QString QgsSqlExpressionCompiler::quotedIdentifier( const QString& identifier )
+{
+  QString quoted = identifier;
+  quoted.replace( '"', "\"\"" );
+  return quoted.prepend( "\"" ).append( "\"" );
+}
+
+QString QgsSqlExpressionCompiler::quotedValue( const QVariant& value )
+{
+  if ( value.isNull() )
+    return "NULL";
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      return value.toString();
+
+    case QVariant::Double:
+      return QString::number( value.toDouble(), 'g', 17 );
+
+    default:
+    {
+      QString v = value.toString();
+      v.replace( "'", "''" );
+      return v.prepend( "'" ).append( "'" );
+    }
+  }
+}
+
+QVariant::Type QgsSqlExpressionCompiler::nodeType( const QgsExpression::Node* node ) const
+{
+  if ( const QgsExpression::NodeLiteral* n = dynamic_cast<const QgsExpression::NodeLiteral*>( node ) )
+  {
+    switch ( n->value().type() )
+    {
+      case QVariant::Int:
+      case QVariant::LongLong:
+      case QVariant::Double:
+        return QVariant::Double;
+      case QVariant::String:
+        return QVariant::String;
+      default:
+        return QVariant::Invalid;
+    }
+  }
+
+  if ( const QgsExpression::NodeColumnRef* n = dynamic_cast<const QgsExpression::NodeColumnRef*>( node ) )
+  {
+    for ( int i = 0; i < mFields.count(); ++i )
+    {
+      if ( QString::compare( mFields[i].name(), n->name(), Qt::CaseInsensitive ) != 0 )
+        continue;
+
+      switch ( mFields[i].type() )
+      {
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QVariant::Double:
+          return QVariant::Double;
+        case QVariant::String:
+          return QVariant::String;
+        default:
+          return QVariant::Invalid;
+      }
+    }
+    return QVariant::Invalid;
+  }
+
+  if ( const QgsExpression::NodeUnaryOperator* n = dynamic_cast<const QgsExpression::NodeUnaryOperator*>( node ) )
+  {
+    if ( n->op() == QgsExpression::uoMinus && nodeType( n->operand() ) == QVariant::Double )
+      return QVariant::Double;
+    return QVariant::Invalid;
+  }
+
+  if ( const QgsExpression::NodeBinaryOperator* n = dynamic_cast<const QgsExpression::NodeBinaryOperator*>( node ) )
+  {
+    switch ( n->op() )
+    {
+      case QgsExpression::boPlus:
+      case QgsExpression::boMinus:
+      case QgsExpression::boMul:
+        if ( nodeType( n->opLeft() ) == QVariant::Double && nodeType( n->opRight() ) == QVariant::Double )
+          return QVariant::Double;
+        return QVariant::Invalid;
+      default:
+        return QVariant::Invalid;
+    }
+  }
+
+  return QVariant::Invalid;
+}
+
+static bool isNullLiteral( const QgsExpression::Node* node )
+{
+  const QgsExpression::NodeLiteral* n = dynamic_cast<const QgsExpression::NodeLiteral*>( node );
+  return n && n->value().isNull();
+}
+
+static bool isAscii( const QString& str )
+{
+  for ( int i = 0; i < str.length(); ++i )
+  {
+    if ( str[i].unicode() > 127 )
+      return false;
+  }
+  return true;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compile( const QgsExpression::Node* node, QString& result )
+{
+  if ( const QgsExpression::NodeUnaryOperator* n = dynamic_cast<const QgsExpression::NodeUnaryOperator*>( node ) )
+  {
+    QString operand;
+    if ( compile( n->operand(), operand ) != Complete )
+      return Fail;
+
+    switch ( n->op() )
+    {
+      case QgsExpression::uoNot:
+        result = QString( "NOT (%1)" ).arg( operand );
+        return Complete;
+
+      case QgsExpression::uoMinus:
+        if ( nodeType( n->operand() ) != QVariant::Double )
+          return Fail;
+        result = QString( "-(%1)" ).arg( operand );
+        return Complete;
+    }
+
+    return Fail;
+  }
+
+  if ( const QgsExpression::NodeBinaryOperator* n = dynamic_cast<const QgsExpression::NodeBinaryOperator*>( node ) )
+  {
+    QString left, right;
+    Result lr = compile( n->opLeft(), left );
+    Result rr = compile( n->opRight(), right );
+
+    switch ( n->op() )
+    {
+      case QgsExpression::boAnd:
+        if ( lr == Fail && rr == Fail )
+          return Fail;
+        if ( lr == Fail )
+        {
+          // use just the right part - a less restrictive condition
+          result = right;
+          return Partial;
+        }
+        if ( rr == Fail )
+        {
+          result = left;
+          return Partial;
+        }
+        result = QString( "(%1) AND (%2)" ).arg( left, right );
+        return lr == Complete && rr == Complete ? Complete : Partial;
+
+      case QgsExpression::boOr:
+        if ( lr == Fail || rr == Fail )
+          return Fail;
+        result = QString( "(%1) OR (%2)" ).arg( left, right );
+        return lr == Complete && rr == Complete ? Complete : Partial;
+
+      default:
+        break;
+    }
+
+    // all the other operators need both operands to be translated exactly
+    if ( lr != Complete || rr != Complete )
+      return Fail;
+
+    QVariant::Type lt = nodeType( n->opLeft() );
+    QVariant::Type rt = nodeType( n->opRight() );
+
+    switch ( n->op() )
+    {
+      case QgsExpression::boEQ:
+      case QgsExpression::boNE:
+      case QgsExpression::boLE:
+      case QgsExpression::boGE:
+      case QgsExpression::boLT:
+      case QgsExpression::boGT:
+        // comparison with NULL is always unknown - both here and in SQL
+        if ( !isNullLiteral( n->opLeft() ) && !isNullLiteral( n->opRight() ) &&
+             ( lt == QVariant::Invalid || lt != rt ) )
+          return Fail; // the expression would convert the types, the database might refuse to
+        if ( lt == QVariant::String && rt == QVariant::String && n->op() != QgsExpression::boEQ && n->op() != QgsExpression::boNE )
+          return Fail; // the expression orders by code points, the database by its collation
+        result = QString( "%1 %2 %3" ).arg( left, QString( QgsExpression::BinaryOperatorText[n->op()] ), right );
+        if (( mFlags & CollationDependent ) && lt == QVariant::String && rt == QVariant::String )
+        {
+          // the collation may consider different strings equal,
+          // so only the equality selects a superset of the features
+          return n->op() == QgsExpression::boEQ ? Partial : Fail;
+        }
+        return Complete;
+
+      case QgsExpression::boIs:
+      case QgsExpression::boIsNot:
+        if ( !isNullLiteral( n->opRight() ) )
+          return Fail;
+        result = QString( "%1 %2 NULL" ).arg( left, QString( QgsExpression::BinaryOperatorText[n->op()] ) );
+        return Complete;
+
+      case QgsExpression::boLike:
+      case QgsExpression::boNotLike:
+      case QgsExpression::boILike:
+      case QgsExpression::boNotILike:
+      {
+        if ( lt != QVariant::String || rt != QVariant::String )
+          return Fail;
+
+        // the expression matches the pattern as a regular expression after replacing % and _
+        const QgsExpression::NodeLiteral* pattern = dynamic_cast<const QgsExpression::NodeLiteral*>( n->opRight() );
+        if ( !pattern || pattern->value().toString().contains( QRegExp( "[\\\\.^$|?*+()\\[\\]{}]" ) ) )
+          return Fail;
+
+        bool negate = n->op() == QgsExpression::boNotLike || n->op() == QgsExpression::boNotILike;
+        bool caseSensitive = n->op() == QgsExpression::boLike || n->op() == QgsExpression::boNotLike;
+        QString op = negate ? "NOT LIKE" : "LIKE";
+
+        if ( mFlags & CollationDependent )
+        {
+          // the collation may match more values, the negation would miss some
+          if ( negate )
+            return Fail;
+          if ( caseSensitive )
+            result = QString( "%1 LIKE %2" ).arg( left, right );
+          else
+            result = QString( "lower(%1) LIKE lower(%2)" ).arg( left, right );
+          return Partial;
+        }
+
+        if ( mFlags & CaseInsensitiveLike )
+        {
+          if ( !caseSensitive )
+          {
+            // other letters than ASCII are compared case sensitively by the database
+            if ( !isAscii( pattern->value().toString() ) )
+              return Fail;
+            result = QString( "%1 %2 %3" ).arg( left, op, right );
+            return Partial;
+          }
+          if ( negate )
+            return Fail;
+          // matches also the values that differ in case
+          result = QString( "%1 LIKE %2" ).arg( left, right );
+          return Partial;
+        }
+
+        if ( caseSensitive )
+          result = QString( "%1 %2 %3" ).arg( left, op, right );
+        else if ( mFlags & ILikeSupported )
+          result = QString( "%1 %2 %3" ).arg( left, QString( negate ? "NOT ILIKE" : "ILIKE" ), right );
+        else
+          result = QString( "lower(%1) %2 lower(%3)" ).arg( left, op, right );
+        return Complete;
+      }
+
+      case QgsExpression::boPlus:
+      case QgsExpression::boMinus:
+      case QgsExpression::boMul:
+        if ( lt != QVariant::Double || rt != QVariant::Double )
+          return Fail;
+        result = QString( "(%1 %2 %3)" ).arg( left, QString( QgsExpression::BinaryOperatorText[n->op()] ), right );
+        return Complete;
+
+      default:
+        // division, modulo, power, concatenation and regular expressions
+        // do not behave the same way in all databases
+        return Fail;
+    }
+  }
+
+  if ( const QgsExpression::NodeInOperator* n = dynamic_cast<const QgsExpression::NodeInOperator*>( node ) )
+  {
+    QString value;
+    if ( compile( n->node(), value ) != Complete )
+      return Fail;
+
+    QVariant::Type type = nodeType( n->node() );
+    if ( type == QVariant::Invalid )
+      return Fail;
+
+    QStringList list;
+    foreach ( QgsExpression::Node* item, n->list()->list() )
+    {
+      QString s;
+      if ( compile( item, s ) != Complete || nodeType( item ) != type )
+        return Fail;
+      list << s;
+    }
+
+    if (( mFlags & CollationDependent ) && type == QVariant::String )
+    {
+      // see the comparison operators
+      if ( n->isNotIn() )
+        return Fail;
+      result = QString( "%1 IN (%2)" ).arg( value, list.join( "," ) );
+      return Partial;
+    }
+
+    result = QString( "%1 %2 (%3)" ).arg( value, QString( n->isNotIn() ? "NOT IN" : "IN" ), list.join( "," ) );
+    return Complete;
+  }
+
+  if ( const QgsExpression::NodeLiteral* n = dynamic_cast<const QgsExpression::NodeLiteral*>( node ) )
+  {
+    if ( !n->value().isNull() && nodeType( n ) == QVariant::Invalid )
+      return Fail;
+    result = quotedValue( n->value() );
+    return Complete;
+  }
+
+  if ( const QgsExpression::NodeColumnRef* n = dynamic_cast<const QgsExpression::NodeColumnRef*>( node ) )
+  {
+    for ( int i = 0; i < mFields.count(); ++i )
+    {
+      if ( QString::compare( mFields[i].name(), n->name(), Qt::CaseInsensitive ) == 0 )
+      {
+        result = quotedIdentifier( mFields[i].name() );
+        return Complete;
+      }
+    }
+    return Fail;
+  }
+
+  // functions and conditions are evaluated by the iterator
+  return Fail;
+}
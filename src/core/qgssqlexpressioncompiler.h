@@ -0,0 +1,81 @@
+/***************************************************************************
+    qgssqlexpressioncompiler.h
+    ---------------------
+    begin                : February 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSSQLEXPRESSIONCOMPILER_H
+#define QGSSQLEXPRESSIONCOMPILER_H
+
+#include "qgsexpression.h"
+#include "qgsfield.h"
+
+/** \ingroup core
+ * Translates a QgsExpression to an SQL WHERE clause so that data providers
+ * may evaluate filter expressions in the database.
+ *
+ * Only a subset of expressions can be translated: comparisons, logical and
+ * simple arithmetic operators, IN, IS NULL, LIKE, literals and column references.
+ * If just a part of an AND expression can be translated, the result is
+ * Partial - the SQL clause selects a superset of the features and the
+ * expression still has to be tested on the fetched features. The same holds
+ * for string comparisons the database may evaluate differently, e.g. a LIKE
+ * which folds only ASCII letters or an equality following a case insensitive
+ * collation. Ordering comparisons of strings are not translated, the database
+ * orders them by its collation rather than by code points.
+ *
+ * Providers subclass it to quote identifiers and values in their dialect.
+ * @note added in 2.0
+ */
+class CORE_EXPORT QgsSqlExpressionCompiler
+{
+  public:
+    enum Result
+    {
+      None,     //!< Nothing has been compiled yet
+      Complete, //!< Expression has been translated completely
+      Partial,  //!< Expression has been translated to a less restrictive clause
+      Fail      //!< Expression could not be translated
+    };
+
+    enum Flag
+    {
+      CaseInsensitiveLike = 1,  //!< LIKE of the database ignores the case of ASCII letters only
+      ILikeSupported      = 2,  //!< ILIKE operator is available
+      CollationDependent  = 4   //!< string comparisons and LIKE follow a collation which may ignore case, accents or trailing spaces
+    };
+    Q_DECLARE_FLAGS( Flags, Flag )
+
+    QgsSqlExpressionCompiler( const QgsFields& fields, Flags flags = 0 );
+    virtual ~QgsSqlExpressionCompiler();
+
+    //! translate the expression, the resulting clause is returned by result()
+    virtual Result compile( const QgsExpression* exp );
+
+    //! the translated WHERE clause
+    QString result() const { return mResult; }
+
+  protected:
+    virtual QString quotedIdentifier( const QString& identifier );
+    virtual QString quotedValue( const QVariant& value );
+    virtual Result compile( const QgsExpression::Node* node, QString& str );
+
+    //! type class of a node: numeric (QVariant::Double), string (QVariant::String) or unknown (QVariant::Invalid)
+    QVariant::Type nodeType( const QgsExpression::Node* node ) const;
+
+    const QgsFields& mFields;
+    Flags mFlags;
+    QString mResult;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS( QgsSqlExpressionCompiler::Flags )
+
+#endif // QGSSQLEXPRESSIONCOMPILER_H
@@ -64,6 +64,7 @@
 #include "qgsvectorlayereditbuffer.h"
 #include "qgsvectorlayereditutils.h"
 #include "qgsvectorlayerfeatureiterator.h"
+#include "qgsvectorlayergeneralization.h"
 #include "qgsvectorlayerjoinbuffer.h"
 #include "qgsvectorlayerundocommand.h"
 #include "qgsvectoroverlay.h"
@@ -102,6 +103,9 @@ QgsVectorLayer::QgsVectorLayer( QString vectorLayerPath,
     , mVertexMarkerOnlyForSelection( false )
     , mEditorLayout( GeneratedLayout )
     , mCache( new QgsVectorLayerCache( this ) )
+    , mScreenGeometryCache( 0 )
+    , mGeneralization( 0 )
+    , mGeneralizationBand( -1 )
     , mEditBuffer( 0 )
     , mJoinBuffer( 0 )
     , mDiagramRenderer( 0 )
@@ -193,6 +197,8 @@ QgsVectorLayer::~QgsVectorLayer()
   delete mEditBuffer;
   delete mJoinBuffer;
   delete mCache;
+  delete mScreenGeometryCache;
+  delete mGeneralization;
   delete mLabel;
   delete mDiagramLayerSettings;
 
@@ -727,12 +733,16 @@ void QgsVectorLayer::drawRendererV2( QgsFeatureIterator &fit, QgsRenderContext&
 
   mRendererV2->startRender( rendererContext, this );
 
+  // lines of consecutive features with the same symbol are drawn together
+  mRendererV2->startBatch();
+
 #ifndef Q_WS_MAC
   int featureCount = 0;
 #endif //Q_WS_MAC
 
   QgsFeature fet;
-  while ( fit.nextFeature( fet ) )
+  QgsFeatureIds notGeneralized;
+  while ( nextFeatureToDraw( fit, fet, notGeneralized ) )
   {
     try
     {
@@ -748,8 +758,13 @@ void QgsVectorLayer::drawRendererV2( QgsFeatureIterator &fit, QgsRenderContext&
       if ( !mEnableBackbuffer ) // do not handle events, as we're already inside a paint event
       {
 #endif // Q_WS_X11
-        if ( mUpdateThreshold > 0 && 0 == featureCount % mUpdateThreshold )
+        if ( rendererContext.isParallelJob() )
+        {
+          // layers drawn in worker threads do not touch the GUI
+        }
+        else if ( mUpdateThreshold > 0 && 0 == featureCount % mUpdateThreshold )
         {
+          mRendererV2->drawBatch();
           emit screenUpdateRequested();
           // emit drawingProgress( featureCount, totalFeatures );
           qApp->processEvents();
@@ -812,7 +827,7 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
   if ( !hasGeometryType() )
     return;
 
-  QHash< QgsSymbolV2*, QList<QgsFeature> > features; // key = symbol, value = array of features
+  QHash< QgsSymbolV2*, QgsScreenFeatureList > features; // key = symbol, value = features in screen coordinates
 
   QSettings settings;
   bool vertexMarkerOnlyForSelection = settings.value( "/qgis/digitizing/marker_only_for_selected", false ).toBool();
@@ -831,10 +846,11 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
 
   // 1. fetch features
   QgsFeature fet;
+  QgsFeatureIds notGeneralized;
 #ifndef Q_WS_MAC
   int featureCount = 0;
 #endif //Q_WS_MAC
-  while ( fit.nextFeature( fet ) )
+  while ( nextFeatureToDraw( fit, fet, notGeneralized ) )
   {
     if ( !fet.geometry() )
       continue; // skip features without geometry
@@ -845,7 +861,7 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
       return;
     }
 #ifndef Q_WS_MAC
-    if ( featureCount % 1000 == 0 )
+    if ( featureCount % 1000 == 0 && !rendererContext.isParallelJob() )
     {
       qApp->processEvents();
     }
@@ -856,11 +872,21 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
       continue;
     }
 
-    if ( !features.contains( sym ) )
+    bool sel = mSelectedFeatureIds.contains( fet.id() );
+    // maybe vertex markers should be drawn only during the last pass...
+    bool drawMarker = ( mEditBuffer && ( !vertexMarkerOnlyForSelection || sel ) );
+
+    try
     {
-      features.insert( sym, QList<QgsFeature>() );
+      // only the screen coordinates and the attributes are kept until all features are fetched
+      mRendererV2->storeScreenFeature( fet, sym, rendererContext, sel, drawMarker, features[sym] );
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse );
+      QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( fet.id() ).arg( cse.what() ) );
     }
-    features[sym].append( fet );
 
     if ( mEditBuffer )
     {
@@ -903,7 +929,8 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
     }
   }
 
-  // 2. draw features in correct order
+  // 2. draw features in correct order, with the lines of a level item in batches
+  mRendererV2->startBatch();
   for ( int l = 0; l < levels.count(); l++ )
   {
     QgsSymbolV2Level& level = levels[l];
@@ -915,42 +942,15 @@ void QgsVectorLayer::drawRendererV2Levels( QgsFeatureIterator &fit, QgsRenderCon
         QgsDebugMsg( "level item's symbol not found!" );
         continue;
       }
-      int layer = item.layer();
-      QList<QgsFeature>& lst = features[item.symbol()];
-      QList<QgsFeature>::iterator fit;
 #ifndef Q_WS_MAC
-      featureCount = 0;
+      if ( !rendererContext.isParallelJob() )
+        qApp->processEvents();
 #endif //Q_WS_MAC
-      for ( fit = lst.begin(); fit != lst.end(); ++fit )
+      mRendererV2->renderScreenFeatures( features[item.symbol()], rendererContext, item.layer() );
+      if ( rendererContext.renderingStopped() )
       {
-        if ( rendererContext.renderingStopped() )
-        {
-          stopRendererV2( rendererContext, selRenderer );
-          return;
-        }
-#ifndef Q_WS_MAC
-        if ( featureCount % 1000 == 0 )
-        {
-          qApp->processEvents();
-        }
-#endif //Q_WS_MAC
-        bool sel = mSelectedFeatureIds.contains( fit->id() );
-        // maybe vertex markers should be drawn only during the last pass...
-        bool drawMarker = ( mEditBuffer && ( !vertexMarkerOnlyForSelection || sel ) );
-
-        try
-        {
-          mRendererV2->renderFeature( *fit, rendererContext, layer, sel, drawMarker );
-        }
-        catch ( const QgsCsException &cse )
-        {
-          Q_UNUSED( cse );
-          QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
-                       .arg( fet.id() ).arg( cse.what() ) );
-        }
-#ifndef Q_WS_MAC
-        ++featureCount;
-#endif //Q_WS_MAC
+        stopRendererV2( rendererContext, selRenderer );
+        return;
       }
     }
   }
@@ -964,6 +964,90 @@ void QgsVectorLayer::reload()
   {
     mDataProvider->reloadData();
   }
+
+  if ( mScreenGeometryCache )
+    mScreenGeometryCache->clear();
+
+  // the features may have been changed by someone else
+  clearGeneralization();
+}
+
+bool QgsVectorLayer::buildGeneralization( const QList<double>& scales )
+{
+  if ( !mGeneralization )
+    mGeneralization = new QgsVectorLayerGeneralization();
+
+  bool res = mGeneralization->build( this, scales );
+  if ( !res )
+    clearGeneralization();
+
+  setCacheImage( 0 );
+  return res;
+}
+
+bool QgsVectorLayer::saveGeneralization( const QString& fileName )
+{
+  return mGeneralization && mGeneralization->save( fileName );
+}
+
+bool QgsVectorLayer::loadGeneralization( const QString& fileName )
+{
+  if ( !mGeneralization )
+    mGeneralization = new QgsVectorLayerGeneralization();
+
+  bool res = mGeneralization->load( fileName, this );
+  if ( !res )
+    clearGeneralization();
+
+  setCacheImage( 0 );
+  return res;
+}
+
+void QgsVectorLayer::clearGeneralization()
+{
+  delete mGeneralization;
+  mGeneralization = 0;
+}
+
+QList<double> QgsVectorLayer::generalizationScales() const
+{
+  return mGeneralization ? mGeneralization->scales() : QList<double>();
+}
+
+bool QgsVectorLayer::nextFeatureToDraw( QgsFeatureIterator& fit, QgsFeature& feature, QgsFeatureIds& missing )
+{
+  while ( fit.nextFeature( feature ) )
+  {
+    if ( mGeneralizationBand < 0 || mGeneralization->setGeometry( feature, mGeneralizationBand ) )
+      return true;
+
+    // not known when the generalization was built
+    missing.insert( feature.id() );
+  }
+
+  if ( missing.isEmpty() )
+    return false;
+
+  // fetch these with their full geometries once the other features are done, the
+  // providers do not allow a second iterator while the first one is still in use
+  QgsDebugMsg( QString( "%1 features are not generalized" ).arg( missing.count() ) );
+  fit = getFeatures( QgsFeatureRequest().setFilterFids( missing ) );
+  missing.clear();
+  mGeneralizationBand = -1;
+  return fit.nextFeature( feature );
+}
+
+void QgsVectorLayer::setScreenGeometryCacheEnabled( bool enabled )
+{
+  if ( enabled && !mScreenGeometryCache )
+  {
+    mScreenGeometryCache = new QgsScreenGeometryCache();
+  }
+  else if ( !enabled )
+  {
+    delete mScreenGeometryCache;
+    mScreenGeometryCache = 0;
+  }
 }
 
 bool QgsVectorLayer::draw( QgsRenderContext& rendererContext )
@@ -1007,9 +1091,26 @@ bool QgsVectorLayer::draw( QgsRenderContext& rendererContext )
     //register label and diagram layer to the labeling engine
     prepareLabelingAndDiagrams( rendererContext, attributes, labeling );
 
-    QgsFeatureIterator fit = getFeatures( QgsFeatureRequest()
-                                          .setFilterRect( rendererContext.extent() )
-                                          .setSubsetOfAttributes( attributes ) );
+    // at small scales the generalized geometries are drawn instead of the fetched ones
+    // features added or deleted by the provider since the generalization was built
+    // are not detected per feature, so the full geometries are drawn then
+    mGeneralizationBand = -1;
+    if ( mGeneralization && !mEditBuffer && !rendererContext.forceVectorOutput() &&
+         featureCount() == mGeneralization->featureCount() )
+      mGeneralizationBand = mGeneralization->bandForScale( rendererContext.rendererScale() );
+
+    QgsFeatureRequest request;
+    request.setFilterRect( rendererContext.extent() ).setSubsetOfAttributes( attributes );
+    if ( mGeneralizationBand >= 0 )
+      request.setFlags( QgsFeatureRequest::NoGeometry );
+    QgsFeatureIterator fit = getFeatures( request );
+
+    // the geometries of edited features may change, so the cache is only used without edits
+    if ( mScreenGeometryCache && !mEditBuffer )
+    {
+      mScreenGeometryCache->begin( rendererContext );
+      rendererContext.setScreenGeometryCache( mScreenGeometryCache );
+    }
 
     if (( mRendererV2->capabilities() & QgsFeatureRendererV2::SymbolLevels )
         && mRendererV2->usingSymbolLevels() )
@@ -1017,6 +1118,8 @@ bool QgsVectorLayer::draw( QgsRenderContext& rendererContext )
     else
       drawRendererV2( fit, rendererContext, labeling );
 
+    rendererContext.setScreenGeometryCache( NULL );
+
     return true;
   }
 
@@ -1073,7 +1176,11 @@ bool QgsVectorLayer::draw( QgsRenderContext& rendererContext )
         }
 
 #ifndef Q_WS_MAC //MH: disable this on Mac for now to avoid problems with resizing
-        if ( mUpdateThreshold > 0 && 0 == featureCount % mUpdateThreshold )
+        if ( rendererContext.isParallelJob() )
+        {
+          // layers drawn in worker threads do not touch the GUI
+        }
+        else if ( mUpdateThreshold > 0 && 0 == featureCount % mUpdateThreshold )
         {
           emit screenUpdateRequested();
           // emit drawingProgress( featureCount, totalFeatures );
@@ -1662,7 +1769,12 @@ bool QgsVectorLayer::setSubsetString( QString subset )
   updateExtents();
 
   if ( res )
+  {
     setCacheImage( 0 );
+    // providers may number the features of the subset differently
+    if ( mScreenGeometryCache )
+      mScreenGeometryCache->clear();
+  }
 
   return res;
 }
@@ -2226,6 +2338,10 @@ bool QgsVectorLayer::startEditing()
   }
 
   mEditBuffer = new QgsVectorLayerEditBuffer( this );
+
+  // the features may be changed from now on
+  if ( mScreenGeometryCache )
+    mScreenGeometryCache->clear();
   // forward signals
   connect( mEditBuffer, SIGNAL( layerModified() ), this, SIGNAL( layerModified() ) ); // TODO[MD]: necessary?
   //connect( mEditBuffer, SIGNAL( layerModified() ), this, SLOT( triggerRepaint() ) ); // TODO[MD]: works well?
@@ -2338,6 +2454,9 @@ bool QgsVectorLayer::setDataProvider( QString const & provider )
       // TODO: Check if the provider has the capability to send fullExtentCalculated
       connect( mDataProvider, SIGNAL( fullExtentCalculated() ), this, SLOT( updateExtents() ) );
 
+      // the generalized geometries were built from the old data
+      connect( mDataProvider, SIGNAL( dataChanged() ), this, SLOT( clearGeneralization() ) );
+
       // get the extent
       QgsRectangle mbr = mDataProvider->extent();
 
@@ -3304,6 +3423,10 @@ bool QgsVectorLayer::commitChanges()
     return false;
   }
 
+  // the generalized geometries do not match the changed features anymore
+  if ( mGeneralization && mEditBuffer->isModified() )
+    clearGeneralization();
+
   bool success = mEditBuffer->commitChanges( mCommitErrors );
 
   if ( success )
@@ -4260,6 +4383,8 @@ QVariant QgsVectorLayer::maximumValue( int index )
 
 void QgsVectorLayer::stopRendererV2( QgsRenderContext& rendererContext, QgsSingleSymbolRendererV2* selRenderer )
 {
+  // draw the rest of the batch before the symbols are stopped
+  mRendererV2->stopBatch();
   mRendererV2->stopRender( rendererContext );
   if ( selRenderer )
   {
@@ -53,6 +53,8 @@ class QgsDiagramRendererV2;
 class QgsDiagramLayerSettings;
 class QgsVectorLayerCache;
 class QgsVectorLayerEditBuffer;
+class QgsScreenGeometryCache;
+class QgsVectorLayerGeneralization;
 class QgsSymbolV2;
 
 typedef QList<int> QgsAttributeList;
@@ -875,6 +877,47 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
 
     inline QgsVectorLayerCache* cache() { return mCache; }
 
+    /** Build generalized copies of the geometries for drawing at the given scales
+     *  (scale denominators) and smaller ones, instead of fetching the full geometries.
+     *  Only lines and polygons are generalized. The generalization is dropped
+     *  when changes of the features are committed, the layer is reloaded or the
+     *  provider reports changed data. Features the generalization has no geometry
+     *  for are drawn with their full geometry, and the full geometries are drawn
+     *  while the number of features differs from the one it was built for.
+     *  @note added in 2.0 */
+    bool buildGeneralization( const QList<double>& scales );
+
+    /** Write the generalized geometries to a file, e.g. next to the data source
+     *  @note added in 2.0 */
+    bool saveGeneralization( const QString& fileName );
+
+    /** Read the generalized geometries written by saveGeneralization(). The file is
+     *  rejected if the features of the layer changed since it was written.
+     *  @note added in 2.0 */
+    bool loadGeneralization( const QString& fileName );
+
+    /** @note added in 2.0 */
+    void clearGeneralization();
+
+    /** Scales of the generalized geometries, empty if there are none
+     *  @note added in 2.0 */
+    QList<double> generalizationScales() const;
+
+    /** Keep the geometries of the features converted to screen coordinates between renderings,
+     *  so that they are not converted again while the map is panned at the same scale.
+     *  The cache is not used while the layer is edited. It is off by default and has to be
+     *  enabled for each layer, e.g. by plugins for large layers that are panned often.
+     *  @note added in 2.0 */
+    void setScreenGeometryCacheEnabled( bool enabled );
+
+    /** @note added in 2.0 */
+    bool screenGeometryCacheEnabled() const { return mScreenGeometryCache != 0; }
+
+    /** The screen geometry cache, NULL if it is not enabled
+     *  @note added in 2.0
+     *  @note not available in python bindings */
+    QgsScreenGeometryCache* screenGeometryCache() { return mScreenGeometryCache; }
+
   signals:
 
     /** This signal is emited when selection was changed */
@@ -973,6 +1016,11 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
     /** Stop version 2 renderer and selected renderer (if required) */
     void stopRendererV2( QgsRenderContext& rendererContext, QgsSingleSymbolRendererV2* selRenderer );
 
+    //! fetch the next feature to draw and set the geometry of the current generalization band.
+    //! Features the band has no geometry for, e.g. added by the provider, are collected in missing
+    //! and fetched with their full geometries at the end.
+    bool nextFeatureToDraw( QgsFeatureIterator& fit, QgsFeature& feature, QgsFeatureIds& missing );
+
     /** Assembles mUpdatedFields considering provider fields, joined fields and added fields
      @note added in 1.7 */
     void updateFields();
@@ -1099,6 +1147,15 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
     //! cache for some vector layer data - currently only geometries for faster editing
     QgsVectorLayerCache* mCache;
 
+    //! screen geometries of the features reused between renderings (can be NULL)
+    QgsScreenGeometryCache* mScreenGeometryCache;
+
+    //! generalized geometries for small scales (can be NULL)
+    QgsVectorLayerGeneralization* mGeneralization;
+
+    //! band of the generalization used by the current drawing, -1 for the full geometries
+    int mGeneralizationBand;
+
     //! stores information about uncommitted changes to layer
     QgsVectorLayerEditBuffer* mEditBuffer;
     friend class QgsVectorLayerEditBuffer;
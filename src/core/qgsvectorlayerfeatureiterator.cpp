@@ -14,6 +14,7 @@
  ***************************************************************************/
 #include "qgsvectorlayerfeatureiterator.h"
 
+#include "qgsexpression.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
@@ -26,6 +27,24 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayer* la
 
   QgsVectorLayerJoinBuffer* joinBuffer = L->mJoinBuffer;
 
+  // the attributes used by the filter expression have to be fetched too
+  bool filterOnProviderFields = true;
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    const QgsFields& fields = L->pendingFields();
+    QgsAttributeList subset = mRequest.subsetOfAttributes();
+    foreach ( const QString& column, mRequest.filterExpression()->referencedColumns() )
+    {
+      int idx = fields.indexFromName( column );
+      if ( idx < 0 || fields.fieldOrigin( idx ) != QgsFields::OriginProvider )
+        filterOnProviderFields = false;
+      if ( idx >= 0 && !subset.contains( idx ) )
+        subset << idx;
+    }
+    if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+      mRequest.setSubsetOfAttributes( subset );
+  }
+
   // prepare joins: may add more attributes to fetch (in order to allow join)
   if ( joinBuffer->containsJoins() )
     prepareJoins();
@@ -33,6 +52,21 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayer* la
   // by default provider's request is the same
   mProviderRequest = mRequest;
 
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    if ( !L->editBuffer() && filterOnProviderFields )
+    {
+      // let the provider evaluate the expression (possibly in the database),
+      // all the features come from the provider so there's no need to test them again
+      mFilterApplied = true;
+    }
+    else
+    {
+      // edited or joined attributes: the features have to be tested here
+      mProviderRequest.disableFilter();
+    }
+  }
+
   if ( mProviderRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
   {
     // prepare list of attributes to match provider fields
@@ -50,7 +84,7 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayer* la
   {
     mFetchedFid = false;
   }
-  else // no filter or filter by rect
+  else // no filter or filter by rect, feature ids or expression
   {
     mProviderIterator = L->dataProvider()->getFeatures( mProviderRequest );
 
@@ -0,0 +1,278 @@
+/***************************************************************************
+    qgsvectorlayergeneralization.cpp
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsvectorlayergeneralization.h"
+
+#include "qgsgeometry.h"
+#include "qgslogger.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cstring>
+
+// identifies the files written by save()
+static const quint32 GENERALIZATION_MAGIC = 0x51474c5a;
+static const quint32 GENERALIZATION_VERSION = 2;
+
+// FNV-1a hash of the bytes added to hash
+static void hashBytes( quint64& hash, const unsigned char* data, size_t size )
+{
+  for ( size_t i = 0; i < size; ++i )
+  {
+    hash ^= data[i];
+    hash *= Q_UINT64_C( 1099511628211 );
+  }
+}
+
+static void hashFeature( quint64& hash, QgsFeature& f )
+{
+  QgsFeatureId fid = f.id();
+  hashBytes( hash, ( const unsigned char* ) &fid, sizeof( fid ) );
+  if ( f.geometry() )
+    hashBytes( hash, f.geometry()->asWkb(), f.geometry()->wkbSize() );
+}
+
+// The file of a file based data source, false for other sources
+static bool sourceFile( QgsVectorLayer* layer, QFileInfo& info )
+{
+  if ( !layer->dataProvider() )
+    return false;
+
+  // OGR sources may name a layer after the file name
+  info = QFileInfo( layer->dataProvider()->dataSourceUri().split( "|" ).first() );
+  return info.isFile();
+}
+
+// Identifies the state of the features the bands are built from. File based sources are
+// identified by the modification time and the size of the file, the features of other
+// sources are hashed.
+static quint64 sourceStamp( QgsVectorLayer* layer )
+{
+  QFileInfo info;
+  if ( sourceFile( layer, info ) )
+    return (( quint64 ) info.lastModified().toTime_t() << 32 ) ^( quint64 ) info.size();
+
+  quint64 hash = Q_UINT64_C( 14695981039346656037 );
+  QgsFeatureIterator fit = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+    hashFeature( hash, f );
+  return hash;
+}
+
+QgsVectorLayerGeneralization::QgsVectorLayerGeneralization()
+    : mFeatureCount( -1 )
+    , mSourceStamp( 0 )
+{
+}
+
+bool QgsVectorLayerGeneralization::build( QgsVectorLayer* layer, const QList<double>& scales )
+{
+  clear();
+
+  if ( layer->geometryType() != QGis::Line && layer->geometryType() != QGis::Polygon )
+    return false;
+
+  double metersPerUnit = 1.0;
+  switch ( layer->crs().mapUnits() )
+  {
+    case QGis::Feet:
+      metersPerUnit = 0.3048;
+      break;
+    case QGis::Degrees:
+      metersPerUnit = 111319.49; // at the equator
+      break;
+    default:
+      break;
+  }
+
+  QList<double> sortedScales = scales;
+  qSort( sortedScales );
+  foreach ( double scale, sortedScales )
+  {
+    if ( scale <= 0 || ( !mBands.isEmpty() && mBands.last().scale == scale ) )
+      continue;
+
+    Band band;
+    band.scale = scale;
+    // half a pixel at 96 dpi
+    band.tolerance = scale * 0.0254 / 96 / 2 / metersPerUnit;
+    mBands.append( band );
+  }
+
+  if ( mBands.isEmpty() )
+    return false;
+
+  // the features of sources without a file are hashed while they are read
+  QFileInfo info;
+  bool hashFeatures = !sourceFile( layer, info );
+  quint64 hash = Q_UINT64_C( 14695981039346656037 );
+
+  QgsFeatureIterator fit = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    if ( hashFeatures )
+      hashFeature( hash, f );
+
+    if ( !f.geometry() )
+      continue;
+
+    // each band is simplified from the previous one, which has less vertices
+    QgsGeometry previous( *f.geometry() );
+    for ( int i = 0; i < mBands.count(); ++i )
+    {
+      QgsGeometry* simplified = previous.simplify( mBands[i].tolerance );
+      // small features would disappear, they keep the previous geometry
+      if ( simplified && !simplified->isGeosEmpty() )
+        previous = *simplified;
+      delete simplified;
+
+      // kept as WKB, which is handed to the drawn features without converting it
+      mBands[i].geometries.insert( f.id(), QByteArray(( const char* ) previous.asWkb(), previous.wkbSize() ) );
+    }
+  }
+
+  mFeatureCount = layer->featureCount();
+  mSourceStamp = hashFeatures ? hash : sourceStamp( layer );
+  QgsDebugMsg( QString( "generalized %1 features in %2 bands" ).arg( mBands[0].geometries.count() ).arg( mBands.count() ) );
+  return true;
+}
+
+bool QgsVectorLayerGeneralization::save( const QString& fileName ) const
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( "cannot write " + fileName );
+    return false;
+  }
+
+  QDataStream out( &file );
+  out << GENERALIZATION_MAGIC << GENERALIZATION_VERSION;
+  out << ( qint64 ) mFeatureCount << mSourceStamp << ( quint32 ) mBands.count();
+  foreach ( const Band& band, mBands )
+  {
+    out << band.scale << band.tolerance << ( quint32 ) band.geometries.count();
+    QHash<QgsFeatureId, QByteArray>::const_iterator it = band.geometries.constBegin();
+    for ( ; it != band.geometries.constEnd(); ++it )
+    {
+      out << ( qint64 ) it.key();
+      out.writeBytes( it.value().constData(), it.value().size() );
+    }
+  }
+
+  return out.status() == QDataStream::Ok;
+}
+
+bool QgsVectorLayerGeneralization::load( const QString& fileName, QgsVectorLayer* layer )
+{
+  clear();
+
+  QFile file( fileName );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream in( &file );
+  quint32 magic, version, bandCount;
+  qint64 featureCount;
+  quint64 stamp;
+  in >> magic >> version;
+  if ( magic != GENERALIZATION_MAGIC || version != GENERALIZATION_VERSION )
+  {
+    QgsDebugMsg( fileName + " is not a generalization file" );
+    return false;
+  }
+  in >> featureCount >> stamp >> bandCount;
+  if ( featureCount != layer->featureCount() || stamp != sourceStamp( layer ) )
+  {
+    QgsDebugMsg( fileName + " was written for other features" );
+    return false;
+  }
+
+  for ( quint32 i = 0; i < bandCount && in.status() == QDataStream::Ok; ++i )
+  {
+    Band band;
+    quint32 count;
+    in >> band.scale >> band.tolerance >> count;
+    for ( quint32 j = 0; j < count && in.status() == QDataStream::Ok; ++j )
+    {
+      qint64 fid;
+      char* wkb;
+      uint length;
+      in >> fid;
+      in.readBytes( wkb, length );
+      if ( !wkb )
+        continue;
+
+      band.geometries.insert( fid, QByteArray( wkb, length ) );
+      delete [] wkb;
+    }
+    mBands.append( band );
+  }
+
+  if ( in.status() != QDataStream::Ok )
+  {
+    QgsDebugMsg( "cannot read " + fileName );
+    clear();
+    return false;
+  }
+
+  mFeatureCount = featureCount;
+  mSourceStamp = stamp;
+  return true;
+}
+
+void QgsVectorLayerGeneralization::clear()
+{
+  mBands.clear();
+  mFeatureCount = -1;
+  mSourceStamp = 0;
+}
+
+QList<double> QgsVectorLayerGeneralization::scales() const
+{
+  QList<double> scales;
+  foreach ( const Band& band, mBands )
+    scales << band.scale;
+  return scales;
+}
+
+int QgsVectorLayerGeneralization::bandForScale( double scale ) const
+{
+  // the most generalized band that is not coarser than half a pixel at the scale
+  int band = -1;
+  while ( band + 1 < mBands.count() && mBands[band + 1].scale <= scale )
+    band++;
+  return band;
+}
+
+bool QgsVectorLayerGeneralization::setGeometry( QgsFeature& feature, int band ) const
+{
+  QHash<QgsFeatureId, QByteArray>::const_iterator it = mBands[band].geometries.constFind( feature.id() );
+  if ( it == mBands[band].geometries.constEnd() )
+    return false;
+
+  // the geometry takes the ownership of a buffer allocated with new[]
+  const QByteArray& wkb = it.value();
+  unsigned char* buffer = new unsigned char[wkb.size()];
+  memcpy( buffer, wkb.constData(), wkb.size() );
+  feature.setGeometryAndOwnership( buffer, wkb.size() );
+  return true;
+}
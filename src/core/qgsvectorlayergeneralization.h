@@ -0,0 +1,88 @@
+/***************************************************************************
+    qgsvectorlayergeneralization.h
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSVECTORLAYERGENERALIZATION_H
+#define QGSVECTORLAYERGENERALIZATION_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "qgsfeature.h"
+
+class QgsVectorLayer;
+
+/** \ingroup core
+ * Generalized copies of the geometries of a vector layer for a set of scales.
+ * A band built for a scale is drawn at that scale and at all smaller scales
+ * (larger scale denominators) up to the next band, so that zoomed out views
+ * neither fetch nor draw the full resolution geometries.
+ * The geometries are simplified with Douglas-Peucker (QgsGeometry::simplify)
+ * with a tolerance of half a pixel at 96 dpi at the scale of the band.
+ * @note added in 2.0
+ * @note not available in python bindings
+ */
+class CORE_EXPORT QgsVectorLayerGeneralization
+{
+  public:
+    QgsVectorLayerGeneralization();
+
+    //! simplify the geometries of all features of the layer for the scales (denominators).
+    //! Points are not generalized: returns false for point layers.
+    bool build( QgsVectorLayer* layer, const QList<double>& scales );
+
+    //! store the bands in a file, so that they do not need to be built again
+    bool save( const QString& fileName ) const;
+
+    //! read the bands from a file written by save(), false if the file was written for other
+    //! features. File based sources are compared by the modification time and size of the file,
+    //! the features of other sources are read to compare them.
+    bool load( const QString& fileName, QgsVectorLayer* layer );
+
+    void clear();
+
+    bool isEmpty() const { return mBands.isEmpty(); }
+
+    //! scale denominators of the bands, in ascending order
+    QList<double> scales() const;
+
+    //! index of the band to draw at the scale, -1 if the full geometries should be drawn
+    int bandForScale( double scale ) const;
+
+    //! number of features of the layer the bands were built for
+    long featureCount() const { return mFeatureCount; }
+
+    //! set the generalized geometry of the band to the feature, false if the band has no geometry for it
+    bool setGeometry( QgsFeature& feature, int band ) const;
+
+  private:
+    struct Band
+    {
+      double scale;
+      double tolerance;  // in layer units
+      QHash<QgsFeatureId, QByteArray> geometries;  // WKB
+    };
+
+    //! bands in ascending order of the scale
+    QList<Band> mBands;
+
+    //! number of features of the layer the bands were built for
+    long mFeatureCount;
+
+    //! modification time and size of the source file, or hash of the features
+    quint64 mSourceStamp;
+};
+
+#endif // QGSVECTORLAYERGENERALIZATION_H
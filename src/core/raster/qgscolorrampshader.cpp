@@ -23,13 +23,16 @@ originally part of the larger QgsRasterLayer class
 
 #include "qgscolorrampshader.h"
 
+#include <QtAlgorithms>
+
 #include <cmath>
 
 QgsColorRampShader::QgsColorRampShader( double theMinimumValue, double theMaximumValue ) : QgsRasterShaderFunction( theMinimumValue, theMaximumValue )
 {
   QgsDebugMsg( "called." );
   mMaximumColorCacheSize = 1024; //good starting value
-  mCurrentColorRampItemIndex = 0;
+  mColorRampType = INTERPOLATED;
+  mClip = false;
 }
 
 QString QgsColorRampShader::colorRampTypeAsQString()
@@ -49,188 +52,114 @@ QString QgsColorRampShader::colorRampTypeAsQString()
   return QString( "Unknown" );
 }
 
-bool QgsColorRampShader::discreteColor( double theValue, int* theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue )
+int QgsColorRampShader::itemIndex( double theValue ) const
 {
-  int myColorRampItemCount = mColorRampItemList.count();
-  if ( myColorRampItemCount <= 0 )
-  {
-    return false;
-  }
+  // first item which is not below the value, values closer than the threshold match
+  return qLowerBound( mRampValues, theValue - DOUBLE_DIFF_THRESHOLD ) - mRampValues.constBegin();
+}
 
-  double myTinyDiff = 0.0;
-  QgsColorRampShader::ColorRampItem myColorRampItem;
-  while ( mCurrentColorRampItemIndex >= 0 && mCurrentColorRampItemIndex < myColorRampItemCount )
+bool QgsColorRampShader::discreteColor( double theValue, int* theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue ) const
+{
+  int myIndex = itemIndex( theValue );
+  if ( myIndex >= mRampValues.size() )
   {
-    //Start searching from the last index - assumtion is that neighboring pixels tend to be similar values
-    myColorRampItem = mColorRampItemList.value( mCurrentColorRampItemIndex );
-    myTinyDiff = qAbs( theValue - myColorRampItem.value );
-    //If the previous entry is less, then search closer to the top of the list (assumes mColorRampItemList is sorted)
-    if ( mCurrentColorRampItemIndex != 0 &&
-         theValue <= mColorRampItemList.at( mCurrentColorRampItemIndex - 1 ).value )
-    {
-      mCurrentColorRampItemIndex--;
-    }
-    else if ( theValue <= myColorRampItem.value || myTinyDiff <= DOUBLE_DIFF_THRESHOLD )
-    {
-      *theReturnRedValue = myColorRampItem.color.red();
-      *theReturnGreenValue = myColorRampItem.color.green();
-      *theReturnBlueValue = myColorRampItem.color.blue();
-      //Cache the shaded value
-      if ( mMaximumColorCacheSize >= mColorCache.size() )
-      {
-        mColorCache.insert( theValue, myColorRampItem.color );
-      }
-      return true;
-    }
-    //Search deeper into the color ramp list
-    else
-    {
-      mCurrentColorRampItemIndex++;
-    }
+    return false; // value not found
   }
 
-  return false; // value not found
+  QRgb myColor = mRampColors[myIndex];
+  *theReturnRedValue = qRed( myColor );
+  *theReturnGreenValue = qGreen( myColor );
+  *theReturnBlueValue = qBlue( myColor );
+  return true;
 }
 
-bool QgsColorRampShader::exactColor( double theValue, int* theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue )
+bool QgsColorRampShader::exactColor( double theValue, int* theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue ) const
 {
-  int myColorRampItemCount = mColorRampItemList.count();
-  if ( myColorRampItemCount <= 0 )
+  int myIndex = itemIndex( theValue );
+  //pixel value sits between ramp entries or beyond the last one
+  if ( myIndex >= mRampValues.size() || qAbs( theValue - mRampValues[myIndex] ) > DOUBLE_DIFF_THRESHOLD )
   {
     return false;
   }
 
-  double myTinyDiff = 0.0;
-  QgsColorRampShader::ColorRampItem myColorRampItem;
-  while ( mCurrentColorRampItemIndex >= 0 && mCurrentColorRampItemIndex < myColorRampItemCount )
-  {
-    //Start searching from the last index - assumtion is that neighboring pixels tend to be similar values
-    myColorRampItem = mColorRampItemList.value( mCurrentColorRampItemIndex );
-    myTinyDiff = qAbs( theValue - myColorRampItem.value );
-    if ( theValue == myColorRampItem.value || myTinyDiff <= DOUBLE_DIFF_THRESHOLD )
-    {
-      *theReturnRedValue = myColorRampItem.color.red();
-      *theReturnGreenValue = myColorRampItem.color.green();
-      *theReturnBlueValue = myColorRampItem.color.blue();
-      //Cache the shaded value
-      if ( mMaximumColorCacheSize >= mColorCache.size() )
-      {
-        mColorCache.insert( theValue, myColorRampItem.color );
-      }
-      return true;
-    }
-    //pixel value sits between ramp entries so bail
-    else if ( mCurrentColorRampItemIndex != myColorRampItemCount - 1 &&
-              theValue > myColorRampItem.value && theValue < mColorRampItemList.at(
-                mCurrentColorRampItemIndex + 1 ).value )
-    {
-      return false;
-    }
-    //Search deeper into the color ramp list
-    else if ( theValue > myColorRampItem.value )
-    {
-      mCurrentColorRampItemIndex++;
-    }
-    //Search back toward the beginning of the list
-    else
-    {
-      mCurrentColorRampItemIndex--;
-    }
-  }
-
-  return false; // value not found
+  QRgb myColor = mRampColors[myIndex];
+  *theReturnRedValue = qRed( myColor );
+  *theReturnGreenValue = qGreen( myColor );
+  *theReturnBlueValue = qBlue( myColor );
+  return true;
 }
 
 bool QgsColorRampShader::interpolatedColor( double theValue, int*
-    theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue )
+    theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue ) const
 {
-  int myColorRampItemCount = mColorRampItemList.count();
+  int myColorRampItemCount = mRampValues.size();
   if ( myColorRampItemCount <= 0 )
   {
     return false;
   }
 
-  double myTinyDiff = 0.0;
-  double myCurrentRampRange; //difference between two consecutive entry values
-  double myOffsetInRange; //difference between the previous entry value and value
-  QgsColorRampShader::ColorRampItem myColorRampItem;
-  while ( mCurrentColorRampItemIndex >= 0 && mCurrentColorRampItemIndex < myColorRampItemCount )
+  int myIndex = itemIndex( theValue );
+  QRgb myColor;
+  // Values outside total range are rendered if mClip is false
+  if ( myIndex >= myColorRampItemCount )
   {
-    //Start searching from the last index - assumtion is that neighboring pixels tend to be similar values
-    myColorRampItem = mColorRampItemList.value( mCurrentColorRampItemIndex );
-    myTinyDiff = qAbs( theValue - myColorRampItem.value );
-    //If the previous entry is less, then search closer to the top of the list (assumes mColorRampItemList is sorted)
-    if ( mCurrentColorRampItemIndex != 0 && theValue <= mColorRampItemList.at( mCurrentColorRampItemIndex - 1 ).value )
+    if ( mClip )
     {
-      mCurrentColorRampItemIndex--;
-    }
-    else if ( mCurrentColorRampItemIndex != 0 && ( theValue <= myColorRampItem.value || myTinyDiff <= DOUBLE_DIFF_THRESHOLD ) )
-    {
-      QgsColorRampShader::ColorRampItem myPreviousColorRampItem = mColorRampItemList.value( mCurrentColorRampItemIndex - 1 );
-      myCurrentRampRange = myColorRampItem.value - myPreviousColorRampItem.value;
-      myOffsetInRange = theValue - myPreviousColorRampItem.value;
-      double scale = myOffsetInRange / myCurrentRampRange;
-
-      *theReturnRedValue = ( int )(( double ) myPreviousColorRampItem.color.red() + (( double )( myColorRampItem.color.red() - myPreviousColorRampItem.color.red() ) * scale ) ) ;
-      *theReturnGreenValue = ( int )(( double ) myPreviousColorRampItem.color.green() + (( double )( myColorRampItem.color.green() - myPreviousColorRampItem.color.green() ) * scale ) );
-      *theReturnBlueValue = ( int )(( double ) myPreviousColorRampItem.color.blue() + (( double )( myColorRampItem.color.blue() - myPreviousColorRampItem.color.blue() ) * scale ) );
-      if ( mMaximumColorCacheSize >= mColorCache.size() )
-      {
-        QColor myNewColor( *theReturnRedValue, *theReturnGreenValue, *theReturnBlueValue );
-        mColorCache.insert( theValue, myNewColor );
-      }
-      return true;
-    }
-    // Values outside total range are rendered if mClip is false
-    else if (( mCurrentColorRampItemIndex == 0 && ( myTinyDiff <= DOUBLE_DIFF_THRESHOLD || ( !mClip && theValue <= myColorRampItem.value ) ) )
-             || ( mCurrentColorRampItemIndex == myColorRampItemCount - 1 && ( myTinyDiff <= DOUBLE_DIFF_THRESHOLD || ( !mClip && theValue >= myColorRampItem.value ) ) ) )
-    {
-      //QgsColorRampShader::ColorRampItem myPreviousColorRampItem = mColorRampItemList.value( mCurrentColorRampItemIndex - 1 );
-      //myCurrentRampRange = myColorRampItem.value - myPreviousColorRampItem.value;
-      //myOffsetInRange = theValue - myPreviousColorRampItem.value;
-
-      *theReturnRedValue = myColorRampItem.color.red();
-      *theReturnGreenValue = myColorRampItem.color.green();
-      *theReturnBlueValue = myColorRampItem.color.blue();
-      if ( mMaximumColorCacheSize >= mColorCache.size() )
-      {
-        QColor myNewColor( *theReturnRedValue, *theReturnGreenValue, *theReturnBlueValue );
-        mColorCache.insert( theValue, myNewColor );
-      }
-      return true;
-    }
-    //Search deeper into the color ramp list
-    else if ( theValue > myColorRampItem.value )
-    {
-      mCurrentColorRampItemIndex++;
+      return false;
     }
-    else
+    myColor = mRampColors[myColorRampItemCount - 1];
+  }
+  else if ( myIndex == 0 )
+  {
+    if ( mClip && qAbs( theValue - mRampValues[0] ) > DOUBLE_DIFF_THRESHOLD )
     {
       return false;
     }
+    myColor = mRampColors[0];
   }
+  else
+  {
+    QRgb myPreviousColor = mRampColors[myIndex - 1];
+    myColor = mRampColors[myIndex];
+    double myCurrentRampRange = mRampValues[myIndex] - mRampValues[myIndex - 1];
+    double myOffsetInRange = theValue - mRampValues[myIndex - 1];
+    double scale = myOffsetInRange / myCurrentRampRange;
 
-  return false;
+    *theReturnRedValue = ( int )(( double ) qRed( myPreviousColor ) + (( double )( qRed( myColor ) - qRed( myPreviousColor ) ) * scale ) );
+    *theReturnGreenValue = ( int )(( double ) qGreen( myPreviousColor ) + (( double )( qGreen( myColor ) - qGreen( myPreviousColor ) ) * scale ) );
+    *theReturnBlueValue = ( int )(( double ) qBlue( myPreviousColor ) + (( double )( qBlue( myColor ) - qBlue( myPreviousColor ) ) * scale ) );
+    return true;
+  }
+
+  *theReturnRedValue = qRed( myColor );
+  *theReturnGreenValue = qGreen( myColor );
+  *theReturnBlueValue = qBlue( myColor );
+  return true;
 }
 
 void QgsColorRampShader::setColorRampItemList( const QList<QgsColorRampShader::ColorRampItem>& theList )
 {
   mColorRampItemList = theList;
-  //Clear the cache
-  mColorCache.clear();
+
+  //The lookup searches sorted values, the list itself keeps the order of the legend
+  QList<QgsColorRampShader::ColorRampItem> mySortedList = theList;
+  qStableSort( mySortedList );
+  mRampValues.resize( mySortedList.size() );
+  mRampColors.resize( mySortedList.size() );
+  for ( int i = 0; i < mySortedList.size(); ++i )
+  {
+    mRampValues[i] = mySortedList[i].value;
+    mRampColors[i] = mySortedList[i].color.rgb();
+  }
 }
 
 void QgsColorRampShader::setColorRampType( QgsColorRampShader::ColorRamp_TYPE theColorRampType )
 {
-  //When the ramp type changes we need to clear out the cache
-  mColorCache.clear();
   mColorRampType = theColorRampType;
 }
 
 void QgsColorRampShader::setColorRampType( QString theType )
 {
-  //When the type of the ramp changes we need to clear out the cache
-  mColorCache.clear();
   if ( theType == "INTERPOLATED" )
   {
     mColorRampType = INTERPOLATED;
@@ -247,29 +176,7 @@ void QgsColorRampShader::setColorRampType( QString theType )
 
 bool QgsColorRampShader::shade( double theValue, int* theReturnRedValue, int* theReturnGreenValue, int* theReturnBlueValue )
 {
-
-  //Get the shaded value from the cache if it exists already
-  QColor myColor = mColorCache.value( theValue );
-  if ( myColor.isValid() )
-  {
-    *theReturnRedValue = myColor.red();
-    *theReturnGreenValue = myColor.green();
-    *theReturnBlueValue = myColor.blue();
-    return true;
-  }
-
-  //pixel value not in cache so generate new value
-
-  //Check to be sure mCurrentColorRampItemIndex is within the valid range.
-  if ( mCurrentColorRampItemIndex < 0 )
-  {
-    mCurrentColorRampItemIndex = 0;
-  }
-  else if ( mCurrentColorRampItemIndex >= mColorRampItemList.size() )
-  {
-    mCurrentColorRampItemIndex = mColorRampItemList.size() - 1;
-  }
-
+  //The lookup does not modify the shader, so blocks may be shaded concurrently
   if ( QgsColorRampShader::EXACT == mColorRampType )
   {
     return exactColor( theValue, theReturnRedValue, theReturnGreenValue, theReturnBlueValue );
@@ -22,7 +22,7 @@ originally part of the larger QgsRasterLayer class
 #define QGSCOLORRAMPSHADER_H
 
 #include <QColor>
-#include <QMap>
+#include <QVector>
 
 #include "qgsrastershaderfunction.h"
 
@@ -70,11 +70,12 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
     /** \brief Get the color ramp type as a string */
     QString colorRampTypeAsQString();
 
-    /** \brief Get the maximum size the color cache can be*/
+    /** \brief Get the maximum size the color cache can be
+     * @note colors are not cached any more, the value is kept for compatibility */
     int maximumColorCacheSize() { return mMaximumColorCacheSize; }
 
     /** \brief Set custom colormap */
-    void setColorRampItemList( const QList<QgsColorRampShader::ColorRampItem>& theList ); //TODO: sort on set
+    void setColorRampItemList( const QList<QgsColorRampShader::ColorRampItem>& theList );
 
     /** \brief Set the color ramp type*/
     void setColorRampType( QgsColorRampShader::ColorRamp_TYPE theColorRampType );
@@ -97,9 +98,6 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
     bool clip() const { return mClip; }
 
   private:
-    /** Current index from which to start searching the color table*/
-    int mCurrentColorRampItemIndex;
-
     //TODO: Consider pulling this out as a separate class and internally storing as a QMap rather than a QList
     /** This vector holds the information for classification based on values.
      * Each item holds a value, a label and a color. The member
@@ -111,27 +109,34 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
     /** \brief The color ramp type */
     QgsColorRampShader::ColorRamp_TYPE mColorRampType;
 
-    /** \brief Cache of values that have already been looked up */
-    QMap<double, QColor> mColorCache;
+    /** Values of the color ramp items in ascending order, searched by shade() */
+    QVector<double> mRampValues;
+
+    /** Colors of the items in mRampValues */
+    QVector<QRgb> mRampColors;
 
-    /** Maximum size of the color cache. The color cache could eat a ton of
-     * memory if you have 32-bit data */
+    /** Not used any more, see maximumColorCacheSize() */
     int mMaximumColorCacheSize;
 
+    /** Index of the first item in mRampValues which is not below the value
+     * (values closer than a small threshold match), the item count if the
+     * value is above the last item */
+    int itemIndex( double theValue ) const;
+
     /** Gets the color for a pixel value from the classification vector
      * mValueClassification. Assigns the color of the lower class for every
      * pixel between two class breaks.*/
-    bool discreteColor( double, int*, int*, int* );
+    bool discreteColor( double, int*, int*, int* ) const;
 
     /** Gets the color for a pixel value from the classification vector
      * mValueClassification. Assigns the color of the exact matching value in
      * the color ramp item list */
-    bool exactColor( double, int*, int*, int* );
+    bool exactColor( double, int*, int*, int* ) const;
 
     /** Gets the color for a pixel value from the classification vector
      * mValueClassification. Interpolates the color between two class breaks
      * linearly.*/
-    bool interpolatedColor( double, int*, int*, int* );
+    bool interpolatedColor( double, int*, int*, int* ) const;
 
     /** Do not render values out of range */
     bool mClip;
@@ -31,6 +31,8 @@ class originally created circa 2004 by T.Sutton, Gary E.Sherman, Steve Halasz
 QgsContrastEnhancement::QgsContrastEnhancement( QgsRasterDataType theDataType )
 {
   mLookupTable = 0;
+  mDisplayLookupTable = 0;
+  mDisplayLookupTableDirty = true;
   mContrastEnhancementFunction = 0;
   mEnhancementDirty = false;
   mContrastEnhancementAlgorithm = NoEnhancement;
@@ -55,6 +57,8 @@ QgsContrastEnhancement::QgsContrastEnhancement( QgsRasterDataType theDataType )
 QgsContrastEnhancement::QgsContrastEnhancement( const QgsContrastEnhancement& ce )
 {
   mLookupTable = 0;
+  mDisplayLookupTable = 0;
+  mDisplayLookupTableDirty = true;
   mContrastEnhancementFunction = 0;
   mEnhancementDirty = true;
   mRasterDataType = ce.mRasterDataType;
@@ -77,6 +81,8 @@ QgsContrastEnhancement::QgsContrastEnhancement( const QgsContrastEnhancement& ce
 
 QgsContrastEnhancement::~QgsContrastEnhancement()
 {
+  delete [] mLookupTable;
+  delete [] mDisplayLookupTable;
 }
 /*
  *
@@ -241,6 +247,38 @@ bool QgsContrastEnhancement::generateLookupTable()
   return true;
 }
 
+/**
+    Return the lookup table used to render whole blocks of 8 and 16 bit data, which
+    combines isValueInDisplayableRange() and enhanceContrast().
+*/
+const int* QgsContrastEnhancement::displayLookupTable()
+{
+  if ( QGS_Byte != mRasterDataType && QGS_UInt16 != mRasterDataType && QGS_Int16 != mRasterDataType )
+    return 0;
+  if ( !mContrastEnhancementFunction )
+    return 0;
+
+  if ( !mDisplayLookupTable )
+  {
+    mDisplayLookupTable = new int[static_cast <int>( mRasterDataTypeRange+1 )];
+    mDisplayLookupTableDirty = true;
+  }
+
+  if ( mDisplayLookupTableDirty )
+  {
+    double myOffset = minimumValuePossible( mRasterDataType );
+    for ( int myIterator = 0; myIterator <= mRasterDataTypeRange; myIterator++ )
+    {
+      double myValue = myIterator + myOffset;
+      mDisplayLookupTable[myIterator] = mContrastEnhancementFunction->isValueInDisplayableRange( myValue ) ?
+                                        mContrastEnhancementFunction->enhance( myValue ) : -1;
+    }
+    mDisplayLookupTableDirty = false;
+  }
+
+  return mDisplayLookupTable;
+}
+
 /**
     Determine if a pixel is within in the displayable range.
 
@@ -289,6 +327,7 @@ void QgsContrastEnhancement::setContrastEnhancementAlgorithm( ContrastEnhancemen
     }
 
     mEnhancementDirty = true;
+    mDisplayLookupTableDirty = true;
     mContrastEnhancementAlgorithm = theAlgorithm;
 
     if ( generateTable )
@@ -311,6 +350,7 @@ void QgsContrastEnhancement::setContrastEnhancementFunction( QgsContrastEnhancem
   {
     mContrastEnhancementFunction = theFunction;
     mContrastEnhancementAlgorithm = UserDefinedEnhancement;
+    mDisplayLookupTableDirty = true;
     generateLookupTable();
   }
 }
@@ -340,6 +380,7 @@ void QgsContrastEnhancement::setMaximumValue( double theValue, bool generateTabl
   }
 
   mEnhancementDirty = true;
+  mDisplayLookupTableDirty = true;
 
   if ( generateTable )
   {
@@ -372,6 +413,7 @@ void QgsContrastEnhancement::setMinimumValue( double theValue, bool generateTabl
   }
 
   mEnhancementDirty = true;
+  mDisplayLookupTableDirty = true;
 
   if ( generateTable )
   {
@@ -402,6 +444,7 @@ void QgsContrastEnhancement::writeXML( QDomDocument& doc, QDomElement& parentEle
 
 void QgsContrastEnhancement::readXML( const QDomElement& elem )
 {
+  mDisplayLookupTableDirty = true;
   QDomElement minValueElem = elem.firstChildElement( "minValue" );
   if ( !minValueElem.isNull() )
   {
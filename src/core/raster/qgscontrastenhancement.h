@@ -100,6 +100,10 @@ class CORE_EXPORT QgsContrastEnhancement
 
     ContrastEnhancementAlgorithm contrastEnhancementAlgorithm() const { return mContrastEnhancementAlgorithm; }
 
+    /** \brief Return the data type of the band
+     * @note added in 2.0 */
+    QgsRasterDataType rasterDataType() const { return mRasterDataType; }
+
     static ContrastEnhancementAlgorithm contrastEnhancementAlgorithmFromString( const QString& contrastEnhancementString );
 
     /*
@@ -113,6 +117,12 @@ class CORE_EXPORT QgsContrastEnhancement
     /** \brief Return true if pixel is in stretable range, false if pixel is outside of range (i.e., clipped) */
     bool isValueInDisplayableRange( double );
 
+    /** \brief Return the enhanced values of all values of an 8 or 16 bit band, indexed by the value minus
+     * minimumValuePossible(). Values outside of the displayable range are -1. Returns 0 for other data types.
+     * @note added in 2.0
+     * @note not available in python bindings */
+    const int* displayLookupTable();
+
     /** \brief Set the contrast enhancement algorithm */
     void setContrastEnhancementAlgorithm( ContrastEnhancementAlgorithm, bool generateTable = true );
 
@@ -145,6 +155,12 @@ class CORE_EXPORT QgsContrastEnhancement
     /** \brief Pointer to the lookup table */
     int *mLookupTable;
 
+    /** \brief Lookup table of enhanced values including the displayable range, see displayLookupTable() */
+    int *mDisplayLookupTable;
+
+    /** \brief Flag indicating if the display lookup table needs to be regenerated */
+    bool mDisplayLookupTableDirty;
+
     /** \brief User defineable minimum value for the band, used for enhanceContrasting */
     double mMinimumValue;
 
@@ -23,6 +23,7 @@
 #include <QDomElement>
 #include <QImage>
 #include <QSet>
+#include <QVector>
 
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface* input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement* redEnhancement,
@@ -132,11 +133,6 @@ QgsRasterBlock* QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
     return outputBlock;
   }
 
-  //In some (common) cases, we can simplify the drawing loop considerably and save render time
-  bool fastDraw = ( !usesTransparency()
-                    && mRedBand > 0 && mGreenBand > 0 && mBlueBand > 0
-                    && mAlphaBand < 1 && !mRedContrastEnhancement && !mGreenContrastEnhancement && !mBlueContrastEnhancement );
-
   QSet<int> bands;
   if ( mRedBand > 0 )
   {
@@ -183,11 +179,7 @@ QgsRasterBlock* QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
     {
       // We should free the alloced mem from block().
       QgsDebugMsg( "No input band" );
-      bandIt--;
-      for ( ; bandIt != bands.constBegin(); bandIt-- )
-      {
-        delete bandBlocks[*bandIt];
-      }
+      qDeleteAll( bandBlocks );
       return outputBlock;
     }
   }
@@ -211,108 +203,84 @@ QgsRasterBlock* QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
 
   if ( !outputBlock->reset( QGis::ARGB32_Premultiplied, width, height ) )
   {
-    for ( int i = 0; i < bandBlocks.size(); i++ )
-    {
-      delete bandBlocks.value( i );
-    }
+    qDeleteAll( bandBlocks );
     return outputBlock;
   }
 
   QRgb myDefaultColor = NODATA_COLOR;
-
-  for ( size_t i = 0; i < ( size_t )width*height; i++ )
+  bool opaque = !usesTransparency();
+  QRgb* outputColors = ( QRgb* )outputBlock->bits(( size_t )0 );
+
+  // components of bands which are not set stay 0
+  QVector<int> redValues( width, 0 );
+  QVector<int> greenValues( width, 0 );
+  QVector<int> blueValues( width, 0 );
+  const int* redRow = redValues.constData();
+  const int* greenRow = greenValues.constData();
+  const int* blueRow = blueValues.constData();
+
+  for ( int row = 0; row < height; row++ )
   {
-    if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
+    size_t rowStart = ( size_t )row * width;
+    if ( redBlock )
     {
-      int redVal = ( int )redBlock->value( i );
-      int greenVal = ( int )greenBlock->value( i );
-      int blueVal = ( int )blueBlock->value( i );
-      if ( redBlock->isNoDataValue( redVal ) ||
-           greenBlock->isNoDataValue( greenVal ) ||
-           blueBlock->isNoDataValue( blueVal ) )
-      {
-        outputBlock->setColor( i, myDefaultColor );
-      }
-      else
-      {
-        outputBlock->setColor( i, qRgba( redVal, greenVal, blueVal, 255 ) );
-      }
-      continue;
+      displayValues( redBlock, mRedContrastEnhancement, rowStart, width, redValues.data() );
     }
-
-    bool isNoData = false;
-    double redVal = 0;
-    double greenVal = 0;
-    double blueVal = 0;
-    if ( mRedBand > 0 )
-    {
-      redVal = redBlock->value( i );
-      if ( redBlock->isNoDataValue( redVal ) ) isNoData = true;
-    }
-    if ( !isNoData && mGreenBand > 0 )
+    if ( greenBlock )
     {
-      greenVal = greenBlock->value( i );
-      if ( greenBlock->isNoDataValue( greenVal ) ) isNoData = true;
+      displayValues( greenBlock, mGreenContrastEnhancement, rowStart, width, greenValues.data() );
     }
-    if ( !isNoData && mBlueBand > 0 )
+    if ( blueBlock )
     {
-      blueVal = ( int )blueBlock->value( i );
-      if ( blueBlock->isNoDataValue( blueVal ) ) isNoData = true;
-    }
-    if ( isNoData )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
+      displayValues( blueBlock, mBlueContrastEnhancement, rowStart, width, blueValues.data() );
     }
+    QRgb* colorRow = outputColors + rowStart;
 
-    //apply default color if red, green or blue not in displayable range
-    if (( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
-        || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
-        || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
+    if ( opaque )
     {
-      outputBlock->setColor( i, myDefaultColor );
+      for ( int col = 0; col < width; col++ )
+      {
+        // no data and values not in the displayable range are negative
+        colorRow[col] = ( redRow[col] | greenRow[col] | blueRow[col] ) < 0 ? myDefaultColor :
+                        qRgba( redRow[col], greenRow[col], blueRow[col], 255 );
+      }
       continue;
     }
 
-    //stretch color values
-    if ( mRedContrastEnhancement )
+    for ( int col = 0; col < width; col++ )
     {
-      redVal = mRedContrastEnhancement->enhanceContrast( redVal );
-    }
-    if ( mGreenContrastEnhancement )
-    {
-      greenVal = mGreenContrastEnhancement->enhanceContrast( greenVal );
-    }
-    if ( mBlueContrastEnhancement )
-    {
-      blueVal = mBlueContrastEnhancement->enhanceContrast( blueVal );
-    }
+      int redVal = redRow[col];
+      int greenVal = greenRow[col];
+      int blueVal = blueRow[col];
+      if (( redVal | greenVal | blueVal ) < 0 )
+      {
+        colorRow[col] = myDefaultColor;
+        continue;
+      }
 
-    //opacity
-    double currentOpacity = mOpacity;
-    if ( mRasterTransparency )
-    {
-      currentOpacity = mRasterTransparency->alphaValue( redVal, greenVal, blueVal, mOpacity * 255 ) / 255.0;
-    }
-    if ( mAlphaBand > 0 )
-    {
-      currentOpacity *= alphaBlock->value( i ) / 255.0;
-    }
+      //opacity
+      double currentOpacity = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentOpacity = mRasterTransparency->alphaValue( redVal, greenVal, blueVal, mOpacity * 255 ) / 255.0;
+      }
+      if ( mAlphaBand > 0 )
+      {
+        currentOpacity *= alphaBlock->value( rowStart + col ) / 255.0;
+      }
 
-    if ( doubleNear( currentOpacity, 1.0 ) )
-    {
-      outputBlock->setColor( i, qRgba( redVal, greenVal, blueVal, 255 ) );
-    }
-    else
-    {
-      outputBlock->setColor( i, qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 ) );
+      if ( doubleNear( currentOpacity, 1.0 ) )
+      {
+        colorRow[col] = qRgba( redVal, greenVal, blueVal, 255 );
+      }
+      else
+      {
+        colorRow[col] = qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 );
+      }
     }
   }
 
-  for ( int i = 0; i < bandBlocks.size(); i++ )
-  {
-    delete bandBlocks.value( i );
-  }
+  qDeleteAll( bandBlocks );
 
   return outputBlock;
 }
@@ -0,0 +1,214 @@
+/***************************************************************************
+    qgsrasterblockcache.cpp
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsrasterblockcache.h"
+#include "qgslogger.h"
+
+#include <QList>
+#include <QMutex>
+
+#include <cstring>
+
+// Blocks shared by a cache and its clones
+class QgsRasterBlockCacheData
+{
+  public:
+    struct Entry
+    {
+      int bandNo;
+      QgsRectangle extent;
+      int width;
+      int height;
+      qint64 bytes;
+      QgsRasterBlock* block;
+    };
+
+    QgsRasterBlockCacheData() : size( 0 ), maximumSize( 64 * 1024 * 1024 ) {}
+    ~QgsRasterBlockCacheData() { shrink( 0 ); }
+
+    //! drop the least recently used blocks until the cache is not larger than maxSize
+    void shrink( qint64 maxSize )
+    {
+      while ( size > maxSize && !entries.isEmpty() )
+      {
+        Entry entry = entries.takeLast();
+        size -= entry.bytes;
+        delete entry.block;
+      }
+    }
+
+    QMutex mutex;
+    QList<Entry> entries; // the most recently used first
+    qint64 size;
+    qint64 maximumSize;
+};
+
+// Finds the position of the extent in the pixels of a cached block with the same
+// resolution. Returns false if the extent is not aligned to the pixels of the block
+// or does not fit into it.
+static bool blockOffset( const QgsRasterBlockCacheData::Entry& entry, const QgsRectangle& extent, int width, int height, int& col, int& row )
+{
+  // a thousandth of a pixel is considered the same position
+  double xRes = entry.extent.width() / entry.width;
+  double yRes = entry.extent.height() / entry.height;
+  if ( qAbs( extent.width() - width * xRes ) > 0.001 * xRes || qAbs( extent.height() - height * yRes ) > 0.001 * yRes )
+    return false;
+
+  double colOffset = ( extent.xMinimum() - entry.extent.xMinimum() ) / xRes;
+  double rowOffset = ( entry.extent.yMaximum() - extent.yMaximum() ) / yRes;
+  col = qRound( colOffset );
+  row = qRound( rowOffset );
+  if ( qAbs( colOffset - col ) > 0.001 || qAbs( rowOffset - row ) > 0.001 )
+    return false;
+
+  return col >= 0 && row >= 0 && col + width <= entry.width && row + height <= entry.height;
+}
+
+static QgsRasterBlock* copyBlock( QgsRasterBlock* source, int col, int row, int width, int height )
+{
+  QgsRasterBlock* block = new QgsRasterBlock( source->dataType(), width, height, source->noDataValue() );
+  if ( block->isEmpty() )
+    return block;
+
+  size_t rowSize = ( size_t )width * QgsRasterBlock::typeSize( source->dataType() );
+  for ( int i = 0; i < height; i++ )
+  {
+    memcpy( block->bits( i, 0 ), source->bits( row + i, col ), rowSize );
+  }
+  return block;
+}
+
+QgsRasterBlockCache::QgsRasterBlockCache( QgsRasterInterface* input )
+    : QgsRasterInterface( input )
+    , mData( new QgsRasterBlockCacheData )
+{
+}
+
+QgsRasterBlockCache::~QgsRasterBlockCache()
+{
+}
+
+QgsRasterInterface * QgsRasterBlockCache::clone() const
+{
+  QgsDebugMsg( "Entered" );
+  QgsRasterBlockCache * cache = new QgsRasterBlockCache( 0 );
+  cache->mData = mData;
+  return cache;
+}
+
+int QgsRasterBlockCache::bandCount() const
+{
+  if ( mInput ) return mInput->bandCount();
+  return 0;
+}
+
+QGis::DataType QgsRasterBlockCache::dataType( int bandNo ) const
+{
+  if ( mInput ) return mInput->dataType( bandNo );
+  return QGis::UnknownDataType;
+}
+
+double QgsRasterBlockCache::noDataValue( int bandNo ) const
+{
+  if ( mInput ) return mInput->noDataValue( bandNo );
+  return QgsRasterInterface::noDataValue( bandNo );
+}
+
+bool QgsRasterBlockCache::setInput( QgsRasterInterface* input )
+{
+  // the blocks were read from the previous input
+  if ( mInput && input != mInput )
+  {
+    clear();
+  }
+  mInput = input;
+  return true;
+}
+
+QgsRasterBlock * QgsRasterBlockCache::block( int bandNo, QgsRectangle  const & extent, int width, int height )
+{
+  if ( !mInput )
+  {
+    return new QgsRasterBlock();
+  }
+  if ( !mOn )
+  {
+    return mInput->block( bandNo, extent, width, height );
+  }
+
+  {
+    QMutexLocker locker( &mData->mutex );
+    for ( int i = 0; i < mData->entries.size(); i++ )
+    {
+      const QgsRasterBlockCacheData::Entry& entry = mData->entries[i];
+      int col, row;
+      if ( entry.bandNo != bandNo || !blockOffset( entry, extent, width, height, col, row ) )
+        continue;
+
+      QgsDebugMsgLevel( QString( "block %1 x %2 at %3, %4 of a cached block" ).arg( width ).arg( height ).arg( col ).arg( row ), 4 );
+      QgsRasterBlock* block = copyBlock( entry.block, col, row, width, height );
+      mData->entries.move( i, 0 );
+      return block;
+    }
+  }
+
+  QgsRasterBlock* block = mInput->block( bandNo, extent, width, height );
+  if ( !block || block->isEmpty() )
+  {
+    return block;
+  }
+
+  QgsRasterBlockCacheData::Entry entry;
+  entry.bandNo = bandNo;
+  entry.extent = extent;
+  entry.width = width;
+  entry.height = height;
+  entry.bytes = ( qint64 )width * height * QgsRasterBlock::typeSize( block->dataType() );
+
+  QMutexLocker locker( &mData->mutex );
+  if ( entry.bytes <= mData->maximumSize )
+  {
+    entry.block = copyBlock( block, 0, 0, width, height );
+    mData->entries.prepend( entry );
+    mData->size += entry.bytes;
+    mData->shrink( mData->maximumSize );
+  }
+
+  return block;
+}
+
+void QgsRasterBlockCache::setMaximumSize( qint64 bytes )
+{
+  QMutexLocker locker( &mData->mutex );
+  mData->maximumSize = bytes;
+  mData->shrink( bytes );
+}
+
+qint64 QgsRasterBlockCache::maximumSize() const
+{
+  QMutexLocker locker( &mData->mutex );
+  return mData->maximumSize;
+}
+
+qint64 QgsRasterBlockCache::size() const
+{
+  QMutexLocker locker( &mData->mutex );
+  return mData->size;
+}
+
+void QgsRasterBlockCache::clear()
+{
+  QMutexLocker locker( &mData->mutex );
+  mData->shrink( 0 );
+}
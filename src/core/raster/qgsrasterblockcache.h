@@ -0,0 +1,70 @@
+/***************************************************************************
+    qgsrasterblockcache.h
+    ---------------------
+    begin                : March 2013
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERBLOCKCACHE_H
+#define QGSRASTERBLOCKCACHE_H
+
+#include "qgsrasterinterface.h"
+
+#include <QSharedPointer>
+
+class QgsRasterBlockCacheData;
+
+/** \ingroup core
+  * Raster pipe interface which keeps the blocks read from its input in memory.
+  * A request for the band, extent and size of a cached block, or for a part of
+  * a cached block at the same resolution, is served without reading the input.
+  * QgsRasterPipe::set() inserts it right after the provider, it may also be
+  * inserted after the renderer with QgsRasterPipe::insert().
+  * The least recently used blocks are dropped when the cached blocks take more
+  * than maximumSize() bytes.
+  * The cache is cleared when an interface before it is inserted, replaced, removed
+  * or switched on/off in the pipe. If an interface before the cache is modified in
+  * place, the cache has to be cleared with QgsRasterPipe::clearBlockCache() or clear().
+  * Copies made by clone() share the cached blocks.
+  * @note added in 2.0
+  */
+class CORE_EXPORT QgsRasterBlockCache : public QgsRasterInterface
+{
+  public:
+    QgsRasterBlockCache( QgsRasterInterface* input = 0 );
+    ~QgsRasterBlockCache();
+
+    QgsRasterInterface * clone() const;
+
+    int bandCount() const;
+
+    QGis::DataType dataType( int bandNo ) const;
+
+    double noDataValue( int bandNo ) const;
+
+    bool setInput( QgsRasterInterface* input );
+
+    QgsRasterBlock* block( int bandNo, const QgsRectangle &extent, int width, int height );
+
+    /** \brief Set the maximum size of the cached blocks in bytes */
+    void setMaximumSize( qint64 bytes );
+    qint64 maximumSize() const;
+
+    /** \brief Size of the cached blocks in bytes */
+    qint64 size() const;
+
+    /** \brief Drop all cached blocks */
+    void clear();
+
+  private:
+    QSharedPointer<QgsRasterBlockCacheData> mData;
+};
+
+#endif // QGSRASTERBLOCKCACHE_H
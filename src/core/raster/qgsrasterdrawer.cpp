@@ -22,6 +22,7 @@
 #include "qgsmaptopixel.h"
 #include <QImage>
 #include <QPainter>
+#include <QThread>
 
 QgsRasterDrawer::QgsRasterDrawer( QgsRasterIterator* iterator ): mIterator( iterator )
 {
@@ -41,6 +42,8 @@ void QgsRasterDrawer::draw( QPainter* p, QgsRasterViewPort* viewPort, const QgsM
 
   // last pipe filter has only 1 band
   int bandNumber = 1;
+  // parts are read in parallel if the pipe allows it, and drawn in order
+  mIterator->setMaximumThreadCount( QThread::idealThreadCount() );
   mIterator->startRasterRead( bandNumber, viewPort->drawableAreaXDim, viewPort->drawableAreaYDim, viewPort->mDrawnExtent );
 
   //number of cols/rows in output pixels
@@ -19,7 +19,10 @@
 #include <typeinfo>
 
 #include <QByteArray>
+#include <QPair>
+#include <QThread>
 #include <QTime>
+#include <QtConcurrentMap>
 
 #include <qmath.h>
 
@@ -47,6 +50,282 @@ bool QgsRasterInterface::isNoDataValue( int bandNo, double value ) const
   return QgsRasterBlock::isNoDataValue( value, noDataValue( bandNo ) );
 }
 
+// Statistics, histogram bins and counts of each value collected from blocks of a band.
+// A batch of blocks is split between several counts which are merged at the end.
+struct QgsRasterBandCounts
+{
+  QgsRasterBandCounts()
+      : noDataValue( std::numeric_limits<double>::quiet_NaN() )
+      , binCount( 0 )
+      , binMinimum( 0 )
+      , binSize( 0 )
+      , includeOutOfRange( false )
+      , nonNullCount( 0 )
+      , valueMinimum( 0 )
+      , elementCount( 0 )
+      , minimum( std::numeric_limits<double>::max() )
+      , maximum( -std::numeric_limits<double>::max() )
+      , sum( 0 )
+      , mean( 0 )
+      , sumOfSquares( 0 )
+  {}
+
+  double noDataValue;
+
+  // histogram bins, no bins are collected if binCount is 0
+  int binCount;
+  double binMinimum;
+  double binSize;
+  bool includeOutOfRange;
+  QgsRasterHistogram::HistogramVector bins;
+  int nonNullCount;
+
+  // number of each integer value from valueMinimum, not collected if empty
+  int valueMinimum;
+  QgsRasterHistogram::HistogramVector values;
+
+  int elementCount;
+  double minimum;
+  double maximum;
+  double sum;
+  double mean;
+  double sumOfSquares;
+
+  // blocks of the current batch with their number of pixels
+  QList< QPair<QgsRasterBlock *, size_t> > blocks;
+};
+
+// Range of the values of 8 and 16 bit integer types, false for other types
+static bool valueRange( QGis::DataType dataType, int &minimum, int &count )
+{
+  switch ( dataType )
+  {
+    case QGis::Byte:
+      minimum = 0;
+      count = 256;
+      return true;
+    case QGis::UInt16:
+      minimum = 0;
+      count = 65536;
+      return true;
+    case QGis::Int16:
+      minimum = -32768;
+      count = 65536;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static inline void countValue( QgsRasterBandCounts &counts, int *bins, int *values, double value )
+{
+  if ( qIsNaN( value ) || doubleNear( value, counts.noDataValue ) )
+    return;
+
+  counts.elementCount++;
+  counts.sum += value;
+  if ( value < counts.minimum ) counts.minimum = value;
+  if ( value > counts.maximum ) counts.maximum = value;
+
+  // Single pass stdev (Welford)
+  double delta = value - counts.mean;
+  counts.mean += delta / counts.elementCount;
+  counts.sumOfSquares += delta * ( value - counts.mean );
+
+  if ( values )
+  {
+    values[( int ) value - counts.valueMinimum]++;
+  }
+
+  if ( bins )
+  {
+    int binIndex = static_cast <int>( qFloor(( value - counts.binMinimum ) / counts.binSize ) );
+    if (( binIndex < 0 || binIndex > ( counts.binCount - 1 ) ) && !counts.includeOutOfRange )
+      return;
+    if ( binIndex < 0 ) binIndex = 0;
+    if ( binIndex > ( counts.binCount - 1 ) ) binIndex = counts.binCount - 1;
+
+    bins[binIndex]++;
+    counts.nonNullCount++;
+  }
+}
+
+template <typename T>
+static void countValues( QgsRasterBandCounts &counts, int *bins, int *values, const T *data, size_t size )
+{
+  for ( size_t i = 0; i < size; i++ )
+  {
+    countValue( counts, bins, values, data[i] );
+  }
+}
+
+// Counts the values of the blocks of a batch, runs in a worker thread
+static void countBlocks( QgsRasterBandCounts &counts )
+{
+  int *bins = counts.bins.isEmpty() ? 0 : counts.bins.data();
+  int *values = counts.values.isEmpty() ? 0 : counts.values.data();
+
+  for ( int b = 0; b < counts.blocks.size(); b++ )
+  {
+    QgsRasterBlock *block = counts.blocks[b].first;
+    size_t size = counts.blocks[b].second;
+    if ( !block || block->isEmpty() )
+      continue;
+
+    const void *data = block->bits(( size_t ) 0 );
+    switch ( block->dataType() )
+    {
+      case QGis::Byte:
+        countValues( counts, bins, values, ( const unsigned char * ) data, size );
+        break;
+      case QGis::UInt16:
+        countValues( counts, bins, values, ( const unsigned short * ) data, size );
+        break;
+      case QGis::Int16:
+        countValues( counts, bins, values, ( const short * ) data, size );
+        break;
+      case QGis::UInt32:
+        countValues( counts, bins, values, ( const unsigned int * ) data, size );
+        break;
+      case QGis::Int32:
+        countValues( counts, bins, values, ( const int * ) data, size );
+        break;
+      case QGis::Float32:
+        countValues( counts, bins, values, ( const float * ) data, size );
+        break;
+      case QGis::Float64:
+        countValues( counts, bins, values, ( const double * ) data, size );
+        break;
+      default:
+        for ( size_t i = 0; i < size; i++ )
+        {
+          countValue( counts, bins, values, block->value( i ) );
+        }
+        break;
+    }
+  }
+}
+
+// Adds the counts of a part of the band, the variance is merged as proposed by Chan et al.
+static void mergeCounts( QgsRasterBandCounts &total, const QgsRasterBandCounts &part )
+{
+  for ( int i = 0; i < part.bins.size(); i++ )
+  {
+    total.bins[i] += part.bins[i];
+  }
+  total.nonNullCount += part.nonNullCount;
+
+  for ( int i = 0; i < part.values.size(); i++ )
+  {
+    total.values[i] += part.values[i];
+  }
+
+  if ( part.elementCount == 0 )
+    return;
+
+  double count = ( double ) total.elementCount + part.elementCount;
+  double delta = part.mean - total.mean;
+  total.mean += delta * part.elementCount / count;
+  total.sumOfSquares += part.sumOfSquares + delta * delta * total.elementCount * part.elementCount / count;
+  total.elementCount += part.elementCount;
+  total.sum += part.sum;
+  if ( part.minimum < total.minimum ) total.minimum = part.minimum;
+  if ( part.maximum > total.maximum ) total.maximum = part.maximum;
+}
+
+static void countBatch( QVector<QgsRasterBandCounts> &parts, QList< QPair<QgsRasterBlock *, size_t> > &batch )
+{
+  // blocks are dealt out to the parts
+  for ( int i = 0; i < batch.size(); i++ )
+  {
+    parts[i % parts.size()].blocks.append( batch[i] );
+  }
+
+  if ( batch.size() == 1 )
+  {
+    countBlocks( parts[0] );
+  }
+  else
+  {
+    QtConcurrent::blockingMap( parts, countBlocks );
+  }
+
+  for ( int i = 0; i < parts.size(); i++ )
+  {
+    parts[i].blocks.clear();
+  }
+  for ( int i = 0; i < batch.size(); i++ )
+  {
+    delete batch[i].first;
+  }
+  batch.clear();
+}
+
+// Reads the band block by block and adds its values to the counts. The blocks are read in
+// the calling thread, because inputs are not thread safe, and a batch of blocks is counted
+// in parallel.
+static void countBand( QgsRasterInterface *input, int bandNo, const QgsRectangle &extent, int width, int height, QgsRasterBandCounts &counts )
+{
+  int myXBlockSize = input->xBlockSize();
+  int myYBlockSize = input->yBlockSize();
+  if ( myXBlockSize == 0 ) // should not happen, but happens
+  {
+    myXBlockSize = 500;
+  }
+  if ( myYBlockSize == 0 ) // should not happen, but happens
+  {
+    myYBlockSize = 500;
+  }
+
+  int myNXBlocks = ( width + myXBlockSize - 1 ) / myXBlockSize;
+  int myNYBlocks = ( height + myYBlockSize - 1 ) / myYBlockSize;
+
+  double myXRes = extent.width() / width;
+  double myYRes = extent.height() / height;
+
+  // the parts start with the settings and empty counts of the total
+  QVector<QgsRasterBandCounts> parts( qMax( 1, QThread::idealThreadCount() ), counts );
+  QList< QPair<QgsRasterBlock *, size_t> > batch;
+  qint64 batchSize = 0;
+
+  // TODO: progress signals
+  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  {
+    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
+    {
+      int myBlockWidth = qMin( myXBlockSize, width - myXBlock * myXBlockSize );
+      int myBlockHeight = qMin( myYBlockSize, height - myYBlock * myYBlockSize );
+
+      double xmin = extent.xMinimum() + myXBlock * myXBlockSize * myXRes;
+      double xmax = xmin + myBlockWidth * myXRes;
+      double ymin = extent.yMaximum() - myYBlock * myYBlockSize * myYRes;
+      double ymax = ymin - myBlockHeight * myYRes;
+
+      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+
+      QgsRasterBlock *blk = input->block( bandNo, myPartExtent, myBlockWidth, myBlockHeight );
+      batch.append( qMakePair( blk, ( size_t ) myBlockWidth * myBlockHeight ) );
+      batchSize += ( qint64 ) myBlockWidth * myBlockHeight;
+
+      // a batch keeps all threads busy and is not too small for the overhead of the threads
+      if ( batch.size() >= parts.size() && batchSize >= 1024 * 1024 )
+      {
+        countBatch( parts, batch );
+        batchSize = 0;
+      }
+    }
+  }
+  if ( !batch.isEmpty() )
+  {
+    countBatch( parts, batch );
+  }
+
+  for ( int i = 0; i < parts.size(); i++ )
+  {
+    mergeCounts( counts, parts[i] );
+  }
+}
+
 void QgsRasterInterface::initStatistics( QgsRasterBandStats &theStatistics,
     int theBandNo,
     int theStats,
@@ -148,123 +427,71 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int theBandNo,
     }
   }
 
-  QgsRectangle myExtent = myRasterBandStats.extent;
-  int myWidth = myRasterBandStats.width;
-  int myHeight = myRasterBandStats.height;
-
-  //int myDataType = dataType( theBandNo );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
+  collectStatistics( myRasterBandStats );
 
-// void *myData = QgsMalloc( myXBlockSize * myYBlockSize * ( QgsRasterBlock::typeSize( dataType( theBandNo ) ) ) );
+  return myRasterBandStats;
+}
 
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
-  // TODO: progress signals
+void QgsRasterInterface::collectStatistics( QgsRasterBandStats &theStatistics )
+{
+  int theBandNo = theStatistics.bandNumber;
 
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
+  QgsRasterBandCounts myCounts;
+  myCounts.noDataValue = noDataValue( theBandNo );
 
-  bool myFirstIterationFlag = true;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  // Values of 8 and 16 bit integer bands are counted in the same pass, histograms
+  // of the same extent and size are then binned without reading the band again
+  int myValueCount;
+  bool myCountValues = valueRange( dataType( theBandNo ), myCounts.valueMinimum, myValueCount );
+  if ( myCountValues )
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      QgsDebugMsg( QString( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ) );
-      int myBlockWidth = qMin( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = qMin( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      //readBlock( theBandNo, myPartExtent, myBlockWidth, myBlockHeight, myData );
-      QgsRasterBlock* blk = block( theBandNo, myPartExtent, myBlockWidth, myBlockHeight );
-
-      // Collect the histogram counts.
-      for ( size_t i = 0; i < (( size_t ) myBlockHeight ) * myBlockWidth; i++ )
-      {
-        //double myValue = readValue( myData, myDataType, myX + ( myY * myBlockWidth ) );
-        double myValue = blk->value( i );
-        //QgsDebugMsg ( QString ( "%1 %2 value %3" ).arg (myX).arg(myY).arg( myValue ) );
-
-        // TODO: user nodata
-        if ( isNoDataValue( theBandNo, myValue ) )
-        {
-          continue; // NULL
-        }
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
+    myCounts.values.fill( 0, myValueCount );
+  }
 
-        //myRasterBandStats.sumOfSquares += static_cast < double >
-        //                                  ( qPow( myValue - myRasterBandStats.mean, 2 ) );
+  countBand( this, theBandNo, theStatistics.extent, theStatistics.width, theStatistics.height, myCounts );
 
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
-    }
+  theStatistics.elementCount = myCounts.elementCount;
+  theStatistics.sum = myCounts.sum;
+  if ( myCounts.elementCount > 0 )
+  {
+    theStatistics.minimumValue = myCounts.minimum;
+    theStatistics.maximumValue = myCounts.maximum;
   }
+  theStatistics.range = theStatistics.maximumValue - theStatistics.minimumValue;
+  theStatistics.mean = theStatistics.sum / theStatistics.elementCount;
 
-  myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
-  myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
-
-  myRasterBandStats.sumOfSquares = mySumOfSquares; // OK with single pass?
+  theStatistics.sumOfSquares = myCounts.sumOfSquares;
 
   // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
   // algorithm which is more error prone (because of rounding errors)
   // Divide result by sample size - 1 and get square root to get stdev
-  myRasterBandStats.stdDev = sqrt( mySumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
+  theStatistics.stdDev = sqrt( myCounts.sumOfSquares / ( theStatistics.elementCount - 1 ) );
 
   QgsDebugMsg( "************ STATS **************" );
-  QgsDebugMsg( QString( "MIN %1" ).arg( myRasterBandStats.minimumValue ) );
-  QgsDebugMsg( QString( "MAX %1" ).arg( myRasterBandStats.maximumValue ) );
-  QgsDebugMsg( QString( "RANGE %1" ).arg( myRasterBandStats.range ) );
-  QgsDebugMsg( QString( "MEAN %1" ).arg( myRasterBandStats.mean ) );
-  QgsDebugMsg( QString( "STDDEV %1" ).arg( myRasterBandStats.stdDev ) );
-
-  //QgsFree( myData );
-
-  myRasterBandStats.statsGathered = QgsRasterBandStats::All;
-  mStatistics.append( myRasterBandStats );
-
-  return myRasterBandStats;
+  QgsDebugMsg( QString( "MIN %1" ).arg( theStatistics.minimumValue ) );
+  QgsDebugMsg( QString( "MAX %1" ).arg( theStatistics.maximumValue ) );
+  QgsDebugMsg( QString( "RANGE %1" ).arg( theStatistics.range ) );
+  QgsDebugMsg( QString( "MEAN %1" ).arg( theStatistics.mean ) );
+  QgsDebugMsg( QString( "STDDEV %1" ).arg( theStatistics.stdDev ) );
+
+  theStatistics.statsGathered = QgsRasterBandStats::All;
+  mStatistics.append( theStatistics );
+
+  if ( myCountValues )
+  {
+    QgsRasterHistogram myValues;
+    myValues.bandNumber = theBandNo;
+    myValues.binCount = myValueCount;
+    myValues.minimum = myCounts.valueMinimum;
+    myValues.maximum = myCounts.valueMinimum + myValueCount - 1;
+    myValues.extent = theStatistics.extent;
+    myValues.width = theStatistics.width;
+    myValues.height = theStatistics.height;
+    myValues.histogramVector = myCounts.values;
+    myValues.nonNullCount = myCounts.elementCount;
+    myValues.valid = true;
+    mValueCounts.append( myValues );
+  }
 }
 
 void QgsRasterInterface::initHistogram( QgsRasterHistogram &theHistogram,
@@ -427,31 +654,7 @@ QgsRasterHistogram QgsRasterInterface::histogram( int theBandNo,
   }
 
   int myBinCount = myHistogram.binCount;
-  int myWidth = myHistogram.width;
-  int myHeight = myHistogram.height;
-  QgsRectangle myExtent = myHistogram.extent;
-  myHistogram.histogramVector.resize( myBinCount );
-
-  //int myDataType = dataType( theBandNo );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  //void *myData = QgsMalloc( myXBlockSize * myYBlockSize * ( QgsRasterBlock::typeSize( dataType( theBandNo ) ) ) );
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
+  myHistogram.histogramVector.fill( 0, myBinCount );
 
   double myMinimum = myHistogram.minimum;
   double myMaximum = myHistogram.maximum;
@@ -466,55 +669,54 @@ QgsRasterHistogram QgsRasterInterface::histogram( int theBandNo,
 
   double myBinSize = ( myMaximum - myMinimum ) / myBinCount;
 
-  // TODO: progress signals
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  int myValueMinimum, myValueCount;
+  if ( valueRange( dataType( theBandNo ), myValueMinimum, myValueCount ) )
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
+    // 8 and 16 bit integer bands are binned from the counts of each value collected
+    // with the statistics
+    int myValuesIndex = valueCountsIndex( myHistogram );
+    if ( myValuesIndex < 0 )
     {
-      int myBlockWidth = qMin( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = qMin( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+      QgsRasterBandStats myStatistics;
+      initStatistics( myStatistics, theBandNo, QgsRasterBandStats::All, theExtent, theSampleSize );
+      collectStatistics( myStatistics );
+      myValuesIndex = valueCountsIndex( myHistogram );
+    }
+    const QgsRasterHistogram::HistogramVector &myValues = mValueCounts.at( myValuesIndex ).histogramVector;
 
-      //readBlock( theBandNo, myPartExtent, myBlockWidth, myBlockHeight, myData );
-      QgsRasterBlock* blk = block( theBandNo, myPartExtent, myBlockWidth, myBlockHeight );
+    for ( int i = 0; i < myValues.size(); i++ )
+    {
+      if ( myValues[i] == 0 )
+        continue;
 
-      // Collect the histogram counts.
-      for ( size_t i = 0; i < (( size_t ) myBlockHeight ) * myBlockWidth; i++ )
+      double myValue = myValueMinimum + i;
+      int myBinIndex = static_cast <int>( qFloor(( myValue - myMinimum ) /  myBinSize ) ) ;
+      if (( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !theIncludeOutOfRange )
       {
-        //double myValue = readValue( myData, myDataType, myX + ( myY * myBlockWidth ) );
-        double myValue = blk->value( i );
-
-        //QgsDebugMsg ( QString ( "%1 %2 value %3" ).arg (myX).arg(myY).arg( myValue ) );
-
-        // TODO: user defined nodata values
-        if ( isNoDataValue( theBandNo, myValue ) )
-        {
-          continue; // NULL
-        }
-
-        int myBinIndex = static_cast <int>( qFloor(( myValue - myMinimum ) /  myBinSize ) ) ;
-        //QgsDebugMsg( QString( "myValue = %1 myBinIndex = %2" ).arg( myValue ).arg( myBinIndex ) );
-
-        if (( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !theIncludeOutOfRange )
-        {
-          continue;
-        }
-        if ( myBinIndex < 0 ) myBinIndex = 0;
-        if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
-
-        myHistogram.histogramVector[myBinIndex] += 1;
-        myHistogram.nonNullCount++;
+        continue;
       }
+      if ( myBinIndex < 0 ) myBinIndex = 0;
+      if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
+
+      myHistogram.histogramVector[myBinIndex] += myValues[i];
+      myHistogram.nonNullCount += myValues[i];
     }
   }
+  else
+  {
+    QgsRasterBandCounts myCounts;
+    myCounts.noDataValue = noDataValue( theBandNo );
+    myCounts.binCount = myBinCount;
+    myCounts.binMinimum = myMinimum;
+    myCounts.binSize = myBinSize;
+    myCounts.includeOutOfRange = theIncludeOutOfRange;
+    myCounts.bins.fill( 0, myBinCount );
 
-  //QgsFree( myData );
+    countBand( this, theBandNo, myHistogram.extent, myHistogram.width, myHistogram.height, myCounts );
+
+    myHistogram.histogramVector = myCounts.bins;
+    myHistogram.nonNullCount = myCounts.nonNullCount;
+  }
 
   myHistogram.valid = true;
   mHistograms.append( myHistogram );
@@ -531,6 +733,22 @@ QgsRasterHistogram QgsRasterInterface::histogram( int theBandNo,
   return myHistogram;
 }
 
+int QgsRasterInterface::valueCountsIndex( const QgsRasterHistogram &theHistogram ) const
+{
+  for ( int i = 0; i < mValueCounts.size(); i++ )
+  {
+    const QgsRasterHistogram &myValues = mValueCounts.at( i );
+    if ( myValues.bandNumber == theHistogram.bandNumber &&
+         myValues.extent == theHistogram.extent &&
+         myValues.width == theHistogram.width &&
+         myValues.height == theHistogram.height )
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
 void QgsRasterInterface::cumulativeCut( int theBandNo,
                                         double theLowerCount, double theUpperCount,
                                         double &theLowerValue, double &theUpperValue,
@@ -596,6 +814,11 @@ QString QgsRasterInterface::capabilitiesString() const
     abilitiesList += tr( "Remove Datasources" );
   }
 
+  if ( abilities & QgsRasterInterface::ThreadedRead )
+  {
+    abilitiesList += tr( "Threaded Reading" );
+  }
+
   QgsDebugMsg( "Capability: " + abilitiesList.join( ", " ) );
 
   return abilitiesList.join( ", " );
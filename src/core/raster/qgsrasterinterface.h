@@ -55,7 +55,8 @@ class CORE_EXPORT QgsRasterInterface
       IdentifyValue =           1 << 9,
       IdentifyText =            1 << 10,
       IdentifyHtml =            1 << 11,
-      IdentifyFeature =         1 << 12  // WMS GML -> feature
+      IdentifyFeature =         1 << 12, // WMS GML -> feature
+      ThreadedRead =            1 << 13  // block() may be called from other threads, one call at a time
     };
 
 
@@ -189,6 +190,8 @@ class CORE_EXPORT QgsRasterInterface
      * @param theStats Requested statistics
      * @param theExtent Extent used to calc statistics, if empty, whole raster extent is used.
      * @param theSampleSize Approximate number of cells in sample. If 0, all cells (whole raster will be used). If raster does not have exact size (WCS without exact size for example), provider decides size of sample.
+     * A sample is read at a lower resolution, its mean is an estimate with a standard error of
+     * stdDev / sqrt( elementCount ).
      * @return Band statistics.
      */
     virtual QgsRasterBandStats bandStatistics( int theBandNo,
@@ -291,6 +294,18 @@ class CORE_EXPORT QgsRasterInterface
                          int theBinCount = 0 );
 
   private:
+    /** Read the band in the extent and size of the statistics, which are filled in
+     * and cached, together with the counts of each value of 8 and 16 bit integer bands */
+    void collectStatistics( QgsRasterBandStats &theStatistics );
+
+    /** Index of the value counts in mValueCounts for the band, extent and size of
+     * the histogram, -1 if none were collected */
+    int valueCountsIndex( const QgsRasterHistogram &theHistogram ) const;
+
+    /** Counts of each value of 8 and 16 bit integer bands, one bin per value,
+     * histograms of the same band, extent and size are binned from them */
+    QList <QgsRasterHistogram> mValueCounts;
+
     // Last rendering cumulative (this and all preceding interfaces) times, from index 1
     //QVector<double> mTime;
 
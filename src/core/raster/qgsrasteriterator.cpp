@@ -15,15 +15,75 @@
 #include "qgsrasteriterator.h"
 #include "qgsrasterinterface.h"
 #include "qgsrasterprojector.h"
+#include "qgsmultibandcolorrenderer.h"
+#include "qgssinglebandgrayrenderer.h"
+#include "qgscontrastenhancement.h"
 #include "qgsrasterviewport.h"
 
+#include <QFuture>
+#include <QMutex>
+#include <QQueue>
+#include <QtConcurrentRun>
+
+// Input of the pipe copies used for concurrent reading. Passes the calls to the
+// data provider of the pipe and lets only one thread at a time read a block.
+class QgsRasterSerializedInput : public QgsRasterInterface
+{
+  public:
+    QgsRasterSerializedInput( QgsRasterInterface* input, QMutex* mutex )
+        : QgsRasterInterface( input ), mMutex( mutex ) {}
+
+    QgsRasterInterface* clone() const { return new QgsRasterSerializedInput( mInput, mMutex ); }
+    int capabilities() const { return mInput->capabilities(); }
+    QGis::DataType dataType( int bandNo ) const { return mInput->dataType( bandNo ); }
+    int bandCount() const { return mInput->bandCount(); }
+    double noDataValue( int bandNo ) const { return mInput->noDataValue( bandNo ); }
+
+    QgsRasterBlock* block( int bandNo, const QgsRectangle& extent, int width, int height )
+    {
+      QMutexLocker locker( mMutex );
+      return mInput->block( bandNo, extent, width, height );
+    }
+
+  private:
+    QMutex* mMutex;
+};
+
+struct QgsRasterIterator::ConcurrentRead
+{
+  struct Part
+  {
+    QFuture<QgsRasterBlock*> block;
+    int nCols;
+    int nRows;
+    int topLeftCol;
+    int topLeftRow;
+    int copy; // index of the pipe copy reading the part
+  };
+
+  QMutex providerMutex;
+  QList<QgsRasterInterface*> copies; // last interface of each pipe copy
+  QList<QgsRasterInterface*> interfaces; // all interfaces of the copies
+  QQueue<Part> parts; // parts being read, in the order they are returned
+  int tileHeight;
+};
+
+static QgsRasterBlock* readPart( QgsRasterInterface* input, int bandNumber, QgsRectangle extent, int width, int height )
+{
+  return input->block( bandNumber, extent, width, height );
+}
+
 QgsRasterIterator::QgsRasterIterator( QgsRasterInterface* input ): mInput( input ),
-    mMaximumTileWidth( 2000 ), mMaximumTileHeight( 2000 )
+    mMaximumTileWidth( 2000 ), mMaximumTileHeight( 2000 ), mMaximumThreadCount( 1 )
 {
 }
 
 QgsRasterIterator::~QgsRasterIterator()
 {
+  foreach ( int bandNumber, mConcurrentReads.keys() )
+  {
+    removeConcurrentRead( bandNumber );
+  }
 }
 
 void QgsRasterIterator::startRasterRead( int bandNumber, int nCols, int nRows, const QgsRectangle& extent )
@@ -47,6 +107,17 @@ void QgsRasterIterator::startRasterRead( int bandNumber, int nCols, int nRows, c
   pInfo.block = 0;
   pInfo.prj = 0;
   mRasterPartInfos.insert( bandNumber, pInfo );
+
+  ConcurrentRead* read = createConcurrentRead( nCols, nRows );
+  if ( read )
+  {
+    mConcurrentReads.insert( bandNumber, read );
+    RasterPartInfo& info = mRasterPartInfos[bandNumber];
+    for ( int i = 0; i < read->copies.size(); i++ )
+    {
+      queuePart( bandNumber, info, read, i );
+    }
+  }
 }
 
 bool QgsRasterIterator::readNextRasterPart( int bandNumber,
@@ -72,6 +143,27 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
     return false;
   }
 
+  QMap<int, ConcurrentRead*>::iterator readIt = mConcurrentReads.find( bandNumber );
+  if ( readIt != mConcurrentReads.end() )
+  {
+    ConcurrentRead* read = readIt.value();
+    if ( read->parts.isEmpty() )
+    {
+      return false;
+    }
+
+    ConcurrentRead::Part part = read->parts.dequeue();
+    *block = part.block.result();
+    nCols = part.nCols;
+    nRows = part.nRows;
+    topLeftCol = part.topLeftCol;
+    topLeftRow = part.topLeftRow;
+
+    //the copy which read the part is free again
+    queuePart( bandNumber, pInfo, read, part.copy );
+    return true;
+  }
+
   //remove last data block
   // TODO: block is released somewhere else (check)
   //delete pInfo.block;
@@ -79,15 +171,28 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
   delete pInfo.prj;
   pInfo.prj = 0;
 
+  QgsRectangle blockRect;
+  if ( !nextPart( pInfo, mMaximumTileHeight, nCols, nRows, topLeftCol, topLeftRow, blockRect ) )
+  {
+    return false;
+  }
+
+  pInfo.block = mInput->block( bandNumber, blockRect, nCols, nRows );
+  *block = pInfo.block;
+
+  return true;
+}
+
+bool QgsRasterIterator::nextPart( RasterPartInfo& pInfo, int tileHeight, int& nCols, int& nRows, int& topLeftCol, int& topLeftRow, QgsRectangle& blockRect )
+{
   //already at end
   if ( pInfo.currentCol == pInfo.nCols && pInfo.currentRow == pInfo.nRows )
   {
     return false;
   }
 
-  //read data block
   nCols = qMin( mMaximumTileWidth, pInfo.nCols - pInfo.currentCol );
-  nRows = qMin( mMaximumTileHeight, pInfo.nRows - pInfo.currentRow );
+  nRows = qMin( tileHeight, pInfo.nRows - pInfo.currentRow );
   QgsDebugMsg( QString( "nCols = %1 nRows = %2" ).arg( nCols ).arg( nRows ) );
 
   //get subrectangle
@@ -96,11 +201,8 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
   double xmax = viewPortExtent.xMinimum() + ( pInfo.currentCol + nCols ) / ( double )pInfo.nCols * viewPortExtent.width();
   double ymin = viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / ( double )pInfo.nRows * viewPortExtent.height();
   double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / ( double )pInfo.nRows * viewPortExtent.height();
-  QgsRectangle blockRect( xmin, ymin, xmax, ymax );
-
-  pInfo.block = mInput->block( bandNumber, blockRect, nCols, nRows );
+  blockRect = QgsRectangle( xmin, ymin, xmax, ymax );
 
-  *block = pInfo.block;
   topLeftCol = pInfo.currentCol;
   topLeftRow = pInfo.currentRow;
 
@@ -118,6 +220,109 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
   return true;
 }
 
+static bool isUserDefined( const QgsContrastEnhancement* ce )
+{
+  return ce && ce->contrastEnhancementAlgorithm() == QgsContrastEnhancement::UserDefinedEnhancement;
+}
+
+//the copy of a contrast enhancement does not have the user defined function, so the renderer cannot be cloned
+static bool hasUserDefinedEnhancement( QgsRasterInterface* iface )
+{
+  QgsSingleBandGrayRenderer* gray = dynamic_cast<QgsSingleBandGrayRenderer*>( iface );
+  if ( gray )
+  {
+    return isUserDefined( gray->contrastEnhancement() );
+  }
+  QgsMultiBandColorRenderer* color = dynamic_cast<QgsMultiBandColorRenderer*>( iface );
+  if ( color )
+  {
+    return isUserDefined( color->redContrastEnhancement() ) || isUserDefined( color->greenContrastEnhancement() )
+           || isUserDefined( color->blueContrastEnhancement() );
+  }
+  return false;
+}
+
+QgsRasterIterator::ConcurrentRead* QgsRasterIterator::createConcurrentRead( int nCols, int nRows )
+{
+  if ( mMaximumThreadCount < 2 || !mInput || nCols <= 0 || nRows <= 0 )
+  {
+    return 0;
+  }
+
+  QgsRasterInterface* provider = mInput->srcInput();
+  if ( provider == mInput || !( provider->capabilities() & QgsRasterInterface::ThreadedRead ) )
+  {
+    return 0;
+  }
+
+  //interfaces above the provider, the first one reads from the provider
+  QList<QgsRasterInterface*> interfaces;
+  for ( QgsRasterInterface* iface = mInput; iface && iface != provider; iface = iface->input() )
+  {
+    //the projector splits its rows between threads itself
+    QgsRasterProjector* projector = dynamic_cast<QgsRasterProjector*>( iface );
+    if ( projector && projector->srcCrs().isValid() && projector->destCrs().isValid() && !( projector->srcCrs() == projector->destCrs() ) )
+    {
+      return 0;
+    }
+    if ( hasUserDefinedEnhancement( iface ) )
+    {
+      QgsDebugMsg( "User defined contrast enhancement, reading serially" );
+      return 0;
+    }
+    interfaces.prepend( iface );
+  }
+
+  //strips of rows, about two per thread
+  int tileHeight = qMin( mMaximumTileHeight, qMax( 256, nRows / ( 2 * mMaximumThreadCount ) + 1 ) );
+  int partCount = (( nCols + mMaximumTileWidth - 1 ) / mMaximumTileWidth ) * (( nRows + tileHeight - 1 ) / tileHeight );
+  int copyCount = qMin( mMaximumThreadCount, partCount );
+  if ( copyCount < 2 )
+  {
+    return 0;
+  }
+
+  ConcurrentRead* read = new ConcurrentRead;
+  read->tileHeight = tileHeight;
+  for ( int i = 0; i < copyCount; i++ )
+  {
+    QgsRasterInterface* input = new QgsRasterSerializedInput( provider, &read->providerMutex );
+    read->interfaces << input;
+    foreach ( QgsRasterInterface* iface, interfaces )
+    {
+      QgsRasterInterface* copy = iface->clone();
+      read->interfaces << copy;
+      copy->setOn( iface->on() );
+      if ( !copy->setInput( input ) )
+      {
+        QgsDebugMsg( "Cannot copy the pipe, reading serially" );
+        qDeleteAll( read->interfaces );
+        delete read;
+        return 0;
+      }
+      input = copy;
+    }
+    read->copies << input;
+  }
+
+  QgsDebugMsg( QString( "reading %1 parts with %2 threads" ).arg( partCount ).arg( copyCount ) );
+  return read;
+}
+
+void QgsRasterIterator::queuePart( int bandNumber, RasterPartInfo& pInfo, ConcurrentRead* read, int copy )
+{
+  ConcurrentRead::Part part;
+  QgsRectangle blockRect;
+  if ( !nextPart( pInfo, read->tileHeight, part.nCols, part.nRows, part.topLeftCol, part.topLeftRow, blockRect ) )
+  {
+    return;
+  }
+
+  part.copy = copy;
+  part.block = QtConcurrent::run( readPart, read->copies[copy], bandNumber, blockRect, part.nCols, part.nRows );
+  read->parts.enqueue( part );
+}
+
 void QgsRasterIterator::stopRasterRead( int bandNumber )
 {
   removePartInfo( bandNumber );
@@ -125,6 +330,8 @@ void QgsRasterIterator::stopRasterRead( int bandNumber )
 
 void QgsRasterIterator::removePartInfo( int bandNumber )
 {
+  removeConcurrentRead( bandNumber );
+
   QMap<int, RasterPartInfo>::iterator partIt = mRasterPartInfos.find( bandNumber );
   if ( partIt != mRasterPartInfos.end() )
   {
@@ -134,3 +341,22 @@ void QgsRasterIterator::removePartInfo( int bandNumber )
     mRasterPartInfos.remove( bandNumber );
   }
 }
+
+void QgsRasterIterator::removeConcurrentRead( int bandNumber )
+{
+  QMap<int, ConcurrentRead*>::iterator readIt = mConcurrentReads.find( bandNumber );
+  if ( readIt == mConcurrentReads.end() )
+  {
+    return;
+  }
+
+  //the copies are used until the parts which were not fetched are read
+  ConcurrentRead* read = readIt.value();
+  while ( !read->parts.isEmpty() )
+  {
+    delete read->parts.dequeue().block.result();
+  }
+  qDeleteAll( read->interfaces );
+  delete read;
+  mConcurrentReads.erase( readIt );
+}
@@ -75,16 +75,44 @@ class CORE_EXPORT QgsRasterIterator
     void setMaximumTileHeight( int h ) { mMaximumTileHeight = h; }
     int maximumTileHeight() const { return mMaximumTileHeight; }
 
+    /**Sets the number of parts read at the same time. With more than one thread the parts
+      are read in the global thread pool, each thread with its own copy of the interfaces
+      above the data provider, and readNextRasterPart returns them in the same order as
+      without threads. This is only done if the data provider has the ThreadedRead
+      capability, no reprojection is needed (the projector uses threads itself) and no
+      renderer has a user defined contrast enhancement function, which cannot be copied.
+      Data provider blocks are still read one at a time.
+      @note added in 2.0 */
+    void setMaximumThreadCount( int count ) { mMaximumThreadCount = count; }
+    int maximumThreadCount() const { return mMaximumThreadCount; }
+
   private:
+    struct ConcurrentRead;
+
     QgsRasterInterface* mInput;
     QMap<int, RasterPartInfo> mRasterPartInfos;
+    QMap<int, ConcurrentRead*> mConcurrentReads;
     QgsRectangle mExtent;
 
     int mMaximumTileWidth;
     int mMaximumTileHeight;
+    int mMaximumThreadCount;
 
     /**Remove part into and release memory*/
     void removePartInfo( int bandNumber );
+
+    /**Advance to the next part of the band
+      @return false if the last part was already returned*/
+    bool nextPart( RasterPartInfo& pInfo, int tileHeight, int& nCols, int& nRows, int& topLeftCol, int& topLeftRow, QgsRectangle& blockRect );
+
+    /**Copy the interfaces above the data provider for concurrent reading, 0 if the parts have to be read serially*/
+    ConcurrentRead* createConcurrentRead( int nCols, int nRows );
+
+    /**Wait for the parts being read and delete the copies of the interfaces*/
+    void removeConcurrentRead( int bandNumber );
+
+    /**Start reading the next part of the band in a thread of the pool*/
+    void queuePart( int bandNumber, RasterPartInfo& pInfo, ConcurrentRead* read, int copy );
 };
 
 #endif // QGSRASTERITERATOR_H
@@ -1846,6 +1846,7 @@ void QgsRasterLayer::setContrastEnhancementAlgorithm( QgsContrastEnhancement::Co
     if ( myEnhancements.value( 1 ) ) myMultiBandRenderer->setGreenContrastEnhancement( myEnhancements.value( 1 ) );
     if ( myEnhancements.value( 2 ) ) myMultiBandRenderer->setBlueContrastEnhancement( myEnhancements.value( 2 ) );
   }
+  mPipe.clearBlockCache( mPipe.renderer() );
 }
 
 void QgsRasterLayer::setContrastEnhancementAlgorithm( QString theAlgorithm, bool theGenerateLookupTableFlag )
@@ -2103,6 +2104,19 @@ void QgsRasterLayer::setRenderer( QgsRasterRenderer* theRenderer )
   mPipe.set( theRenderer );
 }
 
+void QgsRasterLayer::setBlockCacheEnabled( bool enabled )
+{
+  QgsRasterBlockCache* cache = mPipe.blockCache();
+  if ( enabled && !cache )
+  {
+    mPipe.set( new QgsRasterBlockCache() );
+  }
+  else if ( !enabled && cache )
+  {
+    mPipe.remove( cache );
+  }
+}
+
 #if 0
 // not sure if we want it
 void QgsRasterLayer::setResampleFilter( QgsRasterResampleFilter* resampleFilter )
@@ -2224,6 +2238,7 @@ void QgsRasterLayer::thumbnailAsImage( QImage * thepImage )
 
 void QgsRasterLayer::triggerRepaint()
 {
+  mPipe.clearBlockCache();
   emit repaintRequested();
 }
 
@@ -362,6 +362,12 @@ class CORE_EXPORT QgsRasterLayer : public QgsMapLayer
     //void setResampleFilter( QgsRasterResampleFilter* resampleFilter );
     QgsRasterResampleFilter * resampleFilter() const { return mPipe.resampleFilter(); }
 
+    /** \brief Keep the blocks read from the provider in memory, e.g. for tiled WMS requests.
+     * The cache is cleared when the layer is changed, see triggerRepaint().
+     * @note added in 2.0 */
+    void setBlockCacheEnabled( bool enabled );
+    bool blockCacheEnabled() const { return mPipe.blockCache() != 0; }
+
     /** Get raster pipe */
     QgsRasterPipe * pipe() { return &mPipe; }
 
@@ -553,7 +559,8 @@ class CORE_EXPORT QgsRasterLayer : public QgsMapLayer
     /** \brief Draws a preview of the rasterlayer into a pixmap */
     QPixmap previewAsPixmap( QSize size, QColor bgColor = Qt::white );
 
-    /** \brief Emit a signal asking for a repaint. (inherited from maplayer) */
+    /** \brief Emit a signal asking for a repaint. (inherited from maplayer)
+     * The block cache is cleared, as the settings of the provider or the renderer may have changed */
     void triggerRepaint();
 
     //
@@ -32,6 +32,7 @@ QgsRasterInterface * QgsRasterNuller::clone() const
   QgsDebugMsg( "Entered" );
   QgsRasterNuller * nuller = new QgsRasterNuller( 0 );
   nuller->mNoData = mNoData;
+  nuller->mOutputNoData = mOutputNoData;
   return nuller;
 }
 
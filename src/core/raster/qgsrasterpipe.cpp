@@ -86,7 +86,9 @@ bool QgsRasterPipe::insert( int idx, QgsRasterInterface* theInterface )
   {
     success = true;
     mInterfaces.insert( idx, theInterface );
-    setRole( theInterface, idx );
+    // the interfaces after idx moved
+    updateRoles();
+    clearBlockCacheAfter( idx );
     QgsDebugMsg( "inserted ok" );
   }
 
@@ -112,7 +114,8 @@ bool QgsRasterPipe::replace( int idx, QgsRasterInterface* theInterface )
     success = true;
     delete mInterfaces[idx];
     mInterfaces[idx] = theInterface;
-    setRole( theInterface, idx );
+    updateRoles();
+    clearBlockCacheAfter( idx );
     QgsDebugMsg( "replaced ok" );
   }
 
@@ -129,6 +132,7 @@ QgsRasterPipe::Role QgsRasterPipe::interfaceRole( QgsRasterInterface * interface
   else if ( dynamic_cast<QgsRasterResampleFilter *>( interface ) ) role = ResamplerRole;
   else if ( dynamic_cast<QgsRasterProjector *>( interface ) ) role = ProjectorRole;
   else if ( dynamic_cast<QgsRasterNuller *>( interface ) ) role = NullerRole;
+  else if ( dynamic_cast<QgsRasterBlockCache *>( interface ) ) role = CacheRole;
 
   QgsDebugMsg( QString( "%1 role = %2" ).arg( typeid( *interface ).name() ).arg( role ) );
   return role;
@@ -141,6 +145,15 @@ void QgsRasterPipe::setRole( QgsRasterInterface * theInterface, int idx )
   mRoleMap.insert( role, idx );
 }
 
+void QgsRasterPipe::updateRoles()
+{
+  mRoleMap.clear();
+  for ( int i = 0; i < mInterfaces.size(); i++ )
+  {
+    setRole( mInterfaces[i], i );
+  }
+}
+
 void QgsRasterPipe::unsetRole( QgsRasterInterface * theInterface )
 {
   Role role = interfaceRole( theInterface );
@@ -174,6 +187,7 @@ bool QgsRasterPipe::set( QgsRasterInterface* theInterface )
   //   QgsRasterRenderer      - RendererRole
   //   QgsRasterResampler     - ResamplerRole
   //   QgsRasterProjector     - ProjectorRole
+  //   QgsRasterBlockCache    - CacheRole
 
   int providerIdx = mRoleMap.value( ProviderRole, -1 );
   int rendererIdx = mRoleMap.value( RendererRole, -1 );
@@ -195,6 +209,10 @@ bool QgsRasterPipe::set( QgsRasterInterface* theInterface )
   {
     idx =  qMax( qMax( providerIdx, rendererIdx ), resamplerIdx ) + 1;
   }
+  else if ( role == CacheRole )
+  {
+    idx =  providerIdx + 1;
+  }
 
   return insert( idx, theInterface );  // insert may still fail and return false
 }
@@ -234,6 +252,26 @@ QgsRasterNuller * QgsRasterPipe::nuller() const
   return dynamic_cast<QgsRasterNuller*>( interface( NullerRole ) );
 }
 
+QgsRasterBlockCache * QgsRasterPipe::blockCache() const
+{
+  return dynamic_cast<QgsRasterBlockCache*>( interface( CacheRole ) );
+}
+
+void QgsRasterPipe::clearBlockCache( QgsRasterInterface * theInterface )
+{
+  clearBlockCacheAfter( theInterface ? mInterfaces.indexOf( theInterface ) : -1 );
+}
+
+void QgsRasterPipe::clearBlockCacheAfter( int idx )
+{
+  // the blocks depend on the interfaces before the cache only
+  int cacheIdx = mRoleMap.value( CacheRole, -1 );
+  if ( cacheIdx > idx )
+  {
+    blockCache()->clear();
+  }
+}
+
 bool QgsRasterPipe::remove( int idx )
 {
   QgsDebugMsg( QString( "remove at %1" ).arg( idx ) );
@@ -249,9 +287,11 @@ bool QgsRasterPipe::remove( int idx )
   if ( connect( interfaces ) )
   {
     success = true;
-    unsetRole( mInterfaces[idx] );
     delete mInterfaces[idx];
     mInterfaces.remove( idx );
+    // the interfaces after idx moved
+    updateRoles();
+    clearBlockCacheAfter( idx - 1 );
     QgsDebugMsg( "removed ok" );
   }
 
@@ -298,7 +338,11 @@ bool QgsRasterPipe::setOn( int idx, bool on )
 
   mInterfaces[idx]->setOn( on );
 
-  if ( connect( mInterfaces ) ) return true;
+  if ( connect( mInterfaces ) )
+  {
+    clearBlockCacheAfter( idx );
+    return true;
+  }
 
   mInterfaces[idx]->setOn( onOrig );
   connect( mInterfaces );
@@ -28,6 +28,7 @@
 #include "qgsrasternuller.h"
 #include "qgsrasterrenderer.h"
 #include "qgsrasterprojector.h"
+#include "qgsrasterblockcache.h"
 
 #if defined(Q_OS_WIN)
 #undef interface
@@ -48,6 +49,7 @@ class CORE_EXPORT QgsRasterPipe
       ResamplerRole = 3,
       ProjectorRole = 4,
       NullerRole = 5,
+      CacheRole = 6
     };
 
     QgsRasterPipe();
@@ -65,9 +67,11 @@ class CORE_EXPORT QgsRasterPipe
 
     /** Insert a new known interface in default place or replace interface of the same
      * role if it already exists. Known interfaces are: QgsRasterDataProvider,
-     * QgsRasterRenderer, QgsRasterResampleFilter, QgsRasterProjector and their
-     * subclasses. For unknown interfaces it mus be explicitly specified position
-     * where it should be inserted using insert() method.
+     * QgsRasterRenderer, QgsRasterResampleFilter, QgsRasterProjector,
+     * QgsRasterBlockCache and their subclasses. For unknown interfaces it mus be
+     * explicitly specified position where it should be inserted using insert() method.
+     * The block cache is placed right after the provider, so that the settings of
+     * the renderer may be changed without clearing it.
      */
     bool set( QgsRasterInterface * theInterface );
 
@@ -94,6 +98,14 @@ class CORE_EXPORT QgsRasterPipe
     QgsRasterResampleFilter * resampleFilter() const;
     QgsRasterProjector * projector() const;
     QgsRasterNuller * nuller() const;
+    /** @note added in 2.0 */
+    QgsRasterBlockCache * blockCache() const;
+
+    /** Drop the blocks of the block cache if it is after the given interface, or in any
+     * case if no interface is given. Must be called when an interface is modified in place,
+     * e.g. the contrast enhancement of the renderer
+     * @note added in 2.0 */
+    void clearBlockCache( QgsRasterInterface * theInterface = 0 );
 
     /** Set on/off collection of statistics */
     //void setStatsOn( bool on ) { if ( last() ) last()->setStatsOn( on ); }
@@ -113,6 +125,12 @@ class CORE_EXPORT QgsRasterPipe
     // Unset role in mRoleMap
     void unsetRole( QgsRasterInterface * theInterface );
 
+    // Set the roles of all interfaces in mRoleMap
+    void updateRoles();
+
+    // Clear the block cache if it is after the interface at index
+    void clearBlockCacheAfter( int idx );
+
     // Check if index is in bounds
     bool checkBounds( int idx ) const;
 
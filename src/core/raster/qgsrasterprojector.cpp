@@ -20,6 +20,33 @@
 #include "qgsrasterprojector.h"
 #include "qgscoordinatetransform.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+
+// range of destination rows reprojected by one thread in QgsRasterProjector::block()
+struct QgsRasterProjectorRowRange
+{
+  const QgsRasterProjector *projector;
+  const QgsPoint *helpers; // helper points of all matrix rows, 0 for precise reprojection
+  const char *srcData;
+  char *destData;
+  int pixelSize;
+  int firstRow;
+  int lastRow; // exclusive
+};
+
+// copy the pixels of one destination row, T has the size of the pixel
+template <typename T>
+static inline void copyPixels( const char *theSrcData, char *theDestData, const size_t *theSrcIndexes, int theCount )
+{
+  const T *mySrc = reinterpret_cast<const T *>( theSrcData );
+  T *myDest = reinterpret_cast<T *>( theDestData );
+  for ( int i = 0; i < theCount; ++i )
+  {
+    myDest[i] = mySrc[ theSrcIndexes[i] ];
+  }
+}
+
 QgsRasterProjector::QgsRasterProjector(
   QgsCoordinateReferenceSystem theSrcCRS,
   QgsCoordinateReferenceSystem theDestCRS,
@@ -366,17 +393,17 @@ void QgsRasterProjector::calcSrcRowsCols()
 }
 
 
-inline void QgsRasterProjector::destPointOnCPMatrix( int theRow, int theCol, double *theX, double *theY )
+inline void QgsRasterProjector::destPointOnCPMatrix( int theRow, int theCol, double *theX, double *theY ) const
 {
   *theX = mDestExtent.xMinimum() + theCol * mDestExtent.width() / ( mCPCols - 1 );
   *theY = mDestExtent.yMaximum() - theRow * mDestExtent.height() / ( mCPRows - 1 );
 }
 
-inline int QgsRasterProjector::matrixRow( int theDestRow )
+inline int QgsRasterProjector::matrixRow( int theDestRow ) const
 {
   return ( int )( floor(( theDestRow + 0.5 ) / mDestRowsPerMatrixRow ) );
 }
-inline int QgsRasterProjector::matrixCol( int theDestCol )
+inline int QgsRasterProjector::matrixCol( int theDestCol ) const
 {
   return ( int )( floor(( theDestCol + 0.5 ) / mDestColsPerMatrixCol ) );
 }
@@ -388,7 +415,7 @@ QgsPoint QgsRasterProjector::srcPoint( int theDestRow, int theCol )
   return QgsPoint();
 }
 
-void QgsRasterProjector::calcHelper( int theMatrixRow, QgsPoint *thePoints )
+void QgsRasterProjector::calcHelper( int theMatrixRow, QgsPoint *thePoints ) const
 {
   // TODO?: should we also precalc dest cell center coordinates for x and y?
   for ( int myDestCol = 0; myDestCol < mDestCols; myDestCol++ )
@@ -404,8 +431,8 @@ void QgsRasterProjector::calcHelper( int theMatrixRow, QgsPoint *thePoints )
 
     double xfrac = ( myDestX - myDestXMin ) / ( myDestXMax - myDestXMin );
 
-    QgsPoint &mySrcPoint0 = mCPMatrix[theMatrixRow][myMatrixCol];
-    QgsPoint &mySrcPoint1 = mCPMatrix[theMatrixRow][myMatrixCol+1];
+    const QgsPoint &mySrcPoint0 = mCPMatrix[theMatrixRow][myMatrixCol];
+    const QgsPoint &mySrcPoint1 = mCPMatrix[theMatrixRow][myMatrixCol+1];
     double s = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
     double t = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
 
@@ -532,6 +559,100 @@ void QgsRasterProjector::approximateSrcRowCol( int theDestRow, int theDestCol, i
   Q_ASSERT( *theSrcCol < mSrcCols );
 }
 
+void QgsRasterProjector::approximateSrcIndexes( int theDestRow, const QgsPoint *theHelpers, size_t *theSrcIndexes ) const
+{
+  int myMatrixRow = matrixRow( theDestRow );
+  const QgsPoint *myTop = theHelpers + ( size_t ) myMatrixRow * mDestCols;
+  const QgsPoint *myBot = myTop + mDestCols;
+
+  // the interpolation factor between the helper rows is the same for the whole row
+  double myDestY = mDestExtent.yMaximum() - ( theDestRow + 0.5 ) * mDestYRes;
+  double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
+  destPointOnCPMatrix( myMatrixRow + 1, 0, &myDestXMin, &myDestYMin );
+  destPointOnCPMatrix( myMatrixRow, 0, &myDestXMax, &myDestYMax );
+  double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
+
+  double mySrcYMax = mSrcExtent.yMaximum();
+  double mySrcXMin = mSrcExtent.xMinimum();
+
+  for ( int myDestCol = 0; myDestCol < mDestCols; ++myDestCol )
+  {
+    double bx = myBot[myDestCol].x();
+    double by = myBot[myDestCol].y();
+    double mySrcX = bx + ( myTop[myDestCol].x() - bx ) * yfrac;
+    double mySrcY = by + ( myTop[myDestCol].y() - by ) * yfrac;
+
+    // same limits correction as in approximateSrcRowCol()
+    int mySrcRow = qBound( 0, ( int ) floor(( mySrcYMax - mySrcY ) / mSrcYRes ), mSrcRows - 1 );
+    int mySrcCol = qBound( 0, ( int ) floor(( mySrcX - mySrcXMin ) / mSrcXRes ), mSrcCols - 1 );
+    theSrcIndexes[myDestCol] = ( size_t ) mySrcRow * mSrcCols + mySrcCol;
+  }
+}
+
+void QgsRasterProjector::preciseSrcIndexes( int theDestRow, size_t *theSrcIndexes ) const
+{
+  // transform the centers of all the row cells at once
+  QVector<double> x( mDestCols );
+  QVector<double> y( mDestCols, mDestExtent.yMaximum() - ( theDestRow + 0.5 ) * mDestYRes );
+  QVector<double> z( mDestCols, 0.0 );
+  for ( int myDestCol = 0; myDestCol < mDestCols; ++myDestCol )
+  {
+    x[myDestCol] = mDestExtent.xMinimum() + ( myDestCol + 0.5 ) * mDestXRes;
+  }
+
+  mCoordinateTransform.transformInPlace( x, y, z );
+
+  double mySrcYMax = mSrcExtent.yMaximum();
+  double mySrcXMin = mSrcExtent.xMinimum();
+
+  for ( int myDestCol = 0; myDestCol < mDestCols; ++myDestCol )
+  {
+    // same limits correction as in preciseSrcRowCol()
+    int mySrcRow = qBound( 0, ( int ) floor(( mySrcYMax - y[myDestCol] ) / mSrcYRes ), mSrcRows - 1 );
+    int mySrcCol = qBound( 0, ( int ) floor(( x[myDestCol] - mySrcXMin ) / mSrcXRes ), mSrcCols - 1 );
+    theSrcIndexes[myDestCol] = ( size_t ) mySrcRow * mSrcCols + mySrcCol;
+  }
+}
+
+void QgsRasterProjector::projectRows( QgsRasterProjectorRowRange &theRange )
+{
+  const QgsRasterProjector *myProjector = theRange.projector;
+  int myCols = myProjector->mDestCols;
+  int myPixelSize = theRange.pixelSize;
+  QVector<size_t> mySrcIndexes( myCols );
+
+  for ( int myRow = theRange.firstRow; myRow < theRange.lastRow; ++myRow )
+  {
+    if ( theRange.helpers )
+      myProjector->approximateSrcIndexes( myRow, theRange.helpers, mySrcIndexes.data() );
+    else
+      myProjector->preciseSrcIndexes( myRow, mySrcIndexes.data() );
+
+    char *myDest = theRange.destData + ( size_t ) myRow * myCols * myPixelSize;
+    switch ( myPixelSize )
+    {
+      case 1:
+        copyPixels<quint8>( theRange.srcData, myDest, mySrcIndexes.constData(), myCols );
+        break;
+      case 2:
+        copyPixels<quint16>( theRange.srcData, myDest, mySrcIndexes.constData(), myCols );
+        break;
+      case 4:
+        copyPixels<quint32>( theRange.srcData, myDest, mySrcIndexes.constData(), myCols );
+        break;
+      case 8:
+        copyPixels<quint64>( theRange.srcData, myDest, mySrcIndexes.constData(), myCols );
+        break;
+      default:
+        for ( int myCol = 0; myCol < myCols; ++myCol )
+        {
+          memcpy( myDest + ( size_t ) myCol * myPixelSize, theRange.srcData + mySrcIndexes[myCol] * myPixelSize, myPixelSize );
+        }
+        break;
+    }
+  }
+}
+
 void QgsRasterProjector::insertRows()
 {
   for ( int r = 0; r < mCPRows - 1; r++ )
@@ -748,32 +869,51 @@ QgsRasterBlock * QgsRasterProjector::block( int bandNo, QgsRectangle  const & ex
 
   // TODO: fill by no data or transparent
 
-  int srcRow, srcCol;
-  for ( int i = 0; i < height; ++i )
+  // Helper points of all the matrix rows, so that each destination row
+  // can be reprojected independently of the others
+  QVector<QgsPoint> myHelpers;
+  if ( mApproximate )
   {
-    for ( int j = 0; j < width; ++j )
+    myHelpers.resize( mCPRows * mDestCols );
+    for ( int myMatrixRow = 0; myMatrixRow < mCPRows; myMatrixRow++ )
     {
-      srcRowCol( i, j, &srcRow, &srcCol );
-      QgsDebugMsgLevel( QString( "row = %1 col = %2 srcRow = %3 srcCol = %4" ).arg( i ).arg( j ).arg( srcRow ).arg( srcCol ), 5 );
-      size_t srcIndex = srcRow * mSrcCols + srcCol;
-      size_t destIndex = i * width + j;
-
-      char *srcBits = inputBlock->bits( srcIndex );
-      char *destBits = outputBlock->bits( destIndex );
-      if ( !srcBits )
-      {
-        QgsDebugMsg( "Cannot get input block data." );
-        continue;
-      }
-      if ( !destBits )
-      {
-        QgsDebugMsg( "Cannot set output block data." );
-        continue;
-      }
-      memcpy( destBits, srcBits, pixelSize );
+      calcHelper( myMatrixRow, myHelpers.data() + ( size_t ) myMatrixRow * mDestCols );
     }
   }
 
+  // Split the rows between threads for larger blocks. Precise reprojection
+  // stays in this thread, proj is not safe to use from several threads.
+  int myRangeCount = 1;
+  if ( mApproximate && ( size_t ) width * height >= 256 * 256 )
+  {
+    myRangeCount = qMin( QThread::idealThreadCount() * 4, height / 16 );
+  }
+  myRangeCount = qMax( myRangeCount, 1 );
+
+  QList<QgsRasterProjectorRowRange> myRanges;
+  int myRowsPerRange = ( height + myRangeCount - 1 ) / myRangeCount;
+  for ( int myFirstRow = 0; myFirstRow < height; myFirstRow += myRowsPerRange )
+  {
+    QgsRasterProjectorRowRange myRange;
+    myRange.projector = this;
+    myRange.helpers = mApproximate ? myHelpers.constData() : 0;
+    myRange.srcData = static_cast<const char *>( inputBlock->data() );
+    myRange.destData = static_cast<char *>( outputBlock->data() );
+    myRange.pixelSize = pixelSize;
+    myRange.firstRow = myFirstRow;
+    myRange.lastRow = qMin( myFirstRow + myRowsPerRange, height );
+    myRanges.append( myRange );
+  }
+
+  if ( myRanges.size() > 1 )
+  {
+    QtConcurrent::blockingMap( myRanges, projectRows );
+  }
+  else if ( !myRanges.isEmpty() )
+  {
+    projectRows( myRanges[0] );
+  }
+
   delete inputBlock;
 
   return outputBlock;
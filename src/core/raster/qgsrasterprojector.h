@@ -34,6 +34,7 @@
 #include <cmath>
 
 class QgsPoint;
+struct QgsRasterProjectorRowRange;
 
 class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 {
@@ -106,11 +107,11 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
   private:
     /** \brief get destination point for _current_ destination position */
-    void destPointOnCPMatrix( int theRow, int theCol, double *theX, double *theY );
+    void destPointOnCPMatrix( int theRow, int theCol, double *theX, double *theY ) const;
 
     /** \brief Get matrix upper left row/col indexes for destination row/col */
-    int matrixRow( int theDestRow );
-    int matrixCol( int theDestCol );
+    int matrixRow( int theDestRow ) const;
+    int matrixCol( int theDestCol ) const;
 
     /** \brief get destination point for _current_ matrix position */
     QgsPoint srcPoint( int theRow, int theCol );
@@ -154,7 +155,17 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
     bool checkRows();
 
     /** Calculate array of src helper points */
-    void calcHelper( int theMatrixRow, QgsPoint *thePoints );
+    void calcHelper( int theMatrixRow, QgsPoint *thePoints ) const;
+
+    /** \brief Get source pixel indexes for all columns of a destination row.
+     * Approximate mode reads the helper points of all matrix rows (mCPRows x mDestCols)
+     * from theHelpers instead of the sequential top/bottom helpers, so that rows may be
+     * processed in any order and from several threads. */
+    void approximateSrcIndexes( int theDestRow, const QgsPoint *theHelpers, size_t *theSrcIndexes ) const;
+    void preciseSrcIndexes( int theDestRow, size_t *theSrcIndexes ) const;
+
+    /** \brief Copy the source pixels to a range of destination rows */
+    static void projectRows( QgsRasterProjectorRowRange &theRange );
 
     /** Calc / switch helper */
     void nextHelper();
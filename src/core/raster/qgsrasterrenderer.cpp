@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsrasterrenderer.h"
+#include "qgscontrastenhancement.h"
 #include "qgsrasterresampler.h"
 #include "qgsrasterprojector.h"
 #include "qgsrastertransparency.h"
@@ -91,6 +92,168 @@ bool QgsRasterRenderer::setInput( QgsRasterInterface* input )
   return true;
 }
 
+// The kernels below work on plain arrays of one data type so that the compiler can vectorize them
+
+template <typename T>
+static void integerDisplayValues( const T* data, double noDataValue, const int* table, int tableOffset, size_t count, int* values )
+{
+  if ( table )
+  {
+    for ( size_t i = 0; i < count; i++ )
+    {
+      values[i] = ( double )data[i] == noDataValue ? -1 : table[( int )data[i] + tableOffset];
+    }
+  }
+  else
+  {
+    for ( size_t i = 0; i < count; i++ )
+    {
+      values[i] = ( double )data[i] == noDataValue ? -1 : ( int )data[i] & 0xff;
+    }
+  }
+}
+
+template <typename T>
+static void genericDisplayValues( const T* data, double noDataValue, QgsContrastEnhancement* contrastEnhancement, size_t count, int* values )
+{
+  for ( size_t i = 0; i < count; i++ )
+  {
+    double value = data[i];
+    if ( qIsNaN( value ) || doubleNear( value, noDataValue ) )
+    {
+      values[i] = -1;
+    }
+    else if ( !contrastEnhancement )
+    {
+      values[i] = ( int )value & 0xff;
+    }
+    else if ( contrastEnhancement->isValueInDisplayableRange( value ) )
+    {
+      values[i] = contrastEnhancement->enhanceContrast( value );
+    }
+    else
+    {
+      values[i] = -1;
+    }
+  }
+}
+
+template <typename T>
+static void displayValuesOfType( const T* data, double noDataValue, QgsContrastEnhancement* contrastEnhancement,
+                                 bool hasTable, size_t count, int* values )
+{
+  if ( !contrastEnhancement )
+  {
+    integerDisplayValues( data, noDataValue, 0, 0, count, values );
+  }
+  else if ( hasTable )
+  {
+    const int* table = contrastEnhancement->displayLookupTable();
+    int tableOffset = -( int )QgsContrastEnhancement::minimumValuePossible( contrastEnhancement->rasterDataType() );
+    integerDisplayValues( data, noDataValue, table, tableOffset, count, values );
+  }
+  else
+  {
+    genericDisplayValues( data, noDataValue, contrastEnhancement, count, values );
+  }
+}
+
+template <typename T>
+static void typedValues( const T* data, double noDataValue, size_t count, double* values )
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for ( size_t i = 0; i < count; i++ )
+  {
+    double value = data[i];
+    values[i] = ( qIsNaN( value ) || doubleNear( value, noDataValue ) ) ? nan : value;
+  }
+}
+
+void QgsRasterRenderer::displayValues( QgsRasterBlock* block, QgsContrastEnhancement* contrastEnhancement, size_t index, size_t count, int* values )
+{
+  const void* data = block->bits( index );
+  if ( !data || count == 0 )
+  {
+    for ( size_t i = 0; i < count; i++ )
+      values[i] = -1;
+    return;
+  }
+
+  // the lookup table is only valid if the block has the data type the contrast enhancement was made for
+  bool hasTable = contrastEnhancement && ( int )contrastEnhancement->rasterDataType() == ( int )block->dataType()
+                  && contrastEnhancement->displayLookupTable();
+  double noDataValue = block->noDataValue();
+
+  switch ( block->dataType() )
+  {
+    case QGis::Byte:
+      displayValuesOfType(( const quint8* )data, noDataValue, contrastEnhancement, hasTable, count, values );
+      break;
+    case QGis::UInt16:
+      displayValuesOfType(( const quint16* )data, noDataValue, contrastEnhancement, hasTable, count, values );
+      break;
+    case QGis::Int16:
+      displayValuesOfType(( const qint16* )data, noDataValue, contrastEnhancement, hasTable, count, values );
+      break;
+    case QGis::UInt32:
+      displayValuesOfType(( const quint32* )data, noDataValue, contrastEnhancement, false, count, values );
+      break;
+    case QGis::Int32:
+      displayValuesOfType(( const qint32* )data, noDataValue, contrastEnhancement, false, count, values );
+      break;
+    case QGis::Float32:
+      genericDisplayValues(( const float* )data, noDataValue, contrastEnhancement, count, values );
+      break;
+    case QGis::Float64:
+      genericDisplayValues(( const double* )data, noDataValue, contrastEnhancement, count, values );
+      break;
+    default:
+      for ( size_t i = 0; i < count; i++ )
+        values[i] = -1;
+      break;
+  }
+}
+
+void QgsRasterRenderer::readValues( QgsRasterBlock* block, double noDataValue, size_t index, size_t count, double* values )
+{
+  const void* data = block->bits( index );
+  if ( !data || count == 0 )
+  {
+    for ( size_t i = 0; i < count; i++ )
+      values[i] = std::numeric_limits<double>::quiet_NaN();
+    return;
+  }
+
+  switch ( block->dataType() )
+  {
+    case QGis::Byte:
+      typedValues(( const quint8* )data, noDataValue, count, values );
+      break;
+    case QGis::UInt16:
+      typedValues(( const quint16* )data, noDataValue, count, values );
+      break;
+    case QGis::Int16:
+      typedValues(( const qint16* )data, noDataValue, count, values );
+      break;
+    case QGis::UInt32:
+      typedValues(( const quint32* )data, noDataValue, count, values );
+      break;
+    case QGis::Int32:
+      typedValues(( const qint32* )data, noDataValue, count, values );
+      break;
+    case QGis::Float32:
+      typedValues(( const float* )data, noDataValue, count, values );
+      break;
+    case QGis::Float64:
+      typedValues(( const double* )data, noDataValue, count, values );
+      break;
+    default:
+      for ( size_t i = 0; i < count; i++ )
+        values[i] = std::numeric_limits<double>::quiet_NaN();
+      break;
+  }
+}
+
 bool QgsRasterRenderer::usesTransparency( ) const
 {
   if ( !mInput )
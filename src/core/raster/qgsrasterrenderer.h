@@ -25,6 +25,7 @@
 #include "cpl_conv.h"
 
 class QPainter;
+class QgsContrastEnhancement;
 class QgsMapToPixel;
 class QgsRasterResampler;
 class QgsRasterProjector;
@@ -114,6 +115,19 @@ class CORE_EXPORT QgsRasterRenderer : public QgsRasterInterface
     /**Write upper class info into rasterrenderer element (called by writeXML method of subclasses)*/
     void _writeXML( QDomDocument& doc, QDomElement& rasterRendererElem ) const;
 
+    /**Convert count values of a block from index on to color components 0 - 255. No data values and values outside
+      of the displayable range of the contrast enhancement are -1. Without contrast enhancement the values are
+      truncated to their lowest byte, like qRgba() does. 8 and 16 bit values go through the lookup table of the
+      contrast enhancement.
+      @note added in 2.0
+      @note not available in python bindings */
+    static void displayValues( QgsRasterBlock* block, QgsContrastEnhancement* contrastEnhancement, size_t index, size_t count, int* values );
+
+    /**Read count values of a block from index on, no data values are NaN.
+      @note added in 2.0
+      @note not available in python bindings */
+    static void readValues( QgsRasterBlock* block, double noDataValue, size_t index, size_t count, double* values );
+
     QString mType;
 
     /**Global alpha value (0-1)*/
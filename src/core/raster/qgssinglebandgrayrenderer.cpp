@@ -21,6 +21,7 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
+#include <QVector>
 
 QgsSingleBandGrayRenderer::QgsSingleBandGrayRenderer( QgsRasterInterface* input, int grayBand ):
     QgsRasterRenderer( input, "singlebandgray" ), mGrayBand( grayBand ), mGradient( BlackToWhite ), mContrastEnhancement( 0 )
@@ -124,48 +125,55 @@ QgsRasterBlock* QgsSingleBandGrayRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   QRgb myDefaultColor = NODATA_COLOR;
-  for ( size_t i = 0; i < ( size_t )width*height; i++ )
+  bool invert = mGradient == WhiteToBlack;
+  bool opaque = !usesTransparency();
+  QRgb* outputColors = ( QRgb* )outputBlock->bits(( size_t )0 );
+  QVector<int> grayValues( width );
+
+  for ( int row = 0; row < height; row++ )
   {
-    double grayVal = inputBlock->value( i );
+    size_t rowStart = ( size_t )row * width;
+    displayValues( inputBlock, mContrastEnhancement, rowStart, width, grayValues.data() );
+    const int* grayRow = grayValues.constData();
+    QRgb* colorRow = outputColors + rowStart;
 
-    if ( inputBlock->isNoDataValue( grayVal ) )
+    if ( opaque )
     {
-      outputBlock->setColor( i, myDefaultColor );
+      for ( int col = 0; col < width; col++ )
+      {
+        int grayVal = invert ? 255 - grayRow[col] : grayRow[col];
+        colorRow[col] = grayRow[col] < 0 ? myDefaultColor : qRgba( grayVal, grayVal, grayVal, 255 );
+      }
       continue;
     }
 
-    double currentAlpha = mOpacity;
-    if ( mRasterTransparency )
+    for ( int col = 0; col < width; col++ )
     {
-      currentAlpha = mRasterTransparency->alphaValue( grayVal, mOpacity * 255 ) / 255.0;
-    }
-    if ( mAlphaBand > 0 )
-    {
-      currentAlpha *= alphaBlock->value( i ) / 255.0;
-    }
-
-    if ( mContrastEnhancement )
-    {
-      if ( !mContrastEnhancement->isValueInDisplayableRange( grayVal ) )
+      if ( grayRow[col] < 0 )
       {
-        outputBlock->setColor( i, myDefaultColor );
+        colorRow[col] = myDefaultColor;
         continue;
       }
-      grayVal = mContrastEnhancement->enhanceContrast( grayVal );
-    }
 
-    if ( mGradient == WhiteToBlack )
-    {
-      grayVal = 255 - grayVal;
-    }
+      double currentAlpha = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentAlpha = mRasterTransparency->alphaValue( inputBlock->value( rowStart + col ), mOpacity * 255 ) / 255.0;
+      }
+      if ( mAlphaBand > 0 )
+      {
+        currentAlpha *= alphaBlock->value( rowStart + col ) / 255.0;
+      }
 
-    if ( doubleNear( currentAlpha, 1.0 ) )
-    {
-      outputBlock->setColor( i, qRgba( grayVal, grayVal, grayVal, 255 ) );
-    }
-    else
-    {
-      outputBlock->setColor( i, qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 ) );
+      int grayVal = invert ? 255 - grayRow[col] : grayRow[col];
+      if ( doubleNear( currentAlpha, 1.0 ) )
+      {
+        colorRow[col] = qRgba( grayVal, grayVal, grayVal, 255 );
+      }
+      else
+      {
+        colorRow[col] = qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 );
+      }
     }
   }
 
@@ -16,12 +16,55 @@
  ***************************************************************************/
 
 #include "qgssinglebandpseudocolorrenderer.h"
+#include "qgsfreakoutshader.h"
+#include "qgspseudocolorshader.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
+#include <QVector>
+
+// Shades integer data through a table with the color of each value between the minimum
+// and the maximum of the block, so that the shader is called once per distinct value
+// instead of once per pixel. Returns false if the table would have more entries than the block.
+template <typename T>
+static bool shadeIntegerBlock( const T* data, size_t count, double noDataValue, QgsRasterShader* shader, QRgb noDataColor, QRgb* colors )
+{
+  if ( !data || count == 0 )
+    return false;
+
+  T minValue = data[0];
+  T maxValue = data[0];
+  for ( size_t i = 1; i < count; i++ )
+  {
+    if ( data[i] < minValue )
+      minValue = data[i];
+    if ( data[i] > maxValue )
+      maxValue = data[i];
+  }
+
+  qint64 tableSize = ( qint64 )maxValue - ( qint64 )minValue + 1;
+  if ( tableSize > ( qint64 )count )
+    return false;
+
+  QVector<QRgb> table( tableSize );
+  for ( qint64 i = 0; i < tableSize; i++ )
+  {
+    double value = ( double )minValue + i;
+    int red, green, blue;
+    if ( doubleNear( value, noDataValue ) || !shader->shade( value, &red, &green, &blue ) )
+      table[i] = noDataColor;
+    else
+      table[i] = qRgba( red, green, blue, 255 );
+  }
+
+  const QRgb* lookup = table.constData();
+  for ( size_t i = 0; i < count; i++ )
+    colors[i] = lookup[data[i] - minValue];
+  return true;
+}
 
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface* input, int band, QgsRasterShader* shader ):
     QgsRasterRenderer( input, "singlebandpseudocolor" )
@@ -56,14 +99,26 @@ QgsRasterInterface * QgsSingleBandPseudoColorRenderer::clone() const
       colorRampShader->setColorRampType( origColorRampShader->colorRampType() );
 
       colorRampShader->setColorRampItemList( origColorRampShader->colorRampItemList() );
+      colorRampShader->setClip( origColorRampShader->clip() );
       shader->setRasterShaderFunction( colorRampShader );
     }
+    else if ( dynamic_cast<const QgsPseudoColorShader*>( mShader->rasterShaderFunction() ) )
+    {
+      shader->setRasterShaderFunction( new QgsPseudoColorShader( mShader->minimumValue(), mShader->maximumValue() ) );
+    }
+    else if ( dynamic_cast<const QgsFreakOutShader*>( mShader->rasterShaderFunction() ) )
+    {
+      shader->setRasterShaderFunction( new QgsFreakOutShader( mShader->minimumValue(), mShader->maximumValue() ) );
+    }
   }
   QgsSingleBandPseudoColorRenderer * renderer = new QgsSingleBandPseudoColorRenderer( 0, mBand, shader );
 
   renderer->setOpacity( mOpacity );
   renderer->setAlphaBand( mAlphaBand );
   renderer->setRasterTransparency( mRasterTransparency );
+  renderer->setClassificationMin( mClassificationMin );
+  renderer->setClassificationMax( mClassificationMax );
+  renderer->setClassificationMinMaxOrigin( mClassificationMinMaxOrigin );
 
   return renderer;
 }
@@ -148,40 +203,74 @@ QgsRasterBlock* QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   }
 
   QRgb myDefaultColor = NODATA_COLOR;
+  double noDataValue = mInput->noDataValue( mBand );
+  QRgb* outputColors = ( QRgb* )outputBlock->bits(( size_t )0 );
 
-  for ( size_t i = 0; i < ( size_t )width*height; i++ )
+  bool shaded = false;
+  if ( !hasTransparency )
   {
-    double val = inputBlock->value( i );
-    if ( mInput->isNoDataValue( mBand, val ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-    int red, green, blue;
-    if ( !mShader->shade( val, &red, &green, &blue ) )
+    const void* data = inputBlock->bits(( size_t )0 );
+    size_t count = ( size_t )width * height;
+    switch ( inputBlock->dataType() )
     {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
+      case QGis::Byte:
+        shaded = shadeIntegerBlock(( const quint8* )data, count, noDataValue, mShader, myDefaultColor, outputColors );
+        break;
+      case QGis::UInt16:
+        shaded = shadeIntegerBlock(( const quint16* )data, count, noDataValue, mShader, myDefaultColor, outputColors );
+        break;
+      case QGis::Int16:
+        shaded = shadeIntegerBlock(( const qint16* )data, count, noDataValue, mShader, myDefaultColor, outputColors );
+        break;
+      case QGis::UInt32:
+        shaded = shadeIntegerBlock(( const quint32* )data, count, noDataValue, mShader, myDefaultColor, outputColors );
+        break;
+      case QGis::Int32:
+        shaded = shadeIntegerBlock(( const qint32* )data, count, noDataValue, mShader, myDefaultColor, outputColors );
+        break;
+      default:
+        break;
     }
+  }
 
-    if ( !hasTransparency )
-    {
-      outputBlock->setColor( i, qRgba( red, green, blue, 255 ) );
-    }
-    else
+  QVector<double> values( width );
+
+  for ( int row = 0; !shaded && row < height; row++ )
+  {
+    size_t rowStart = ( size_t )row * width;
+    readValues( inputBlock, noDataValue, rowStart, width, values.data() );
+    const double* valueRow = values.constData();
+    QRgb* colorRow = outputColors + rowStart;
+
+    for ( int col = 0; col < width; col++ )
     {
-      //opacity
-      double currentOpacity = mOpacity;
-      if ( mRasterTransparency )
+      double val = valueRow[col];
+      int red, green, blue;
+      if ( qIsNaN( val ) || !mShader->shade( val, &red, &green, &blue ) )
       {
-        currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+        colorRow[col] = myDefaultColor;
+        continue;
       }
-      if ( mAlphaBand > 0 )
+
+      if ( !hasTransparency )
       {
-        currentOpacity *= alphaBlock->value( i ) / 255.0;
+        colorRow[col] = qRgba( red, green, blue, 255 );
+      }
+      else
+      {
+        //opacity
+        double currentOpacity = mOpacity;
+        if ( mRasterTransparency )
+        {
+          currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+        }
+        if ( mAlphaBand > 0 )
+        {
+          currentOpacity *= alphaBlock->value( rowStart + col ) / 255.0;
+        }
+
+        colorRow[col] = qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * 255 );
       }
-
-      outputBlock->setColor( i, qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * 255 ) );
     }
   }
 
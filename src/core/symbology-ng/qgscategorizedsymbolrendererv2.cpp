@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include <algorithm>
+#include <cstring>
 
 #include "qgscategorizedsymbolrendererv2.h"
 
@@ -165,20 +166,58 @@ QgsCategorizedSymbolRendererV2::~QgsCategorizedSymbolRendererV2()
   delete mSourceColorRamp;
 }
 
+static quint64 doubleHashKey( double value )
+{
+  quint64 key;
+  memcpy( &key, &value, sizeof( key ) );
+  return key;
+}
+
 void QgsCategorizedSymbolRendererV2::rebuildHash()
 {
   mSymbolHash.clear();
+  mIntSymbolHash.clear();
+  mDoubleSymbolHash.clear();
 
   for ( int i = 0; i < mCategories.count(); ++i )
   {
     QgsRendererCategoryV2& cat = mCategories[i];
-    mSymbolHash.insert( cat.value().toString(), cat.symbol() );
+    QString key = cat.value().toString();
+    mSymbolHash.insert( key, cat.symbol() );
+
+    // numbers are looked up directly if the category matches their string
+    bool ok;
+    qlonglong intValue = key.toLongLong( &ok );
+    if ( ok && QString::number( intValue ) == key )
+      mIntSymbolHash.insert( intValue, cat.symbol() );
+    double doubleValue = key.toDouble( &ok );
+    if ( ok && QVariant( doubleValue ).toString() == key )
+      mDoubleSymbolHash.insert( doubleHashKey( doubleValue ), cat.symbol() );
   }
 }
 
 QgsSymbolV2* QgsCategorizedSymbolRendererV2::symbolForValue( QVariant value )
 {
-  // TODO: special case for int, double
+  if ( !value.isNull() )
+  {
+    if ( value.type() == QVariant::Int || value.type() == QVariant::LongLong )
+    {
+      // the string of an integer always has the same form, so this is the only possible category
+      QHash<qlonglong, QgsSymbolV2*>::const_iterator it = mIntSymbolHash.constFind( value.toLongLong() );
+      if ( it != mIntSymbolHash.constEnd() )
+        return *it;
+      QgsDebugMsg( "attribute value not found: " + value.toString() );
+      return NULL;
+    }
+    else if ( value.type() == QVariant::Double )
+    {
+      // different doubles may have the same string, continue with it if not found
+      QHash<quint64, QgsSymbolV2*>::const_iterator it = mDoubleSymbolHash.constFind( doubleHashKey( value.toDouble() ) );
+      if ( it != mDoubleSymbolHash.constEnd() )
+        return *it;
+    }
+  }
+
   QHash<QString, QgsSymbolV2*>::iterator it = mSymbolHash.find( value.toString() );
   if ( it == mSymbolHash.end() )
   {
@@ -230,7 +269,7 @@ QgsSymbolV2* QgsCategorizedSymbolRendererV2::symbolForFeature( QgsFeature& featu
     sizeScale = attrs[mSizeScaleFieldIdx].toDouble();
 
   // take a temporary symbol (or create it if doesn't exist)
-  QgsSymbolV2* tempSymbol = mTempSymbols[attrs[mAttrNum].toString()];
+  QgsSymbolV2* tempSymbol = mTempSymbols[symbol];
 
   // modify the temporary symbol and return it
   if ( tempSymbol->type() == QgsSymbolV2::Marker )
@@ -383,7 +422,7 @@ void QgsCategorizedSymbolRendererV2::startRender( QgsRenderContext& context, con
       tempSymbol->setRenderHints(( mRotationFieldIdx != -1 ? QgsSymbolV2::DataDefinedRotation : 0 ) |
                                  ( mSizeScaleFieldIdx != -1 ? QgsSymbolV2::DataDefinedSizeScale : 0 ) );
       tempSymbol->startRender( context, vlayer );
-      mTempSymbols[ it->value().toString()] = tempSymbol;
+      mTempSymbols[ it->symbol()] = tempSymbol;
     }
   }
 
@@ -396,7 +435,7 @@ void QgsCategorizedSymbolRendererV2::stopRender( QgsRenderContext& context )
     it->symbol()->stopRender( context );
 
   // cleanup mTempSymbols
-  QHash<QString, QgsSymbolV2*>::iterator it2 = mTempSymbols.begin();
+  QHash<QgsSymbolV2*, QgsSymbolV2*>::iterator it2 = mTempSymbols.begin();
   for ( ; it2 != mTempSymbols.end(); ++it2 )
   {
     it2.value()->stopRender( context );
@@ -164,8 +164,14 @@ class CORE_EXPORT QgsCategorizedSymbolRendererV2 : public QgsFeatureRendererV2
     //! hashtable for faster access to symbols
     QHash<QString, QgsSymbolV2*> mSymbolHash;
 
-    //! temporary symbols, used for data-defined rotation and scaling
-    QHash<QString, QgsSymbolV2*> mTempSymbols;
+    //! hashtables for access to symbols by integer and double values without
+    //! converting the values to strings (only categories whose value string
+    //! is the string of the number)
+    QHash<qlonglong, QgsSymbolV2*> mIntSymbolHash;
+    QHash<quint64, QgsSymbolV2*> mDoubleSymbolHash;
+
+    //! temporary symbols, used for data-defined rotation and scaling (by the original symbol)
+    QHash<QgsSymbolV2*, QgsSymbolV2*> mTempSymbols;
 
     void rebuildHash();
 
@@ -160,7 +160,8 @@ QgsGraduatedSymbolRendererV2::QgsGraduatedSymbolRendererV2( QString attrName, Qg
     mSourceColorRamp( NULL ),
     mScaleMethod( QgsSymbolV2::ScaleArea ),
     mRotationFieldIdx( -1 ),
-    mSizeScaleFieldIdx( -1 )
+    mSizeScaleFieldIdx( -1 ),
+    mRangesSorted( false )
 {
   // TODO: check ranges for sanity (NULL symbols, invalid ranges)
 }
@@ -174,13 +175,57 @@ QgsGraduatedSymbolRendererV2::~QgsGraduatedSymbolRendererV2()
 
 QgsSymbolV2* QgsGraduatedSymbolRendererV2::symbolForValue( double value )
 {
-  for ( QgsRangeList::iterator it = mRanges.begin(); it != mRanges.end(); ++it )
+  if ( !mRangesSorted )
   {
-    if ( it->lowerValue() <= value && it->upperValue() >= value )
-      return it->symbol();
+    // not rendering: go through the ranges
+    for ( QgsRangeList::iterator it = mRanges.begin(); it != mRanges.end(); ++it )
+    {
+      if ( it->lowerValue() <= value && it->upperValue() >= value )
+        return it->symbol();
+    }
+    // the value is out of the range: return NULL instead of symbol
+    return NULL;
+  }
+
+  // ranges starting before the value, as long as some of them may end after it;
+  // if more ranges contain the value, the first one in the list is used
+  int pos = qUpperBound( mSortedLowerValues.constBegin(), mSortedLowerValues.constEnd(), value ) - mSortedLowerValues.constBegin();
+  int found = -1;
+  for ( int i = pos - 1; i >= 0 && mSortedMaxUpperValues[i] >= value; --i )
+  {
+    int idx = mSortedRanges[i];
+    if ( mRanges[idx].upperValue() >= value && ( found == -1 || idx < found ) )
+      found = idx;
   }
   // the value is out of the range: return NULL instead of symbol
-  return NULL;
+  return found != -1 ? mRanges[found].symbol() : NULL;
+}
+
+static bool lowerValueLessThan( const QPair<double, int>& p1, const QPair<double, int>& p2 )
+{
+  return p1.first < p2.first || ( p1.first == p2.first && p1.second < p2.second );
+}
+
+void QgsGraduatedSymbolRendererV2::sortRanges()
+{
+  QList< QPair<double, int> > lowerValues;
+  for ( int i = 0; i < mRanges.count(); ++i )
+    lowerValues.append( qMakePair( mRanges[i].lowerValue(), i ) );
+  qSort( lowerValues.begin(), lowerValues.end(), lowerValueLessThan );
+
+  mSortedLowerValues.clear();
+  mSortedMaxUpperValues.clear();
+  mSortedRanges.clear();
+  double maxUpper = -std::numeric_limits<double>::infinity();
+  for ( int i = 0; i < lowerValues.count(); ++i )
+  {
+    int idx = lowerValues[i].second;
+    maxUpper = qMax( maxUpper, mRanges[idx].upperValue() );
+    mSortedLowerValues.append( lowerValues[i].first );
+    mSortedMaxUpperValues.append( maxUpper );
+    mSortedRanges.append( idx );
+  }
+  mRangesSorted = true;
 }
 
 QgsSymbolV2* QgsGraduatedSymbolRendererV2::symbolForFeature( QgsFeature& feature )
@@ -242,6 +287,9 @@ void QgsGraduatedSymbolRendererV2::startRender( QgsRenderContext& context, const
   mRotationFieldIdx  = ( mRotationField.isEmpty()  ? -1 : vlayer->fieldNameIndex( mRotationField ) );
   mSizeScaleFieldIdx = ( mSizeScaleField.isEmpty() ? -1 : vlayer->fieldNameIndex( mSizeScaleField ) );
 
+  // prepare binary search of ranges
+  sortRanges();
+
   QgsRangeList::iterator it = mRanges.begin();
   for ( ; it != mRanges.end(); ++it )
   {
@@ -276,6 +324,11 @@ void QgsGraduatedSymbolRendererV2::stopRender( QgsRenderContext& context )
     delete it2.value();
   }
   mTempSymbols.clear();
+
+  mSortedLowerValues.clear();
+  mSortedMaxUpperValues.clear();
+  mSortedRanges.clear();
+  mRangesSorted = false;
 }
 
 QList<QString> QgsGraduatedSymbolRendererV2::usedAttributes()
@@ -18,6 +18,8 @@
 #include "qgssymbolv2.h"
 #include "qgsrendererv2.h"
 
+#include <QVector>
+
 class CORE_EXPORT QgsRendererRangeV2
 {
   public:
@@ -189,6 +191,17 @@ class CORE_EXPORT QgsGraduatedSymbolRendererV2 : public QgsFeatureRendererV2
     QHash<QgsSymbolV2*, QgsSymbolV2*> mTempSymbols;
 #endif
 
+    //! lower values of the ranges in ascending order, maximum of upper values up to each
+    //! of them and indexes of the ranges, for binary search in symbolForValue()
+    QVector<double> mSortedLowerValues;
+    QVector<double> mSortedMaxUpperValues;
+    QVector<int> mSortedRanges;
+    //! whether the sorted ranges are prepared, between startRender and stopRender
+    bool mRangesSorted;
+
+    //! prepare the sorted ranges (in startRender)
+    void sortRanges();
+
     QgsSymbolV2* symbolForValue( double value );
 };
 
@@ -140,6 +140,32 @@ void QgsSimpleLineSymbolLayerV2::renderPolyline( const QPolygonF& points, QgsSym
   }
 }
 
+void QgsSimpleLineSymbolLayerV2::renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsSymbolV2RenderContext& context )
+{
+  QPainter* p = context.renderContext().painter();
+  if ( !p )
+  {
+    return;
+  }
+
+  if ( context.renderHints() & QgsSymbolV2::DataDefinedSizeScale )
+  {
+    QgsLineSymbolLayerV2::renderPolylines( polylines, count, context );
+    return;
+  }
+
+  // the pen is set only once for the whole batch
+  p->setPen( context.selected() ? mSelPen : mPen );
+  double scaledOffset = context.outputLineWidth( mOffset );
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( mOffset == 0 )
+      p->drawPolyline( polylines[i] );
+    else
+      p->drawPolyline( ::offsetLine( polylines[i], scaledOffset ) );
+  }
+}
+
 QgsStringMap QgsSimpleLineSymbolLayerV2::properties() const
 {
   QgsStringMap map;
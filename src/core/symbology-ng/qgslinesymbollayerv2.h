@@ -50,6 +50,8 @@ class CORE_EXPORT QgsSimpleLineSymbolLayerV2 : public QgsLineSymbolLayerV2
 
     void renderPolyline( const QPolygonF& points, QgsSymbolV2RenderContext& context );
 
+    void renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsSymbolV2RenderContext& context );
+
     QgsStringMap properties() const;
 
     QgsSymbolLayerV2* clone() const;
@@ -15,6 +15,7 @@
 
 #include "qgsrendererv2.h"
 #include "qgssymbolv2.h"
+#include "qgssymbollayerv2.h"
 #include "qgssymbollayerv2utils.h"
 
 #include "qgssinglesymbolrendererv2.h" // for default renderer
@@ -32,6 +33,8 @@
 #include <QDomDocument>
 #include <QPolygonF>
 
+// maximum number of lines collected before they are drawn
+static const int BATCH_SIZE = 1000;
 
 
 unsigned char* QgsFeatureRendererV2::_getPoint( QPointF& pt, QgsRenderContext& context, unsigned char* wkb )
@@ -110,6 +113,8 @@ unsigned char* QgsFeatureRendererV2::_getLineString( QPolygonF& pts, QgsRenderCo
     mtp.transformInPlace( ptr->rx(), ptr->ry() );
   }
 
+  if ( context.simplifyThreshold() > 0 )
+    _simplify( pts, context.simplifyThreshold(), 2 );
 
   return wkb;
 }
@@ -174,6 +179,9 @@ unsigned char* QgsFeatureRendererV2::_getPolygon( QPolygonF& pts, QList<QPolygon
       mtp.transformInPlace( ptr->rx(), ptr->ry() );
     }
 
+    if ( context.simplifyThreshold() > 0 )
+      _simplify( poly, context.simplifyThreshold(), 4 );
+
     if ( idx == 0 )
       pts = poly;
     else
@@ -183,11 +191,40 @@ unsigned char* QgsFeatureRendererV2::_getPolygon( QPolygonF& pts, QList<QPolygon
   return wkb;
 }
 
+void QgsFeatureRendererV2::_simplify( QPolygonF& pts, double threshold, int minPoints )
+{
+  int n = pts.size();
+  if ( n <= minPoints )
+    return;
+
+  double threshold2 = threshold * threshold;
+  QPointF* data = pts.data();
+  int last = 0;
+  for ( int i = 1; i < n - 1; ++i )
+  {
+    // without this vertex, at most last + 1 kept and n - 1 - i following vertices remain
+    if ( last + n - i < minPoints )
+    {
+      data[++last] = data[i];
+      continue;
+    }
+
+    double dx = data[i].x() - data[last].x();
+    double dy = data[i].y() - data[last].y();
+    if ( dx * dx + dy * dy >= threshold2 )
+      data[++last] = data[i];
+  }
+  data[++last] = data[n - 1];
+  pts.resize( last + 1 );
+}
+
 
 QgsFeatureRendererV2::QgsFeatureRendererV2( QString type )
     : mType( type ), mUsingSymbolLevels( false ),
     mCurrentVertexMarkerType( QgsVectorLayer::Cross ),
-    mCurrentVertexMarkerSize( 3 )
+    mCurrentVertexMarkerSize( 3 ),
+    mBatchingEnabled( true ), mBatching( false ), mBatchCount( 0 ), mBatchSymbol( NULL ),
+    mBatchLayer( -1 ), mBatchSelected( false ), mBatchContext( NULL )
 {
 }
 
@@ -209,6 +246,13 @@ bool QgsFeatureRendererV2::renderFeature( QgsFeature& feature, QgsRenderContext&
 
 void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, int layer, bool selected, bool drawVertexMarker )
 {
+  QgsScreenGeometryCache* cache = context.screenGeometryCache();
+  if ( cache && !drawVertexMarker && renderCachedFeature( feature, symbol, context, *cache, layer, selected ) )
+    return;
+
+  if ( mBatching && batchFeature( feature, symbol, context, layer, selected, drawVertexMarker ) )
+    return;
+
   QgsSymbolV2::SymbolType symbolType = symbol->type();
 
   QgsGeometry* geom = feature.geometry();
@@ -347,6 +391,469 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
   }
 }
 
+void QgsFeatureRendererV2::startBatch()
+{
+  mBatching = mBatchingEnabled;
+  mBatchCount = 0;
+  mBatchSymbol = NULL;
+  mBatchContext = NULL;
+}
+
+void QgsFeatureRendererV2::drawBatch()
+{
+  if ( mBatchCount == 0 )
+    return;
+
+  mBatchSymbol->renderPolylines( mBatchLines, mBatchCount, *mBatchContext, mBatchLayer, mBatchSelected );
+  mBatchCount = 0;
+}
+
+void QgsFeatureRendererV2::stopBatch()
+{
+  drawBatch();
+  mBatching = false;
+  mBatchSymbol = NULL;
+  mBatchContext = NULL;
+  mBatchLines.clear();
+}
+
+bool QgsFeatureRendererV2::canBatchSymbol( QgsSymbolV2* symbol, int layer ) const
+{
+  if ( symbol->type() != QgsSymbolV2::Line )
+    return false;
+
+  // data-defined rotation and size change the symbol for each feature
+  if ( symbol->renderHints() & ( QgsSymbolV2::DataDefinedRotation | QgsSymbolV2::DataDefinedSizeScale ) )
+    return false;
+
+  // with more layers the features would be drawn layer by layer instead of one after another
+  if ( layer == -1 && symbol->symbolLayerCount() != 1 )
+    return false;
+
+  // simple lines do not need the feature
+  QgsSymbolLayerV2* symbolLayer = symbol->symbolLayer( layer == -1 ? 0 : layer );
+  return symbolLayer && symbolLayer->layerType() == "SimpleLine";
+}
+
+bool QgsFeatureRendererV2::batchFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, int layer, bool selected, bool drawVertexMarker )
+{
+  QGis::WkbType wkbType = feature.geometry()->wkbType();
+  bool isLine = wkbType == QGis::WKBLineString || wkbType == QGis::WKBLineString25D;
+  bool isMultiLine = wkbType == QGis::WKBMultiLineString || wkbType == QGis::WKBMultiLineString25D;
+
+  if ( drawVertexMarker || !( isLine || isMultiLine ) || !setBatchSymbol( symbol, context, layer, selected ) )
+  {
+    // the feature is not drawn with the batch: draw the batch first to keep the order
+    drawBatch();
+    return false;
+  }
+
+  unsigned char* wkb = feature.geometry()->asWkb();
+  unsigned int num = 1;
+  if ( isMultiLine )
+  {
+    num = *(( int* )( wkb + 5 ) );
+    wkb += 9;
+  }
+
+  for ( unsigned int i = 0; i < num; ++i )
+  {
+    wkb = _getLineString( nextBatchLine(), context, wkb );
+    appendBatchLine();
+  }
+  return true;
+}
+
+bool QgsFeatureRendererV2::setBatchSymbol( QgsSymbolV2* symbol, QgsRenderContext& context, int layer, bool selected )
+{
+  if ( symbol == mBatchSymbol && layer == mBatchLayer && selected == mBatchSelected && &context == mBatchContext )
+    return true;
+
+  drawBatch();
+  if ( !canBatchSymbol( symbol, layer ) )
+    return false;
+
+  mBatchSymbol = static_cast<QgsLineSymbolV2*>( symbol );
+  mBatchLayer = layer;
+  mBatchSelected = selected;
+  mBatchContext = &context;
+  return true;
+}
+
+QPolygonF& QgsFeatureRendererV2::nextBatchLine()
+{
+  if ( mBatchCount == mBatchLines.count() )
+    mBatchLines.append( QPolygonF() );
+  return mBatchLines[mBatchCount];
+}
+
+void QgsFeatureRendererV2::appendBatchLine()
+{
+  if ( ++mBatchCount == BATCH_SIZE )
+    drawBatch();
+}
+
+QgsScreenGeometryCache::QgsScreenGeometryCache( int maxPoints )
+    : mPointCount( 0 ), mMaxPoints( maxPoints ), mMapUnitsPerPixel( 0 ), mSimplifyThreshold( 0 )
+{
+}
+
+void QgsScreenGeometryCache::begin( const QgsRenderContext& context )
+{
+  const QgsMapToPixel& mtp = context.mapToPixel();
+  const QgsCoordinateTransform* ct = context.coordinateTransform();
+  QString transform = ct ? ct->sourceCrs().toProj4() + " -> " + ct->destCRS().toProj4() : QString();
+
+  if ( mtp.mapUnitsPerPixel() != mMapUnitsPerPixel || transform != mTransform
+       || context.simplifyThreshold() != mSimplifyThreshold )
+  {
+    clear();
+    mMapUnitsPerPixel = mtp.mapUnitsPerPixel();
+    mTransform = transform;
+    mSimplifyThreshold = context.simplifyThreshold();
+  }
+
+  // at the same scale the map to pixel conversion only moves the origin
+  QgsPoint origin = mtp.transform( 0, 0 );
+  mOrigin = QPointF( origin.x(), origin.y() );
+}
+
+void QgsScreenGeometryCache::clear()
+{
+  mEntries.clear();
+  mPointCount = 0;
+}
+
+const QgsScreenGeometryCache::Entry* QgsFeatureRendererV2::cachedScreenGeometry( QgsFeature& feature, QgsRenderContext& context, QgsScreenGeometryCache& cache )
+{
+  // the same rectangle as used for clipping in _getLineString() and _getPolygon()
+  const QgsRectangle& e = context.extent();
+  double cw = e.width() / 10; double ch = e.height() / 10;
+  QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+
+  QHash<QgsFeatureId, QgsScreenGeometryCache::Entry>::const_iterator it = cache.mEntries.constFind( feature.id() );
+  if ( it != cache.mEntries.constEnd() )
+    return clipRect.contains( it->bounds ) ? &it.value() : NULL;
+
+  if ( cache.mPointCount >= cache.mMaxPoints )
+    return NULL;
+
+  QgsGeometry* geom = feature.geometry();
+  bool isPolygon;
+  bool multi;
+  switch ( geom->wkbType() )
+  {
+    case QGis::WKBLineString:
+    case QGis::WKBLineString25D:
+      isPolygon = false; multi = false; break;
+    case QGis::WKBMultiLineString:
+    case QGis::WKBMultiLineString25D:
+      isPolygon = false; multi = true; break;
+    case QGis::WKBPolygon:
+    case QGis::WKBPolygon25D:
+      isPolygon = true; multi = false; break;
+    case QGis::WKBMultiPolygon:
+    case QGis::WKBMultiPolygon25D:
+      isPolygon = true; multi = true; break;
+    default:
+      return NULL;
+  }
+
+  // a geometry inside the rectangle is not changed by clipping
+  QgsRectangle bounds = geom->boundingBox();
+  if ( !clipRect.contains( bounds ) )
+    return NULL;
+
+  QgsScreenGeometryCache::Entry entry;
+  entry.bounds = bounds;
+
+  unsigned char* wkb = geom->asWkb();
+  unsigned int num = multi ? *(( int* )( wkb + 5 ) ) : 1;
+  unsigned char* ptr = multi ? wkb + 9 : wkb;
+  QPolygonF pts;
+  QList<QPolygonF> holes;
+  for ( unsigned int i = 0; i < num; ++i )
+  {
+    pts.clear();
+    holes.clear();
+    if ( isPolygon )
+    {
+      ptr = _getPolygon( pts, holes, context, ptr );
+      entry.rings.append( pts );
+      foreach ( const QPolygonF& hole, holes )
+        entry.rings.append( hole );
+    }
+    else
+    {
+      ptr = _getLineString( pts, context, ptr );
+      entry.rings.append( pts );
+    }
+    entry.partEnds.append( entry.rings.count() );
+  }
+
+  for ( int i = 0; i < entry.rings.count(); ++i )
+  {
+    entry.rings[i].translate( -cache.mOrigin );
+    cache.mPointCount += entry.rings[i].count();
+  }
+
+  return &cache.mEntries.insert( feature.id(), entry ).value();
+}
+
+bool QgsFeatureRendererV2::renderCachedFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, QgsScreenGeometryCache& cache, int layer, bool selected )
+{
+  // points are cheap to convert
+  QgsSymbolV2::SymbolType symbolType = symbol->type();
+  if ( symbolType == QgsSymbolV2::Marker )
+    return false;
+
+  QGis::GeometryType geometryType = feature.geometry()->type();
+  if (( symbolType == QgsSymbolV2::Line && geometryType != QGis::Line ) ||
+      ( symbolType == QgsSymbolV2::Fill && geometryType != QGis::Polygon ) )
+    return false;
+
+  const QgsScreenGeometryCache::Entry* entry = cachedScreenGeometry( feature, context, cache );
+  if ( !entry )
+    return false;
+
+  QPolygonF pts;
+  QList<QPolygonF> holes;
+  for ( int part = 0; part < entry->partEnds.count(); ++part )
+  {
+    int ringBegin = part == 0 ? 0 : entry->partEnds[part - 1];
+    int ringEnd = entry->partEnds[part];
+
+    if ( symbolType == QgsSymbolV2::Line )
+    {
+      if ( mBatching && setBatchSymbol( symbol, context, layer, selected ) )
+      {
+        QPolygonF& line = nextBatchLine();
+        line = entry->rings[ringBegin];
+        line.translate( cache.mOrigin );
+        appendBatchLine();
+        continue;
+      }
+
+      drawBatch();
+      pts = entry->rings[ringBegin];
+      pts.translate( cache.mOrigin );
+      (( QgsLineSymbolV2* )symbol )->renderPolyline( pts, &feature, context, layer, selected );
+    }
+    else
+    {
+      drawBatch();
+      pts = entry->rings[ringBegin];
+      pts.translate( cache.mOrigin );
+      holes.clear();
+      for ( int ring = ringBegin + 1; ring < ringEnd; ++ring )
+      {
+        holes.append( entry->rings[ring] );
+        holes.last().translate( cache.mOrigin );
+      }
+      (( QgsFillSymbolV2* )symbol )->renderPolygon( pts, ( holes.count() ? &holes : NULL ), &feature, context, layer, selected );
+    }
+  }
+  return true;
+}
+
+void QgsScreenFeatureList::clear()
+{
+  mFeatures.clear();
+  mAttributes.clear();
+  mPartEnds.clear();
+  mRingEnds.clear();
+  mCoords.clear();
+}
+
+void QgsScreenFeatureList::ring( int index, QPolygonF& pts ) const
+{
+  int begin = index == 0 ? 0 : mRingEnds[index - 1];
+  int end = mRingEnds[index];
+  pts.resize( end - begin );
+  const float* coords = mCoords.constData() + 2 * begin;
+  QPointF* ptr = pts.data();
+  for ( int i = begin; i < end; ++i, coords += 2 )
+  {
+    *ptr++ = QPointF( coords[0], coords[1] );
+  }
+}
+
+void QgsScreenFeatureList::appendRing( const QPolygonF& pts )
+{
+  foreach ( const QPointF& pt, pts )
+  {
+    mCoords.append( pt.x() );
+    mCoords.append( pt.y() );
+  }
+  mRingEnds.append( mCoords.count() / 2 );
+}
+
+void QgsFeatureRendererV2::storeScreenFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, bool selected, bool drawVertexMarker, QgsScreenFeatureList& list )
+{
+  QgsGeometry* geom = feature.geometry();
+  unsigned char* wkb = geom->asWkb();
+
+  // convert all the parts first, so that a failed transformation leaves the list unchanged
+  QList< QList<QPolygonF> > parts;
+  QgsSymbolV2::SymbolType type;
+  switch ( geom->wkbType() )
+  {
+    case QGis::WKBPoint:
+    case QGis::WKBPoint25D:
+    case QGis::WKBMultiPoint:
+    case QGis::WKBMultiPoint25D:
+    {
+      // the points are stored as one ring and drawn one by one
+      type = QgsSymbolV2::Marker;
+      bool multi = geom->wkbType() == QGis::WKBMultiPoint || geom->wkbType() == QGis::WKBMultiPoint25D;
+      unsigned int num = multi ? *(( int* )( wkb + 5 ) ) : 1;
+      unsigned char* ptr = multi ? wkb + 9 : wkb;
+      QPolygonF pts;
+      QPointF pt;
+      for ( unsigned int i = 0; i < num; ++i )
+      {
+        ptr = _getPoint( pt, context, ptr );
+        pts.append( pt );
+      }
+      parts.append( QList<QPolygonF>() << pts );
+    }
+    break;
+
+    case QGis::WKBLineString:
+    case QGis::WKBLineString25D:
+    case QGis::WKBMultiLineString:
+    case QGis::WKBMultiLineString25D:
+    {
+      type = QgsSymbolV2::Line;
+      bool multi = geom->wkbType() == QGis::WKBMultiLineString || geom->wkbType() == QGis::WKBMultiLineString25D;
+      unsigned int num = multi ? *(( int* )( wkb + 5 ) ) : 1;
+      unsigned char* ptr = multi ? wkb + 9 : wkb;
+      for ( unsigned int i = 0; i < num; ++i )
+      {
+        QPolygonF pts;
+        ptr = _getLineString( pts, context, ptr );
+        parts.append( QList<QPolygonF>() << pts );
+      }
+    }
+    break;
+
+    case QGis::WKBPolygon:
+    case QGis::WKBPolygon25D:
+    case QGis::WKBMultiPolygon:
+    case QGis::WKBMultiPolygon25D:
+    {
+      type = QgsSymbolV2::Fill;
+      bool multi = geom->wkbType() == QGis::WKBMultiPolygon || geom->wkbType() == QGis::WKBMultiPolygon25D;
+      unsigned int num = multi ? *(( int* )( wkb + 5 ) ) : 1;
+      unsigned char* ptr = multi ? wkb + 9 : wkb;
+      for ( unsigned int i = 0; i < num; ++i )
+      {
+        QPolygonF pts;
+        QList<QPolygonF> holes;
+        ptr = _getPolygon( pts, holes, context, ptr );
+        parts.append( QList<QPolygonF>() << pts << holes );
+      }
+    }
+    break;
+
+    default:
+      QgsDebugMsg( QString( "unsupported wkb type 0x%1 for rendering" ).arg( geom->wkbType(), 0, 16 ) );
+      return;
+  }
+
+  foreach ( const QList<QPolygonF>& rings, parts )
+  {
+    foreach ( const QPolygonF& pts, rings )
+      list.appendRing( pts );
+    list.mPartEnds.append( list.mRingEnds.count() );
+  }
+
+  QgsScreenFeatureList::Feature f;
+  f.id = feature.id();
+  f.symbol = symbol;
+  f.type = type;
+  f.flags = ( selected ? QgsScreenFeatureList::Selected : 0 ) | ( drawVertexMarker ? QgsScreenFeatureList::DrawVertexMarker : 0 );
+  f.partEnd = list.mPartEnds.count();
+  list.mFeatures.append( f );
+  // the attributes are implicitly shared with the feature
+  list.mAttributes.append( feature.attributes() );
+  list.mFields = feature.fields();
+}
+
+void QgsFeatureRendererV2::renderScreenFeatures( const QgsScreenFeatureList& list, QgsRenderContext& context, int layer )
+{
+  QgsFeature feature;
+  feature.setFields( list.mFields );
+  feature.setValid( true );
+  QPolygonF pts;
+  QList<QPolygonF> holes;
+
+  for ( int i = 0; i < list.count(); ++i )
+  {
+    if ( context.renderingStopped() )
+      break;
+
+    const QgsScreenFeatureList::Feature& f = list.mFeatures[i];
+    feature.setFeatureId( f.id );
+    feature.setAttributes( list.mAttributes[i] );
+
+    // the feature has no geometry here, which the choice of the symbol may depend on
+    QgsSymbolV2* symbol = f.symbol;
+    if ( !symbol )
+      continue;
+    if ( symbol->type() != f.type )
+    {
+      QgsDebugMsg( "geometry type does not match the symbol type!" );
+      continue;
+    }
+
+    bool selected = f.flags & QgsScreenFeatureList::Selected;
+    bool drawVertexMarker = f.flags & QgsScreenFeatureList::DrawVertexMarker;
+    int partBegin = i == 0 ? 0 : list.mFeatures[i - 1].partEnd;
+    for ( int part = partBegin; part < f.partEnd; ++part )
+    {
+      int ringBegin = part == 0 ? 0 : list.mPartEnds[part - 1];
+      int ringEnd = list.mPartEnds[part];
+
+      if ( f.type == QgsSymbolV2::Line && mBatching && !drawVertexMarker && setBatchSymbol( symbol, context, layer, selected ) )
+      {
+        list.ring( ringBegin, nextBatchLine() );
+        appendBatchLine();
+        continue;
+      }
+
+      // other features are drawn after the lines collected before them
+      drawBatch();
+      list.ring( ringBegin, pts );
+      switch ( f.type )
+      {
+        case QgsSymbolV2::Marker:
+          for ( int j = 0; j < pts.count(); ++j )
+            (( QgsMarkerSymbolV2* )symbol )->renderPoint( pts[j], &feature, context, layer, selected );
+          break;
+
+        case QgsSymbolV2::Line:
+          (( QgsLineSymbolV2* )symbol )->renderPolyline( pts, &feature, context, layer, selected );
+          if ( drawVertexMarker )
+            renderVertexMarkerPolyline( pts, context );
+          break;
+
+        case QgsSymbolV2::Fill:
+          holes.clear();
+          for ( int ring = ringBegin + 1; ring < ringEnd; ++ring )
+          {
+            holes.append( QPolygonF() );
+            list.ring( ring, holes.last() );
+          }
+          (( QgsFillSymbolV2* )symbol )->renderPolygon( pts, ( holes.count() ? &holes : NULL ), &feature, context, layer, selected );
+          if ( drawVertexMarker )
+            renderVertexMarkerPolygon( pts, ( holes.count() ? &holes : NULL ), context );
+          break;
+      }
+    }
+  }
+}
+
 QString QgsFeatureRendererV2::dump()
 {
   return "UNKNOWN RENDERER\n";
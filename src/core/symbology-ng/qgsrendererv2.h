@@ -17,18 +17,23 @@
 #define QGSRENDERERV2_H
 
 #include "qgis.h"
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
 
+#include <QHash>
 #include <QList>
 #include <QString>
 #include <QVariant>
 #include <QPair>
 #include <QPixmap>
+#include <QPolygonF>
+#include <QVector>
 #include <QDomDocument>
 #include <QDomElement>
 
 class QgsSymbolV2;
+class QgsLineSymbolV2;
 class QgsRenderContext;
-class QgsFeature;
 class QgsVectorLayer;
 
 typedef QMap<QString, QString> QgsStringMap;
@@ -62,6 +67,101 @@ typedef QList< QgsSymbolV2LevelItem > QgsSymbolV2Level;
 typedef QList< QgsSymbolV2Level > QgsSymbolV2LevelOrder;
 
 
+/**
+  Features with their geometries converted to screen coordinates and stored in compact
+  arrays, so that they can be drawn several times (e.g. once for each symbol level)
+  without keeping copies of the features with their geometries.
+  @note added in 2.0
+  @note not available in python bindings
+ */
+class CORE_EXPORT QgsScreenFeatureList
+{
+  public:
+    QgsScreenFeatureList() : mFields( 0 ) {}
+
+    int count() const { return mFeatures.count(); }
+
+    void clear();
+
+  protected:
+    friend class QgsFeatureRendererV2;
+
+    enum Flags { Selected = 1, DrawVertexMarker = 2 };
+
+    struct Feature
+    {
+      QgsFeatureId id;
+      QgsSymbolV2* symbol;  // chosen for the feature with its geometry
+      int type;     // QgsSymbolV2::SymbolType needed by the geometry
+      int flags;
+      int partEnd;  // end of the parts of the feature in mPartEnds
+    };
+
+    //! copy a ring to the polygon
+    void ring( int index, QPolygonF& pts ) const;
+
+    //! append the points of a ring
+    void appendRing( const QPolygonF& pts );
+
+    QVector<Feature> mFeatures;
+    QVector<QgsAttributes> mAttributes;
+    const QgsFields* mFields;
+    //! end of the rings of each part in mRingEnds
+    QVector<int> mPartEnds;
+    //! end of the points of each ring, in points of mCoords
+    QVector<int> mRingEnds;
+    //! x and y screen coordinates of the points, single precision is enough for pixels
+    QVector<float> mCoords;
+};
+
+/**
+  Geometries of the features of a layer in screen coordinates, simplified like when
+  drawing. They are kept between the renderings of the layer and reused as long as the
+  scale and the coordinate transformation do not change, e.g. while panning the map.
+  Only features that are entirely inside the clipping rectangle are cached,
+  as their geometries are not clipped.
+  @note added in 2.0
+  @note not available in python bindings
+ */
+class CORE_EXPORT QgsScreenGeometryCache
+{
+  public:
+    //! the cache stops growing when it holds maxPoints vertices
+    QgsScreenGeometryCache( int maxPoints = 2000000 );
+
+    //! prepare for drawing with the context, the geometries are dropped
+    //! if they were converted with another scale, transformation or simplification
+    void begin( const QgsRenderContext& context );
+
+    void clear();
+
+    int count() const { return mEntries.count(); }
+
+    int pointCount() const { return mPointCount; }
+
+  protected:
+    friend class QgsFeatureRendererV2;
+
+    struct Entry
+    {
+      QgsRectangle bounds;       // of the geometry in layer coordinates
+      QVector<QPolygonF> rings;  // in pixels, relative to the map origin
+      QVector<int> partEnds;     // end of the rings of each part
+    };
+
+    QHash<QgsFeatureId, Entry> mEntries;
+    int mPointCount;
+    int mMaxPoints;
+
+    // the conversion the geometries were made with
+    double mMapUnitsPerPixel;
+    QString mTransform;
+    double mSimplifyThreshold;
+
+    //! pixel position of the map origin in the current rendering
+    QPointF mOrigin;
+};
+
 //////////////
 // renderers
 
@@ -173,9 +273,52 @@ class CORE_EXPORT QgsFeatureRendererV2
     //! @note added in 1.9
     virtual QgsSymbolV2List symbolsForFeature( QgsFeature& feat );
 
+    //! Start collecting the lines of features rendered with simple line symbol layers
+    //! and draw them in batches of the same symbol layer, so that the painter is set up
+    //! once for many features. Nothing else may draw with the painter until the batch
+    //! is drawn by drawBatch() or stopBatch().
+    //! If batching is disabled startBatch() does nothing and every feature is rendered directly
+    //! @note added in 2.0
+    void startBatch();
+    //! draw the lines collected since the last call
+    //! @note added in 2.0
+    void drawBatch();
+    //! draw the collected lines and stop collecting them
+    //! @note added in 2.0
+    void stopBatch();
+
+    //! whether startBatch() collects lines, true by default
+    //! @note added in 2.0
+    bool batchingEnabled() const { return mBatchingEnabled; }
+    //! enable or disable collecting lines in batches, for comparing the output of both
+    //! @note added in 2.0
+    void setBatchingEnabled( bool enabled ) { mBatchingEnabled = enabled; }
+
+    //! Convert the geometry of the feature to screen coordinates and append it
+    //! with the id, the attributes and the symbol of the feature to the list.
+    //! The symbol is the one returned by symbolForFeature() for the feature with its geometry.
+    //! @note added in 2.0
+    //! @note not available in python bindings
+    void storeScreenFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, bool selected, bool drawVertexMarker, QgsScreenFeatureList& list );
+
+    //! Render the features stored in the list with their stored symbols, like renderFeature() does
+    //! @note added in 2.0
+    //! @note not available in python bindings
+    void renderScreenFeatures( const QgsScreenFeatureList& list, QgsRenderContext& context, int layer = -1 );
+
   protected:
     QgsFeatureRendererV2( QString type );
 
+    //! collect the lines of the feature in the batch, false if the feature must be rendered directly
+    bool batchFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, int layer, bool selected, bool drawVertexMarker );
+    //! whether the symbol layer (or all layers if -1) can render batches of lines without the features
+    bool canBatchSymbol( QgsSymbolV2* symbol, int layer ) const;
+    //! continue the batch with the symbol, draws the batch if it had another symbol; false if the symbol cannot be batched
+    bool setBatchSymbol( QgsSymbolV2* symbol, QgsRenderContext& context, int layer, bool selected );
+    //! polygon for the next line of the batch, added by appendBatchLine()
+    QPolygonF& nextBatchLine();
+    void appendBatchLine();
+
     void renderFeatureWithSymbol( QgsFeature& feature,
                                   QgsSymbolV2* symbol,
                                   QgsRenderContext& context,
@@ -190,6 +333,16 @@ class CORE_EXPORT QgsFeatureRendererV2
     //! render editing vertex marker for a polygon
     void renderVertexMarkerPolygon( QPolygonF& pts, QList<QPolygonF>* rings, QgsRenderContext& context );
 
+    //! render the feature with the geometry from the cache, false if it is not cached and cannot be
+    bool renderCachedFeature( QgsFeature& feature, QgsSymbolV2* symbol, QgsRenderContext& context, QgsScreenGeometryCache& cache, int layer, bool selected );
+    //! return the cached screen geometry of a line or polygon feature, converting it if needed,
+    //! or NULL if it would need clipping in the current extent
+    static const QgsScreenGeometryCache::Entry* cachedScreenGeometry( QgsFeature& feature, QgsRenderContext& context, QgsScreenGeometryCache& cache );
+
+    //! drop the vertices closer than threshold to the previous vertex, keeping the last one.
+    //! Vertices are kept if fewer than minPoints would remain otherwise.
+    static void _simplify( QPolygonF& pts, double threshold, int minPoints );
+
     static unsigned char* _getPoint( QPointF& pt, QgsRenderContext& context, unsigned char* wkb );
     static unsigned char* _getLineString( QPolygonF& pts, QgsRenderContext& context, unsigned char* wkb );
     static unsigned char* _getPolygon( QPolygonF& pts, QList<QPolygonF>& holes, QgsRenderContext& context, unsigned char* wkb );
@@ -202,6 +355,17 @@ class CORE_EXPORT QgsFeatureRendererV2
     int mCurrentVertexMarkerType;
     /** The current size of editing marker */
     int mCurrentVertexMarkerSize;
+
+    bool mBatchingEnabled;
+
+    // batch of lines in screen coordinates, the polygons are reused
+    bool mBatching;
+    QVector<QPolygonF> mBatchLines;
+    int mBatchCount;
+    QgsLineSymbolV2* mBatchSymbol;
+    int mBatchLayer;
+    bool mBatchSelected;
+    QgsRenderContext* mBatchContext;
 };
 
 class QgsRendererV2Widget;  // why does SIP fail, when this isn't here
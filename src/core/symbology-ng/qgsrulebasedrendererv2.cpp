@@ -22,17 +22,20 @@
 #include "qgslogger.h"
 
 #include <QSet>
+#include <QVarLengthArray>
 
 #include <QDomDocument>
 #include <QDomElement>
 
+#include <cstring>
+#include <limits>
 
 
 QgsRuleBasedRendererV2::Rule::Rule( QgsSymbolV2* symbol, int scaleMinDenom, int scaleMaxDenom, QString filterExp, QString label, QString description )
     : mParent( NULL ), mSymbol( symbol ),
     mScaleMinDenom( scaleMinDenom ), mScaleMaxDenom( scaleMaxDenom ),
     mFilterExp( filterExp ), mLabel( label ), mDescription( description ),
-    mFilter( NULL )
+    mFilter( NULL ), mFilterIndex( NULL )
 {
   initFilter();
 }
@@ -41,6 +44,7 @@ QgsRuleBasedRendererV2::Rule::~Rule()
 {
   delete mSymbol;
   delete mFilter;
+  delete mFilterIndex;
   qDeleteAll( mChildren );
   // do NOT delete parent
 }
@@ -283,9 +287,355 @@ void QgsRuleBasedRendererV2::Rule::toSld( QDomDocument& doc, QDomElement &elemen
   }
 }
 
+// conversion to a number the same way as the comparison operators of expressions do it
+static bool filterValueToDouble( const QVariant& value, double& number )
+{
+  if ( value.type() == QVariant::Int || value.type() == QVariant::Double )
+  {
+    number = value.toDouble();
+    return true;
+  }
+  if ( value.type() == QVariant::String )
+  {
+    bool ok;
+    number = value.toString().toDouble( &ok );
+    return ok;
+  }
+  return false;
+}
+
+static quint64 filterNumberKey( double number )
+{
+  if ( number == 0 )
+    number = 0; // -0 is equal to 0
+  quint64 key;
+  memcpy( &key, &number, sizeof( key ) );
+  return key;
+}
+
+// test of one attribute in the conjunction of a filter
+struct FilterTerm
+{
+  FilterTerm()
+      : equality( false )
+      , lower( -std::numeric_limits<double>::infinity() )
+      , upper( std::numeric_limits<double>::infinity() ) {}
+
+  bool isUsable() const { return equality || lower > -std::numeric_limits<double>::infinity() || upper < std::numeric_limits<double>::infinity(); }
+
+  bool equality;
+  QList<QVariant> values; // values of equality or IN test
+  double lower, upper;    // numeric bounds, inclusive
+};
+
+struct FilterRange
+{
+  double lower, upper;
+  int child;
+  bool operator<( const FilterRange& other ) const { return lower < other.lower; }
+};
+
+static int filterField( const QgsExpression::Node* node, const QgsFields& fields )
+{
+  const QgsExpression::NodeColumnRef* ref = dynamic_cast<const QgsExpression::NodeColumnRef*>( node );
+  if ( !ref )
+    return -1;
+  for ( int i = 0; i < fields.count(); ++i )
+  {
+    if ( QString::compare( fields[i].name(), ref->name(), Qt::CaseInsensitive ) == 0 )
+      return i;
+  }
+  return -1;
+}
+
+static bool filterStaticValue( const QgsExpression::Node* node, QgsExpression* exp, QVariant& value )
+{
+  if ( !node->isStatic() )
+    return false;
+  // static nodes return their folded value
+  value = const_cast<QgsExpression::Node*>( node )->eval( exp, 0 );
+  return true;
+}
+
+// collect tests of attributes with constants which must all be true for the filter to be true
+static void analyseFilterNode( const QgsExpression::Node* node, QgsExpression* exp, const QgsFields& fields, QMap<int, FilterTerm>& terms )
+{
+  if ( const QgsExpression::NodeBinaryOperator* op = dynamic_cast<const QgsExpression::NodeBinaryOperator*>( node ) )
+  {
+    QgsExpression::BinaryOperator o = op->op();
+    if ( o == QgsExpression::boAnd )
+    {
+      analyseFilterNode( op->opLeft(), exp, fields, terms );
+      analyseFilterNode( op->opRight(), exp, fields, terms );
+      return;
+    }
+
+    QVariant value;
+    int field = filterField( op->opLeft(), fields );
+    if ( field == -1 || !filterStaticValue( op->opRight(), exp, value ) )
+    {
+      field = filterField( op->opRight(), fields );
+      if ( field == -1 || !filterStaticValue( op->opLeft(), exp, value ) )
+        return;
+      // constant on the left side: mirror the comparison
+      switch ( o )
+      {
+        case QgsExpression::boLT: o = QgsExpression::boGT; break;
+        case QgsExpression::boGT: o = QgsExpression::boLT; break;
+        case QgsExpression::boLE: o = QgsExpression::boGE; break;
+        case QgsExpression::boGE: o = QgsExpression::boLE; break;
+        default: break;
+      }
+    }
+
+    double number;
+    switch ( o )
+    {
+      case QgsExpression::boEQ:
+        if ( !terms[field].equality )
+        {
+          terms[field].equality = true;
+          terms[field].values << value;
+        }
+        break;
+
+      case QgsExpression::boGT:
+      case QgsExpression::boGE:
+        if ( filterValueToDouble( value, number ) && !qIsNaN( number ) )
+          terms[field].lower = qMax( terms[field].lower, number );
+        break;
+
+      case QgsExpression::boLT:
+      case QgsExpression::boLE:
+        if ( filterValueToDouble( value, number ) && !qIsNaN( number ) )
+          terms[field].upper = qMin( terms[field].upper, number );
+        break;
+
+      default:
+        break;
+    }
+  }
+  else if ( const QgsExpression::NodeInOperator* in = dynamic_cast<const QgsExpression::NodeInOperator*>( node ) )
+  {
+    int field = filterField( in->node(), fields );
+    if ( in->isNotIn() || field == -1 || terms.value( field ).equality )
+      return;
+
+    QList<QVariant> values;
+    foreach ( const QgsExpression::Node* n, in->list()->list() )
+    {
+      QVariant value;
+      if ( !filterStaticValue( n, exp, value ) )
+        return;
+      values << value;
+    }
+    terms[field].equality = true;
+    terms[field].values = values;
+  }
+}
+
+/**
+  Index of the active children of a rule by the value of the attribute their
+  filters test most often. Children with an equality or IN test are found in
+  hashes, children with numeric bounds in a list of intervals and the other
+  children are always candidates. Candidates are still tested with their filter,
+  the index only skips children which cannot match.
+ */
+class QgsRuleBasedRendererV2::Rule::FilterIndex
+{
+  public:
+    FilterIndex( int theField ) : field( theField ) {}
+
+    void addValue( const QVariant& value, int child )
+    {
+      // comparison with NULL is never true
+      if ( value.isNull() )
+        return;
+
+      // values which are not numbers are compared with literals as strings
+      double number;
+      bool isNumber = filterValueToDouble( value, number );
+      if ( isNumber )
+        numbers[filterNumberKey( number )].append( child );
+      else
+        texts[value.toString()].append( child );
+      strings[value.toString()].append( child );
+    }
+
+    void addRange( double lower, double upper, int child )
+    {
+      FilterRange range = { lower, upper, child };
+      ranges.append( range );
+    }
+
+    void finish()
+    {
+      qSort( ranges );
+      double maxUpper = -std::numeric_limits<double>::infinity();
+      for ( int i = 0; i < ranges.count(); ++i )
+      {
+        maxUpper = qMax( maxUpper, ranges[i].upper );
+        lowers.append( ranges[i].lower );
+        maxUppers.append( maxUpper );
+      }
+    }
+
+    void candidates( const QVariant& value, QVarLengthArray<int, 64>& result ) const
+    {
+      foreach ( int child, others )
+        result.append( child );
+
+      if ( value.isNull() )
+        return;
+
+      double number;
+      if ( filterValueToDouble( value, number ) )
+      {
+        append( numbers.constFind( filterNumberKey( number ) ), numbers.constEnd(), result );
+        if ( !texts.isEmpty() )
+          append( texts.constFind( value.toString() ), texts.constEnd(), result );
+
+        // intervals containing the number: those starting before it and not ending before it
+        int pos = qUpperBound( lowers.constBegin(), lowers.constEnd(), number ) - lowers.constBegin();
+        for ( int i = pos - 1; i >= 0 && maxUppers[i] >= number; --i )
+        {
+          if ( ranges[i].upper >= number )
+            result.append( ranges[i].child );
+        }
+      }
+      else
+      {
+        append( strings.constFind( value.toString() ), strings.constEnd(), result );
+
+        // bounds are compared as strings with values which are not numbers
+        foreach ( const FilterRange& range, ranges )
+          result.append( range.child );
+      }
+    }
+
+    int field;
+    QList<int> others;
+
+  private:
+    template <typename T>
+    static void append( T it, T end, QVarLengthArray<int, 64>& result )
+    {
+      if ( it == end )
+        return;
+      foreach ( int child, it.value() )
+        result.append( child );
+    }
+
+    // children by the numeric values of literals
+    QHash<quint64, QList<int> > numbers;
+    // children by the string values of all literals, for values which are not numbers
+    QHash<QString, QList<int> > strings;
+    // children by literals which are not numbers, for values which are numbers
+    QHash<QString, QList<int> > texts;
+    // intervals sorted by lower bound and the maximum of upper bounds up to each of them
+    QList<FilterRange> ranges;
+    QVector<double> lowers;
+    QVector<double> maxUppers;
+};
+
+void QgsRuleBasedRendererV2::Rule::initFilterIndex( const QgsFields& fields )
+{
+  delete mFilterIndex;
+  mFilterIndex = NULL;
+
+  if ( mActiveChildren.count() < 2 )
+    return;
+
+  // find tests of attributes in filters of children
+  QList< QMap<int, FilterTerm> > childTerms;
+  QMap<int, int> fieldCounts;
+  foreach ( Rule* rule, mActiveChildren )
+  {
+    QMap<int, FilterTerm> terms;
+    QgsExpression* exp = rule->mFilter;
+    if ( exp && exp->rootNode() && !exp->hasParserError() && !exp->hasEvalError() )
+      analyseFilterNode( exp->rootNode(), exp, fields, terms );
+
+    QMap<int, FilterTerm>::iterator it = terms.begin();
+    while ( it != terms.end() )
+    {
+      if ( it->isUsable() )
+      {
+        fieldCounts[it.key()]++;
+        ++it;
+      }
+      else
+      {
+        it = terms.erase( it );
+      }
+    }
+    childTerms.append( terms );
+  }
+
+  // index by the attribute tested by most children
+  int field = -1;
+  int count = 0;
+  for ( QMap<int, int>::const_iterator it = fieldCounts.constBegin(); it != fieldCounts.constEnd(); ++it )
+  {
+    if ( it.value() > count )
+    {
+      field = it.key();
+      count = it.value();
+    }
+  }
+  if ( count < 2 )
+    return;
+
+  mFilterIndex = new FilterIndex( field );
+  for ( int i = 0; i < childTerms.count(); ++i )
+  {
+    if ( !childTerms[i].contains( field ) )
+    {
+      mFilterIndex->others.append( i );
+      continue;
+    }
+
+    const FilterTerm& term = childTerms[i][field];
+    if ( term.equality )
+    {
+      foreach ( const QVariant& value, term.values )
+        mFilterIndex->addValue( value, i );
+    }
+    else
+    {
+      mFilterIndex->addRange( term.lower, term.upper, i );
+    }
+  }
+  mFilterIndex->finish();
+}
+
+const QgsRuleBasedRendererV2::RuleList& QgsRuleBasedRendererV2::Rule::activeChildrenForFeature( QgsFeature& feat, RuleList& candidates )
+{
+  if ( !mFilterIndex )
+    return mActiveChildren;
+
+  QVarLengthArray<int, 64> indexes;
+  mFilterIndex->candidates( feat.attribute( mFilterIndex->field ), indexes );
+
+  // keep the order of rules, a child may be found more times
+  qSort( indexes.begin(), indexes.end() );
+  int last = -1;
+  for ( int i = 0; i < indexes.count(); ++i )
+  {
+    if ( indexes[i] != last )
+    {
+      candidates.append( mActiveChildren[indexes[i]] );
+      last = indexes[i];
+    }
+  }
+  return candidates;
+}
+
 bool QgsRuleBasedRendererV2::Rule::startRender( QgsRenderContext& context, const QgsVectorLayer *vlayer )
 {
   mActiveChildren.clear();
+  delete mFilterIndex;
+  mFilterIndex = NULL;
 
   // filter out rules which are not compatible with this scale
   if ( !isScaleOK( context.rendererScale() ) )
@@ -304,10 +654,16 @@ bool QgsRuleBasedRendererV2::Rule::startRender( QgsRenderContext& context, const
     Rule* rule = *it;
     if ( rule->startRender( context, vlayer ) )
     {
-      // only add those which are active with current scale
-      mActiveChildren.append( rule );
+      // only add those which are active with current scale and may render something
+      if ( rule->mSymbol || !rule->mActiveChildren.isEmpty() )
+        mActiveChildren.append( rule );
+      else
+        rule->stopRender( context );
     }
   }
+
+  // look up the children by the attribute values instead of testing all of them
+  initFilterIndex( vlayer->pendingFields() );
   return true;
 }
 
@@ -375,7 +731,9 @@ bool QgsRuleBasedRendererV2::Rule::renderFeature( QgsRuleBasedRendererV2::Featur
   }
 
   // process children
-  for ( QList<Rule*>::iterator it = mActiveChildren.begin(); it != mActiveChildren.end(); ++it )
+  RuleList candidates;
+  const RuleList& children = activeChildrenForFeature( featToRender.feat, candidates );
+  for ( RuleList::const_iterator it = children.constBegin(); it != children.constEnd(); ++it )
   {
     Rule* rule = *it;
     rendered |= rule->renderFeature( featToRender, context, renderQueue );
@@ -390,7 +748,9 @@ bool QgsRuleBasedRendererV2::Rule::willRenderFeature( QgsFeature& feat )
   if ( mSymbol )
     return true;
 
-  for ( QList<Rule*>::iterator it = mActiveChildren.begin(); it != mActiveChildren.end(); ++it )
+  RuleList candidates;
+  const RuleList& children = activeChildrenForFeature( feat, candidates );
+  for ( RuleList::const_iterator it = children.constBegin(); it != children.constEnd(); ++it )
   {
     Rule* rule = *it;
     if ( rule->willRenderFeature( feat ) )
@@ -407,7 +767,9 @@ QgsSymbolV2List QgsRuleBasedRendererV2::Rule::symbolsForFeature( QgsFeature& fea
   if ( mSymbol )
     lst.append( mSymbol );
 
-  for ( QList<Rule*>::iterator it = mActiveChildren.begin(); it != mActiveChildren.end(); ++it )
+  RuleList candidates;
+  const RuleList& children = activeChildrenForFeature( feat, candidates );
+  for ( RuleList::const_iterator it = children.constBegin(); it != children.constEnd(); ++it )
   {
     Rule* rule = *it;
     lst += rule->symbolsForFeature( feat );
@@ -424,7 +786,9 @@ QgsRuleBasedRendererV2::RuleList QgsRuleBasedRendererV2::Rule::rulesForFeature(
   if ( mSymbol )
     lst.append( this );
 
-  for ( QList<Rule*>::iterator it = mActiveChildren.begin(); it != mActiveChildren.end(); ++it )
+  RuleList candidates;
+  const RuleList& children = activeChildrenForFeature( feat, candidates );
+  for ( RuleList::const_iterator it = children.constBegin(); it != children.constEnd(); ++it )
   {
     Rule* rule = *it;
     lst += rule->rulesForFeature( feat );
@@ -445,6 +809,8 @@ void QgsRuleBasedRendererV2::Rule::stopRender( QgsRenderContext& context )
 
   mActiveChildren.clear();
   mSymbolNormZLevels.clear();
+  delete mFilterIndex;
+  mFilterIndex = NULL;
 }
 
 QgsRuleBasedRendererV2::Rule* QgsRuleBasedRendererV2::Rule::create( QDomElement& ruleElem, QgsSymbolV2Map& symbolMap )
@@ -675,6 +1041,9 @@ void QgsRuleBasedRendererV2::stopRender( QgsRenderContext& context )
   // do the actual rendering
   //
 
+  // the jobs of a level are mostly drawn with the same symbols: draw their lines in batches
+  startBatch();
+
   // go through all levels
   foreach ( const RenderLevel& level, mRenderQueue )
   {
@@ -700,6 +1069,8 @@ void QgsRuleBasedRendererV2::stopRender( QgsRenderContext& context )
     }
   }
 
+  stopBatch();
+
   // clean current features
   mCurrentFeatures.clear();
 
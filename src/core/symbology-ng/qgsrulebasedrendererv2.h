@@ -167,6 +167,13 @@ class CORE_EXPORT QgsRuleBasedRendererV2 : public QgsFeatureRendererV2
       protected:
         void initFilter();
 
+        class FilterIndex;
+
+        //! build the index of active children by the attribute their filters test
+        void initFilterIndex( const QgsFields& fields );
+        //! active children whose filter may match the feature, in their original order
+        const RuleList& activeChildrenForFeature( QgsFeature& feat, RuleList& candidates );
+
         Rule* mParent; // parent rule (NULL only for root rule)
         QgsSymbolV2* mSymbol;
         int mScaleMinDenom, mScaleMaxDenom;
@@ -179,6 +186,7 @@ class CORE_EXPORT QgsRuleBasedRendererV2 : public QgsFeatureRendererV2
         // temporary while rendering
         QList<int> mSymbolNormZLevels;
         RuleList mActiveChildren;
+        FilterIndex* mFilterIndex;
     };
 
     /////
@@ -31,6 +31,7 @@
 #include <QPicture>
 #include <QSvgRenderer>
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 
@@ -83,6 +84,8 @@ QgsSvgCache* QgsSvgCache::mInstance = 0;
 
 QgsSvgCache* QgsSvgCache::instance()
 {
+  static QMutex sInstanceMutex;
+  QMutexLocker locker( &sInstanceMutex );
   if ( !mInstance )
   {
     mInstance = new QgsSvgCache();
@@ -108,9 +111,11 @@ QgsSvgCache::~QgsSvgCache()
 }
 
 
-const QImage& QgsSvgCache::svgAsImage( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
-                                       double widthScaleFactor, double rasterScaleFactor, bool& fitsInCache )
+QImage QgsSvgCache::svgAsImage( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                                double widthScaleFactor, double rasterScaleFactor, bool& fitsInCache )
 {
+  QMutexLocker locker( &mMutex );
+
   fitsInCache = true;
   QgsSvgCacheEntry* currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
@@ -142,15 +147,19 @@ const QImage& QgsSvgCache::svgAsImage( const QString& file, double size, const Q
     {
       cacheImage( currentEntry );
     }
-    trimToMaximumSize();
   }
 
-  return *( currentEntry->image );
+  //copy while locked, the entry may be evicted by the trim or by another thread afterwards
+  QImage image = currentEntry->image ? *( currentEntry->image ) : QImage();
+  trimToMaximumSize();
+  return image;
 }
 
-const QPicture& QgsSvgCache::svgAsPicture( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
-    double widthScaleFactor, double rasterScaleFactor )
+QPicture QgsSvgCache::svgAsPicture( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                                    double widthScaleFactor, double rasterScaleFactor )
 {
+  QMutexLocker locker( &mMutex );
+
   QgsSvgCacheEntry* currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
   //if current entry picture is 0: cache picture for entry
@@ -158,10 +167,11 @@ const QPicture& QgsSvgCache::svgAsPicture( const QString& file, double size, con
   if ( !currentEntry->picture )
   {
     cachePicture( currentEntry );
-    trimToMaximumSize();
   }
 
-  return *( currentEntry->picture );
+  QPicture picture = *( currentEntry->picture );
+  trimToMaximumSize();
+  return picture;
 }
 
 QgsSvgCacheEntry* QgsSvgCache::insertSVG( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
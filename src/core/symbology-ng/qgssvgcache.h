@@ -21,6 +21,7 @@
 #include <QColor>
 #include <QMap>
 #include <QMultiHash>
+#include <QMutex>
 #include <QString>
 #include <QUrl>
 
@@ -69,10 +70,14 @@ class CORE_EXPORT QgsSvgCache : public QObject
     static QgsSvgCache* instance();
     ~QgsSvgCache();
 
-    const QImage& svgAsImage( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
-                              double widthScaleFactor, double rasterScaleFactor, bool& fitsInCache );
-    const QPicture& svgAsPicture( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
-                                  double widthScaleFactor, double rasterScaleFactor );
+    /**Returns the svg rendered as image. The cache may be used by several render threads,
+      so the image is returned as a (shallow) copy which stays valid when the entry is evicted.
+      If the image is too large for the cache, fitsInCache is false and a null image is returned*/
+    QImage svgAsImage( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                       double widthScaleFactor, double rasterScaleFactor, bool& fitsInCache );
+    /**Returns the svg as picture, a (shallow) copy like for svgAsImage*/
+    QPicture svgAsPicture( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                           double widthScaleFactor, double rasterScaleFactor );
 
     /**Tests if an svg file contains parameters for fill, outline color, outline width. If yes, possible default values are returned. If there are several
       default values in the svg file, only the first one is considered*/
@@ -123,6 +128,9 @@ class CORE_EXPORT QgsSvgCache : public QObject
     QgsSvgCacheEntry* mLeastRecentEntry;
     QgsSvgCacheEntry* mMostRecentEntry;
 
+    //Guards the entries, the lookup and the list for the parallel render jobs
+    QMutex mMutex;
+
     //Maximum cache size
     static const long mMaximumSize = 20000000;
 
@@ -69,6 +69,12 @@ void QgsLineSymbolLayerV2::renderPolygonOutline( const QPolygonF& points, QList<
   }
 }
 
+void QgsLineSymbolLayerV2::renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsSymbolV2RenderContext& context )
+{
+  for ( int i = 0; i < count; ++i )
+    renderPolyline( polylines[i], context );
+}
+
 
 void QgsFillSymbolLayerV2::drawPreviewIcon( QgsSymbolV2RenderContext& context, QSize size )
 {
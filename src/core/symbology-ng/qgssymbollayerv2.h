@@ -21,6 +21,7 @@
 #include <QMap>
 #include <QPointF>
 #include <QSet>
+#include <QVector>
 #include <QDomDocument>
 #include <QDomElement>
 
@@ -135,6 +136,12 @@ class CORE_EXPORT QgsLineSymbolLayerV2 : public QgsSymbolLayerV2
     //! @note added in v1.7
     virtual void renderPolygonOutline( const QPolygonF& points, QList<QPolygonF>* rings, QgsSymbolV2RenderContext& context );
 
+    //! render the first count polylines of a batch drawn with the same context,
+    //! the default implementation calls renderPolyline() for each of them
+    //! @note added in 2.0
+    //! @note not available in python bindings
+    virtual void renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsSymbolV2RenderContext& context );
+
     virtual void setWidth( double width ) { mWidth = width; }
     virtual double width() const { return mWidth; }
 
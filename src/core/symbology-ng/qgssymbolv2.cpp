@@ -588,6 +588,23 @@ void QgsLineSymbolV2::renderPolyline( const QPolygonF& points, const QgsFeature*
   }
 }
 
+void QgsLineSymbolV2::renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsRenderContext& context, int layer, bool selected )
+{
+  QgsSymbolV2RenderContext symbolContext( context, mOutputUnit, mAlpha, selected, mRenderHints, 0 );
+  if ( layer != -1 )
+  {
+    if ( layer >= 0 && layer < mLayers.count() )
+      (( QgsLineSymbolLayerV2* ) mLayers[layer] )->renderPolylines( polylines, count, symbolContext );
+    return;
+  }
+
+  for ( QgsSymbolLayerV2List::iterator it = mLayers.begin(); it != mLayers.end(); ++it )
+  {
+    QgsLineSymbolLayerV2* layer = ( QgsLineSymbolLayerV2* ) * it;
+    layer->renderPolylines( polylines, count, symbolContext );
+  }
+}
+
 
 QgsSymbolV2* QgsLineSymbolV2::clone() const
 {
@@ -19,6 +19,7 @@
 #include "qgis.h"
 #include <QList>
 #include <QMap>
+#include <QVector>
 
 class QColor;
 class QImage;
@@ -249,6 +250,12 @@ class CORE_EXPORT QgsLineSymbolV2 : public QgsSymbolV2
 
     void renderPolyline( const QPolygonF& points, const QgsFeature* f, QgsRenderContext& context, int layer = -1, bool selected = false );
 
+    //! render the first count polylines of a batch with the symbol layer (or with all layers
+    //! one after another if -1), the symbol layers get no feature in their context
+    //! @note added in 2.0
+    //! @note not available in python bindings
+    void renderPolylines( const QVector<QPolygonF>& polylines, int count, QgsRenderContext& context, int layer = -1, bool selected = false );
+
     virtual QgsSymbolV2* clone() const;
 };
 
@@ -1221,6 +1221,32 @@ bool QgsProjectParser::featureInfoWithWktGeometry() const
   return ( wktElem.text().compare( "true", Qt::CaseInsensitive ) == 0 );
 }
 
+bool QgsProjectParser::rasterBlockCacheEnabled() const
+{
+  if ( !mXMLDoc )
+  {
+    return false;
+  }
+
+  QDomElement qgisElem = mXMLDoc->documentElement();
+  if ( qgisElem.isNull() )
+  {
+    return false;
+  }
+  QDomElement propertiesElem = qgisElem.firstChildElement( "properties" );
+  if ( propertiesElem.isNull() )
+  {
+    return false;
+  }
+  QDomElement cacheElem = propertiesElem.firstChildElement( "WMSRasterBlockCache" );
+  if ( cacheElem.isNull() )
+  {
+    return false;
+  }
+
+  return ( cacheElem.text().compare( "true", Qt::CaseInsensitive ) == 0 );
+}
+
 QgsRectangle QgsProjectParser::mapRectangle() const
 {
   if ( !mXMLDoc )
@@ -1423,6 +1449,12 @@ QgsMapLayer* QgsProjectParser::createLayerFromElement( const QDomElement& elem,
   {
     layer->readXML( const_cast<QDomElement&>( elem ) ); //should be changed to const in QgsMapLayer
     layer->setLayerName( layerName( elem ) );
+    QgsRasterLayer* rasterLayer = qobject_cast<QgsRasterLayer*>( layer );
+    if ( rasterLayer && rasterBlockCacheEnabled() )
+    {
+      //the cached layers serve many tile requests at the same resolutions
+      rasterLayer->setBlockCacheEnabled( true );
+    }
     if ( useCache )
     {
       QgsMSLayerCache::instance()->insertLayer( absoluteUri, id, layer, mProjectPath );
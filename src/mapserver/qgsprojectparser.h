@@ -163,6 +163,8 @@ class QgsProjectParser: public QgsConfigParser
     /**Adds layers from a legend group to list (could be embedded or a normal group)*/
     void addLayersFromGroup( const QDomElement& legendGroupElem, QList<QgsMapLayer*>& layerList, bool useCache = true ) const;
     void addLayerFromLegendLayer( const QDomElement& legendLayerElem, QList<QgsMapLayer*>& layerList, bool useCache = true ) const;
+    /**True if the raster layers should keep the blocks read from their providers in memory (project property WMSRasterBlockCache)*/
+    bool rasterBlockCacheEnabled() const;
     /**Returns the text of the <id> element for a layer element
     @return id or a null string in case of error*/
     QString layerId( const QDomElement& layerElem ) const;
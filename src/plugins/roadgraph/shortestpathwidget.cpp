@@ -287,16 +287,30 @@ QgsGraph* RgShortestPathWidget::getPath( QgsPoint& p1, QgsPoint& p2 )
   if ( mCriterionName->currentIndex() > 0 )
     criterionNum = 1;
 
-  QgsGraph* shortestpathTree = QgsGraphAnalyzer::shortestTree( graph, startVertexIdx, criterionNum );
+  int stopVertexIdx = graph->findVertex( p2 );
 
-  delete graph;
-
-  if ( shortestpathTree->findVertex( p2 ) == -1 )
+  QList< int > arcs = QgsGraphAnalyzer::shortestPath( graph, startVertexIdx, stopVertexIdx, criterionNum, QgsGraphAnalyzer::AStar );
+  if ( arcs.isEmpty() && startVertexIdx != stopVertexIdx )
   {
+    delete graph;
     QMessageBox::critical( this, tr( "Path not found" ), tr( "Path not found" ) );
     return NULL;
   }
-  return shortestpathTree;
+
+  // graph holding just the path
+  QgsGraph* shortestpath = new QgsGraph();
+  int prevVertexIdx = shortestpath->addVertex( graph->vertex( startVertexIdx ).point() );
+  foreach ( int arcIdx, arcs )
+  {
+    const QgsGraphArc& arc = graph->arc( arcIdx );
+    int vertexIdx = shortestpath->addVertex( graph->vertex( arc.inVertex() ).point() );
+    shortestpath->addArc( prevVertexIdx, vertexIdx, arc.properties() );
+    prevVertexIdx = vertexIdx;
+  }
+
+  delete graph;
+
+  return shortestpath;
 }
 
 void RgShortestPathWidget::findingPath()
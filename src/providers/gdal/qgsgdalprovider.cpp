@@ -964,7 +964,8 @@ int QgsGdalProvider::capabilities() const
                    | QgsRasterDataProvider::BuildPyramids
                    | QgsRasterDataProvider::Histogram
                    | QgsRasterDataProvider::Create
-                   | QgsRasterDataProvider::Remove;
+                   | QgsRasterDataProvider::Remove
+                   | QgsRasterDataProvider::ThreadedRead;
   GDALDriverH myDriver = GDALGetDatasetDriver( mGdalDataset );
   QString name = GDALGetDriverShortName( myDriver );
   QgsDebugMsg( "driver short name = " + name );
@@ -48,6 +48,17 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryProvider* p, const
     if ( it != P->mFeatures.end() )
       mFeatureIdList.append( mRequest.filterFid() );
   }
+  else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    mUsingFeatureIdList = true;
+    foreach ( QgsFeatureId fid, mRequest.filterFids() )
+    {
+      if ( P->mFeatures.contains( fid ) )
+        mFeatureIdList.append( fid );
+    }
+    qSort( mFeatureIdList );
+    mFilterApplied = true;
+  }
   else
   {
     mUsingFeatureIdList = false;
@@ -392,13 +392,8 @@ bool QgsMemoryProvider::createSpatialIndex()
 {
   if ( !mSpatialIndex )
   {
-    mSpatialIndex = new QgsSpatialIndex();
-
-    // add existing features to index
-    for ( QgsFeatureMap::iterator it = mFeatures.begin(); it != mFeatures.end(); ++it )
-    {
-      mSpatialIndex->insertFeature( *it );
-    }
+    // bulk load existing features to index
+    mSpatialIndex = new QgsSpatialIndex( getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ) );
   }
   return true;
 }
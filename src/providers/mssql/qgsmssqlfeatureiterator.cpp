@@ -18,10 +18,35 @@
 #include "qgsmssqlfeatureiterator.h"
 #include "qgsmssqlprovider.h"
 #include "qgslogger.h"
+#include "qgssqlexpressioncompiler.h"
 
 #include <QObject>
 #include <QTextStream>
 
+//! translates filter expressions to Transact-SQL
+class QgsMssqlExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+    // string comparisons follow the collation of the column, which is case insensitive by default
+    QgsMssqlExpressionCompiler( const QgsFields& fields )
+        : QgsSqlExpressionCompiler( fields, CollationDependent ) {}
+
+  protected:
+    QString quotedIdentifier( const QString& identifier )
+    {
+      QString quoted = identifier;
+      quoted.replace( "]", "]]" );
+      return quoted.prepend( "[" ).append( "]" );
+    }
+
+    QString quotedValue( const QVariant& value )
+    {
+      if ( !value.isNull() && value.type() == QVariant::String )
+        return "N" + QgsSqlExpressionCompiler::quotedValue( value );
+      return QgsSqlExpressionCompiler::quotedValue( value );
+    }
+};
+
 
 QgsMssqlFeatureIterator::QgsMssqlFeatureIterator( QgsMssqlProvider* provider, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIterator( request ), mProvider( provider )
@@ -139,7 +164,7 @@ void QgsMssqlFeatureIterator::BuildStatement( const QgsFeatureRequest& request )
 
   bool filterAdded = false;
   // set spatial filter
-  if ( request.filterType() & QgsFeatureRequest::FilterRect )
+  if ( request.filterType() == QgsFeatureRequest::FilterRect )
   {
     // polygons should be CCW for SqlGeography
     QString r;
@@ -159,7 +184,7 @@ void QgsMssqlFeatureIterator::BuildStatement( const QgsFeatureRequest& request )
   }
 
   // set fid filter
-  if (( request.filterType() & QgsFeatureRequest::FilterFid ) && !mProvider->mFidColName.isEmpty() )
+  if (( request.filterType() == QgsFeatureRequest::FilterFid ) && !mProvider->mFidColName.isEmpty() )
   {
     // set attribute filter
     if ( !filterAdded )
@@ -169,6 +194,34 @@ void QgsMssqlFeatureIterator::BuildStatement( const QgsFeatureRequest& request )
     filterAdded = true;
   }
 
+  // set fids filter
+  if (( request.filterType() == QgsFeatureRequest::FilterFids ) && !mProvider->mFidColName.isEmpty() )
+  {
+    QStringList fids;
+    foreach ( QgsFeatureId fid, request.filterFids() )
+    {
+      fids << QString::number( fid );
+    }
+    QString fidsFilter = fids.isEmpty() ? "1=0" : QString( "[%1] in (%2)" ).arg( mProvider->mFidColName, fids.join( "," ) );
+    mStatement += QString( filterAdded ? " and %1" : " where %1" ).arg( fidsFilter );
+    filterAdded = true;
+    mFilterApplied = true;
+  }
+
+  // set expression filter
+  if ( request.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    QgsMssqlExpressionCompiler compiler( mProvider->mAttributeFields );
+    QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      mStatement += QString( filterAdded ? " and (%1)" : " where (%1)" ).arg( compiler.result() );
+      filterAdded = true;
+      // a partially compiled expression still needs to be tested on the fetched features
+      mFilterApplied = result == QgsSqlExpressionCompiler::Complete;
+    }
+  }
+
   if ( !mProvider->mSqlWhereClause.isEmpty() )
   {
     if ( !filterAdded )
@@ -19,6 +19,7 @@
 #include "qgsapplication.h"
 #include "qgslogger.h"
 #include "qgsgeometry.h"
+#include "qgssqlexpressioncompiler.h"
 
 #include <QTextCodec>
 
@@ -30,8 +31,22 @@
 // - mEncoding
 
 
+//! translates filter expressions to OGR SQL attribute filters
+class QgsOgrExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+    QgsOgrExpressionCompiler( QgsOgrProvider* p )
+        : QgsSqlExpressionCompiler( p->fields(), CaseInsensitiveLike ), mProvider( p ) {}
+
+  protected:
+    QString quotedIdentifier( const QString& identifier ) { return mProvider->quotedIdentifier( identifier ); }
+
+    QgsOgrProvider* mProvider;
+};
+
+
 QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrProvider* p, const QgsFeatureRequest& request )
-    : QgsAbstractFeatureIterator( request ), P( p )
+    : QgsAbstractFeatureIterator( request ), P( p ), mAttributeFilter( false )
 {
   // make sure that only one iterator is active
   if ( P->mActiveIterator )
@@ -60,6 +75,44 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrProvider* p, const QgsFeatur
     OGR_L_SetSpatialFilter( P->ogrLayer, 0 );
   }
 
+  // attribute filter to select features
+  QString attributeFilter;
+  bool filterComplete = true;
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    QStringList fids;
+    foreach ( QgsFeatureId fid, mRequest.filterFids() )
+    {
+      fids << QString::number( FID_TO_NUMBER( fid ) );
+    }
+    attributeFilter = fids.isEmpty() ? "FID < 0" : QString( "FID IN (%1)" ).arg( fids.join( "," ) );
+  }
+  else if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    QgsOgrExpressionCompiler compiler( P );
+    QgsSqlExpressionCompiler::Result result = compiler.compile( mRequest.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      attributeFilter = compiler.result();
+      filterComplete = result == QgsSqlExpressionCompiler::Complete;
+    }
+  }
+
+  if ( !attributeFilter.isEmpty() )
+  {
+    QgsDebugMsg( "Setting attribute filter " + attributeFilter );
+    if ( OGR_L_SetAttributeFilter( P->ogrLayer, P->mEncoding->fromUnicode( attributeFilter ).constData() ) == OGRERR_NONE )
+    {
+      mAttributeFilter = true;
+      // features still need to be tested if the expression was compiled just partially
+      mFilterApplied = filterComplete;
+    }
+    else
+    {
+      QgsDebugMsg( "Attribute filter rejected by OGR - testing the features instead" );
+    }
+  }
+
   //start with first feature
   rewind();
 }
@@ -73,6 +126,9 @@ void QgsOgrFeatureIterator::ensureRelevantFields()
 {
   bool needGeom = ( mRequest.filterType() == QgsFeatureRequest::FilterRect ) || !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
   QgsAttributeList attrs = ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : P->attributeIndexes();
+  // the attributes used by a filter expression must not be ignored
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+    attrs = P->attributeIndexes();
   P->setRelevantFields( needGeom, attrs );
   P->mRelevantFieldsForNextFeature = true;
 }
@@ -156,6 +212,12 @@ bool QgsOgrFeatureIterator::close()
   if ( mClosed )
     return false;
 
+  if ( mAttributeFilter )
+  {
+    OGR_L_SetAttributeFilter( P->ogrLayer, 0 );
+    mAttributeFilter = false;
+  }
+
   // tell provider that this iterator is not active anymore
   P->mActiveIterator = 0;
 
@@ -48,6 +48,9 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIterator
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature & f, int attindex );
 
     bool mFeatureFetched;
+
+    //! whether an attribute filter has been set on the OGR layer
+    bool mAttributeFilter;
 };
 
 
@@ -319,5 +319,6 @@ class QgsOgrProvider : public QgsVectorDataProvider
     bool syncToDisc();
 
     friend class QgsOgrFeatureIterator;
+    friend class QgsOgrExpressionCompiler;
     QgsOgrFeatureIterator* mActiveIterator; //!< pointer to currently active iterator (0 if none)
 };
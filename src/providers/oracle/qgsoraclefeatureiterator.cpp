@@ -19,9 +19,22 @@
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
 #include "qgsgeometry.h"
+#include "qgssqlexpressioncompiler.h"
 
 #include <QObject>
 
+//! translates filter expressions to Oracle SQL
+class QgsOracleExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+    QgsOracleExpressionCompiler( const QgsFields& fields )
+        : QgsSqlExpressionCompiler( fields ) {}
+
+  protected:
+    QString quotedIdentifier( const QString& identifier ) { return QgsOracleConn::quotedIdentifier( identifier ); }
+    QString quotedValue( const QVariant& value ) { return QgsOracleConn::quotedValue( value ); }
+};
+
 QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleProvider *p, const QgsFeatureRequest &request )
     : QgsAbstractFeatureIterator( request )
     , P( p )
@@ -75,6 +88,31 @@ QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleProvider *p, const
       whereClause = P->whereClause( request.filterFid() );
       break;
 
+    case QgsFeatureRequest::FilterFids:
+    {
+      QStringList clauses;
+      foreach ( QgsFeatureId fid, request.filterFids() )
+      {
+        clauses << "(" + P->whereClause( fid ) + ")";
+      }
+      whereClause = clauses.isEmpty() ? "1=0" : "(" + clauses.join( " OR " ) + ")";
+      mFilterApplied = true;
+    }
+    break;
+
+    case QgsFeatureRequest::FilterExpression:
+    {
+      QgsOracleExpressionCompiler compiler( P->mAttributeFields );
+      QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+      if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+      {
+        whereClause = "(" + compiler.result() + ")";
+        // a partially compiled expression still needs to be tested on the fetched features
+        mFilterApplied = result == QgsSqlExpressionCompiler::Complete;
+      }
+    }
+    break;
+
     case QgsFeatureRequest::FilterNone:
       break;
   }
@@ -200,6 +238,7 @@ bool QgsOracleFeatureIterator::nextFeature( QgsFeature& feature )
     }
 
     feature.setFeatureId( fid );
+    feature.setFields( &P->mAttributeFields ); // allow name-based attribute lookups
     QgsDebugMsgLevel( QString( "fid=%1" ).arg( fid ), 5 );
 
     // iterate attributes
@@ -17,6 +17,7 @@
 
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
+#include "qgssqlexpressioncompiler.h"
 
 #include <QObject>
 
@@ -43,6 +44,19 @@
 const int QgsPostgresFeatureIterator::sFeatureQueueSize = 2000;
 
 
+//! translates filter expressions to PostgreSQL
+class QgsPostgresExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+    QgsPostgresExpressionCompiler( const QgsFields& fields )
+        : QgsSqlExpressionCompiler( fields, ILikeSupported ) {}
+
+  protected:
+    QString quotedIdentifier( const QString& identifier ) { return QgsPostgresConn::quotedIdentifier( identifier ); }
+    QString quotedValue( const QVariant& value ) { return QgsPostgresConn::quotedValue( value ); }
+};
+
+
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresProvider* p, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIterator( request ), P( p )
     , mFeatureQueueSize( sFeatureQueueSize )
@@ -63,6 +77,22 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresProvider* p,
   {
     whereClause = P->whereClause( request.filterFid() );
   }
+  else if ( request.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    whereClause = whereClauseFids();
+    mFilterApplied = true;
+  }
+  else if ( request.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    QgsPostgresExpressionCompiler compiler( P->mAttributeFields );
+    QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      whereClause = "(" + compiler.result() + ")";
+      // a partially compiled expression still needs to be tested on the fetched features
+      mFilterApplied = result == QgsSqlExpressionCompiler::Complete;
+    }
+  }
 
   if ( !P->mSqlWhereClause.isEmpty() )
   {
@@ -192,6 +222,30 @@ bool QgsPostgresFeatureIterator::nextFeature( QgsFeature& feature )
 }
 
 
+QString QgsPostgresFeatureIterator::whereClauseFids()
+{
+  if ( mRequest.filterFids().isEmpty() )
+    return "false";
+
+  if ( P->mPrimaryKeyType == QgsPostgresProvider::pktInt )
+  {
+    QStringList fids;
+    foreach ( QgsFeatureId fid, mRequest.filterFids() )
+    {
+      fids << QString::number( fid );
+    }
+    return QString( "%1 IN (%2)" ).arg( P->quotedIdentifier( P->field( P->mPrimaryKeyAttrs[0] ).name() ) ).arg( fids.join( "," ) );
+  }
+
+  QStringList clauses;
+  foreach ( QgsFeatureId fid, mRequest.filterFids() )
+  {
+    clauses << "(" + P->whereClause( fid ) + ")";
+  }
+  return "(" + clauses.join( " OR " ) + ")";
+}
+
+
 bool QgsPostgresFeatureIterator::rewind()
 {
   if ( mClosed )
@@ -43,6 +43,8 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIterator
     QgsPostgresProvider* P;
 
     QString whereClauseRect();
+    //! where clause for FilterFids requests
+    QString whereClauseFids();
     bool getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature );
     void getFeatureAttribute( int idx, QgsPostgresResult& queryResult, int row, int& col, QgsFeature& feature );
     bool declareCursor( const QString& whereClause );
@@ -18,6 +18,7 @@
 
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
+#include "qgssqlexpressioncompiler.h"
 
 
 // from provider:
@@ -37,6 +38,18 @@
 // quotedIdentifier()
 
 
+//! translates filter expressions to SQLite SQL
+class QgsSpatiaLiteExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+    QgsSpatiaLiteExpressionCompiler( const QgsFields& fields )
+        : QgsSqlExpressionCompiler( fields, CaseInsensitiveLike ) {}
+
+  protected:
+    QString quotedIdentifier( const QString& identifier ) { return QgsSpatiaLiteProvider::quotedIdentifier( identifier ); }
+};
+
+
 QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteProvider* p, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIterator( request )
     , P( p )
@@ -60,6 +73,24 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteProvide
     whereClause += whereClauseFid();
   }
 
+  if ( request.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    whereClause += whereClauseFids();
+    mFilterApplied = true;
+  }
+
+  if ( request.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    QgsSpatiaLiteExpressionCompiler compiler( P->attributeFields );
+    QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      whereClause += "( " + compiler.result() + ")";
+      // a partially compiled expression still needs to be tested on the fetched features
+      mFilterApplied = result == QgsSqlExpressionCompiler::Complete;
+    }
+  }
+
   if ( !P->mSubsetString.isEmpty() )
   {
     if ( !whereClause.isEmpty() )
@@ -203,6 +234,16 @@ QString QgsSpatiaLiteFeatureIterator::whereClauseFid()
   return QString( "%1=%2" ).arg( quotedPrimaryKey() ).arg( mRequest.filterFid() );
 }
 
+QString QgsSpatiaLiteFeatureIterator::whereClauseFids()
+{
+  QStringList fids;
+  foreach ( QgsFeatureId fid, mRequest.filterFids() )
+  {
+    fids << QString::number( fid );
+  }
+  return QString( "%1 IN (%2)" ).arg( quotedPrimaryKey() ).arg( fids.join( "," ) );
+}
+
 QString QgsSpatiaLiteFeatureIterator::whereClauseRect()
 {
   QgsRectangle rect = mRequest.filterRect();
@@ -46,6 +46,7 @@ class QgsSpatiaLiteFeatureIterator : public QgsAbstractFeatureIterator
 
     QString whereClauseRect();
     QString whereClauseFid();
+    QString whereClauseFids();
     QString mbr( const QgsRectangle& rect );
     bool prepareStatement( QString whereClause );
     QString quotedPrimaryKey();
@@ -43,6 +43,14 @@ QgsWFSFeatureIterator::QgsWFSFeatureIterator( QgsWFSProvider* provider, const Qg
     case QgsFeatureRequest::FilterFid:
       mSelectedFeatures.push_back( request.filterFid() );
       break;
+    case QgsFeatureRequest::FilterFids:
+      foreach ( QgsFeatureId fid, request.filterFids() )
+      {
+        if ( mProvider->mFeatures.contains( fid ) )
+          mSelectedFeatures.push_back( fid );
+      }
+      mFilterApplied = true;
+      break;
     case QgsFeatureRequest::FilterNone:
       mSelectedFeatures = mProvider->mFeatures.keys();
     default: //QgsFeatureRequest::FilterNone
@@ -24,6 +24,7 @@
 #include <QTest>
 
 #include <cstdio>
+#include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -51,6 +52,8 @@ typedef SInt32 SRefCon;
 #endif
 
 #include "qgsbench.h"
+#include "qgsbenchcases.h"
+#include "qgsbenchsuite.h"
 #include "qgsapplication.h"
 #include <qgsconfig.h>
 #include <qgsversion.h>
@@ -81,6 +84,11 @@ void usage( std::string const & appName )
             << "\t[--configpath path]\tuse the given path for all user configuration\n"
             << "\t[--prefix path]\tpath to a different build of qgis, may be used to test old versions\n"
             << "\t[--quality]\trenderer hint(s), comma separated, possible values: Antialiasing,TextAntialiasing,SmoothPixmapTransform,NonCosmeticDefaultPen\n"
+            << "\t[--suite cases]\trun benchmark cases instead of the project rendering, comma separated: micro, macro, all or case name prefixes\n"
+            << "\t[--warmup iterations]\tnumber of untimed iterations of each case, default 1\n"
+            << "\t[--baseline filename]\tcompare the case medians with a log (JSON) written by an earlier run\n"
+            << "\t[--tolerance percent]\tslowdown reported as regression when comparing with the baseline, default 10\n"
+            << "\t[--list]\tlist the benchmark cases\n"
             << "\t[--help]\t\tthis text\n\n"
             << "  FILES:\n"
             << "    Files specified on the command line can include rasters,\n"
@@ -135,6 +143,11 @@ int main( int argc, char *argv[] )
   int mySnapshotWidth = 800;
   int mySnapshotHeight = 600;
   QString myQuality = "";
+  QString mySuite = "";
+  int myWarmup = 1;
+  QString myBaselineFileName = "";
+  double myTolerance = 10.0;
+  bool myList = false;
 
   // This behaviour will set initial extent of map canvas, but only if
   // there are no command line arguments. This gives a usable map
@@ -173,13 +186,18 @@ int main( int argc, char *argv[] )
       {"configpath", required_argument, 0, 'c'},
       {"prefix", required_argument, 0, 'r'},
       {"quality", required_argument, 0, 'q'},
+      {"suite", required_argument, 0, 'u'},
+      {"warmup", required_argument, 0, 'm'},
+      {"baseline", required_argument, 0, 'b'},
+      {"tolerance", required_argument, 0, 't'},
+      {"list", no_argument, 0, 'a'},
       {0, 0, 0, 0}
     };
 
     /* getopt_long stores the option index here. */
     int option_index = 0;
 
-    optionChar = getopt_long( argc, argv, "islwhpeocrq",
+    optionChar = getopt_long( argc, argv, "islwhpeocrqumbta",
                               long_options, &option_index );
 
     /* Detect the end of the options. */
@@ -242,6 +260,26 @@ int main( int argc, char *argv[] )
         myQuality = optarg;
         break;
 
+      case 'u':
+        mySuite = optarg;
+        break;
+
+      case 'm':
+        myWarmup = QString( optarg ).toInt();
+        break;
+
+      case 'b':
+        myBaselineFileName = QDir::convertSeparators( QFileInfo( QFile::decodeName( optarg ) ).absoluteFilePath() );
+        break;
+
+      case 't':
+        myTolerance = QString( optarg ).toDouble();
+        break;
+
+      case 'a':
+        myList = true;
+        break;
+
       case '?':
         usage( argv[0] );
         return 2;   // XXX need standard exit codes
@@ -322,6 +360,26 @@ int main( int argc, char *argv[] )
     {
       myQuality = argv[++i];
     }
+    else if ( i + 1 < argc && ( arg == "--suite" || arg == "-u" ) )
+    {
+      mySuite = argv[++i];
+    }
+    else if ( i + 1 < argc && ( arg == "--warmup" || arg == "-m" ) )
+    {
+      myWarmup = QString( argv[++i] ).toInt();
+    }
+    else if ( i + 1 < argc && ( arg == "--baseline" || arg == "-b" ) )
+    {
+      myBaselineFileName = QDir::convertSeparators( QFileInfo( QFile::decodeName( argv[++i] ) ).absoluteFilePath() );
+    }
+    else if ( i + 1 < argc && ( arg == "--tolerance" || arg == "-t" ) )
+    {
+      myTolerance = QString( argv[++i] ).toDouble();
+    }
+    else if ( arg == "--list" || arg == "-a" )
+    {
+      myList = true;
+    }
     else
     {
       myFileList.append( QDir::convertSeparators( QFileInfo( QFile::decodeName( argv[i] ) ).absoluteFilePath() ) );
@@ -529,6 +587,44 @@ int main( int argc, char *argv[] )
     }
   }
 
+  /////////////////////////////////////////////////////////////////////
+  // Run the benchmark cases if requested
+  /////////////////////////////////////////////////////////////////////
+  if ( myList || !mySuite.isEmpty() )
+  {
+    int result = 0;
+    QgsBenchSuite suite( myIterations, myWarmup );
+    addBenchCases( suite, qbench, mySnapshotWidth, mySnapshotHeight );
+
+    if ( myList )
+    {
+      foreach ( QString name, suite.caseNames() )
+      {
+        std::cout << name.toLocal8Bit().constData() << std::endl;
+      }
+    }
+    else
+    {
+      suite.run( mySuite );
+
+      if ( myLogFileName != "" )
+      {
+        suite.saveLog( myLogFileName );
+      }
+
+      suite.printLog();
+
+      if ( myBaselineFileName != "" )
+      {
+        // non zero exit code if a case got slower or the baseline is not readable
+        result = suite.compare( myBaselineFileName, myTolerance ) == 0 ? 0 : 1;
+      }
+    }
+
+    delete qbench;
+    return result;
+  }
+
   qbench->render();
 
   if ( mySnapshotFileName != "" )
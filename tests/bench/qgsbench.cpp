@@ -163,10 +163,8 @@ void QgsBench::setExtent( const QgsRectangle & extent )
   mSetExtent = true;
 }
 
-void QgsBench::render()
+void QgsBench::setupMapRenderer()
 {
-  QgsDebugMsg( "entered" );
-
   QgsDebugMsg( "extent: " +  mMapRenderer->extent().toString() );
 
   QMap<QString, QgsMapLayer*> layersMap = QgsMapLayerRegistry::instance()->mapLayers();
@@ -190,6 +188,13 @@ void QgsBench::render()
 
   // Necessary?
   //mMapRenderer->setLabelingEngine( new QgsPalLabeling() );
+}
+
+void QgsBench::render()
+{
+  QgsDebugMsg( "entered" );
+
+  setupMapRenderer();
 
   mImage = new QImage( mWidth, mHeight, QImage::Format_ARGB32_Premultiplied );
   mImage->fill( 0 );
@@ -292,7 +297,8 @@ QString QgsBench::serialize( QMap<QString, QVariant> theMap, int level )
         list.append( space2 + "\"" + i.key() + "\": " + QString( "%1" ).arg( i.value().toInt() ) );
         break;
       case QMetaType::Double:
-        list.append( space2 + "\"" + i.key() + "\": " + QString( "%1" ).arg( i.value().toDouble(), 0, 'f', 3 ) );
+        // significant digits, so that the times of the micro benchmarks are not rounded to zero
+        list.append( space2 + "\"" + i.key() + "\": " + QString::number( i.value().toDouble(), 'g', 12 ) );
         break;
       case QMetaType::QString:
         list.append( space2 + "\"" + i.key() + "\": \"" + i.value().toString() + "\"" );
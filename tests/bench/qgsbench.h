@@ -43,6 +43,11 @@ class QgsBench :  public QObject
 
     void render();
 
+    // set layers, extent and projection of the map renderer
+    void setupMapRenderer();
+
+    QgsMapRenderer* mapRenderer() { return mMapRenderer; }
+
     void printLog();
 
     bool openProject( const QString & fileName );
@@ -53,9 +58,10 @@ class QgsBench :  public QObject
 
     void saveLog( const QString & fileName );
 
-    QString serialize( QMap<QString, QVariant> theMap, int level = 0 );
+    static QString serialize( QMap<QString, QVariant> theMap, int level = 0 );
 
     void  setRenderHints( QPainter::RenderHints hints ) { mRendererHints = hints; }
+    QPainter::RenderHints renderHints() const { return mRendererHints; }
 
   public slots:
     void readProject( const QDomDocument &doc );
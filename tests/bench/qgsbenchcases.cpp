@@ -0,0 +1,359 @@
+/***************************************************************************
+                 qgsbenchcases.cpp  - Benchmark cases
+                             -------------------
+    begin                : 2013-03-20
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <cmath>
+
+#include <QImage>
+#include <QPainter>
+
+#include "qgsbench.h"
+#include "qgsbenchcases.h"
+#include "qgsbenchsuite.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgscoordinatetransform.h"
+#include "qgsexpression.h"
+#include "qgsfeature.h"
+#include "qgsfield.h"
+#include "qgsgeometry.h"
+#include "qgsmaplayerregistry.h"
+#include "qgsmaprenderer.h"
+#include "qgsmaptopixel.h"
+#include "qgspallabeling.h"
+#include "qgsrasterblock.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterpipe.h"
+#include "qgsrendercontext.h"
+#include "qgsrendererv2.h"
+#include "qgsvectorlayer.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// number of items processed by one iteration of the micro benchmarks
+static const int MICRO_FEATURES = 10000;
+static const int MICRO_POLYGONS = 1000;
+static const int MICRO_POINTS = 100000;
+
+// result of the measured code, so that the compiler cannot drop it
+static volatile double gSink = 0;
+
+// evaluation of a prepared expression
+class QgsExpressionBenchCase : public QgsBenchCase
+{
+  public:
+    QgsExpressionBenchCase( const QString& name, const QString& expression )
+        : QgsBenchCase( name, Micro ), mExpression( expression ) {}
+
+    bool setUp()
+    {
+      mFields.append( QgsField( "id", QVariant::Int ) );
+      mFields.append( QgsField( "value", QVariant::Double ) );
+      mFields.append( QgsField( "name", QVariant::String ) );
+
+      mFeatures.resize( MICRO_FEATURES );
+      for ( int i = 0; i < MICRO_FEATURES; i++ )
+      {
+        mFeatures[i].setFeatureId( i );
+        mFeatures[i].initAttributes( 3 );
+        mFeatures[i].setAttribute( 0, i );
+        mFeatures[i].setAttribute( 1, i * 0.5 );
+        mFeatures[i].setAttribute( 2, QString( "feature %1" ).arg( i ) );
+      }
+
+      return !mExpression.hasParserError() && mExpression.prepare( mFields );
+    }
+
+    void run()
+    {
+      int n = 0;
+      for ( int i = 0; i < mFeatures.size(); i++ )
+      {
+        n += mExpression.evaluate( &mFeatures[i] ).toInt();
+      }
+      gSink = n;
+    }
+
+    void tearDown()
+    {
+      mFeatures.clear();
+    }
+
+  private:
+    QgsExpression mExpression;
+    QgsFields mFields;
+    QVector<QgsFeature> mFeatures;
+};
+
+// gives access to the WKB conversion of the renderers
+struct QgsBenchRendererAccess : public QgsFeatureRendererV2
+{
+  static unsigned char* getPolygon( QPolygonF& pts, QList<QPolygonF>& holes, QgsRenderContext& context, unsigned char* wkb )
+  {
+    return _getPolygon( pts, holes, context, wkb );
+  }
+};
+
+// conversion of polygon WKB to screen coordinates, optionally with a coordinate transform
+// and simplification of the rings
+class QgsGetPolygonBenchCase : public QgsBenchCase
+{
+  public:
+    QgsGetPolygonBenchCase( const QString& name, bool transform, double simplifyThreshold = 0 )
+        : QgsBenchCase( name, Micro ), mTransform( transform ), mCoordinateTransform( 0 )
+    {
+      mContext.setSimplifyThreshold( simplifyThreshold );
+    }
+
+    bool setUp()
+    {
+      // polygons with 200 vertices and a hole in a grid over the world
+      for ( int i = 0; i < MICRO_POLYGONS; i++ )
+      {
+        double cx = -170 + ( i % 40 ) * 8.5;
+        double cy = -80 + ( i / 40 ) * 6.4;
+        QgsPolygon polygon( 2 );
+        for ( int j = 0; j <= 200; j++ )
+        {
+          double a = 2 * M_PI * ( j % 200 ) / 200;
+          polygon[0].append( QgsPoint( cx + 2 * cos( a ), cy + 2 * sin( a ) ) );
+        }
+        for ( int j = 0; j <= 50; j++ )
+        {
+          double a = -2 * M_PI * ( j % 50 ) / 50;
+          polygon[1].append( QgsPoint( cx + cos( a ), cy + sin( a ) ) );
+        }
+        mGeometries.append( QgsGeometry::fromPolygon( polygon ) );
+      }
+
+      if ( mTransform )
+      {
+        QgsCoordinateReferenceSystem source, dest;
+        source.createFromOgcWmsCrs( "EPSG:4326" );
+        dest.createFromOgcWmsCrs( "EPSG:3857" );
+        if ( !source.isValid() || !dest.isValid() )
+          return false;
+        mCoordinateTransform = new QgsCoordinateTransform( source, dest );
+        mContext.setCoordinateTransform( mCoordinateTransform );
+        mContext.setMapToPixel( QgsMapToPixel( 40000, 2e7, -2e7, -2e7 ) );
+      }
+      else
+      {
+        mContext.setMapToPixel( QgsMapToPixel( 0.36, 90, -90, -180 ) );
+      }
+      return true;
+    }
+
+    void run()
+    {
+      QPolygonF pts;
+      QList<QPolygonF> holes;
+      int n = 0;
+      foreach ( QgsGeometry* geometry, mGeometries )
+      {
+        holes.clear();
+        QgsBenchRendererAccess::getPolygon( pts, holes, mContext, geometry->asWkb() );
+        n += pts.size();
+      }
+      gSink = n;
+    }
+
+    void tearDown()
+    {
+      qDeleteAll( mGeometries );
+      mGeometries.clear();
+      mContext.setCoordinateTransform( 0 );
+      delete mCoordinateTransform;
+      mCoordinateTransform = 0;
+    }
+
+  private:
+    bool mTransform;
+    QList<QgsGeometry*> mGeometries;
+    QgsRenderContext mContext;
+    QgsCoordinateTransform* mCoordinateTransform;
+};
+
+// transformation of coordinate arrays with QgsCoordinateTransform::transformCoords
+class QgsTransformCoordsBenchCase : public QgsBenchCase
+{
+  public:
+    QgsTransformCoordsBenchCase( const QString& name )
+        : QgsBenchCase( name, Micro ), mCoordinateTransform( 0 ) {}
+
+    bool setUp()
+    {
+      QgsCoordinateReferenceSystem source, dest;
+      source.createFromOgcWmsCrs( "EPSG:4326" );
+      dest.createFromOgcWmsCrs( "EPSG:3857" );
+      if ( !source.isValid() || !dest.isValid() )
+        return false;
+      mCoordinateTransform = new QgsCoordinateTransform( source, dest );
+
+      for ( int i = 0; i < MICRO_POINTS; i++ )
+      {
+        mX.append( -180 + 360.0 * ( i % 1000 ) / 1000 );
+        mY.append( -80 + 160.0 * ( i / 1000 ) / ( MICRO_POINTS / 1000 ) );
+        mZ.append( 0 );
+      }
+      mTransformedX.resize( MICRO_POINTS );
+      mTransformedY.resize( MICRO_POINTS );
+      mTransformedZ.resize( MICRO_POINTS );
+      return true;
+    }
+
+    void prepareRun()
+    {
+      // the coordinates are transformed in place, the buffers are not shared so run() does not copy them
+      qCopy( mX.constBegin(), mX.constEnd(), mTransformedX.begin() );
+      qCopy( mY.constBegin(), mY.constEnd(), mTransformedY.begin() );
+      qCopy( mZ.constBegin(), mZ.constEnd(), mTransformedZ.begin() );
+    }
+
+    void run()
+    {
+      mCoordinateTransform->transformInPlace( mTransformedX, mTransformedY, mTransformedZ );
+      gSink = mTransformedX[0];
+    }
+
+    void tearDown()
+    {
+      delete mCoordinateTransform;
+      mCoordinateTransform = 0;
+    }
+
+  private:
+    QgsCoordinateTransform* mCoordinateTransform;
+    QVector<double> mX, mY, mZ;
+    QVector<double> mTransformedX, mTransformedY, mTransformedZ;
+};
+
+// iteration over all features of a vector layer
+class QgsFeatureIterationBenchCase : public QgsBenchCase
+{
+  public:
+    QgsFeatureIterationBenchCase( QgsVectorLayer* layer )
+        : QgsBenchCase( QString( "features/%1/%2" ).arg( layer->providerType(), layer->name() ), Macro ), mLayer( layer ) {}
+
+    void run()
+    {
+      QgsFeatureIterator fit = mLayer->getFeatures();
+      QgsFeature f;
+      int n = 0;
+      while ( fit.nextFeature( f ) )
+      {
+        n++;
+      }
+      gSink = n;
+    }
+
+  private:
+    QgsVectorLayer* mLayer;
+};
+
+// block of one stage of a raster pipe, the time includes the stages before it
+class QgsRasterPipeBenchCase : public QgsBenchCase
+{
+  public:
+    QgsRasterPipeBenchCase( QgsRasterLayer* layer, const QString& stage, QgsRasterInterface* iface, int width, int height )
+        : QgsBenchCase( QString( "raster/%1/%2" ).arg( layer->name(), stage ), Macro )
+        , mLayer( layer ), mInterface( iface ), mWidth( width ), mHeight( height ) {}
+
+    void run()
+    {
+      QgsRasterBlock* block = mInterface->block( 1, mLayer->extent(), mWidth, mHeight );
+      gSink = block && !block->isEmpty() ? 1 : 0;
+      delete block;
+    }
+
+  private:
+    QgsRasterLayer* mLayer;
+    QgsRasterInterface* mInterface;
+    int mWidth;
+    int mHeight;
+};
+
+// rendering of the whole project, optionally with labeling
+class QgsRenderBenchCase : public QgsBenchCase
+{
+  public:
+    QgsRenderBenchCase( const QString& name, QgsBench* bench, int width, int height, bool labeling )
+        : QgsBenchCase( name, Macro ), mBench( bench ), mImage( width, height, QImage::Format_ARGB32_Premultiplied ), mLabeling( labeling ) {}
+
+    bool setUp()
+    {
+      mBench->setupMapRenderer();
+      QgsMapRenderer* renderer = mBench->mapRenderer();
+      renderer->setOutputSize( mImage.size(), mImage.logicalDpiX() );
+      renderer->setLabelingEngine( mLabeling ? new QgsPalLabeling() : 0 );
+      return true;
+    }
+
+    void run()
+    {
+      mImage.fill( 0 );
+      QPainter painter( &mImage );
+      painter.setRenderHints( mBench->renderHints() );
+      mBench->mapRenderer()->render( &painter );
+    }
+
+    void tearDown()
+    {
+      mBench->mapRenderer()->setLabelingEngine( 0 );
+    }
+
+  private:
+    QgsBench* mBench;
+    QImage mImage;
+    bool mLabeling;
+};
+
+void addBenchCases( QgsBenchSuite& suite, QgsBench* bench, int width, int height )
+{
+  suite.addCase( new QgsExpressionBenchCase( "expression/arithmetic", "value * 2 + id > 100 AND id % 3 = 0" ) );
+  suite.addCase( new QgsExpressionBenchCase( "expression/string", "name LIKE 'feature 1%' OR upper(name) = 'FEATURE 5'" ) );
+  suite.addCase( new QgsGetPolygonBenchCase( "renderer/getPolygon", false ) );
+  suite.addCase( new QgsGetPolygonBenchCase( "renderer/getPolygon/transform", true ) );
+  suite.addCase( new QgsGetPolygonBenchCase( "renderer/getPolygon/simplify", false, 1.0 ) );
+  suite.addCase( new QgsTransformCoordsBenchCase( "transform/transformCoords" ) );
+
+  QMap<QString, QgsMapLayer*> layers = QgsMapLayerRegistry::instance()->mapLayers();
+  foreach ( QgsMapLayer* layer, layers )
+  {
+    if ( QgsVectorLayer* vl = qobject_cast<QgsVectorLayer*>( layer ) )
+    {
+      suite.addCase( new QgsFeatureIterationBenchCase( vl ) );
+    }
+    else if ( QgsRasterLayer* rl = qobject_cast<QgsRasterLayer*>( layer ) )
+    {
+      QgsRasterPipe* pipe = rl->pipe();
+      if ( pipe->provider() )
+        suite.addCase( new QgsRasterPipeBenchCase( rl, "provider", pipe->provider(), width, height ) );
+      if ( pipe->renderer() )
+        suite.addCase( new QgsRasterPipeBenchCase( rl, "renderer", pipe->renderer(), width, height ) );
+      if ( pipe->resampleFilter() )
+        suite.addCase( new QgsRasterPipeBenchCase( rl, "resampler", pipe->resampleFilter(), width, height ) );
+      if ( pipe->projector() )
+        suite.addCase( new QgsRasterPipeBenchCase( rl, "projector", pipe->projector(), width, height ) );
+    }
+  }
+
+  if ( !layers.isEmpty() )
+  {
+    suite.addCase( new QgsRenderBenchCase( "render", bench, width, height, false ) );
+    suite.addCase( new QgsRenderBenchCase( "render/labeling", bench, width, height, true ) );
+  }
+}
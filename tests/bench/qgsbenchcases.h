@@ -0,0 +1,27 @@
+/***************************************************************************
+                 qgsbenchcases.h  - Benchmark cases
+                             -------------------
+    begin                : 2013-03-20
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSBENCHCASES_H
+#define QGSBENCHCASES_H
+
+class QgsBench;
+class QgsBenchSuite;
+
+// add the micro benchmarks on generated data and the macro benchmarks
+// on the layers loaded from the project to the suite
+void addBenchCases( QgsBenchSuite& suite, QgsBench* bench, int width, int height );
+
+#endif // QGSBENCHCASES_H
@@ -0,0 +1,398 @@
+/***************************************************************************
+                 qgsbenchsuite.cpp  - Benchmark suites
+                             -------------------
+    begin                : 2013-03-20
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <cmath>
+#include <iostream>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+#include "qgsbench.h"
+#include "qgsbenchsuite.h"
+#include "qgslogger.h"
+
+QgsBenchSuite::QgsBenchSuite( int theIterations, int theWarmup )
+    : mIterations( qMax( theIterations, 1 ) ), mWarmup( qMax( theWarmup, 0 ) )
+{
+}
+
+QgsBenchSuite::~QgsBenchSuite()
+{
+  qDeleteAll( mCases );
+}
+
+void QgsBenchSuite::addCase( QgsBenchCase* benchCase )
+{
+  mCases.append( benchCase );
+}
+
+QStringList QgsBenchSuite::caseNames() const
+{
+  QStringList names;
+  foreach ( QgsBenchCase* benchCase, mCases )
+  {
+    names << benchCase->name();
+  }
+  return names;
+}
+
+bool QgsBenchSuite::selected( const QgsBenchCase* benchCase, const QStringList& selection ) const
+{
+  foreach ( QString s, selection )
+  {
+    if ( s == "all" ||
+         ( s == "micro" && benchCase->kind() == QgsBenchCase::Micro ) ||
+         ( s == "macro" && benchCase->kind() == QgsBenchCase::Macro ) ||
+         benchCase->name().startsWith( s ) )
+      return true;
+  }
+  return false;
+}
+
+void QgsBenchSuite::run( const QString& selection )
+{
+  QStringList selectionList = selection.split( ',', QString::SkipEmptyParts );
+
+  QMap<QString, QVariant> casesMap;
+  foreach ( QgsBenchCase* benchCase, mCases )
+  {
+    if ( !selected( benchCase, selectionList ) )
+      continue;
+
+    QgsDebugMsg( "running " + benchCase->name() );
+    if ( !benchCase->setUp() )
+    {
+      fprintf( stderr, "Cannot set up %s, skipped\n", benchCase->name().toLocal8Bit().constData() );
+      continue;
+    }
+
+    for ( int i = 0; i < mWarmup; i++ )
+    {
+      benchCase->prepareRun();
+      benchCase->run();
+    }
+
+    // wall clock time, so that the cases running in several threads get faster
+    QVector<double> times;
+    QElapsedTimer timer;
+    for ( int i = 0; i < mIterations; i++ )
+    {
+      benchCase->prepareRun();
+      timer.start();
+      benchCase->run();
+      times.append( timer.nsecsElapsed() / 1000000.0 );
+    }
+
+    benchCase->tearDown();
+
+    casesMap.insert( benchCase->name(), statistics( times ) );
+  }
+
+  mLogMap.insert( "iterations", mIterations );
+  mLogMap.insert( "warmup", mWarmup );
+  mLogMap.insert( "cases", casesMap );
+}
+
+QMap<QString, QVariant> QgsBenchSuite::statistics( QVector<double> times )
+{
+  QMap<QString, QVariant> map;
+  int n = times.size();
+  if ( n == 0 )
+    return map;
+
+  qSort( times );
+
+  double sum = 0;
+  for ( int i = 0; i < n; i++ )
+  {
+    sum += times[i];
+  }
+  double mean = sum / n;
+
+  double sumSquares = 0;
+  for ( int i = 0; i < n; i++ )
+  {
+    sumSquares += ( times[i] - mean ) * ( times[i] - mean );
+  }
+
+  // nearest rank percentile
+  int p95 = qMax(( int ) ceil( 0.95 * n ) - 1, 0 );
+
+  map.insert( "min", times[0] );
+  map.insert( "max", times[n - 1] );
+  map.insert( "mean", mean );
+  map.insert( "median", n % 2 ? times[n / 2] : ( times[n / 2 - 1] + times[n / 2] ) / 2 );
+  map.insert( "p95", times[p95] );
+  map.insert( "stdev", n > 1 ? sqrt( sumSquares / ( n - 1 ) ) : 0.0 );
+  return map;
+}
+
+void QgsBenchSuite::printLog()
+{
+  QMap<QString, QVariant> casesMap = mLogMap["cases"].toMap();
+  QMap<QString, QVariant>::const_iterator i = casesMap.constBegin();
+  for ( ; i != casesMap.constEnd(); ++i )
+  {
+    QMap<QString, QVariant> stats = i.value().toMap();
+    QString s = QString( "%1: median %2 ms, p95 %3 ms, stdev %4 ms" ).arg( i.key() )
+                .arg( stats["median"].toDouble(), 0, 'g', 4 )
+                .arg( stats["p95"].toDouble(), 0, 'g', 4 )
+                .arg( stats["stdev"].toDouble(), 0, 'g', 4 );
+    std::cout << s.toLocal8Bit().constData() << std::endl;
+  }
+}
+
+void QgsBenchSuite::saveLog( const QString & fileName )
+{
+  QFile file( fileName );
+  file.open( QIODevice::WriteOnly | QIODevice::Text );
+  QTextStream out( &file );
+  out << QgsBench::serialize( mLogMap ).toAscii().constData() << "\n";
+  file.close();
+}
+
+int QgsBenchSuite::compare( const QString & fileName, double tolerance )
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+  {
+    fprintf( stderr, "Cannot open baseline %s\n", fileName.toLocal8Bit().constData() );
+    return -1;
+  }
+
+  bool ok;
+  QMap<QString, QVariant> baselineCases = parseJson( QTextStream( &file ).readAll(), &ok ).toMap()["cases"].toMap();
+  if ( !ok )
+  {
+    fprintf( stderr, "Cannot parse baseline %s\n", fileName.toLocal8Bit().constData() );
+    return -1;
+  }
+
+  int regressions = 0;
+  QMap<QString, QVariant> casesMap = mLogMap["cases"].toMap();
+  QMap<QString, QVariant>::const_iterator i = casesMap.constBegin();
+  for ( ; i != casesMap.constEnd(); ++i )
+  {
+    if ( !baselineCases.contains( i.key() ) )
+    {
+      std::cout << i.key().toLocal8Bit().constData() << ": not in baseline" << std::endl;
+      continue;
+    }
+
+    double current = i.value().toMap()["median"].toDouble();
+    double baseline = baselineCases[i.key()].toMap()["median"].toDouble();
+    double change = baseline > 0 ? ( current - baseline ) / baseline * 100 : 0;
+
+    QString status = "ok";
+    if ( change > tolerance )
+    {
+      status = "REGRESSION";
+      regressions++;
+    }
+    else if ( change < -tolerance )
+    {
+      status = "improved";
+    }
+
+    QString s = QString( "%1: %2 ms -> %3 ms (%4%5%) %6" ).arg( i.key() )
+                .arg( baseline, 0, 'g', 4 )
+                .arg( current, 0, 'g', 4 )
+                .arg( change >= 0 ? "+" : "" )
+                .arg( change, 0, 'f', 1 )
+                .arg( status );
+    std::cout << s.toLocal8Bit().constData() << std::endl;
+  }
+  return regressions;
+}
+
+// minimal recursive descent JSON parser, enough to read the logs written by saveLog()
+class QgsBenchJsonParser
+{
+  public:
+    QgsBenchJsonParser( const QString& json ) : mJson( json ), mPos( 0 ), mOk( true ) {}
+
+    QVariant parse( bool* ok )
+    {
+      QVariant value = parseValue();
+      skipSpaces();
+      if ( mPos != mJson.size() )
+        mOk = false;
+      if ( ok )
+        *ok = mOk;
+      return value;
+    }
+
+  private:
+    void skipSpaces()
+    {
+      while ( mPos < mJson.size() && mJson[mPos].isSpace() )
+        mPos++;
+    }
+
+    bool expect( QChar c )
+    {
+      skipSpaces();
+      if ( mPos < mJson.size() && mJson[mPos] == c )
+      {
+        mPos++;
+        return true;
+      }
+      mOk = false;
+      return false;
+    }
+
+    QVariant parseValue()
+    {
+      skipSpaces();
+      if ( mPos >= mJson.size() )
+      {
+        mOk = false;
+        return QVariant();
+      }
+
+      QChar c = mJson[mPos];
+      if ( c == '{' )
+        return parseObject();
+      if ( c == '[' )
+        return parseArray();
+      if ( c == '"' )
+        return parseString();
+      if ( mJson.mid( mPos, 4 ) == "true" )
+      {
+        mPos += 4;
+        return true;
+      }
+      if ( mJson.mid( mPos, 5 ) == "false" )
+      {
+        mPos += 5;
+        return false;
+      }
+      if ( mJson.mid( mPos, 4 ) == "null" )
+      {
+        mPos += 4;
+        return QVariant();
+      }
+      return parseNumber();
+    }
+
+    QVariant parseObject()
+    {
+      QMap<QString, QVariant> map;
+      expect( '{' );
+      skipSpaces();
+      if ( mPos < mJson.size() && mJson[mPos] == '}' )
+      {
+        mPos++;
+        return map;
+      }
+      while ( mOk )
+      {
+        skipSpaces();
+        QString key = parseString();
+        if ( !expect( ':' ) )
+          break;
+        map.insert( key, parseValue() );
+        skipSpaces();
+        if ( mPos < mJson.size() && mJson[mPos] == ',' )
+        {
+          mPos++;
+          continue;
+        }
+        expect( '}' );
+        break;
+      }
+      return map;
+    }
+
+    QVariant parseArray()
+    {
+      QList<QVariant> list;
+      expect( '[' );
+      skipSpaces();
+      if ( mPos < mJson.size() && mJson[mPos] == ']' )
+      {
+        mPos++;
+        return list;
+      }
+      while ( mOk )
+      {
+        list.append( parseValue() );
+        skipSpaces();
+        if ( mPos < mJson.size() && mJson[mPos] == ',' )
+        {
+          mPos++;
+          continue;
+        }
+        expect( ']' );
+        break;
+      }
+      return list;
+    }
+
+    QString parseString()
+    {
+      QString s;
+      if ( !expect( '"' ) )
+        return s;
+      while ( mPos < mJson.size() && mJson[mPos] != '"' )
+      {
+        if ( mJson[mPos] == '\\' && mPos + 1 < mJson.size() )
+        {
+          mPos++;
+          QChar e = mJson[mPos];
+          if ( e == 'n' ) s += '\n';
+          else if ( e == 't' ) s += '\t';
+          else if ( e == 'u' && mPos + 4 < mJson.size() )
+          {
+            s += QChar( mJson.mid( mPos + 1, 4 ).toUShort( 0, 16 ) );
+            mPos += 4;
+          }
+          else s += e;
+        }
+        else
+        {
+          s += mJson[mPos];
+        }
+        mPos++;
+      }
+      expect( '"' );
+      return s;
+    }
+
+    QVariant parseNumber()
+    {
+      int start = mPos;
+      while ( mPos < mJson.size() && ( mJson[mPos].isDigit() || QString( "+-.eE" ).contains( mJson[mPos] ) ) )
+        mPos++;
+      bool ok;
+      double value = mJson.mid( start, mPos - start ).toDouble( &ok );
+      if ( !ok )
+        mOk = false;
+      return value;
+    }
+
+    QString mJson;
+    int mPos;
+    bool mOk;
+};
+
+QVariant QgsBenchSuite::parseJson( const QString& json, bool* ok )
+{
+  QgsBenchJsonParser parser( json );
+  return parser.parse( ok );
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+                 qgsbenchsuite.h  - Benchmark suites
+                             -------------------
+    begin                : 2013-03-20
+    copyright            : (C) 2013 by the QGIS Project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSBENCHSUITE_H
+#define QGSBENCHSUITE_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+/** One named benchmark. Micro benchmarks time a single function on generated
+ * data, macro benchmarks time a whole operation on the loaded project.
+ */
+class QgsBenchCase
+{
+  public:
+    enum Kind
+    {
+      Micro,
+      Macro
+    };
+
+    QgsBenchCase( const QString& name, Kind kind ) : mName( name ), mKind( kind ) {}
+    virtual ~QgsBenchCase() {}
+
+    QString name() const { return mName; }
+    Kind kind() const { return mKind; }
+
+    // prepare the data, called once before the warmup iterations, false to skip the case
+    virtual bool setUp() { return true; }
+
+    // reset the data modified by run(), called before each iteration and not timed
+    virtual void prepareRun() {}
+
+    // the timed code, called once per iteration
+    virtual void run() = 0;
+
+    // release the data, called after the last iteration
+    virtual void tearDown() {}
+
+  private:
+    QString mName;
+    Kind mKind;
+};
+
+/** Runs benchmark cases with warmup iterations, computes statistics of the
+ * wall clock times and compares them to a baseline log.
+ */
+class QgsBenchSuite
+{
+  public:
+    QgsBenchSuite( int theIterations, int theWarmup );
+    ~QgsBenchSuite();
+
+    // add a case, the suite takes ownership
+    void addCase( QgsBenchCase* benchCase );
+
+    // names of all cases
+    QStringList caseNames() const;
+
+    // run the cases selected by comma separated list of "micro", "macro", "all" or case name prefixes
+    void run( const QString& selection );
+
+    void printLog();
+
+    void saveLog( const QString & fileName );
+
+    // compare the medians with a log saved by saveLog(), tolerance in percents
+    // @return number of cases slower than the baseline by more than the tolerance, -1 if the baseline cannot be read
+    int compare( const QString & fileName, double tolerance );
+
+    // statistics of times in milliseconds: min, max, mean, median, p95, stdev
+    static QMap<QString, QVariant> statistics( QVector<double> times );
+
+    // parse a JSON document, objects are returned as QMap<QString, QVariant>
+    static QVariant parseJson( const QString& json, bool* ok = 0 );
+
+  private:
+    bool selected( const QgsBenchCase* benchCase, const QStringList& selection ) const;
+
+    int mIterations;
+    int mWarmup;
+
+    QList<QgsBenchCase*> mCases;
+
+    // log map
+    QMap<QString, QVariant> mLogMap;
+};
+
+#endif // QGSBENCHSUITE_H
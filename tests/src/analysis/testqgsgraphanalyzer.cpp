@@ -0,0 +1,180 @@
+/***************************************************************************
+  testqgsgraphanalyzer.cpp
+  --------------------------------------
+Date                 : March 2013
+Copyright            : (C) 2013 by the QGIS Project
+Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+
+#include <limits>
+
+//header for class being tested
+#include <qgsgraph.h>
+#include <qgsgraphanalyzer.h>
+#include <qgscompactgraph.h>
+
+class TestQgsGraphAnalyzer: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void compactDijkstra();
+    void sameAsDijkstra();
+    void unreachable();
+  private:
+    //! add arcs in both directions
+    void addArcs( int vertex1, int vertex2, double cost );
+    //! arcs of the path in the tree of dijkstra()
+    QList<int> treePath( const QVector<int>& tree, int startVertexIdx, int stopVertexIdx );
+
+    QgsGraph* mGraph;
+};
+
+void TestQgsGraphAnalyzer::addArcs( int vertex1, int vertex2, double cost )
+{
+  mGraph->addArc( vertex1, vertex2, QVector<QVariant>() << cost );
+  mGraph->addArc( vertex2, vertex1, QVector<QVariant>() << cost );
+}
+
+QList<int> TestQgsGraphAnalyzer::treePath( const QVector<int>& tree, int startVertexIdx, int stopVertexIdx )
+{
+  QList<int> path;
+  if ( tree[ stopVertexIdx ] == -1 )
+    return path;
+
+  for ( int v = stopVertexIdx; v != startVertexIdx; v = mGraph->arc( tree[v] ).outVertex() )
+  {
+    path.prepend( tree[v] );
+  }
+  return path;
+}
+
+void TestQgsGraphAnalyzer::initTestCase()
+{
+  // two rows of three vertices, the shortest paths between them are unique
+  //
+  //  3 -1.1- 4 -1.3- 5
+  //  |       |       |
+  // 1.2     2.0     0.7
+  //  |       |       |
+  //  0 -1.0- 1 -1.5- 2       6 (only an arc to 0)
+  mGraph = new QgsGraph();
+  mGraph->addVertex( QgsPoint( 0, 0 ) );
+  mGraph->addVertex( QgsPoint( 1, 0 ) );
+  mGraph->addVertex( QgsPoint( 2, 0 ) );
+  mGraph->addVertex( QgsPoint( 0, 1 ) );
+  mGraph->addVertex( QgsPoint( 1, 1 ) );
+  mGraph->addVertex( QgsPoint( 2, 1 ) );
+  mGraph->addVertex( QgsPoint( 5, 5 ) );
+  addArcs( 0, 1, 1.0 );
+  addArcs( 1, 2, 1.5 );
+  addArcs( 0, 3, 1.2 );
+  addArcs( 3, 4, 1.1 );
+  addArcs( 4, 5, 1.3 );
+  addArcs( 1, 4, 2.0 );
+  addArcs( 2, 5, 0.7 );
+  mGraph->addArc( 6, 0, QVector<QVariant>() << 1.0 );
+}
+
+void TestQgsGraphAnalyzer::cleanupTestCase()
+{
+  delete mGraph;
+}
+
+void TestQgsGraphAnalyzer::compactDijkstra()
+{
+  QgsCompactGraph compact( mGraph, 0 );
+  QCOMPARE( compact.vertexCount(), mGraph->vertexCount() );
+  QCOMPARE( compact.outArc().size(), mGraph->arcCount() );
+  QCOMPARE( compact.inArc().size(), mGraph->arcCount() );
+  QVERIFY( compact.heuristicFactor() > 0 );
+
+  QVector<int> tree;
+  QVector<double> cost;
+  QgsGraphAnalyzer::dijkstra( mGraph, 0, 0, &tree, &cost );
+  QCOMPARE( cost[5], 3.2 );
+  QCOMPARE( treePath( tree, 0, 5 ), QList<int>() << 0 << 2 << 12 );
+
+  for ( int start = 0; start < mGraph->vertexCount(); ++start )
+  {
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, &tree, &cost );
+    QVector<int> compactTree;
+    QVector<double> compactCost;
+    QgsGraphAnalyzer::dijkstra( &compact, start, &compactTree, &compactCost );
+    QCOMPARE( compactTree, tree );
+    QCOMPARE( compactCost, cost );
+  }
+}
+
+void TestQgsGraphAnalyzer::sameAsDijkstra()
+{
+  QgsCompactGraph compact( mGraph, 0 );
+  QList<QgsGraphAnalyzer::Algorithm> algorithms;
+  algorithms << QgsGraphAnalyzer::Dijkstra << QgsGraphAnalyzer::AStar << QgsGraphAnalyzer::Bidirectional;
+
+  for ( int start = 0; start < mGraph->vertexCount(); ++start )
+  {
+    QVector<int> tree;
+    QVector<double> cost;
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, &tree, &cost );
+
+    // including start == stop, which has no arcs and no cost
+    for ( int stop = 0; stop < mGraph->vertexCount(); ++stop )
+    {
+      QList<int> expectedPath = treePath( tree, start, stop );
+      double expectedCost = start == stop ? 0.0 : cost[ stop ];
+
+      foreach ( QgsGraphAnalyzer::Algorithm algorithm, algorithms )
+      {
+        double pathCost = -1;
+        QList<int> path = QgsGraphAnalyzer::shortestPath( &compact, start, stop, algorithm, &pathCost );
+        QCOMPARE( path, expectedPath );
+        if ( expectedCost == std::numeric_limits<double>::infinity() )
+          QVERIFY( pathCost == expectedCost );
+        else
+          QVERIFY( qAbs( pathCost - expectedCost ) < 1e-12 );
+
+        QCOMPARE( QgsGraphAnalyzer::shortestPath( mGraph, start, stop, 0, algorithm ), path );
+      }
+    }
+  }
+}
+
+void TestQgsGraphAnalyzer::unreachable()
+{
+  QgsCompactGraph compact( mGraph, 0 );
+  double inf = std::numeric_limits<double>::infinity();
+
+  QVector<int> tree;
+  QVector<double> cost;
+  QgsGraphAnalyzer::dijkstra( &compact, 0, &tree, &cost );
+  QCOMPARE( tree[6], -1 );
+  QVERIFY( cost[6] == inf );
+
+  double pathCost = 0;
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, 3, 6, QgsGraphAnalyzer::AStar, &pathCost ).isEmpty() );
+  QVERIFY( pathCost == inf );
+  pathCost = 0;
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, 3, 6, QgsGraphAnalyzer::Bidirectional, &pathCost ).isEmpty() );
+  QVERIFY( pathCost == inf );
+
+  // the other way round there is a path
+  QCOMPARE( QgsGraphAnalyzer::shortestPath( &compact, 6, 3, QgsGraphAnalyzer::Bidirectional, &pathCost ).size(), 2 );
+  QVERIFY( qAbs( pathCost - 2.2 ) < 1e-12 );
+
+  // invalid vertices
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, 0, 7, QgsGraphAnalyzer::AStar, &pathCost ).isEmpty() );
+  QVERIFY( pathCost == inf );
+}
+
+QTEST_MAIN( TestQgsGraphAnalyzer )
+#include "moc_testqgsgraphanalyzer.cxx"
@@ -0,0 +1,204 @@
+/***************************************************************************
+  testqgslinevectorlayerdirector.cpp
+  --------------------------------------
+Date                 : March 2013
+Copyright            : (C) 2013 by the QGIS Project
+Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+
+#include <limits>
+#include <set>
+#include <utility>
+
+#include <qgsapplication.h>
+#include <qgscoordinatereferencesystem.h>
+#include <qgsgeometry.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+//header for class being tested
+#include <qgsgraph.h>
+#include <qgsgraphbuilder.h>
+#include <qgslinevectorlayerdirector.h>
+
+class TestQgsLineVectorLayerDirector: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void tiePoints();
+    void nearestSegments();
+  private:
+    //! builds the graph of the lines in both directions
+    QgsGraph* makeGraph( const QList<QgsPolyline>& lines, const QVector<QgsPoint>& additionalPoints, QVector<QgsPoint>& tiedPoints );
+};
+
+void TestQgsLineVectorLayerDirector::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsLineVectorLayerDirector::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsGraph* TestQgsLineVectorLayerDirector::makeGraph( const QList<QgsPolyline>& lines, const QVector<QgsPoint>& additionalPoints, QVector<QgsPoint>& tiedPoints )
+{
+  QgsVectorLayer layer( "LineString", "lines", "memory" );
+  if ( !layer.isValid() )
+    return 0;
+
+  QgsFeatureList features;
+  foreach ( const QgsPolyline& line, lines )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromPolyline( line ) );
+    features << feature;
+  }
+  layer.dataProvider()->addFeatures( features );
+
+  QgsLineVectorLayerDirector director( &layer, -1, "direct", "reverse", "both", 3 );
+  QgsGraphBuilder builder( layer.crs(), false );
+  director.makeGraph( &builder, additionalPoints, tiedPoints );
+  return builder.graph();
+}
+
+void TestQgsLineVectorLayerDirector::tiePoints()
+{
+  // the sides of a square, the left one starts at -0.0
+  //
+  //  (0,10) ---- (10,10)
+  //    |            |
+  //    |            |
+  //  (-0,0) ---- (10,0)
+  QList<QgsPolyline> lines;
+  lines << ( QgsPolyline() << QgsPoint( 0, 0 ) << QgsPoint( 10, 0 ) << QgsPoint( 10, 10 ) );
+  lines << ( QgsPolyline() << QgsPoint( 0, 10 ) << QgsPoint( 10, 10 ) );
+  lines << ( QgsPolyline() << QgsPoint( -0.0, 0 ) << QgsPoint( 0, 10 ) );
+
+  QVector<QgsPoint> additionalPoints;
+  additionalPoints << QgsPoint( 5, -1 )     // below the bottom side
+  << QgsPoint( 5, 5 )                       // as far from all sides, tied to the first segment
+  << QgsPoint( 9, 9 )                       // as far from the right and top sides
+  << QgsPoint( -0.0, 3 )                    // on the left side
+  << QgsPoint( 20, 20 )                     // outside of the lines, nearest to a corner
+  << QgsPoint( -0.0, -0.0 );                // on the corner starting at -0.0
+
+  QVector<QgsPoint> tiedPoints;
+  QgsGraph* graph = makeGraph( lines, additionalPoints, tiedPoints );
+  QVERIFY( graph );
+
+  QCOMPARE( tiedPoints.size(), additionalPoints.size() );
+  QCOMPARE( tiedPoints[0].x(), 5.0 );
+  QCOMPARE( tiedPoints[0].y(), 0.0 );
+  QCOMPARE( tiedPoints[1].x(), 5.0 );
+  QCOMPARE( tiedPoints[1].y(), 0.0 );
+  QCOMPARE( tiedPoints[2].x(), 10.0 );
+  QCOMPARE( tiedPoints[2].y(), 9.0 );
+  QCOMPARE( tiedPoints[3].x(), 0.0 );
+  QCOMPARE( tiedPoints[3].y(), 3.0 );
+  QCOMPARE( tiedPoints[4].x(), 10.0 );
+  QCOMPARE( tiedPoints[4].y(), 10.0 );
+  QCOMPARE( tiedPoints[5].x(), 0.0 );
+  QCOMPARE( tiedPoints[5].y(), 0.0 );
+
+  // the corners and the tied points (5,0), (10,9) and (0,3), the corner at -0.0 is the one at 0
+  QCOMPARE( graph->vertexCount(), 7 );
+  // the bottom, right and left sides are split by the tied points, in both directions
+  QCOMPARE( graph->arcCount(), 14 );
+  for ( int i = 0; i < graph->vertexCount(); ++i )
+  {
+    QCOMPARE( graph->vertex( i ).outArc().size(), 2 );
+    QCOMPARE( graph->vertex( i ).inArc().size(), 2 );
+  }
+
+  delete graph;
+}
+
+void TestQgsLineVectorLayerDirector::nearestSegments()
+{
+  // random lines and tie points, some of them outside of the lines
+  qsrand( 42 );
+  QList<QgsPolyline> lines;
+  QVector<QgsPoint> segmentStart;
+  QVector<QgsPoint> segmentEnd;
+  for ( int i = 0; i < 40; ++i )
+  {
+    QgsPolyline line;
+    int pointCount = 2 + i % 3;
+    for ( int j = 0; j < pointCount; ++j )
+    {
+      line << QgsPoint( 100 + qrand() % 10000 / 100.0, 100 + qrand() % 10000 / 100.0 );
+      if ( j > 0 )
+      {
+        segmentStart << line[j - 1];
+        segmentEnd << line[j];
+      }
+    }
+    lines << line;
+  }
+
+  QVector<QgsPoint> additionalPoints;
+  for ( int i = 0; i < 100; ++i )
+  {
+    additionalPoints << QgsPoint( 80 + qrand() % 14000 / 100.0, 80 + qrand() % 14000 / 100.0 );
+  }
+
+  QVector<QgsPoint> tiedPoints;
+  QgsGraph* graph = makeGraph( lines, additionalPoints, tiedPoints );
+  QVERIFY( graph );
+
+  // the nearest point on the first nearest segment
+  std::set< std::pair<double, double> > vertices;
+  QVector< std::set< std::pair<double, double> > > pointsOnSegment( segmentStart.size() );
+  for ( int s = 0; s < segmentStart.size(); ++s )
+  {
+    pointsOnSegment[s].insert( std::make_pair( segmentStart[s].x(), segmentStart[s].y() ) );
+    pointsOnSegment[s].insert( std::make_pair( segmentEnd[s].x(), segmentEnd[s].y() ) );
+    vertices.insert( pointsOnSegment[s].begin(), pointsOnSegment[s].end() );
+  }
+  for ( int i = 0; i < additionalPoints.size(); ++i )
+  {
+    int nearest = -1;
+    double minDist = std::numeric_limits<double>::infinity();
+    QgsPoint expected;
+    for ( int s = 0; s < segmentStart.size(); ++s )
+    {
+      QgsPoint segmentPoint;
+      double d = additionalPoints[i].sqrDistToSegment( segmentStart[s].x(), segmentStart[s].y(), segmentEnd[s].x(), segmentEnd[s].y(), segmentPoint );
+      if ( d < minDist )
+      {
+        minDist = d;
+        nearest = s;
+        expected = segmentPoint;
+      }
+    }
+    QCOMPARE( tiedPoints[i].x(), expected.x() );
+    QCOMPARE( tiedPoints[i].y(), expected.y() );
+    pointsOnSegment[ nearest ].insert( std::make_pair( expected.x(), expected.y() ) );
+    vertices.insert( std::make_pair( expected.x(), expected.y() ) );
+  }
+
+  int arcCount = 0;
+  for ( int s = 0; s < pointsOnSegment.size(); ++s )
+    arcCount += 2 * (( int ) pointsOnSegment[s].size() - 1 );
+
+  QCOMPARE( graph->vertexCount(), ( int ) vertices.size() );
+  QCOMPARE( graph->arcCount(), arcCount );
+
+  delete graph;
+}
+
+QTEST_MAIN( TestQgsLineVectorLayerDirector )
+#include "moc_testqgslinevectorlayerdirector.cxx"
@@ -0,0 +1,215 @@
+/***************************************************************************
+  testqgsninecellfilters.cpp
+  --------------------------------------
+Date                 : March 2013
+Copyright            : (C) 2013 by the QGIS Project
+Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+#include <QDir>
+#include <QVector>
+
+#include <cmath>
+#include <gdal.h>
+#include <cpl_string.h>
+
+//header for class being tested
+#include <qgsninecellfilter.h>
+#include <qgsslopefilter.h>
+#include <qgsaspectfilter.h>
+#include <qgshillshadefilter.h>
+#include <qgsruggednessfilter.h>
+#include <qgstotalcurvaturefilter.h>
+
+// slope filter whose window function returns the center cell
+class CenterSlopeFilter : public QgsSlopeFilter
+{
+  public:
+    CenterSlopeFilter( const QString& inputFile, const QString& outputFile, const QString& outputFormat )
+        : QgsSlopeFilter( inputFile, outputFile, outputFormat ) {}
+
+    float processNineCellWindow( float* x11, float* x21, float* x31,
+                                 float* x12, float* x22, float* x32,
+                                 float* x13, float* x23, float* x33 )
+    {
+      Q_UNUSED( x11 ); Q_UNUSED( x21 ); Q_UNUSED( x31 ); Q_UNUSED( x12 );
+      Q_UNUSED( x32 ); Q_UNUSED( x13 ); Q_UNUSED( x23 ); Q_UNUSED( x33 );
+      return *x22;
+    }
+};
+
+class TestQgsNineCellFilters: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void slope();
+    void aspect();
+    void hillshade();
+    void ruggedness();
+    void totalCurvature();
+    void reimplementedWindow();
+  private:
+    //! runs the filter on the DEM and compares every output cell with processNineCellWindow
+    void compareWithWindows( QgsNineCellFilter& filter );
+    //! reads the output raster
+    QVector<float> readOutput();
+
+    QString mInputFile;
+    QString mOutputFile;
+    //! the DEM with a border of nodata values around it
+    QVector<float> mPadded;
+};
+
+// the processed strips have 130 rows (the input has blocks of 10 rows)
+static const int COLS = 23;
+static const int ROWS = 300;
+static const float NODATA = -1.0f;
+
+void TestQgsNineCellFilters::initTestCase()
+{
+  GDALAllRegister();
+  mInputFile = QDir::tempPath() + QDir::separator() + "ninecellfilters_dem.tif";
+  mOutputFile = QDir::tempPath() + QDir::separator() + "ninecellfilters_result.tif";
+
+  // a smooth surface with nodata cells at the borders, inside and next to the strip boundaries
+  QVector<float> dem( COLS * ROWS );
+  for ( int row = 0; row < ROWS; ++row )
+  {
+    for ( int col = 0; col < COLS; ++col )
+    {
+      dem[ row * COLS + col ] = 100 + 40 * sin( col * 0.3 ) * cos( row * 0.05 ) + 0.2 * row;
+    }
+  }
+  int nodataCells[][2] = { { 0, 0 }, { 0, 7 }, { 12, COLS - 1 }, { 50, 10 }, { 51, 11 }, { 129, 3 }, { 130, 4 },
+    { 130, 5 }, { 259, 0 }, { 260, 20 }, { ROWS - 1, 15 }, { ROWS - 1, COLS - 1 }
+  };
+  for ( unsigned int i = 0; i < sizeof( nodataCells ) / sizeof( nodataCells[0] ); ++i )
+  {
+    dem[ nodataCells[i][0] * COLS + nodataCells[i][1] ] = NODATA;
+  }
+
+  mPadded.fill( NODATA, ( COLS + 2 ) * ( ROWS + 2 ) );
+  for ( int row = 0; row < ROWS; ++row )
+  {
+    qCopy( dem.constBegin() + row * COLS, dem.constBegin() + ( row + 1 ) * COLS, mPadded.begin() + ( row + 1 ) * ( COLS + 2 ) + 1 );
+  }
+
+  char** options = CSLSetNameValue( NULL, "BLOCKYSIZE", "10" );
+  GDALDatasetH dataset = GDALCreate( GDALGetDriverByName( "GTiff" ), mInputFile.toLocal8Bit().data(), COLS, ROWS, 1, GDT_Float32, options );
+  CSLDestroy( options );
+  QVERIFY( dataset );
+  double geotransform[6] = { 1000, 10, 0, 5000, 0, -10 };
+  GDALSetGeoTransform( dataset, geotransform );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  GDALSetRasterNoDataValue( band, NODATA );
+  QCOMPARE( GDALRasterIO( band, GF_Write, 0, 0, COLS, ROWS, dem.data(), COLS, ROWS, GDT_Float32, 0, 0 ), CE_None );
+  GDALClose( dataset );
+}
+
+void TestQgsNineCellFilters::cleanupTestCase()
+{
+  QFile::remove( mInputFile );
+  QFile::remove( mOutputFile );
+}
+
+QVector<float> TestQgsNineCellFilters::readOutput()
+{
+  QVector<float> output( COLS * ROWS );
+  GDALDatasetH dataset = GDALOpen( mOutputFile.toLocal8Bit().data(), GA_ReadOnly );
+  if ( !dataset )
+    return QVector<float>();
+  GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, 0, 0, COLS, ROWS, output.data(), COLS, ROWS, GDT_Float32, 0, 0 );
+  GDALClose( dataset );
+  return output;
+}
+
+void TestQgsNineCellFilters::compareWithWindows( QgsNineCellFilter& filter )
+{
+  QCOMPARE( filter.processRaster( 0 ), 0 );
+  QVector<float> output = readOutput();
+  QCOMPARE( output.size(), COLS * ROWS );
+
+  int w = COLS + 2;
+  int nodataResults = 0;
+  for ( int row = 0; row < ROWS; ++row )
+  {
+    for ( int col = 0; col < COLS; ++col )
+    {
+      float* x11 = mPadded.data() + row * w + col;
+      float* x12 = x11 + w;
+      float* x13 = x12 + w;
+      float expected = filter.processNineCellWindow( x11, x11 + 1, x11 + 2, x12, x12 + 1, x12 + 2, x13, x13 + 1, x13 + 2 );
+      float value = output[ row * COLS + col ];
+      if ( expected == filter.outputNodataValue() )
+        nodataResults++;
+      if ( qAbs( value - expected ) > 1e-4 * qMax( 1.0f, qAbs( expected ) ) )
+      {
+        QFAIL( QString( "row %1 column %2: %3 instead of %4" ).arg( row ).arg( col ).arg( value ).arg( expected ).toLocal8Bit().data() );
+      }
+    }
+  }
+  // the nodata cells are part of the test
+  QVERIFY( nodataResults > 0 );
+}
+
+void TestQgsNineCellFilters::slope()
+{
+  QgsSlopeFilter filter( mInputFile, mOutputFile, "GTiff" );
+  QVERIFY( filter.prepareForConcurrentUse() );
+  compareWithWindows( filter );
+}
+
+void TestQgsNineCellFilters::aspect()
+{
+  QgsAspectFilter filter( mInputFile, mOutputFile, "GTiff" );
+  compareWithWindows( filter );
+}
+
+void TestQgsNineCellFilters::hillshade()
+{
+  QgsHillshadeFilter filter( mInputFile, mOutputFile, "GTiff", 315, 45 );
+  filter.setZFactor( 2.0 );
+  compareWithWindows( filter );
+}
+
+void TestQgsNineCellFilters::ruggedness()
+{
+  QgsRuggednessFilter filter( mInputFile, mOutputFile, "GTiff" );
+  compareWithWindows( filter );
+}
+
+void TestQgsNineCellFilters::totalCurvature()
+{
+  QgsTotalCurvatureFilter filter( mInputFile, mOutputFile, "GTiff" );
+  compareWithWindows( filter );
+}
+
+void TestQgsNineCellFilters::reimplementedWindow()
+{
+  CenterSlopeFilter filter( mInputFile, mOutputFile, "GTiff" );
+  QVERIFY( !filter.prepareForConcurrentUse() );
+  QCOMPARE( filter.processRaster( 0 ), 0 );
+  QVector<float> output = readOutput();
+  QCOMPARE( output.size(), COLS * ROWS );
+
+  // the output is the input, not the slope
+  for ( int row = 0; row < ROWS; ++row )
+  {
+    for ( int col = 0; col < COLS; ++col )
+    {
+      QCOMPARE( output[ row * COLS + col ], mPadded[( row + 1 ) * ( COLS + 2 ) + col + 1 ] );
+    }
+  }
+}
+
+QTEST_MAIN( TestQgsNineCellFilters )
+#include "moc_testqgsninecellfilters.cxx"
@@ -40,6 +40,7 @@ class TestContrastEnhancements: public QObject
     void clipMinMaxEnhancementTest();
     void linearMinMaxEnhancementWithClipTest();
     void linearMinMaxEnhancementTest();
+    void displayLookupTableTest();
   private:
     QString mReport;
 };
@@ -102,6 +103,35 @@ void TestContrastEnhancements::linearMinMaxEnhancementTest()
   //Original pixel value of 240 should be scaled to 255
   QVERIFY( 255.0 == myEnhancement.enhance( 240.0 ) ) ;
 }
+void TestContrastEnhancements::displayLookupTableTest()
+{
+  QgsContrastEnhancement myEnhancement( QgsContrastEnhancement::QGS_Int16 );
+  myEnhancement.setContrastEnhancementAlgorithm( QgsContrastEnhancement::StretchAndClipToMinimumMaximum );
+  myEnhancement.setMinimumValue( -100.0 );
+  myEnhancement.setMaximumValue( 100.0 );
+
+  const int* myTable = myEnhancement.displayLookupTable();
+  QVERIFY( myTable );
+  //the table is indexed from the minimum value of the data type
+  int myOffset = 32768;
+  //values out of range are clipped
+  QCOMPARE( myTable[-101 + myOffset], -1 );
+  QCOMPARE( myTable[101 + myOffset], -1 );
+  //and the others are stretched the same way as single values
+  QCOMPARE( myTable[-100 + myOffset], 0 );
+  QCOMPARE( myTable[100 + myOffset], 255 );
+  QCOMPARE( myTable[50 + myOffset], myEnhancement.enhanceContrast( 50.0 ) );
+
+  //the table follows changes of the range
+  myEnhancement.setMaximumValue( 50.0 );
+  QCOMPARE( myEnhancement.displayLookupTable()[100 + myOffset], -1 );
+  QCOMPARE( myEnhancement.displayLookupTable()[50 + myOffset], 255 );
+
+  //no table for data types larger than 16 bits
+  QgsContrastEnhancement myFloatEnhancement( QgsContrastEnhancement::QGS_Float32 );
+  QVERIFY( !myFloatEnhancement.displayLookupTable() );
+}
+
 QTEST_MAIN( TestContrastEnhancements )
 #include "moc_testcontrastenhancements.cxx"
 
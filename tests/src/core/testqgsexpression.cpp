@@ -216,6 +216,16 @@ class TestQgsExpression: public QObject
       QTest::newRow( "like 2" ) << "'hello' like 'lo'" << false << QVariant( 0 );
       QTest::newRow( "like 3" ) << "'hello' like '%LO'" << false << QVariant( 0 );
       QTest::newRow( "ilike" ) << "'hello' ilike '%LO'" << false << QVariant( 1 );
+      QTest::newRow( "like prefix" ) << "'hello' like 'he%'" << false << QVariant( 1 );
+      QTest::newRow( "like suffix" ) << "'hello' like '%llo'" << false << QVariant( 1 );
+      QTest::newRow( "like contains" ) << "'hello' like '%el%'" << false << QVariant( 1 );
+      QTest::newRow( "like exact" ) << "'hello' like 'hello'" << false << QVariant( 1 );
+      QTest::newRow( "like all" ) << "'hello' like '%%'" << false << QVariant( 1 );
+      QTest::newRow( "like empty" ) << "'hello' like ''" << false << QVariant( 0 );
+      QTest::newRow( "like regexp chars" ) << "'hello' like 'h.llo'" << false << QVariant( 1 );
+      QTest::newRow( "not like contains" ) << "'hello' not like '%EL%'" << false << QVariant( 1 );
+      QTest::newRow( "ilike contains" ) << "'hello' ilike '%EL%'" << false << QVariant( 1 );
+      QTest::newRow( "not ilike prefix" ) << "'hello' not ilike 'HE%'" << false << QVariant( 0 );
       QTest::newRow( "regexp 1" ) << "'hello' ~ 'll'" << false << QVariant( 1 );
       QTest::newRow( "regexp 2" ) << "'hello' ~ '^ll'" << false << QVariant( 0 );
       QTest::newRow( "regexp 3" ) << "'hello' ~ 'llo$'" << false << QVariant( 1 );
@@ -409,6 +419,146 @@ class TestQgsExpression: public QObject
       QCOMPARE( res2.type(), QVariant::Invalid );
     }
 
+    void eval_prepared()
+    {
+      QgsFields fields;
+      fields.append( QgsField( "id", QVariant::Int ) );
+      fields.append( QgsField( "value", QVariant::Double ) );
+      fields.append( QgsField( "name", QVariant::String ) );
+
+      QgsFeature f;
+      f.initAttributes( 3 );
+      f.setAttribute( 0, QVariant( 7 ) );
+      f.setAttribute( 1, QVariant( 2.5 ) );
+      f.setAttribute( 2, QVariant( "10" ) );
+
+      // constant subexpressions are evaluated once
+      QgsExpression exp( "id + 2 * 3 - length('abc')" );
+      QCOMPARE( exp.prepare( fields ), true );
+      QCOMPARE( exp.rootNode()->isStatic(), false );
+      QCOMPARE( exp.rootNode()->resultType(), QVariant::Int );
+      QCOMPARE( exp.evaluate( &f ), QVariant( 10 ) );
+
+      QgsExpression exp2( "upper('a') || 'b'" );
+      QCOMPARE( exp2.prepare( fields ), true );
+      QCOMPARE( exp2.rootNode()->isStatic(), true );
+      QCOMPARE( exp2.evaluate( &f ), QVariant( "Ab" ) );
+
+      // errors in constant subexpressions are reported on evaluation
+      QgsExpression exp3( "id + -'abc'" );
+      QCOMPARE( exp3.prepare( fields ), true );
+      QCOMPARE( exp3.hasEvalError(), false );
+      QCOMPARE( exp3.evaluate( &f ), QVariant() );
+      QCOMPARE( exp3.hasEvalError(), true );
+
+      // numeric operands with known types
+      QgsExpression exp4( "value * 2 + id" );
+      QCOMPARE( exp4.prepare( fields ), true );
+      QCOMPARE( exp4.rootNode()->resultType(), QVariant::Double );
+      QCOMPARE( exp4.evaluate( &f ), QVariant( 12.0 ) );
+
+      // string values are still compared as numbers when both can be converted
+      QgsExpression exp5( "name = 10.0" );
+      QCOMPARE( exp5.prepare( fields ), true );
+      QCOMPARE( exp5.evaluate( &f ), QVariant( 1 ) );
+
+      QgsExpression exp6( "name = '10.0'" );
+      QCOMPARE( exp6.prepare( fields ), true );
+      QCOMPARE( exp6.evaluate( &f ), QVariant( 1 ) );
+
+      QgsExpression exp7( "name < 'abc'" );
+      QCOMPARE( exp7.prepare( fields ), true );
+      QCOMPARE( exp7.evaluate( &f ), QVariant( 1 ) );
+
+      // NULL values take the generic path
+      f.setAttribute( 1, QVariant( QVariant::Double ) );
+      QCOMPARE( exp4.evaluate( &f ), QVariant() );
+      QgsExpression exp8( "value IS NULL AND id > 5" );
+      QCOMPARE( exp8.prepare( fields ), true );
+      QCOMPARE( exp8.evaluate( &f ), QVariant( 1 ) );
+
+      // values depending on the context are not constant
+      QgsExpression exp9( "$rownum + 1" );
+      QCOMPARE( exp9.prepare( fields ), true );
+      QCOMPARE( exp9.rootNode()->isStatic(), false );
+      exp9.setCurrentRowNumber( 5 );
+      QCOMPARE( exp9.evaluate( &f ), QVariant( 6 ) );
+
+      // geometry functions are not evaluated once, even without the geometry of the feature
+      QgsExpression exp10( "geomFromWKT('POINT(1 2)')" );
+      QCOMPARE( exp10.prepare( fields ), true );
+      QCOMPARE( exp10.rootNode()->isStatic(), false );
+      QVERIFY( exp10.evaluate( &f ).canConvert<QgsGeometry>() );
+
+      QgsExpression exp11( "intersects(geomFromWKT('POINT(1 2)'), buffer(geomFromWKT('POINT(1 2)'), 1))" );
+      QCOMPARE( exp11.prepare( fields ), true );
+      QCOMPARE( exp11.rootNode()->isStatic(), false );
+      QCOMPARE( exp11.evaluate( &f ), QVariant( 1 ) );
+    }
+
+    void eval_block()
+    {
+      QgsFields fields;
+      fields.append( QgsField( "id", QVariant::Int ) );
+      fields.append( QgsField( "name", QVariant::String ) );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < 5; i++ )
+      {
+        QgsFeature f( i );
+        f.initAttributes( 2 );
+        f.setAttribute( 0, i == 3 ? QVariant( QVariant::Int ) : QVariant( i ) );
+        f.setAttribute( 1, QString( "f%1" ).arg( i ) );
+        features << f;
+      }
+
+      // the results are the same as with evaluate()
+      QStringList expressions;
+      expressions << "id * 2 + $rownum"
+      << "id > 1 AND name <> 'f4'"
+      << "id < 1 OR length(name) = 2"
+      << "-id"
+      << "id IN (1, 2, NULL)"
+      << "coalesce(id, 10) || upper(name)"
+      << "CASE WHEN id > 2 THEN 'big' ELSE name END"
+      << "name LIKE 'f%' AND name NOT ILIKE '%F3'"
+      << "name ~ '[12]$'"
+      << "$id";
+      foreach ( QString string, expressions )
+      {
+        QgsExpression exp( string );
+        QCOMPARE( exp.prepare( fields ), true );
+        exp.setCurrentRowNumber( 1 );
+        QVector<QVariant> values = exp.evaluateBlock( features );
+        QCOMPARE( exp.hasEvalError(), false );
+        QCOMPARE( values.count(), features.count() );
+        for ( int i = 0; i < features.count(); i++ )
+        {
+          exp.setCurrentRowNumber( 1 + i );
+          QCOMPARE( values[i], exp.evaluate( &features[i] ) );
+        }
+      }
+
+      QgsExpression filter( "id >= 2" );
+      QCOMPARE( filter.prepare( fields ), true );
+      QBitArray matches = filter.filterBlock( features );
+      QCOMPARE( matches.size(), 5 );
+      QCOMPARE( matches.count( true ), 2 );
+      QVERIFY( matches.testBit( 2 ) && matches.testBit( 4 ) );
+
+      // the right operand of OR is only evaluated where the left one is not true
+      QgsExpression exp2( "id < 3 OR toint(name) > 0" );
+      QCOMPARE( exp2.prepare( fields ), true );
+      QVector<QVariant> values2 = exp2.evaluateBlock( features );
+      QCOMPARE( exp2.hasEvalError(), true );
+      QCOMPARE( values2.count(), 0 );
+
+      QgsFeatureList firstFeatures = features.mid( 0, 3 );
+      values2 = exp2.evaluateBlock( firstFeatures );
+      QCOMPARE( exp2.hasEvalError(), false );
+      QCOMPARE( values2.count(), 3 );
+    }
+
     void eval_rownum()
     {
       QgsExpression exp( "$rownum + 1" );
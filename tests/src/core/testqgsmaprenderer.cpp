@@ -19,6 +19,7 @@
 #include <QObject>
 #include <QPainter>
 #include <QTime>
+#include <QTimer>
 #include <iostream>
 
 #include <QApplication>
@@ -40,10 +41,26 @@
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsmaplayerregistry.h>
+#include <qgspallabeling.h>
+#include <qgsmarkersymbollayerv2.h>
+#include <qgssinglesymbolrendererv2.h>
+#include <qgssymbolv2.h>
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
 
+// stops the rendering of a map renderer when its event loop runs
+class RenderCanceler : public QObject
+{
+    Q_OBJECT;
+  public:
+    RenderCanceler( QgsMapRenderer* renderer ) : mRenderer( renderer ) {}
+  public slots:
+    void cancel() { mRenderer->rendererContext()->setRenderingStopped( true ); }
+  private:
+    QgsMapRenderer* mRenderer;
+};
+
 /** \ingroup UnitTests
  * This is a unit test for the QgsMapRenderer class.
  * It will do some performance testing too
@@ -60,14 +77,26 @@ class TestQgsMapRenderer: public QObject
 
     /** This method tests render perfomance */
     void performanceTest();
+    /** This method tests rendering of the layers in worker threads */
+    void parallelRenderingTest();
+    /** This method tests layers with svg symbols and labels drawn in worker threads */
+    void parallelSvgRenderingTest();
+    /** This method tests canceling the rendering while the worker threads draw */
+    void parallelRenderingCancelTest();
 
   private:
+    /** Render the svg layers to an image, in worker threads if parallel is true */
+    QImage renderSvgLayers( bool parallel );
+    /** Compare two images, allowing for rounding differences of the composition */
+    bool imagesMatch( const QImage& image1, const QImage& image2 );
+
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError;
     QgsCoordinateReferenceSystem mCRS;
     QgsFields mFields;
     QgsMapRenderer * mpMapRenderer;
     QgsMapLayer * mpPolysLayer;
+    QgsMapRenderer * mpSvgRenderer;
     QString mReport;
 };
 
@@ -167,6 +196,58 @@ void TestQgsMapRenderer::initTestCase()
   // add the test layer to the maprender
   mpMapRenderer = new QgsMapRenderer();
   mpMapRenderer->setLayerSet( QStringList( mpPolysLayer->id() ) );
+
+  //
+  // create point layers with svg markers of many sizes, the layers share the
+  // svg cache, which is trimmed while they are drawn
+  //
+  QString mySvgFileName = myTmpDir + "maprender_testmarker.svg";
+  QFile mySvgFile( mySvgFileName );
+  QVERIFY( mySvgFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  mySvgFile.write( "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"100\" height=\"100\" viewBox=\"0 0 100 100\">"
+                   "<circle cx=\"50\" cy=\"50\" r=\"40\" fill=\"param(fill) #ff0000\" stroke=\"param(outline) #000000\""
+                   " stroke-width=\"param(outline-width) 4\"/></svg>" );
+  mySvgFile.close();
+
+  QStringList mySvgLayerIds;
+  for ( int i = 0; i < 4; i++ )
+  {
+    QgsVectorLayer* mypSvgLayer = new QgsVectorLayer( "Point?field=size:double&field=name:string",
+        QString( "svg%1" ).arg( i ), "memory" );
+    QVERIFY( mypSvgLayer->isValid() );
+    QgsFeatureList myFeatures;
+    for ( int j = 0; j < 2000; j++ )
+    {
+      QgsFeature myFeature;
+      myFeature.setGeometry( QgsGeometry::fromPoint( QgsPoint( j % 60 + 0.25 * i, j / 60 + 0.25 * i ) ) );
+      myFeature.initAttributes( 2 );
+      myFeature.setAttribute( 0, 2 + ( j * 7 + i ) % 40 );
+      myFeature.setAttribute( 1, QString( "p%1" ).arg( j ) );
+      myFeatures << myFeature;
+    }
+    QVERIFY( mypSvgLayer->dataProvider()->addFeatures( myFeatures ) );
+
+    QgsSvgMarkerSymbolLayerV2* mypSvgMarker = new QgsSvgMarkerSymbolLayerV2( mySvgFileName, 1.0 );
+    mypSvgMarker->setFillColor( QColor::fromHsv( 90 * i, 255, 255 ) );
+    QgsSingleSymbolRendererV2* mypRenderer = new QgsSingleSymbolRendererV2(
+      new QgsMarkerSymbolV2( QgsSymbolLayerV2List() << mypSvgMarker ) );
+    mypRenderer->setSizeScaleField( "size" );
+    mypSvgLayer->setRendererV2( mypRenderer );
+
+    QgsPalLayerSettings myLabelSettings;
+    myLabelSettings.enabled = true;
+    myLabelSettings.fieldName = "name";
+    myLabelSettings.writeToLayer( mypSvgLayer );
+
+    QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer *>() << mypSvgLayer );
+    mySvgLayerIds << mypSvgLayer->id();
+  }
+  mpSvgRenderer = new QgsMapRenderer();
+  mpSvgRenderer->setLayerSet( mySvgLayerIds );
+  mpSvgRenderer->setLabelingEngine( new QgsPalLabeling() );
+  mpSvgRenderer->setOutputSize( QSize( 600, 400 ), 96 );
+  mpSvgRenderer->setExtent( QgsRectangle( 0, 0, 60, 40 ) );
+
   mReport += "<h1>Map Render Tests</h1>\n";
 }
 
@@ -194,6 +275,78 @@ void TestQgsMapRenderer::performanceTest()
   QVERIFY( myResultFlag );
 }
 
+void TestQgsMapRenderer::parallelRenderingTest()
+{
+  mpMapRenderer->setExtent( mpPolysLayer->extent() );
+  mpMapRenderer->setParallelRenderingEnabled( true );
+  QgsRenderChecker myChecker;
+  myChecker.setControlName( "expected_maprender" );
+  myChecker.setMapRenderer( mpMapRenderer );
+  bool myResultFlag = myChecker.runTest( "maprender_parallel" );
+  mReport += myChecker.report();
+  mpMapRenderer->setParallelRenderingEnabled( false );
+  QVERIFY( myResultFlag );
+}
+
+QImage TestQgsMapRenderer::renderSvgLayers( bool parallel )
+{
+  QImage myImage( 600, 400, QImage::Format_ARGB32_Premultiplied );
+  myImage.fill( qRgb( 255, 255, 255 ) );
+  QPainter myPainter( &myImage );
+  mpSvgRenderer->setParallelRenderingEnabled( parallel );
+  mpSvgRenderer->render( &myPainter );
+  myPainter.end();
+  mpSvgRenderer->setParallelRenderingEnabled( false );
+  return myImage;
+}
+
+bool TestQgsMapRenderer::imagesMatch( const QImage& image1, const QImage& image2 )
+{
+  if ( image1.size() != image2.size() )
+    return false;
+
+  for ( int y = 0; y < image1.height(); y++ )
+  {
+    for ( int x = 0; x < image1.width(); x++ )
+    {
+      QRgb myPixel1 = image1.pixel( x, y );
+      QRgb myPixel2 = image2.pixel( x, y );
+      if ( qAbs( qRed( myPixel1 ) - qRed( myPixel2 ) ) > 2 ||
+           qAbs( qGreen( myPixel1 ) - qGreen( myPixel2 ) ) > 2 ||
+           qAbs( qBlue( myPixel1 ) - qBlue( myPixel2 ) ) > 2 ||
+           qAbs( qAlpha( myPixel1 ) - qAlpha( myPixel2 ) ) > 2 )
+        return false;
+    }
+  }
+  return true;
+}
+
+void TestQgsMapRenderer::parallelSvgRenderingTest()
+{
+  QImage mySerialImage = renderSvgLayers( false );
+  QImage myParallelImage = renderSvgLayers( true );
+  QVERIFY( imagesMatch( mySerialImage, myParallelImage ) );
+
+  // again with the entries left in the cache by the worker threads
+  myParallelImage = renderSvgLayers( true );
+  QVERIFY( imagesMatch( mySerialImage, myParallelImage ) );
+}
+
+void TestQgsMapRenderer::parallelRenderingCancelTest()
+{
+  // cancel as soon as the renderer waits for the worker threads
+  RenderCanceler myCanceler( mpSvgRenderer );
+  QTimer::singleShot( 0, &myCanceler, SLOT( cancel() ) );
+  renderSvgLayers( true );
+  // the workers may all have finished before the renderer waited for them
+  QCoreApplication::processEvents();
+
+  // a canceled rendering does not change the next ones
+  QImage mySerialImage = renderSvgLayers( false );
+  QImage myParallelImage = renderSvgLayers( true );
+  QVERIFY( imagesMatch( mySerialImage, myParallelImage ) );
+}
+
 QTEST_MAIN( TestQgsMapRenderer )
 #include "moc_testqgsmaprenderer.cxx"
 
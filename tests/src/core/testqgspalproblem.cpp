@@ -0,0 +1,258 @@
+/***************************************************************************
+     testqgspalproblem.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest>
+#include <QList>
+#include <QtConcurrentMap>
+
+#include <list>
+#include <vector>
+#include <cstring>
+
+//qgis includes...
+#include <qgsgeometry.h>
+#include <qgspoint.h>
+
+#include <pal/pal.h>
+#include <pal/layer.h>
+#include <pal/palgeometry.h>
+#include <pal/problem.h>
+#include <pal/labelposition.h>
+#include <pal/feature.h>
+
+using namespace pal;
+
+// point feature for pal, owns its geometry
+class TestPalGeometry : public PalGeometry
+{
+  public:
+    TestPalGeometry( double x, double y ) : mGeometry( QgsGeometry::fromPoint( QgsPoint( x, y ) ) ) {}
+    ~TestPalGeometry() { delete mGeometry; }
+
+    GEOSGeometry* getGeosGeometry() { return mGeometry->asGeos(); }
+    void releaseGeosGeometry( GEOSGeometry* geom ) { Q_UNUSED( geom ); }
+
+  private:
+    QgsGeometry* mGeometry;
+};
+
+// a placed label
+struct PlacedLabel
+{
+  QByteArray featureId;
+  double x;
+  double y;
+  double alpha;
+};
+
+static void solvePart( Problem* part )
+{
+  part->solve();
+}
+
+/** \ingroup UnitTests
+ * This is a unit test for the labeling problem solved in independent parts
+ */
+class TestQgsPalProblem : public QObject
+{
+    Q_OBJECT
+  private slots:
+    void cleanup();
+    void sameSolution_data();
+    void sameSolution();
+    void singleGroup();
+
+  private:
+    //! creates pal with a layer of points, in clusters of competing labels or in a single chain
+    Pal* createPal( SearchMethod method, bool clusters );
+    //! the placed labels of a solved problem, in feature order
+    QList<PlacedLabel> placedLabels( Problem* problem );
+    void compareLabels( const QList<PlacedLabel>& labels, const QList<PlacedLabel>& expected );
+
+    QList<TestPalGeometry*> mGeometries;
+};
+
+static double BBOX[4] = { 0, 0, 1000, 1000 };
+
+void TestQgsPalProblem::cleanup()
+{
+  qDeleteAll( mGeometries );
+  mGeometries.clear();
+}
+
+Pal* TestQgsPalProblem::createPal( SearchMethod method, bool clusters )
+{
+  Pal* pal = new Pal;
+  pal->setSearch( method );
+  pal->setPointP( 8 );
+  Layer* layer = pal->addLayer( "points", -1, -1, P_POINT, METER, 0.5, false, true, true );
+
+  QList<QgsPoint> points;
+  if ( clusters )
+  {
+    // clusters of four points with overlapping candidates, 200 map units apart
+    for ( int i = 0; i < 5; i++ )
+    {
+      for ( int j = 0; j < 5; j++ )
+      {
+        double x = 100 + 200 * i;
+        double y = 100 + 200 * j;
+        points << QgsPoint( x, y ) << QgsPoint( x + 6, y ) << QgsPoint( x, y + 5 ) << QgsPoint( x + 8 + i, y + 6 + j );
+      }
+    }
+    // points alone
+    points << QgsPoint( 50, 950 ) << QgsPoint( 950, 50 ) << QgsPoint( 400, 500 );
+  }
+  else
+  {
+    // each point competes with the next ones
+    for ( int i = 0; i < 60; i++ )
+      points << QgsPoint( 100 + 8 * i, 500 + ( i % 3 ) );
+  }
+
+  for ( int i = 0; i < points.size(); i++ )
+  {
+    TestPalGeometry* geometry = new TestPalGeometry( points[i].x(), points[i].y() );
+    mGeometries << geometry;
+    QByteArray id = QByteArray::number( i );
+    layer->registerFeature( id.constData(), geometry, 10, 4 );
+  }
+
+  // the label of this feature does not fit in the extent, it has no candidates
+  TestPalGeometry* geometry = new TestPalGeometry( 300, 300 );
+  mGeometries << geometry;
+  layer->registerFeature( "too large", geometry, 2000, 4 );
+
+  return pal;
+}
+
+QList<PlacedLabel> TestQgsPalProblem::placedLabels( Problem* problem )
+{
+  QList<PlacedLabel> labels;
+  std::list<LabelPosition*>* solution = problem->getSolution( false );
+  for ( std::list<LabelPosition*>::iterator it = solution->begin(); it != solution->end(); ++it )
+  {
+    PlacedLabel label;
+    label.featureId = ( *it )->getFeaturePart()->getUID();
+    label.x = ( *it )->getX();
+    label.y = ( *it )->getY();
+    label.alpha = ( *it )->getAlpha();
+    labels << label;
+  }
+  delete solution;
+  return labels;
+}
+
+void TestQgsPalProblem::compareLabels( const QList<PlacedLabel>& labels, const QList<PlacedLabel>& expected )
+{
+  QCOMPARE( labels.size(), expected.size() );
+  for ( int i = 0; i < labels.size(); i++ )
+  {
+    QCOMPARE( labels[i].featureId, expected[i].featureId );
+    QCOMPARE( labels[i].x, expected[i].x );
+    QCOMPARE( labels[i].y, expected[i].y );
+    QCOMPARE( labels[i].alpha, expected[i].alpha );
+  }
+}
+
+void TestQgsPalProblem::sameSolution_data()
+{
+  QTest::addColumn<int>( "method" );
+
+  QTest::newRow( "falp" ) << ( int ) FALP;
+  QTest::newRow( "chain" ) << ( int ) CHAIN;
+  QTest::newRow( "popmusic tabu" ) << ( int ) POPMUSIC_TABU;
+  QTest::newRow( "popmusic chain" ) << ( int ) POPMUSIC_CHAIN;
+  QTest::newRow( "popmusic tabu chain" ) << ( int ) POPMUSIC_TABU_CHAIN;
+}
+
+void TestQgsPalProblem::sameSolution()
+{
+  QFETCH( int, method );
+  Pal* pal = createPal(( SearchMethod ) method, true );
+
+  Problem* serial = pal->extractProblem( 1, BBOX );
+  // the feature without candidates is not part of the problem
+  QCOMPARE( serial->getNumFeatures(), 103 );
+  serial->reduce();
+  serial->solve();
+  QList<PlacedLabel> serialLabels = placedLabels( serial );
+  // every group places a label at least
+  QVERIFY( serialLabels.size() >= 28 );
+
+  Problem* split = pal->extractProblem( 1, BBOX );
+  split->reduce();
+  std::vector<Problem*> parts = split->split( 8 );
+  QVERIFY( parts.size() > 1 );
+  QtConcurrent::blockingMap( parts, solvePart );
+  split->mergeParts( parts );
+  QVERIFY( parts.empty() );
+  compareLabels( placedLabels( split ), serialLabels );
+  QVERIFY( qAbs( split->getSolutionCost() - serial->getSolutionCost() ) < 1e-9 );
+
+  // a part for each group
+  Problem* perGroup = pal->extractProblem( 1, BBOX );
+  perGroup->reduce();
+  parts = perGroup->split( 1000 );
+  QCOMPARE(( int ) parts.size(), 28 );
+  for ( size_t i = 0; i < parts.size(); i++ )
+    parts[i]->solve();
+  perGroup->mergeParts( parts );
+  compareLabels( placedLabels( perGroup ), serialLabels );
+  QVERIFY( qAbs( perGroup->getSolutionCost() - serial->getSolutionCost() ) < 1e-9 );
+
+  // as done for rendering
+  Problem* solved = pal->extractProblem( 1, BBOX );
+  std::list<LabelPosition*>* solution = pal->solveProblem( solved, false );
+  QCOMPARE(( int ) solution->size(), serialLabels.size() );
+  delete solution;
+  compareLabels( placedLabels( solved ), serialLabels );
+
+  delete serial;
+  delete split;
+  delete perGroup;
+  delete solved;
+  delete pal;
+}
+
+void TestQgsPalProblem::singleGroup()
+{
+  Pal* pal = createPal( POPMUSIC_TABU_CHAIN, false );
+
+  Problem* serial = pal->extractProblem( 1, BBOX );
+  QCOMPARE( serial->getNumFeatures(), 60 );
+  serial->reduce();
+  serial->solve();
+  QList<PlacedLabel> serialLabels = placedLabels( serial );
+
+  // the problem is not split
+  Problem* split = pal->extractProblem( 1, BBOX );
+  split->reduce();
+  QVERIFY( split->split( 8 ).empty() );
+  delete split;
+
+  Problem* solved = pal->extractProblem( 1, BBOX );
+  std::list<LabelPosition*>* solution = pal->solveProblem( solved, false );
+  delete solution;
+  compareLabels( placedLabels( solved ), serialLabels );
+  QCOMPARE( solved->getSolutionCost(), serial->getSolutionCost() );
+
+  delete serial;
+  delete solved;
+  delete pal;
+}
+
+QTEST_MAIN( TestQgsPalProblem )
+#include "moc_testqgspalproblem.cxx"
@@ -0,0 +1,223 @@
+/***************************************************************************
+     testqgsrasterblockcache.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+#include <QObject>
+
+//header for class being tested
+#include <qgsrasterblockcache.h>
+#include <qgsrasterblock.h>
+#include <qgsapplication.h>
+#include <qgsrasterlayer.h>
+#include <qgsrasterpipe.h>
+#include "testqgsrasterinput.h"
+
+class TestQgsRasterBlockCache: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void exactAndContainedRequests();
+    void otherRequests();
+    void sizeLimit();
+    void clones();
+    void pipeRole();
+    void pipeInvalidation();
+};
+
+void TestQgsRasterBlockCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsRasterBlockCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsRasterBlockCache::exactAndContainedRequests()
+{
+  TestRasterInput input;
+  QgsRasterBlockCache cache( &input );
+
+  QgsRasterBlock* block = cache.block( 1, QgsRectangle( 0, 0, 100, 100 ), 100, 100 );
+  QCOMPARE( input.reads, 1 );
+  QCOMPARE( block->value( 10, 20 ), 20.0 + 1000 * 90 );
+  delete block;
+  QCOMPARE( cache.size(), ( qint64 ) 100 * 100 * 4 );
+
+  // same request
+  block = cache.block( 1, QgsRectangle( 0, 0, 100, 100 ), 100, 100 );
+  QCOMPARE( input.reads, 1 );
+  QCOMPARE( block->value( 10, 20 ), 20.0 + 1000 * 90 );
+  delete block;
+
+  // part of the cached block
+  block = cache.block( 1, QgsRectangle( 10, 20, 30, 50 ), 20, 30 );
+  QCOMPARE( input.reads, 1 );
+  QCOMPARE( block->value( 0, 0 ), 10.0 + 1000 * 50 );
+  QCOMPARE( block->value( 29, 19 ), 29.0 + 1000 * 21 );
+  delete block;
+}
+
+void TestQgsRasterBlockCache::otherRequests()
+{
+  TestRasterInput input;
+  QgsRasterBlockCache cache( &input );
+  delete cache.block( 1, QgsRectangle( 0, 0, 100, 100 ), 100, 100 );
+
+  // not aligned to the pixels
+  delete cache.block( 1, QgsRectangle( 10.5, 20, 30.5, 50 ), 20, 30 );
+  QCOMPARE( input.reads, 2 );
+
+  // other resolution
+  delete cache.block( 1, QgsRectangle( 0, 0, 100, 100 ), 50, 50 );
+  QCOMPARE( input.reads, 3 );
+
+  // partly outside
+  delete cache.block( 1, QgsRectangle( 90, 90, 110, 110 ), 20, 20 );
+  QCOMPARE( input.reads, 4 );
+
+  // other band
+  delete cache.block( 2, QgsRectangle( 0, 0, 100, 100 ), 100, 100 );
+  QCOMPARE( input.reads, 5 );
+}
+
+void TestQgsRasterBlockCache::sizeLimit()
+{
+  TestRasterInput input;
+  QgsRasterBlockCache cache( &input );
+  cache.setMaximumSize( 2 * 10 * 10 * 4 );
+
+  delete cache.block( 1, QgsRectangle( 0, 0, 10, 10 ), 10, 10 );
+  delete cache.block( 1, QgsRectangle( 10, 0, 20, 10 ), 10, 10 );
+  delete cache.block( 1, QgsRectangle( 0, 0, 10, 10 ), 10, 10 );
+  QCOMPARE( input.reads, 2 );
+
+  // drops the least recently used block
+  delete cache.block( 1, QgsRectangle( 20, 0, 30, 10 ), 10, 10 );
+  QCOMPARE( cache.size(), ( qint64 ) 2 * 10 * 10 * 4 );
+  delete cache.block( 1, QgsRectangle( 0, 0, 10, 10 ), 10, 10 );
+  QCOMPARE( input.reads, 3 );
+  delete cache.block( 1, QgsRectangle( 10, 0, 20, 10 ), 10, 10 );
+  QCOMPARE( input.reads, 4 );
+
+  // larger than the cache
+  delete cache.block( 1, QgsRectangle( 0, 0, 100, 100 ), 100, 100 );
+  QVERIFY( cache.size() <= cache.maximumSize() );
+
+  cache.clear();
+  QCOMPARE( cache.size(), ( qint64 ) 0 );
+}
+
+void TestQgsRasterBlockCache::clones()
+{
+  TestRasterInput input;
+  QgsRasterBlockCache cache( &input );
+  delete cache.block( 1, QgsRectangle( 0, 0, 10, 10 ), 10, 10 );
+
+  QgsRasterInterface* clone = cache.clone();
+  QVERIFY( clone->setInput( &input ) );
+  delete clone->block( 1, QgsRectangle( 0, 0, 10, 10 ), 10, 10 );
+  QCOMPARE( input.reads, 1 );
+
+  // another input drops the blocks
+  TestRasterInput otherInput;
+  QVERIFY( clone->setInput( &otherInput ) );
+  QCOMPARE( cache.size(), ( qint64 ) 0 );
+  delete clone;
+}
+
+void TestQgsRasterBlockCache::pipeRole()
+{
+  QgsRasterLayer layer( QString( TEST_DATA_DIR ) + "/tenbytenraster.asc", "tenbytenraster" );
+  QVERIFY( layer.isValid() );
+  QgsRasterPipe* pipe = layer.pipe();
+  QgsRasterInterface* renderer = pipe->renderer();
+  QVERIFY( renderer );
+  QVERIFY( !layer.blockCacheEnabled() );
+
+  // the cache is placed right after the provider
+  layer.setBlockCacheEnabled( true );
+  QVERIFY( layer.blockCacheEnabled() );
+  QgsRasterInterface* cache = pipe->blockCache();
+  QVERIFY( cache );
+  QCOMPARE( pipe->at( 1 ), cache );
+  QCOMPARE( cache->input(), ( QgsRasterInterface* ) pipe->provider() );
+  QCOMPARE(( QgsRasterInterface* ) pipe->renderer(), renderer );
+  QCOMPARE( renderer->input(), cache );
+
+  layer.setBlockCacheEnabled( false );
+  QVERIFY( !pipe->blockCache() );
+  QCOMPARE(( QgsRasterInterface* ) pipe->renderer(), renderer );
+  QCOMPARE( pipe->at( 1 ), renderer );
+  QCOMPARE( renderer->input(), ( QgsRasterInterface* ) pipe->provider() );
+}
+
+void TestQgsRasterBlockCache::pipeInvalidation()
+{
+  QgsRasterLayer layer( QString( TEST_DATA_DIR ) + "/tenbytenraster.asc", "tenbytenraster" );
+  QVERIFY( layer.isValid() );
+  QgsRasterPipe* pipe = layer.pipe();
+  QgsRectangle extent = layer.extent();
+
+  layer.setBlockCacheEnabled( true );
+  QgsRasterBlockCache* cache = pipe->blockCache();
+  delete cache->block( 1, extent, 10, 10 );
+  QVERIFY( cache->size() > 0 );
+
+  // the renderer is after the cache
+  pipe->clearBlockCache( pipe->renderer() );
+  QVERIFY( cache->size() > 0 );
+  pipe->clearBlockCache( pipe->provider() );
+  QCOMPARE( cache->size(), ( qint64 ) 0 );
+
+  delete cache->block( 1, extent, 10, 10 );
+  layer.triggerRepaint();
+  QCOMPARE( cache->size(), ( qint64 ) 0 );
+
+  // a cache after the renderer keeps rendered images
+  layer.setBlockCacheEnabled( false );
+  cache = new QgsRasterBlockCache();
+  QVERIFY( pipe->insert( 2, cache ) );
+  QCOMPARE( pipe->blockCache(), cache );
+  QCOMPARE( cache->input(), ( QgsRasterInterface* ) pipe->renderer() );
+  delete cache->block( 1, extent, 10, 10 );
+  QVERIFY( cache->size() > 0 );
+
+  // renderer settings changed in place
+  pipe->clearBlockCache( pipe->renderer() );
+  QCOMPARE( cache->size(), ( qint64 ) 0 );
+
+  // renderer replaced
+  delete cache->block( 1, extent, 10, 10 );
+  layer.setRenderer( dynamic_cast<QgsRasterRenderer*>( pipe->renderer()->clone() ) );
+  QCOMPARE( cache->size(), ( qint64 ) 0 );
+
+  // interface inserted before the cache
+  delete cache->block( 1, extent, 10, 10 );
+  QgsRasterNuller* nuller = new QgsRasterNuller();
+  QVERIFY( pipe->insert( 1, nuller ) );
+  QCOMPARE( cache->size(), ( qint64 ) 0 );
+
+  // interface after the cache removed
+  delete cache->block( 1, extent, 10, 10 );
+  QVERIFY( pipe->remove( pipe->projector() ) );
+  QVERIFY( cache->size() > 0 );
+}
+
+QTEST_MAIN( TestQgsRasterBlockCache )
+#include "moc_testqgsrasterblockcache.cxx"
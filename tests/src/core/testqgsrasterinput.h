@@ -0,0 +1,72 @@
+/***************************************************************************
+     testqgsrasterinput.h
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef TESTQGSRASTERINPUT_H
+#define TESTQGSRASTERINPUT_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+#include <qgsrasterinterface.h>
+#include <qgsrasterblock.h>
+
+/** \ingroup UnitTests
+ * Synthetic input for the raster tests. Each pixel of the Float32 band holds the x coordinate
+ * and 1000 times the y coordinate of its top left corner, subclasses may compute other values.
+ * The input may be read by several threads, it counts the blocks read and records the threads reading them.
+ */
+class TestRasterInput : public QgsRasterInterface
+{
+  public:
+    TestRasterInput( int capabilities = NoCapabilities ) : reads( 0 ), mCapabilities( capabilities ) {}
+
+    QgsRasterInterface* clone() const { return new TestRasterInput( mCapabilities ); }
+    int capabilities() const { return mCapabilities; }
+    QGis::DataType dataType( int bandNo ) const { Q_UNUSED( bandNo ); return QGis::Float32; }
+    int bandCount() const { return 1; }
+
+    //! value of the pixel with the top left corner at x, y
+    virtual double value( int bandNo, double x, double y ) const { Q_UNUSED( bandNo ); return x + 1000 * y; }
+
+    QgsRasterBlock* block( int bandNo, const QgsRectangle& extent, int width, int height )
+    {
+      {
+        QMutexLocker locker( &mutex );
+        reads++;
+        threads.insert( QThread::currentThread() );
+      }
+      QgsRasterBlock* block = new QgsRasterBlock( dataType( bandNo ), width, height, noDataValue( bandNo ) );
+      double xRes = extent.width() / width;
+      double yRes = extent.height() / height;
+      for ( int row = 0; row < height; row++ )
+      {
+        for ( int col = 0; col < width; col++ )
+        {
+          block->setValue( row, col, value( bandNo, extent.xMinimum() + col * xRes, extent.yMaximum() - row * yRes ) );
+        }
+      }
+      return block;
+    }
+
+    QMutex mutex;
+    int reads;
+    QSet<QThread*> threads;
+
+  private:
+    int mCapabilities;
+};
+
+#endif // TESTQGSRASTERINPUT_H
@@ -0,0 +1,216 @@
+/***************************************************************************
+     testqgsrasteriterator.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+#include <QObject>
+#include <QThread>
+
+//header for class being tested
+#include <qgsrasteriterator.h>
+#include <qgsrasterblock.h>
+#include <qgsrasternuller.h>
+#include <qgssinglebandgrayrenderer.h>
+#include <qgscontrastenhancement.h>
+#include <qgscontrastenhancementfunction.h>
+#include "testqgsrasterinput.h"
+
+// A part returned by the iterator
+struct Part
+{
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  QByteArray data;
+
+  bool operator==( const Part& other ) const
+  {
+    return nCols == other.nCols && nRows == other.nRows && topLeftCol == other.topLeftCol &&
+           topLeftRow == other.topLeftRow && data == other.data;
+  }
+};
+
+class TestQgsRasterIterator: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void init();
+    void cleanup();
+    void sameParts();
+    void stopWithPartsInFlight();
+    void deleteWithPartsInFlight();
+    void userDefinedEnhancement();
+
+  private:
+    // read at most maxParts parts of band 1, all if maxParts is -1
+    QList<Part> readParts( QgsRasterIterator& iterator, int maxParts = -1 );
+
+    TestRasterInput* mProvider;
+    QgsRasterNuller* mNuller;
+};
+
+// the iterator reads 400 x 300 pixels of a 400 x 300 map unit extent in parts of 100 x 100,
+// the strips of rows used by the threads are not higher, so the parts are the same
+static const int COLS = 400;
+static const int ROWS = 300;
+static const int PART_COUNT = 12;
+
+void TestQgsRasterIterator::init()
+{
+  mProvider = new TestRasterInput( QgsRasterInterface::Size | QgsRasterInterface::ThreadedRead );
+  mNuller = new QgsRasterNuller( mProvider );
+}
+
+void TestQgsRasterIterator::cleanup()
+{
+  delete mNuller;
+  delete mProvider;
+}
+
+QList<Part> TestQgsRasterIterator::readParts( QgsRasterIterator& iterator, int maxParts )
+{
+  QList<Part> parts;
+  Part part;
+  QgsRasterBlock* block = 0;
+  while (( maxParts < 0 || parts.size() < maxParts ) &&
+         iterator.readNextRasterPart( 1, part.nCols, part.nRows, &block, part.topLeftCol, part.topLeftRow ) )
+  {
+    part.data = QByteArray( block->bits( 0, 0 ), part.nCols * part.nRows * block->dataTypeSize( 1 ) );
+    parts << part;
+    delete block;
+  }
+  return parts;
+}
+
+void TestQgsRasterIterator::sameParts()
+{
+  QgsRectangle extent( 0, 0, COLS, ROWS );
+
+  QgsRasterIterator serial( mNuller );
+  serial.setMaximumTileWidth( 100 );
+  serial.setMaximumTileHeight( 100 );
+  serial.setMaximumThreadCount( 1 );
+  serial.startRasterRead( 1, COLS, ROWS, extent );
+  QList<Part> serialParts = readParts( serial );
+  serial.stopRasterRead( 1 );
+  QCOMPARE( serialParts.size(), PART_COUNT );
+  QCOMPARE( mProvider->threads.size(), 1 );
+  QVERIFY( mProvider->threads.contains( QThread::currentThread() ) );
+
+  mProvider->threads.clear();
+  QgsRasterIterator threaded( mNuller );
+  threaded.setMaximumTileWidth( 100 );
+  threaded.setMaximumTileHeight( 100 );
+  threaded.setMaximumThreadCount( 4 );
+  threaded.startRasterRead( 1, COLS, ROWS, extent );
+  QList<Part> threadedParts = readParts( threaded );
+  threaded.stopRasterRead( 1 );
+
+  // read in the thread pool
+  QVERIFY( !mProvider->threads.isEmpty() );
+  QVERIFY( !mProvider->threads.contains( QThread::currentThread() ) );
+
+  QCOMPARE( threadedParts.size(), serialParts.size() );
+  for ( int i = 0; i < serialParts.size(); i++ )
+  {
+    QVERIFY( threadedParts[i] == serialParts[i] );
+  }
+}
+
+void TestQgsRasterIterator::stopWithPartsInFlight()
+{
+  QgsRectangle extent( 0, 0, COLS, ROWS );
+
+  QgsRasterIterator serial( mNuller );
+  serial.setMaximumTileWidth( 100 );
+  serial.setMaximumTileHeight( 100 );
+  serial.startRasterRead( 1, COLS, ROWS, extent );
+  QList<Part> serialParts = readParts( serial );
+  serial.stopRasterRead( 1 );
+
+  QgsRasterIterator threaded( mNuller );
+  threaded.setMaximumTileWidth( 100 );
+  threaded.setMaximumTileHeight( 100 );
+  threaded.setMaximumThreadCount( 4 );
+  threaded.startRasterRead( 1, COLS, ROWS, extent );
+
+  // the next parts are queued when two are fetched
+  QList<Part> parts = readParts( threaded, 2 );
+  QCOMPARE( parts.size(), 2 );
+  QVERIFY( parts[0] == serialParts[0] );
+  QVERIFY( parts[1] == serialParts[1] );
+  threaded.stopRasterRead( 1 );
+
+  int nCols, nRows, topLeftCol, topLeftRow;
+  QgsRasterBlock* block = 0;
+  QVERIFY( !threaded.readNextRasterPart( 1, nCols, nRows, &block, topLeftCol, topLeftRow ) );
+  QVERIFY( !block );
+
+  // the iterator reads all parts again after a restart
+  threaded.startRasterRead( 1, COLS, ROWS, extent );
+  parts = readParts( threaded, 5 );
+  threaded.startRasterRead( 1, COLS, ROWS, extent );
+  parts = readParts( threaded );
+  threaded.stopRasterRead( 1 );
+  QCOMPARE( parts.size(), serialParts.size() );
+  for ( int i = 0; i < serialParts.size(); i++ )
+  {
+    QVERIFY( parts[i] == serialParts[i] );
+  }
+}
+
+void TestQgsRasterIterator::deleteWithPartsInFlight()
+{
+  QgsRasterIterator* threaded = new QgsRasterIterator( mNuller );
+  threaded->setMaximumTileWidth( 100 );
+  threaded->setMaximumTileHeight( 100 );
+  threaded->setMaximumThreadCount( 4 );
+  threaded->startRasterRead( 1, COLS, ROWS, QgsRectangle( 0, 0, COLS, ROWS ) );
+  QCOMPARE( readParts( *threaded, 1 ).size(), 1 );
+
+  // waits for the queued parts before the pipe copies are deleted
+  delete threaded;
+}
+
+void TestQgsRasterIterator::userDefinedEnhancement()
+{
+  QgsSingleBandGrayRenderer renderer( mProvider, 1 );
+  QgsContrastEnhancement* ce = new QgsContrastEnhancement( QgsContrastEnhancement::QGS_Float32 );
+  ce->setMinimumValue( 0, false );
+  ce->setMaximumValue( ROWS * 1000 + COLS, false );
+  ce->setContrastEnhancementAlgorithm( QgsContrastEnhancement::StretchToMinimumMaximum );
+  renderer.setContrastEnhancement( ce );
+
+  // the renderer is copied for the threads
+  QgsRasterIterator threaded( &renderer );
+  threaded.setMaximumTileWidth( 100 );
+  threaded.setMaximumTileHeight( 100 );
+  threaded.setMaximumThreadCount( 4 );
+  threaded.startRasterRead( 1, COLS, ROWS, QgsRectangle( 0, 0, COLS, ROWS ) );
+  QCOMPARE( readParts( threaded ).size(), PART_COUNT );
+  threaded.stopRasterRead( 1 );
+  QVERIFY( !mProvider->threads.contains( QThread::currentThread() ) );
+
+  // the copies would not have the user defined function, the parts are read serially
+  mProvider->threads.clear();
+  ce->setContrastEnhancementFunction( new QgsContrastEnhancementFunction( QgsContrastEnhancement::QGS_Float32, 0, ROWS * 1000 + COLS ) );
+  threaded.startRasterRead( 1, COLS, ROWS, QgsRectangle( 0, 0, COLS, ROWS ) );
+  QCOMPARE( readParts( threaded ).size(), PART_COUNT );
+  threaded.stopRasterRead( 1 );
+  QCOMPARE( mProvider->threads.size(), 1 );
+  QVERIFY( mProvider->threads.contains( QThread::currentThread() ) );
+}
+
+QTEST_MAIN( TestQgsRasterIterator )
+#include "moc_testqgsrasteriterator.cxx"
@@ -39,6 +39,8 @@
 #include <qgssinglebandpseudocolorrenderer.h>
 #include <qgsvectorcolorrampv2.h>
 #include <qgscptcityarchive.h>
+#include <qgsrasterprojector.h>
+#include <qgscoordinatetransform.h>
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -69,6 +71,7 @@ class TestQgsRasterLayer: public QObject
     void buildExternalOverviews();
     void registry();
     void transparency();
+    void reprojectedBlock();
   private:
     bool render( QString theFileName );
     bool setQml( QString theType );
@@ -478,5 +481,43 @@ void TestQgsRasterLayer::transparency()
   QVERIFY( render( "raster_transparency" ) );
 }
 
+void TestQgsRasterLayer::reprojectedBlock()
+{
+  // block() reprojects whole rows (in several threads for large blocks),
+  // the result must match the source cells found by srcRowCol()
+  QVERIFY( mpLandsatRasterLayer->isValid() );
+  QgsRasterDataProvider *provider = mpLandsatRasterLayer->dataProvider();
+
+  QgsCoordinateReferenceSystem destCrs;
+  destCrs.createFromOgcWmsCrs( "EPSG:4326" );
+  QgsCoordinateTransform ct( mpLandsatRasterLayer->crs(), destCrs );
+  QgsRectangle destExtent = ct.transformBoundingBox( mpLandsatRasterLayer->extent() );
+
+  QgsRasterProjector projector;
+  projector.setCRS( mpLandsatRasterLayer->crs(), destCrs );
+  projector.setInput( provider );
+
+  int width = 400;
+  int height = 300;
+  QgsRasterBlock *block = projector.block( 1, destExtent, width, height );
+  QVERIFY( block && !block->isEmpty() );
+
+  QgsRasterBlock *srcBlock = provider->block( 1, projector.srcExtent(), projector.srcCols(), projector.srcRows() );
+  QVERIFY( srcBlock && !srcBlock->isEmpty() );
+
+  int srcRow, srcCol;
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      projector.srcRowCol( row, col, &srcRow, &srcCol );
+      QCOMPARE( block->value( row, col ), srcBlock->value( srcRow, srcCol ) );
+    }
+  }
+
+  delete srcBlock;
+  delete block;
+}
+
 QTEST_MAIN( TestQgsRasterLayer )
 #include "moc_testqgsrasterlayer.cxx"
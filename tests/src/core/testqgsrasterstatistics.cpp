@@ -0,0 +1,128 @@
+/***************************************************************************
+     testqgsrasterstatistics.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+#include <QObject>
+
+#include <qmath.h>
+
+//header for class being tested
+#include <qgsrasterinterface.h>
+#include <qgsrasterblock.h>
+#include "testqgsrasterinput.h"
+
+// 1000 x 1000 pixels read in blocks of 100 x 100, band 1 is Int16 and band 2 is Float32
+// with the same values, -1000 is nodata
+class TestStatisticsInput : public TestRasterInput
+{
+  public:
+    TestStatisticsInput() : TestRasterInput( Size ) {}
+
+    QgsRasterInterface* clone() const { return new TestStatisticsInput; }
+    QGis::DataType dataType( int bandNo ) const { return bandNo == 1 ? QGis::Int16 : QGis::Float32; }
+    int bandCount() const { return 2; }
+    double noDataValue( int bandNo ) const { Q_UNUSED( bandNo ); return -1000; }
+    QgsRectangle extent() { return QgsRectangle( 0, 0, 1000, 1000 ); }
+    int xBlockSize() const { return 100; }
+    int yBlockSize() const { return 100; }
+    int xSize() const { return 1000; }
+    int ySize() const { return 1000; }
+
+    static double pixelValue( int col, int row ) { return ( col * 7 + row * 13 ) % 2000 - 1000; }
+    double value( int bandNo, double x, double y ) const { Q_UNUSED( bandNo ); return pixelValue( qRound( x ), 1000 - qRound( y ) ); }
+};
+
+class TestQgsRasterStatistics: public QObject
+{
+    Q_OBJECT;
+  private slots:
+    void statistics();
+    void histogram();
+};
+
+void TestQgsRasterStatistics::statistics()
+{
+  int count = 0;
+  double sum = 0;
+  for ( int row = 0; row < 1000; row++ )
+  {
+    for ( int col = 0; col < 1000; col++ )
+    {
+      double value = TestStatisticsInput::pixelValue( col, row );
+      if ( value == -1000 )
+        continue;
+      count++;
+      sum += value;
+    }
+  }
+  double mean = sum / count;
+  double sumOfSquares = 0;
+  for ( int row = 0; row < 1000; row++ )
+  {
+    for ( int col = 0; col < 1000; col++ )
+    {
+      double value = TestStatisticsInput::pixelValue( col, row );
+      if ( value == -1000 )
+        continue;
+      sumOfSquares += ( value - mean ) * ( value - mean );
+    }
+  }
+  double stdDev = sqrt( sumOfSquares / ( count - 1 ) );
+
+  for ( int bandNo = 1; bandNo <= 2; bandNo++ )
+  {
+    TestStatisticsInput input;
+    QgsRasterBandStats stats = input.bandStatistics( bandNo );
+    QCOMPARE( input.reads, 100 );
+    QCOMPARE( stats.elementCount, count );
+    QCOMPARE( stats.minimumValue, -999.0 );
+    QCOMPARE( stats.maximumValue, 999.0 );
+    QCOMPARE( stats.sum, sum );
+    QVERIFY( qAbs( stats.mean - mean ) < 1e-9 );
+    QVERIFY( qAbs( stats.stdDev - stdDev ) < 1e-9 );
+
+    // cached
+    input.bandStatistics( bandNo );
+    QCOMPARE( input.reads, 100 );
+  }
+}
+
+void TestQgsRasterStatistics::histogram()
+{
+  // Int16 histograms are binned from the values counted with the statistics
+  TestStatisticsInput intInput;
+  intInput.bandStatistics( 1 );
+  QgsRasterHistogram intHistogram = intInput.histogram( 1, 100 );
+  QgsRasterHistogram rangeHistogram = intInput.histogram( 1, 10, -100, 100, QgsRectangle(), 0, true );
+  QCOMPARE( intInput.reads, 100 );
+
+  // Float32 histograms are counted from the blocks
+  TestStatisticsInput floatInput;
+  QgsRasterHistogram floatHistogram = floatInput.histogram( 2, 100 );
+  QgsRasterHistogram floatRangeHistogram = floatInput.histogram( 2, 10, -100, 100, QgsRectangle(), 0, true );
+
+  QCOMPARE( intHistogram.nonNullCount, floatHistogram.nonNullCount );
+  QCOMPARE( intHistogram.histogramVector, floatHistogram.histogramVector );
+  QCOMPARE( rangeHistogram.nonNullCount, floatRangeHistogram.nonNullCount );
+  QCOMPARE( rangeHistogram.histogramVector, floatRangeHistogram.histogramVector );
+
+  int total = 0;
+  foreach ( int binCount, intHistogram.histogramVector )
+    total += binCount;
+  QCOMPARE( total, intHistogram.nonNullCount );
+  QCOMPARE( intHistogram.nonNullCount, intInput.bandStatistics( 1 ).elementCount );
+}
+
+QTEST_MAIN( TestQgsRasterStatistics )
+#include "moc_testqgsrasterstatistics.cxx"
@@ -21,6 +21,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopServices>
+#include <QPainter>
 
 #include <iostream>
 //qgis includes...
@@ -30,9 +31,51 @@
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsmaplayerregistry.h>
+#include <qgsgeometry.h>
+#include <qgsrendercontext.h>
+#include <qgsrendererv2.h>
+#include <qgssymbolv2.h>
+#include <qgslinesymbollayerv2.h>
+#include <qgsgraduatedsymbolrendererv2.h>
+#include <qgscategorizedsymbolrendererv2.h>
 //qgis test includes
 #include "qgsrenderchecker.h"
 
+// chooses the symbol by the position of the geometry, which the features
+// drawn for the symbol levels do not have anymore
+class PositionRenderer : public QgsFeatureRendererV2
+{
+  public:
+    PositionRenderer( QgsSymbolV2* left, QgsSymbolV2* right )
+        : QgsFeatureRendererV2( "position" ), mLeft( left ), mRight( right ) {}
+    ~PositionRenderer() { delete mLeft; delete mRight; }
+
+    QgsSymbolV2* symbolForFeature( QgsFeature& feature )
+    {
+      if ( !feature.geometry() )
+        return 0;
+      return feature.geometry()->boundingBox().xMinimum() < 50 ? mLeft : mRight;
+    }
+    void startRender( QgsRenderContext& context, const QgsVectorLayer* vlayer )
+    {
+      mLeft->startRender( context, vlayer );
+      mRight->startRender( context, vlayer );
+    }
+    void stopRender( QgsRenderContext& context )
+    {
+      mLeft->stopRender( context );
+      mRight->stopRender( context );
+    }
+    QList<QString> usedAttributes() { return QList<QString>(); }
+    QgsFeatureRendererV2* clone() { return new PositionRenderer( mLeft->clone(), mRight->clone() ); }
+    QgsSymbolV2List symbols() { return QgsSymbolV2List() << mLeft << mRight; }
+    int capabilities() { return SymbolLevels; }
+
+  private:
+    QgsSymbolV2* mLeft;
+    QgsSymbolV2* mRight;
+};
+
 /** \ingroup UnitTests
  * This is a unit test for the different renderers for vector layers.
  */
@@ -49,6 +92,10 @@ class TestQgsRenderers: public QObject
     void uniqueValue();
     void graduatedSymbol();
     void continuousSymbol();
+    void symbolLevels();
+    void graduatedRanges();
+    void categorizedValues();
+    void lineBatching();
   private:
     bool mTestHasError;
     bool setQml( QString theType ); //uniquevalue / continuous / single /
@@ -163,6 +210,269 @@ void TestQgsRenderers::continuousSymbol()
   QVERIFY( imageCheck( "continuous" ) );
 }
 
+// draw a layer to an image of 100 x 100 pixels of 1 map unit
+static QImage drawLayer( QgsVectorLayer& layer )
+{
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  QPainter painter( &image );
+  QgsRenderContext context;
+  context.setPainter( &painter );
+  context.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  context.setMapToPixel( QgsMapToPixel( 1, 100, 0, 0 ) );
+  layer.draw( context );
+  painter.end();
+  return image;
+}
+
+// line symbol with a wide line in the first level and a narrow one in the second
+static QgsLineSymbolV2* levelsSymbol( QColor color )
+{
+  QgsSimpleLineSymbolLayerV2* wide = new QgsSimpleLineSymbolLayerV2( Qt::black, 3 );
+  wide->setRenderingPass( 0 );
+  QgsSimpleLineSymbolLayerV2* narrow = new QgsSimpleLineSymbolLayerV2( color, 1 );
+  narrow->setRenderingPass( 1 );
+  return new QgsLineSymbolV2( QgsSymbolLayerV2List() << wide << narrow );
+}
+
+void TestQgsRenderers::symbolLevels()
+{
+  // lines far enough apart for the levels not to change the result
+  QgsVectorLayer layer( "LineString", "lines", "memory" );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5; i++ )
+  {
+    QgsFeature left;
+    left.setGeometry( QgsGeometry::fromPolyline( QgsPolyline() << QgsPoint( 5, 10 + 20 * i ) << QgsPoint( 45, 10 + 20 * i ) ) );
+    QgsFeature right;
+    right.setGeometry( QgsGeometry::fromPolyline( QgsPolyline() << QgsPoint( 55 + 10 * i, 5 ) << QgsPoint( 55 + 10 * i, 95 ) ) );
+    features << left << right;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  PositionRenderer* renderer = new PositionRenderer( levelsSymbol( Qt::red ), levelsSymbol( Qt::blue ) );
+  layer.setRendererV2( renderer );
+
+  QImage image = drawLayer( layer );
+  // both symbols are drawn
+  QCOMPARE( image.pixel( 25, 50 ), QColor( Qt::red ).rgba() );
+  QCOMPARE( image.pixel( 75, 50 ), QColor( Qt::blue ).rgba() );
+
+  renderer->setUsingSymbolLevels( true );
+  QImage levelsImage = drawLayer( layer );
+  QVERIFY( levelsImage == image );
+}
+
+// the symbol of the first range containing the value, as the renderer did without sorting the ranges
+static QgsSymbolV2* firstRangeSymbol( const QgsRangeList& ranges, double value )
+{
+  for ( int i = 0; i < ranges.count(); i++ )
+  {
+    if ( ranges[i].lowerValue() <= value && ranges[i].upperValue() >= value )
+      return ranges[i].symbol();
+  }
+  return 0;
+}
+
+void TestQgsRenderers::graduatedRanges()
+{
+  QgsVectorLayer layer( "Point?field=value:double", "points", "memory" );
+  QVERIFY( layer.isValid() );
+
+  // unsorted ranges which overlap, share bounds, contain each other or are empty
+  QgsRangeList ranges;
+  ranges << QgsRendererRangeV2( 10, 20, QgsSymbolV2::defaultSymbol( QGis::Point ), "10 - 20" );
+  ranges << QgsRendererRangeV2( 0, 5, QgsSymbolV2::defaultSymbol( QGis::Point ), "0 - 5" );
+  ranges << QgsRendererRangeV2( 4, 12, QgsSymbolV2::defaultSymbol( QGis::Point ), "4 - 12" );
+  ranges << QgsRendererRangeV2( 20, 30, QgsSymbolV2::defaultSymbol( QGis::Point ), "20 - 30" );
+  ranges << QgsRendererRangeV2( 0, 100, QgsSymbolV2::defaultSymbol( QGis::Point ), "0 - 100" );
+  ranges << QgsRendererRangeV2( 15, 16, QgsSymbolV2::defaultSymbol( QGis::Point ), "15 - 16" );
+  ranges << QgsRendererRangeV2( 150, 150, QgsSymbolV2::defaultSymbol( QGis::Point ), "150" );
+  ranges << QgsRendererRangeV2( -10, -20, QgsSymbolV2::defaultSymbol( QGis::Point ), "empty" );
+  ranges << QgsRendererRangeV2( 140, 160, QgsSymbolV2::defaultSymbol( QGis::Point ), "140 - 160" );
+  QgsGraduatedSymbolRendererV2 renderer( "value", ranges );
+  const QgsRangeList& rendererRanges = renderer.ranges();
+
+  // the bounds of the ranges, values just beside them and between them
+  QList<double> values;
+  for ( int i = 0; i < rendererRanges.count(); i++ )
+  {
+    double lower = rendererRanges[i].lowerValue();
+    double upper = rendererRanges[i].upperValue();
+    values << lower << upper << lower - 0.001 << lower + 0.001 << upper - 0.001 << upper + 0.001 << ( lower + upper ) / 2;
+  }
+  values << -1000 << 1000 << 35 << 120;
+
+  QgsFeature feature;
+  feature.initAttributes( 1 );
+  QgsRenderContext context;
+  renderer.startRender( context, &layer );
+  for ( int pass = 0; pass < 2; pass++ )
+  {
+    // with the sorted ranges while rendering, then with the list of ranges
+    if ( pass == 1 )
+      renderer.stopRender( context );
+
+    foreach ( double value, values )
+    {
+      feature.setAttribute( 0, value );
+      QVERIFY2( renderer.symbolForFeature( feature ) == firstRangeSymbol( rendererRanges, value ),
+                QString( "value %1" ).arg( value ).toLocal8Bit().constData() );
+    }
+  }
+
+  // the first range containing the value is used
+  renderer.startRender( context, &layer );
+  feature.setAttribute( 0, 5.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererRanges[1].symbol() );
+  feature.setAttribute( 0, 12.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererRanges[0].symbol() );
+  feature.setAttribute( 0, 20.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererRanges[0].symbol() );
+  feature.setAttribute( 0, 31.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererRanges[4].symbol() );
+  feature.setAttribute( 0, 150.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererRanges[6].symbol() );
+  feature.setAttribute( 0, -15.0 );
+  QVERIFY( !renderer.symbolForFeature( feature ) );
+  feature.setAttribute( 0, 100.5 );
+  QVERIFY( !renderer.symbolForFeature( feature ) );
+  renderer.stopRender( context );
+}
+
+// the symbol of the category whose value has the string of the value, as the renderer did with numbers
+static QgsSymbolV2* categoryStringSymbol( const QgsCategoryList& categories, const QVariant& value )
+{
+  QgsSymbolV2* symbol = 0;
+  for ( int i = 0; i < categories.count(); i++ )
+  {
+    // the last category with the string is in the hash
+    if ( categories[i].value().toString() == value.toString() )
+      symbol = categories[i].symbol();
+  }
+  return symbol;
+}
+
+void TestQgsRenderers::categorizedValues()
+{
+  QgsVectorLayer layer( "Point?field=value:string", "points", "memory" );
+  QVERIFY( layer.isValid() );
+
+  // numbers and strings, some strings are the strings of numbers
+  QList<QVariant> categoryValues;
+  categoryValues << QVariant( 1 ) << QVariant( "2" ) << QVariant( 2.5 ) << QVariant( "abc" ) << QVariant( "01" )
+  << QVariant( 1e20 ) << QVariant( -3 ) << QVariant( "1.50" ) << QVariant( 7.0 ) << QVariant( qlonglong( 1 ) << 40 )
+  << QVariant( "" );
+  QgsCategoryList categories;
+  foreach ( QVariant value, categoryValues )
+  {
+    categories << QgsRendererCategoryV2( value, QgsSymbolV2::defaultSymbol( QGis::Point ), value.toString() );
+  }
+  QgsCategorizedSymbolRendererV2 renderer( "value", categories );
+  const QgsCategoryList& rendererCategories = renderer.categories();
+
+  // values of other types than the categories, matching or not
+  QList<QVariant> values;
+  values << QVariant( 1 ) << QVariant( qlonglong( 1 ) ) << QVariant( 1.0 ) << QVariant( "1" ) << QVariant( "01" )
+  << QVariant( 2 ) << QVariant( 2.0 ) << QVariant( "2" ) << QVariant( 2.5 ) << QVariant( "2.5" ) << QVariant( "2.50" )
+  << QVariant( 1.5 ) << QVariant( "1.50" ) << QVariant( 1e20 ) << QVariant( "1e+20" ) << QVariant( -3 ) << QVariant( -3.0 )
+  << QVariant( "-3" ) << QVariant( 7 ) << QVariant( 7.0 ) << QVariant( "7" ) << QVariant( qlonglong( 1 ) << 40 )
+  << QVariant( double( qlonglong( 1 ) << 40 ) ) << QVariant( "abc" ) << QVariant( "ABC" ) << QVariant( 0 )
+  << QVariant( "" ) << QVariant( QVariant::String ) << QVariant( QVariant::Int ) << QVariant( QVariant::Double );
+
+  QgsFeature feature;
+  feature.initAttributes( 1 );
+  QgsRenderContext context;
+  renderer.startRender( context, &layer );
+  foreach ( QVariant value, values )
+  {
+    feature.setAttribute( 0, value );
+    QVERIFY2( renderer.symbolForFeature( feature ) == categoryStringSymbol( rendererCategories, value ),
+              QString( "value %1 of type %2" ).arg( value.toString() ).arg( value.typeName() ).toLocal8Bit().constData() );
+  }
+
+  // numbers find the category of their string
+  feature.setAttribute( 0, 1.0 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererCategories[0].symbol() );
+  feature.setAttribute( 0, 2 );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererCategories[1].symbol() );
+  feature.setAttribute( 0, "2.5" );
+  QVERIFY( renderer.symbolForFeature( feature ) == rendererCategories[2].symbol() );
+  feature.setAttribute( 0, 1.5 );
+  QVERIFY( !renderer.symbolForFeature( feature ) );
+  renderer.stopRender( context );
+}
+
+void TestQgsRenderers::lineBatching()
+{
+  QgsVectorLayer layer( "MultiLineString?field=kind:integer", "lines", "memory" );
+  QVERIFY( layer.isValid() );
+
+  // crossing lines, so that the order of drawing matters, in runs of the same kind
+  QgsFeatureList features;
+  for ( int i = 0; i < 40; i++ )
+  {
+    QgsFeature feature;
+    feature.initAttributes( 1 );
+    feature.setAttribute( 0, ( i / 3 + i / 7 ) % 5 );
+    QgsPolyline line;
+    line << QgsPoint( 5, 2 + 2.3 * i ) << QgsPoint( 50, 50 + ( i % 4 ) ) << QgsPoint( 95, 95 - 2.3 * i );
+    if ( i % 5 == 0 )
+    {
+      QgsPolyline second;
+      second << QgsPoint( 2.5 * i, 5 ) << QgsPoint( 100 - 2.5 * i, 95 );
+      feature.setGeometry( QgsGeometry::fromMultiPolyline( QgsMultiPolyline() << line << second ) );
+    }
+    else
+    {
+      feature.setGeometry( QgsGeometry::fromPolyline( line ) );
+    }
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsFeatureIds selected;
+  QgsFeatureIterator fit = layer.getFeatures();
+  QgsFeature feature;
+  for ( int i = 0; fit.nextFeature( feature ); i++ )
+  {
+    if ( i % 4 == 1 || i % 11 == 0 )
+      selected << feature.id();
+  }
+  layer.setSelectedFeatures( selected );
+
+  // simple lines, one with an offset and one with two layers, and a marker line that is never batched
+  QgsCategoryList categories;
+  categories << QgsRendererCategoryV2( QVariant( 0 ), new QgsLineSymbolV2( QgsSymbolLayerV2List() << new QgsSimpleLineSymbolLayerV2( Qt::red, 1 ) ), "red" );
+  QgsSimpleLineSymbolLayerV2* dashed = new QgsSimpleLineSymbolLayerV2( Qt::blue, 2, Qt::DashLine );
+  dashed->setOffset( 1.5 );
+  categories << QgsRendererCategoryV2( QVariant( 1 ), new QgsLineSymbolV2( QgsSymbolLayerV2List() << dashed ), "blue" );
+  categories << QgsRendererCategoryV2( QVariant( 2 ), levelsSymbol( Qt::yellow ), "yellow" );
+  categories << QgsRendererCategoryV2( QVariant( 3 ), new QgsLineSymbolV2( QgsSymbolLayerV2List() << new QgsMarkerLineSymbolLayerV2( true, 8 ) ), "markers" );
+  categories << QgsRendererCategoryV2( QVariant( 4 ), new QgsLineSymbolV2( QgsSymbolLayerV2List() << new QgsSimpleLineSymbolLayerV2( Qt::green, 0.5 ) ), "green" );
+  QgsCategorizedSymbolRendererV2* renderer = new QgsCategorizedSymbolRendererV2( "kind", categories );
+  layer.setRendererV2( renderer );
+
+  for ( int levels = 0; levels < 2; levels++ )
+  {
+    renderer->setUsingSymbolLevels( levels == 1 );
+
+    renderer->setBatchingEnabled( false );
+    QImage direct = drawLayer( layer );
+    renderer->setBatchingEnabled( true );
+    QImage batched = drawLayer( layer );
+
+    QVERIFY( batched == direct );
+  }
+
+  // the selection is drawn, so it is part of the comparison
+  renderer->setUsingSymbolLevels( false );
+  QImage selectedImage = drawLayer( layer );
+  layer.removeSelection();
+  QVERIFY( drawLayer( layer ) != selectedImage );
+}
+
 //
 // Private helper functions not called directly by CTest
 //
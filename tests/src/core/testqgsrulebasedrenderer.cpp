@@ -104,6 +104,58 @@ class TestQgsRuleBasedRenderer: public QObject
       delete layer;
     }
 
+    void test_filter_index()
+    {
+      QgsVectorLayer* layer = new QgsVectorLayer( "point?field=fld:int&field=name:string", "x", "memory" );
+      QgsFeature f1; f1.initAttributes( 2 ); f1.setAttribute( 0, QVariant( 3 ) ); f1.setAttribute( 1, QVariant( "a" ) );
+      QgsFeature f2; f2.initAttributes( 2 ); f2.setAttribute( 0, QVariant( 15 ) ); f2.setAttribute( 1, QVariant( "b" ) );
+      QgsFeature f3; f3.initAttributes( 2 ); f3.setAttribute( 0, QVariant() ); f3.setAttribute( 1, QVariant( "c" ) );
+
+      // categories, ranges and other filters mixed in one level
+      RRule* rootRule = new RRule( NULL );
+      for ( int i = 0; i < 20; i++ )
+        rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, QString( "fld = %1" ).arg( i ) ) );
+      RRule* rIn = new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "\"FLD\" IN (3, '15.0') AND name <> 'x'" );
+      RRule* rRange = new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "10 < fld AND fld <= 20" );
+      RRule* rOther = new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "name = 'c' OR fld = 3" );
+      rootRule->appendChild( rIn );
+      rootRule->appendChild( rRange );
+      rootRule->appendChild( rOther );
+
+      // group without any rule active at the current scale
+      RRule* group = new RRule( NULL );
+      group->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 1000, 2000, "fld = 3" ) );
+      rootRule->appendChild( group );
+
+      QgsRuleBasedRendererV2 r( rootRule );
+      QgsRenderContext ctx;
+      ctx.setRendererScale( 5000 );
+      r.startRender( ctx, layer );
+
+      RRule::RuleList lst1 = r.rootRule()->rulesForFeature( f1 );
+      QCOMPARE( lst1.count(), 3 );
+      QCOMPARE( lst1[0], rootRule->children()[3] );
+      QCOMPARE( lst1[1], rIn );
+      QCOMPARE( lst1[2], rOther );
+
+      RRule::RuleList lst2 = r.rootRule()->rulesForFeature( f2 );
+      QCOMPARE( lst2.count(), 3 );
+      QCOMPARE( lst2[0], rootRule->children()[15] );
+      QCOMPARE( lst2[1], rIn );
+      QCOMPARE( lst2[2], rRange );
+
+      RRule::RuleList lst3 = r.rootRule()->rulesForFeature( f3 );
+      QCOMPARE( lst3.count(), 1 );
+      QCOMPARE( lst3[0], rOther );
+
+      QCOMPARE( r.symbolsForFeature( f2 ).count(), 3 );
+      QVERIFY( r.willRenderFeature( f3 ) );
+
+      r.stopRender( ctx );
+
+      delete layer;
+    }
+
   private:
     void xml2domElement( QString testFile, QDomDocument& doc )
     {
@@ -0,0 +1,188 @@
+/***************************************************************************
+     testqgsscreengeometrycache.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest>
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+
+//header for class being tested
+#include <qgsrendererv2.h>
+
+#include <qgsapplication.h>
+#include <qgsgeometry.h>
+#include <qgsmaptopixel.h>
+#include <qgsrendercontext.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+// gives access to the protected conversion of the renderer
+class TestRenderer : public QgsFeatureRendererV2
+{
+  public:
+    TestRenderer() : QgsFeatureRendererV2( "test" ) {}
+
+    QgsSymbolV2* symbolForFeature( QgsFeature& ) { return 0; }
+    void startRender( QgsRenderContext&, const QgsVectorLayer* ) {}
+    void stopRender( QgsRenderContext& ) {}
+    QList<QString> usedAttributes() { return QList<QString>(); }
+    QgsFeatureRendererV2* clone() { return new TestRenderer; }
+    QgsSymbolV2List symbols() { return QgsSymbolV2List(); }
+
+    static void simplify( QPolygonF& pts, double threshold, int minPoints ) { _simplify( pts, threshold, minPoints ); }
+
+    static bool isCached( QgsFeature& feature, QgsRenderContext& context, QgsScreenGeometryCache& cache )
+    {
+      return cachedScreenGeometry( feature, context, cache ) != NULL;
+    }
+};
+
+// 100 x 100 pixels of 1 map unit showing the extent from xmin, ymin
+static void setExtent( QgsRenderContext& context, double xmin, double ymin, double mapUnitsPerPixel = 1 )
+{
+  context.setExtent( QgsRectangle( xmin, ymin, xmin + 100 * mapUnitsPerPixel, ymin + 100 * mapUnitsPerPixel ) );
+  context.setMapToPixel( QgsMapToPixel( mapUnitsPerPixel, ymin + 100 * mapUnitsPerPixel, ymin, xmin ) );
+}
+
+class TestQgsScreenGeometryCache: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void initTestCase();
+    void simplifyLine();
+    void simplifyRing();
+    void simplifyZeroThreshold();
+    void cacheOnPan();
+    void cacheOnEdit();
+};
+
+void TestQgsScreenGeometryCache::initTestCase()
+{
+  // we need the memory provider
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsScreenGeometryCache::simplifyLine()
+{
+  QPolygonF line;
+  line << QPointF( 0, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0.2, 0 ) << QPointF( 5, 0 ) << QPointF( 5.1, 0 ) << QPointF( 10, 0 );
+  TestRenderer::simplify( line, 1, 2 );
+  QCOMPARE( line, QPolygonF() << QPointF( 0, 0 ) << QPointF( 5, 0 ) << QPointF( 10, 0 ) );
+
+  // a sub-pixel line keeps its end points
+  QPolygonF small;
+  small << QPointF( 0, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0.2, 0 ) << QPointF( 0.3, 0 ) << QPointF( 0.4, 0 );
+  TestRenderer::simplify( small, 1, 2 );
+  QCOMPARE( small, QPolygonF() << QPointF( 0, 0 ) << QPointF( 0.4, 0 ) );
+}
+
+void TestQgsScreenGeometryCache::simplifyRing()
+{
+  // a sub-pixel ring keeps four vertices
+  QPolygonF ring;
+  ring << QPointF( 0, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0.2, 0.1 ) << QPointF( 0.1, 0.2 ) << QPointF( 0, 0.1 ) << QPointF( 0, 0 );
+  TestRenderer::simplify( ring, 1, 4 );
+  QCOMPARE( ring.count(), 4 );
+  QCOMPARE( ring.first(), QPointF( 0, 0 ) );
+  QCOMPARE( ring.last(), QPointF( 0, 0 ) );
+
+  // rings with up to four vertices are not changed
+  QPolygonF triangle;
+  triangle << QPointF( 0, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0, 0.1 ) << QPointF( 0, 0 );
+  QPolygonF copy = triangle;
+  TestRenderer::simplify( triangle, 1, 4 );
+  QCOMPARE( triangle, copy );
+}
+
+void TestQgsScreenGeometryCache::simplifyZeroThreshold()
+{
+  QPolygonF line;
+  line << QPointF( 0, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0.1, 0 ) << QPointF( 0.2, 0 ) << QPointF( 10, 0 );
+  QPolygonF copy = line;
+  TestRenderer::simplify( line, 0, 2 );
+  QCOMPARE( line, copy );
+}
+
+void TestQgsScreenGeometryCache::cacheOnPan()
+{
+  QgsFeature feature( 1 );
+  feature.setGeometry( QgsGeometry::fromPolyline( QgsPolyline() << QgsPoint( 40, 40 ) << QgsPoint( 60, 60 ) ) );
+
+  QgsRenderContext context;
+  setExtent( context, 0, 0 );
+  QgsScreenGeometryCache cache;
+  cache.begin( context );
+  QVERIFY( TestRenderer::isCached( feature, context, cache ) );
+  QCOMPARE( cache.count(), 1 );
+  QCOMPARE( cache.pointCount(), 2 );
+
+  // panned at the same scale, the cached geometry is used
+  setExtent( context, 10, 10 );
+  cache.begin( context );
+  QCOMPARE( cache.count(), 1 );
+  QVERIFY( TestRenderer::isCached( feature, context, cache ) );
+  QCOMPARE( cache.count(), 1 );
+
+  // the feature would need clipping, it is drawn without the cache
+  setExtent( context, 55, 55 );
+  cache.begin( context );
+  QVERIFY( !TestRenderer::isCached( feature, context, cache ) );
+  QCOMPARE( cache.count(), 1 );
+
+  // another scale drops the geometries
+  setExtent( context, 0, 0, 0.5 );
+  cache.begin( context );
+  QCOMPARE( cache.count(), 0 );
+
+  // another simplification drops the geometries
+  setExtent( context, 0, 0 );
+  cache.begin( context );
+  QVERIFY( TestRenderer::isCached( feature, context, cache ) );
+  context.setSimplifyThreshold( 1 );
+  cache.begin( context );
+  QCOMPARE( cache.count(), 0 );
+}
+
+void TestQgsScreenGeometryCache::cacheOnEdit()
+{
+  QgsVectorLayer layer( "LineString", "lines", "memory" );
+  QVERIFY( layer.isValid() );
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromPolyline( QgsPolyline() << QgsPoint( 40, 40 ) << QgsPoint( 60, 60 ) ) );
+  QVERIFY( layer.dataProvider()->addFeatures( QgsFeatureList() << feature ) );
+
+  QVERIFY( !layer.screenGeometryCache() );
+  layer.setScreenGeometryCacheEnabled( true );
+  QVERIFY( layer.screenGeometryCache() );
+
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  QPainter painter( &image );
+  QgsRenderContext context;
+  context.setPainter( &painter );
+  setExtent( context, 0, 0 );
+
+  QVERIFY( layer.draw( context ) );
+  QCOMPARE( layer.screenGeometryCache()->count(), 1 );
+
+  // the features may change while the layer is edited
+  QVERIFY( layer.startEditing() );
+  QCOMPARE( layer.screenGeometryCache()->count(), 0 );
+  QVERIFY( layer.draw( context ) );
+  QCOMPARE( layer.screenGeometryCache()->count(), 0 );
+  layer.rollBack();
+}
+
+QTEST_MAIN( TestQgsScreenGeometryCache )
+#include "moc_testqgsscreengeometrycache.cxx"
@@ -0,0 +1,94 @@
+/***************************************************************************
+     testqgssqlexpressioncompiler.cpp
+     --------------------------------------
+    Date                 : March 2013
+    Copyright            : (C) 2013 by the QGIS Project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest>
+
+//qgis includes...
+#include <qgsexpression.h>
+#include <qgssqlexpressioncompiler.h>
+
+
+/** \ingroup UnitTests
+ * This is a unit test for the translation of expressions to SQL
+ */
+class TestQgsSqlExpressionCompiler : public QObject
+{
+    Q_OBJECT
+  private slots:
+    void initTestCase();
+
+    void numberOrdering();
+    void stringOrdering();
+    void stringEquality();
+
+  private:
+    QgsSqlExpressionCompiler::Result compile( const QString& expression, QgsSqlExpressionCompiler::Flags flags, QString& sql );
+
+    QgsFields mFields;
+};
+
+void TestQgsSqlExpressionCompiler::initTestCase()
+{
+  mFields.append( QgsField( "name", QVariant::String ) );
+  mFields.append( QgsField( "num", QVariant::Int ) );
+}
+
+QgsSqlExpressionCompiler::Result TestQgsSqlExpressionCompiler::compile( const QString& expression, QgsSqlExpressionCompiler::Flags flags, QString& sql )
+{
+  QgsExpression exp( expression );
+  QgsSqlExpressionCompiler compiler( mFields, flags );
+  QgsSqlExpressionCompiler::Result result = compiler.compile( &exp );
+  sql = compiler.result();
+  return result;
+}
+
+void TestQgsSqlExpressionCompiler::numberOrdering()
+{
+  QString sql;
+  QCOMPARE( compile( "\"num\" < 3", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Complete );
+  QCOMPARE( sql, QString( "\"num\" < 3" ) );
+  QCOMPARE( compile( "\"num\" >= 3", QgsSqlExpressionCompiler::CollationDependent, sql ), QgsSqlExpressionCompiler::Complete );
+}
+
+void TestQgsSqlExpressionCompiler::stringOrdering()
+{
+  QString sql;
+
+  // the database orders strings by its collation, whatever the provider flags are
+  QCOMPARE( compile( "\"name\" < 'b'", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Fail );
+  QCOMPARE( compile( "\"name\" >= 'b'", QgsSqlExpressionCompiler::CaseInsensitiveLike, sql ), QgsSqlExpressionCompiler::Fail );
+  QCOMPARE( compile( "'b' > \"name\"", QgsSqlExpressionCompiler::Flags( 0 ), sql ), QgsSqlExpressionCompiler::Fail );
+  QCOMPARE( compile( "\"name\" <= 'b'", QgsSqlExpressionCompiler::CollationDependent, sql ), QgsSqlExpressionCompiler::Fail );
+
+  // the rest of an AND still narrows the request
+  QCOMPARE( compile( "\"name\" < 'b' AND \"num\" < 3", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Partial );
+  QCOMPARE( sql, QString( "\"num\" < 3" ) );
+  QCOMPARE( compile( "\"name\" < 'b' OR \"num\" < 3", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Fail );
+}
+
+void TestQgsSqlExpressionCompiler::stringEquality()
+{
+  QString sql;
+  QCOMPARE( compile( "\"name\" = 'b'", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Complete );
+  QCOMPARE( sql, QString( "\"name\" = 'b'" ) );
+  QCOMPARE( compile( "\"name\" <> 'b'", QgsSqlExpressionCompiler::ILikeSupported, sql ), QgsSqlExpressionCompiler::Complete );
+
+  // a collation may consider different strings equal
+  QCOMPARE( compile( "\"name\" = 'b'", QgsSqlExpressionCompiler::CollationDependent, sql ), QgsSqlExpressionCompiler::Partial );
+  QCOMPARE( compile( "\"name\" <> 'b'", QgsSqlExpressionCompiler::CollationDependent, sql ), QgsSqlExpressionCompiler::Fail );
+}
+
+QTEST_MAIN( TestQgsSqlExpressionCompiler )
+#include "moc_testqgssqlexpressioncompiler.cxx"
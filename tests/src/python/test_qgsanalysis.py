@@ -18,7 +18,8 @@ import unittest
 import sys
 import os
 from utilities import unitTestDataPath, getQgisTestApp
-from PyQt4.QtCore import QFileInfo, QDir, QStringList
+from qgis.core import QgsVectorLayer, QgsFeature, QgsGeometry, QgsPoint
+from PyQt4.QtCore import QFileInfo, QDir, QStringList, QVariant
 from PyQt4.QtXml import QDomDocument
 
 # support python < 2.7 via unittest2
@@ -55,6 +56,107 @@ class TestQgsZonalStatistics(TestCase):
         except ImportError:
             self.fail('Failed to import zonal statistics python module')
 
+    def testStatistics(self):
+        """Test the statistics of polygons on a raster with the column
+        index as cell value"""
+        from qgis.analysis import QgsZonalStatistics
+        layer = QgsVectorLayer("Polygon", "zones", "memory")
+        provider = layer.dataProvider()
+
+        # raster extent is 1535375,5083255 - 1535475,5083355, 10m cells
+        ft = QgsFeature()
+        # covers columns 2-4 of the two top rows
+        ft.setGeometry(QgsGeometry.fromWkt(
+            'POLYGON((1535395 5083335, 1535425 5083335, 1535425 5083355, '
+            '1535395 5083355, 1535395 5083335))'))
+        ft2 = QgsFeature()
+        # covers columns 6-8 of the bottom row with a hole over column 7
+        ft2.setGeometry(QgsGeometry.fromWkt(
+            'POLYGON((1535435 5083255, 1535465 5083255, 1535465 5083265, '
+            '1535435 5083265, 1535435 5083255),'
+            '(1535446 5083256, 1535454 5083256, 1535454 5083264, '
+            '1535446 5083264, 1535446 5083256))'))
+        res, features = provider.addFeatures([ft, ft2])
+        assert res, 'Failed to add features'
+
+        rasterFile = os.path.join(TEST_DATA_DIR, 'tenbytenraster.asc')
+        zs = QgsZonalStatistics(layer, rasterFile, 'z_', 1,
+                                QgsZonalStatistics.All)
+        self.assertEqual(zs.calculateStatistics(None), 0)
+
+        fields = provider.fields()
+        expected = [{'z_count': 6, 'z_sum': 18, 'z_mean': 3, 'z_min': 2,
+                     'z_max': 4, 'z_stdev': (2.0 / 3) ** 0.5,
+                     'z_majority': 2},
+                    {'z_count': 2, 'z_sum': 14, 'z_mean': 7, 'z_min': 6,
+                     'z_max': 8, 'z_stdev': 1, 'z_majority': 6}]
+        for f, values in zip(layer.getFeatures(), expected):
+            attrs = f.attributes()
+            for name, value in values.items():
+                got = attrs[provider.fieldNameIndex(name)].toDouble()[0]
+                myMessage = '%s: Expected: %s Got: %s' % (name, value, got)
+                self.assertAlmostEqual(got, value, 6, myMessage)
+
+
+
+class TestQgsIDWInterpolator(TestCase):
+
+    def createInterpolator(self):
+        from qgis.analysis import QgsInterpolator, QgsIDWInterpolator
+        self.layer = QgsVectorLayer("Point?field=value:double", "samples",
+                                    "memory")
+        features = []
+        for x in range(10):
+            for y in range(10):
+                ft = QgsFeature()
+                ft.setGeometry(QgsGeometry.fromPoint(QgsPoint(x, y)))
+                ft.setAttributes([QVariant(float(x * y))])
+                features.append(ft)
+        res, features = self.layer.dataProvider().addFeatures(features)
+        assert res, 'Failed to add features'
+
+        layerData = QgsInterpolator.LayerData()
+        layerData.vectorLayer = self.layer
+        layerData.zCoordInterpolation = False
+        layerData.interpolationAttribute = 0
+        layerData.mInputType = QgsInterpolator.POINTS
+        return QgsIDWInterpolator([layerData])
+
+    def testNeighbors(self):
+        """Interpolation from all the neighbors found in the index is the
+        same as from all the vertices"""
+        interpolator = self.createInterpolator()
+        for x, y in [(2.5, 3.5), (0.1, 8.7), (12.0, -3.0)]:
+            res, allValue = interpolator.interpolatePoint(x, y)
+            self.assertEqual(res, 0)
+            interpolator.setMaxNeighbors(100)
+            res, neighborsValue = interpolator.interpolatePoint(x, y)
+            interpolator.setMaxNeighbors(0)
+            self.assertEqual(res, 0)
+            self.assertAlmostEqual(allValue, neighborsValue, 8)
+
+        # the four nearest vertices are at the same distance
+        interpolator.setMaxNeighbors(4)
+        res, value = interpolator.interpolatePoint(2.5, 3.5)
+        self.assertEqual(res, 0)
+        self.assertAlmostEqual(value, (2 * 3 + 3 * 3 + 2 * 4 + 3 * 4) / 4.0, 8)
+
+        # vertex at the point
+        res, value = interpolator.interpolatePoint(4, 5)
+        self.assertEqual(res, 0)
+        self.assertAlmostEqual(value, 20, 8)
+
+    def testSearchRadius(self):
+        interpolator = self.createInterpolator()
+        interpolator.setSearchRadius(0.8)
+        res, value = interpolator.interpolatePoint(2.5, 3.5)
+        self.assertEqual(res, 0)
+        self.assertAlmostEqual(value, (2 * 3 + 3 * 3 + 2 * 4 + 3 * 4) / 4.0, 8)
+
+        # no vertex within the radius
+        res, value = interpolator.interpolatePoint(20, 20)
+        self.assertNotEqual(res, 0)
+
 
 if __name__ == '__main__':
     unittest.main()
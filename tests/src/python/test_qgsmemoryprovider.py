@@ -109,5 +109,38 @@ class TestQgsMemoryProvider(TestCase):
         myProvider = myMemoryLayer.dataProvider()
         assert myProvider is not None
 
+    def testFilterRequest(self):
+        """Test filtering the features by ids and by expression"""
+        layer = QgsVectorLayer("Point?field=name:string(20)&field=age:integer",
+                               "test", "memory")
+        provider = layer.dataProvider()
+
+        features = []
+        for name, age in [("Johny", 20), ("Mary", 35), ("Peter", 50)]:
+            ft = QgsFeature()
+            ft.setGeometry(QgsGeometry.fromPoint(QgsPoint(age, age)))
+            ft.setAttributes([QVariant(name), QVariant(age)])
+            features.append(ft)
+        res, features = provider.addFeatures(features)
+        assert res, "Failed to add features"
+
+        ids = set([features[0].id(), features[2].id()])
+        request = QgsFeatureRequest().setFilterFids(ids)
+        got = set([f.id() for f in layer.getFeatures(request)])
+        myMessage = 'Expected: %s\nGot: %s\n' % (ids, got)
+        assert got == ids, myMessage
+
+        request = QgsFeatureRequest().setFilterExpression("age > 30")
+        got = sorted([str(f.attributes()[0].toString())
+                      for f in layer.getFeatures(request)])
+        myMessage = 'Expected: %s\nGot: %s\n' % (["Mary", "Peter"], got)
+        assert got == ["Mary", "Peter"], myMessage
+
+        request = QgsFeatureRequest().setFilterExpression("age > 30 and name like 'P%'")
+        got = [str(f.attributes()[0].toString())
+               for f in layer.getFeatures(request)]
+        myMessage = 'Expected: %s\nGot: %s\n' % (["Peter"], got)
+        assert got == ["Peter"], myMessage
+
 if __name__ == '__main__':
     unittest.main()
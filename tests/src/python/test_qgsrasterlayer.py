@@ -163,6 +163,33 @@ class TestQgsRasterLayer(TestCase):
         # crash on next line
         QgsMapLayerRegistry.instance().addMapLayers([myRasterLayer])
 
+    def testColorRampShader(self):
+        """Check the colors of the ramp types, the items are not sorted."""
+        myShader = QgsColorRampShader()
+        myShader.setColorRampItemList([
+            QgsColorRampShader.ColorRampItem(100, QtGui.QColor(0, 200, 0)),
+            QgsColorRampShader.ColorRampItem(0, QtGui.QColor(0, 0, 0)),
+            QgsColorRampShader.ColorRampItem(200, QtGui.QColor(200, 0, 100))])
+
+        myShader.setColorRampType(QgsColorRampShader.INTERPOLATED)
+        assert myShader.shade(50) == (True, 0, 100, 0), myShader.shade(50)
+        assert myShader.shade(150) == (True, 100, 100, 50), myShader.shade(150)
+        assert myShader.shade(200) == (True, 200, 0, 100)
+        assert myShader.shade(0) == (True, 0, 0, 0)
+
+        myShader.setColorRampType(QgsColorRampShader.DISCRETE)
+        assert myShader.shade(50) == (True, 0, 200, 0)
+        assert myShader.shade(100) == (True, 0, 200, 0)
+        assert myShader.shade(100.5) == (True, 200, 0, 100)
+        assert not myShader.shade(201)[0]
+
+        myShader.setColorRampType(QgsColorRampShader.EXACT)
+        assert myShader.shade(100) == (True, 0, 200, 0)
+        assert myShader.shade(0) == (True, 0, 0, 0)
+        assert not myShader.shade(50)[0]
+        assert not myShader.shade(-1)[0]
+        assert not myShader.shade(300)[0]
+
     def testShaderCrash(self):
         """Check if we assign a shader and then reassign it no crash occurs."""
         myPath = os.path.join(unitTestDataPath('raster'),
@@ -15,6 +15,7 @@ __revision__ = '$Format:%H$'
 import unittest
 
 from qgis.core import (QgsSpatialIndex,
+                       QgsVectorLayer,
                        QgsFeature,
                        QgsGeometry,
                        QgsRectangle,
@@ -58,3 +59,47 @@ class TestQgsSpatialIndex(unittest.TestCase):
         myMessage = ('Expected: %s\nGot: %s\n' %
                      ([0, 1, 5], fids))
         assert fids == [0, 1, 5], myMessage
+
+    def testBulkLoad(self):
+        layer = QgsVectorLayer("Point", "test", "memory")
+        features = []
+        for y in range(100):
+            for x in range(100):
+                ft = QgsFeature()
+                ft.setGeometry(QgsGeometry.fromPoint(QgsPoint(x, y)))
+                features.append(ft)
+        res, features = layer.dataProvider().addFeatures(features)
+        assert res, "Failed to add features"
+        fidAt = dict([((int(f.geometry().asPoint().x()),
+                        int(f.geometry().asPoint().y())), f.id())
+                      for f in features])
+
+        idx = QgsSpatialIndex(layer.getFeatures())
+
+        # intersection test
+        rect = QgsRectangle(10.5, 20.5, 13.5, 22.5)
+        fids = idx.intersects(rect)
+        fids.sort()
+        expected = sorted([fidAt[(x, y)] for x in range(11, 14)
+                           for y in range(21, 23)])
+        myMessage = ('Expected: %s\nGot: %s\n' % (expected, fids))
+        assert fids == expected, myMessage
+
+        # nearest neighbor test
+        fids = idx.nearestNeighbor(QgsPoint(50.1, 50.1), 1)
+        myMessage = ('Expected: %s\nGot: %s\n' %
+                     ([fidAt[(50, 50)]], fids))
+        assert fids == [fidAt[(50, 50)]], myMessage
+
+        # empty iterator gives an empty index that still accepts features
+        emptyLayer = QgsVectorLayer("Point", "empty", "memory")
+        idx = QgsSpatialIndex(emptyLayer.getFeatures())
+        assert idx.intersects(QgsRectangle(-1, -1, 1, 1)) == []
+        ft = QgsFeature()
+        ft.setFeatureId(1)
+        ft.setGeometry(QgsGeometry.fromPoint(QgsPoint(0, 0)))
+        idx.insertFeature(ft)
+        assert idx.intersects(QgsRectangle(-1, -1, 1, 1)) == [1]
+
+if __name__ == '__main__':
+    unittest.main()
@@ -13,9 +13,10 @@ __copyright__ = 'Copyright 2012, The Quantum GIS Project'
 __revision__ = '$Format:%H$'
 
 import os
-from PyQt4.QtCore import QVariant
+from PyQt4.QtCore import QVariant, QDir, QSize
+from PyQt4.QtGui import QImage, QPainter
 
-from qgis.core import QgsVectorLayer, QgsFeature, QgsGeometry, QgsPoint, QgsField, QgsFields, QgsMapLayerRegistry, QgsVectorJoinInfo
+from qgis.core import QgsVectorLayer, QgsFeature, QgsGeometry, QgsPoint, QgsField, QgsFields, QgsMapLayerRegistry, QgsVectorJoinInfo, QgsMapRenderer, QgsRectangle
 from utilities import (unitTestDataPath,
                        getQgisTestApp,
                        TestCase,
@@ -986,6 +987,77 @@ class TestQgsVectorLayer(TestCase):
 
         assert not layer.deleteAttribute(-1)
 
+    def test_generalization(self):
+        layer = QgsVectorLayer("LineString", "lines", "memory")
+        f = QgsFeature()
+        f.setGeometry(QgsGeometry.fromPolyline([QgsPoint(i, (i % 2) * 0.001) for i in range(1000)]))
+        assert layer.dataProvider().addFeatures([f])
+
+        assert layer.buildGeneralization([1000000, 1000])
+        assert layer.generalizationScales() == [1000, 1000000]
+
+        fileName = os.path.join(str(QDir.tempPath()), "test_generalization.qgen")
+        assert layer.saveGeneralization(fileName)
+        layer.clearGeneralization()
+        assert layer.generalizationScales() == []
+        assert layer.loadGeneralization(fileName)
+        assert layer.generalizationScales() == [1000, 1000000]
+
+        # written for other geometries of the same number of features
+        changed = QgsFeature()
+        assert layer.getFeatures().nextFeature(changed)
+        assert layer.dataProvider().changeGeometryValues({changed.id(): QgsGeometry.fromPolyline([QgsPoint(0, 0), QgsPoint(1, 1)])})
+        assert not layer.loadGeneralization(fileName)
+
+        # written for another number of features
+        assert layer.buildGeneralization([1000000, 1000])
+        assert layer.saveGeneralization(fileName)
+        assert layer.dataProvider().addFeatures([QgsFeature(f)])
+        assert not layer.loadGeneralization(fileName)
+        os.remove(fileName)
+
+        # points are not generalized
+        assert not createLayerWithOnePoint().buildGeneralization([1000])
+
+    def test_generalization_draw_added(self):
+        def columnDrawn(layer, column):
+            renderer = QgsMapRenderer()
+            renderer.setLayerSet([layer.id()])
+            renderer.setOutputSize(QSize(100, 100), 96)
+            renderer.setExtent(QgsRectangle(0, 0, 100, 100))
+            image = QImage(100, 100, QImage.Format_ARGB32_Premultiplied)
+            image.fill(0)
+            p = QPainter(image)
+            renderer.render(p)
+            p.end()
+            return any(image.pixel(x, 50) != 0 for x in range(column - 2, column + 3))
+
+        layer = QgsVectorLayer("LineString", "lines", "memory")
+        QgsMapLayerRegistry.instance().addMapLayers([layer])
+        f = QgsFeature()
+        f.setGeometry(QgsGeometry.fromPolyline([QgsPoint(10, 20), QgsPoint(10, 80)]))
+        assert layer.dataProvider().addFeatures([f])
+        assert layer.buildGeneralization([1000])
+        assert columnDrawn(layer, 10)
+
+        # added by the provider: another number of features, the full geometries are drawn
+        added = QgsFeature()
+        added.setGeometry(QgsGeometry.fromPolyline([QgsPoint(50, 20), QgsPoint(50, 80)]))
+        assert layer.dataProvider().addFeatures([added])
+        assert columnDrawn(layer, 50)
+
+        # the same number of features again, the band has no geometry for the added one
+        first = QgsFeature()
+        assert layer.getFeatures().nextFeature(first)
+        assert layer.dataProvider().deleteFeatures([first.id()])
+        assert layer.featureCount() == 1
+        assert columnDrawn(layer, 50)
+        assert not columnDrawn(layer, 10)
+
+        # a reload drops the generalization
+        layer.reload()
+        assert layer.generalizationScales() == []
+        QgsMapLayerRegistry.instance().removeMapLayers([layer.id()])
 
 # TODO:
 # - fetch rect: feat with changed geometry: 1. in rect, 2. out of rect